@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "machine.h"
+
+// frames queued at 60fps into a fake device that plays at a skewed clock and drains a whole
+// buffer at a time, like SDL_QueueAudio, once left to drift and once with the rate control
+
+static struct
+{
+	s32 rate;
+	s32 buffer;
+	s32 seconds;
+	s32 jitter;
+} Opts = {44100, 1024, 600, 2000};
+
+// within the default 5000 range, real devices are rarely more than 1000 off
+static const s32 Skews[] = {-4000, -2000, -500, -100, 0, 100, 500, 2000, 4000};
+
+typedef struct
+{
+	double clock;	// sample frames per second the device really plays
+	double next;	// when it drains the next buffer
+	s32 queued;
+	s32 glitches;	// buffers it had to pad with silence
+	bool paused;
+} Sink;
+
+static void play(Sink* sink, double now)
+{
+	for(; sink->next <= now; sink->next += Opts.buffer / sink->clock)
+	{
+		if(sink->paused)
+			continue;
+
+		if(sink->queued < Opts.buffer)
+			sink->glitches++;
+
+		sink->queued = MAX(sink->queued - Opts.buffer, 0);
+	}
+}
+
+typedef struct
+{
+	s32 depth;		// at the end, in sample frames
+	s32 low;		// over the second half
+	s32 high;
+	s32 glitches;	// after the queue first filled
+	tic80_audio_sync_stats stats;
+} Result;
+
+static Result run(s32 skew, bool control)
+{
+	tic_mem* tic = tic_create(Opts.rate);
+
+	const tic80_audio_sync_config config = 
+	{
+		.samplerate = Opts.rate,
+		.latency = (u32)((s64)Opts.buffer * 1000000 / Opts.rate + 2 * 1000000 / TIC80_FRAMERATE),
+	};
+
+	tic80_audio_sync* sync = tic80_audio_sync_create(&config);
+	const s32 target = tic80_audio_sync_report(sync).target;
+
+	Sink sink = {.clock = Opts.rate * (1.0 + skew / 1000000.0), .paused = true};
+	Result result = {.low = INT32_MAX};
+
+	// left to itself the queue is filled once at the start
+	s32 glitches = 0;
+	bool filled = false;
+
+	srand(skew);
+
+	const s32 frames = Opts.seconds * TIC80_FRAMERATE;
+	for(s32 f = 0; f < frames; f++)
+	{
+		double now = (double)f / TIC80_FRAMERATE + (rand() % (2 * Opts.jitter + 1) - Opts.jitter) / 1000000.0;
+		play(&sink, now);
+
+		if(control)
+		{
+			tic_sound_rate(tic, tic80_audio_sync_update(sync, sink.queued));
+			sink.paused = tic80_audio_sync_report(sync).filling;
+		}
+		else sink.paused = sink.queued < target && !filled;
+
+		if(!sink.paused && !filled)
+		{
+			filled = true;
+			glitches = sink.glitches;
+		}
+
+		tic->api.tick_start(tic, &tic->ram.sfx, &tic->ram.music);
+		tic->api.tick_end(tic);
+
+		sink.queued += tic->samples.size / (TIC_STEREO_CHANNELS * sizeof(s16));
+
+		if(f >= frames / 2)
+		{
+			result.low = MIN(result.low, sink.queued);
+			result.high = MAX(result.high, sink.queued);
+		}
+	}
+
+	result.depth = sink.queued;
+	result.glitches = sink.glitches - glitches;
+	result.stats = tic80_audio_sync_report(sync);
+
+	tic80_audio_sync_delete(sync);
+	tic_close(tic);
+
+	return result;
+}
+
+static double ms(s32 frames)
+{
+	return frames * 1000.0 / Opts.rate;
+}
+
+static void usage()
+{
+	printf("usage: audiosim [-r samplerate] [-b device buffer] [-s seconds] [-j frame jitter us]\n");
+}
+
+int main(int argc, char** argv)
+{
+	for(s32 i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if(!value || arg[0] != '-' || strlen(arg) != 2)
+		{
+			usage();
+			return 1;
+		}
+
+		switch(arg[1])
+		{
+		case 'r': Opts.rate = atoi(value); break;
+		case 'b': Opts.buffer = atoi(value); break;
+		case 's': Opts.seconds = atoi(value); break;
+		case 'j': Opts.jitter = atoi(value); break;
+		default: usage(); return 1;
+		}
+
+		i++;
+	}
+
+	if(Opts.rate <= 0 || Opts.buffer <= 0 || Opts.seconds <= 0 || Opts.jitter < 0)
+	{
+		usage();
+		return 1;
+	}
+
+	printf("%i Hz, %i frame device buffer, %i s, frames +-%i us\n\n", Opts.rate, Opts.buffer, Opts.seconds, Opts.jitter);
+	printf("  skew ppm |  drift: end ms  glitches | control: end ms  low ms  high ms  glitches  underruns  correction low/high/end\n");
+
+	s32 failed = 0;
+
+	for(s32 i = 0; i < COUNT_OF(Skews); i++)
+	{
+		Result drift = run(Skews[i], false);
+		Result control = run(Skews[i], true);
+
+		// within a device buffer and a frame of the target once it settled, and never dry
+		const s32 target = control.stats.target;
+		const s32 slack = Opts.buffer + Opts.rate / TIC80_FRAMERATE;
+		bool ok = control.glitches == 0 && control.low >= target - slack && control.high <= target + slack;
+
+		printf("%10i | %14.1f %9i | %15.1f %7.1f %8.1f %9i %10u  %6i %6i %6i%s\n", Skews[i],
+			ms(drift.depth), drift.glitches,
+			ms(control.depth), ms(control.low), ms(control.high), control.glitches, control.stats.underruns,
+			control.stats.low, control.stats.high, control.stats.correction, ok ? "" : "  FAILED");
+
+		if(!ok)
+			failed++;
+	}
+
+	return failed ? 1 : 0;
+}
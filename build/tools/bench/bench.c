@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+static u64 Counter = 0;
+static u64 getCounter() {return Counter;}
+static u64 getFreq() {return TIC80_FRAMERATE;}
+
+static void onError(void* data, const char* info)
+{
+	fprintf(stderr, "error: %s\n", info);
+	exit(-1);
+}
+
+static void onTrace(void* data, const char* text, u8 color)
+{
+	if(data)
+		snprintf(data, BenchTraceSize, "%s", text);
+}
+
+static void onExit(void* data) {}
+
+tic_tick_data bench_tick_data(char* trace)
+{
+	return (tic_tick_data)
+	{
+		.error = onError,
+		.trace = onTrace,
+		.exit = onExit,
+		.counter = getCounter,
+		.freq = getFreq,
+		.data = trace,
+	};
+}
+
+void bench_next_frame()
+{
+	Counter++;
+}
+
+tic_mem* bench_create(const char* code, void(*fill)(tic_cartridge* cart))
+{
+	tic_mem* tic = tic_create(44100);
+
+	if(fill)
+		fill(tic->cart);
+
+	snprintf(tic->cart->code.data, sizeof tic->cart->code.data, "%s", code);
+	tic->api.reset(tic);
+
+	return tic;
+}
+
+double bench_run(tic_mem* tic, s32 frames, bool blit, tic_tick_data* data)
+{
+	clock_t start = clock();
+
+	for(s32 i = 0; i < frames; i++)
+	{
+		tic->api.tick_start(tic, &tic->ram.sfx, &tic->ram.music);
+		tic->api.tick(tic, data);
+		tic->api.tick_end(tic);
+
+		if(blit)
+			tic->api.blit(tic, tic->api.scanline, tic->api.overline, NULL);
+
+		bench_next_frame();
+	}
+
+	return bench_us_per_frame(start, frames);
+}
+
+double bench_us_per_frame(clock_t start, s32 frames)
+{
+	return (double)(clock() - start) * 1000000 / CLOCKS_PER_SEC / frames;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <time.h>
+
+#include "machine.h"
+
+// what the benches share to tick a machine outside the studio
+
+enum {BenchTraceSize = 1024};
+
+// script errors end the process, the last trace goes into trace when it isn't NULL,
+// the clock only moves on bench_next_frame() so time() is the same on every run
+tic_tick_data bench_tick_data(char* trace);
+void bench_next_frame();
+
+// a machine running code, fill gets the cart first when it's given
+tic_mem* bench_create(const char* code, void(*fill)(tic_cartridge* cart));
+
+// ticks frames, blitting through SCN() and OVR() too if asked, returns us per frame
+double bench_run(tic_mem* tic, s32 frames, bool blit, tic_tick_data* data);
+
+double bench_us_per_frame(clock_t start, s32 frames);
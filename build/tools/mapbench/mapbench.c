@@ -0,0 +1,184 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "bench.h"
+
+// the same rays, sweeps, fill and path done in Lua over mget() and the flags in ram,
+// and with mray(), msweep(), mfill() and mpath(); the first frame traces the results of
+// both and they have to match
+
+// %d is the flags address, there is no fget() to read them with
+static const char ScriptCart[] =
+	"-- script: lua\n"
+	"F=%d W=240 H=136 first=true\n"
+	"DX={1,-1,0,0} DY={0,0,1,-1}\n"
+	"function solid(x,y) return peek(F+mget(x%%W,y%%H))&1==1 end\n"
+	"function ray(x0,y0,x1,y1)\n"
+	" local dx,dy=x1-x0,y1-y0\n"
+	" local cx,cy=x0//8,y0//8\n"
+	" local sx,sy=dx>0 and 1 or -1,dy>0 and 1 or -1\n"
+	" local ddx=dx~=0 and 8/math.abs(dx) or math.huge\n"
+	" local ddy=dy~=0 and 8/math.abs(dy) or math.huge\n"
+	" local tx=dx~=0 and ((cx+(sx>0 and 1 or 0))*8-x0)/dx or math.huge\n"
+	" local ty=dy~=0 and ((cy+(sy>0 and 1 or 0))*8-y0)/dy or math.huge\n"
+	" local t=0\n"
+	" while true do\n"
+	"  if solid(cx,cy) then return true,cx%%W,cy%%H end\n"
+	"  if tx>1 and ty>1 then return false end\n"
+	"  if tx<ty then t=tx tx=tx+ddx cx=cx+sx else t=ty ty=ty+ddy cy=cy+sy end\n"
+	" end\n"
+	"end\n"
+	"function sweep(p,s,d,q,qs,vertical)\n"
+	" local a0=q//8 local a1=math.max(a0,math.ceil((q+qs)/8)-1)\n"
+	" local c0,c1,st\n"
+	" if d>0 then c0=math.ceil((p+s)/8) c1=math.ceil((p+s+d)/8)-1 st=1\n"
+	" else c0=p//8-1 c1=(p+d)//8 st=-1 end\n"
+	" for c=c0,c1,st do for a=a0,a1 do\n"
+	"  if vertical and solid(a,c) or not vertical and solid(c,a) then\n"
+	"   return st>0 and c*8-(p+s) or (c+1)*8-p\n"
+	"  end\n"
+	" end end\n"
+	" return d\n"
+	"end\n"
+	"function fill(x,y)\n"
+	" local r=solid(x,y) local seen={[y*W+x]=true} local stack={y*W+x} local n=0\n"
+	" while #stack>0 do\n"
+	"  local i=table.remove(stack) local cx,cy=i%%W,i//W n=n+1\n"
+	"  for k=1,4 do\n"
+	"   local nx,ny=(cx+DX[k])%%W,(cy+DY[k])%%H local j=ny*W+nx\n"
+	"   if not seen[j] and solid(nx,ny)==r then seen[j]=true stack[#stack+1]=j end\n"
+	"  end\n"
+	" end\n"
+	" return n\n"
+	"end\n"
+	"function path(x0,y0,x1,y1)\n"
+	" local s,g=y0*W+x0,y1*W+x1\n"
+	" local cost,from,heap,n={[s]=0},{},{},0\n"
+	" local function h(i) local dx,dy=math.abs(i%%W-x1),math.abs(i//W-y1) return math.min(dx,W-dx)+math.min(dy,H-dy) end\n"
+	" local function push(i,f)\n"
+	"  n=n+1 heap[n]={f,i} local k=n\n"
+	"  while k>1 and heap[k//2][1]>heap[k][1] do heap[k//2],heap[k]=heap[k],heap[k//2] k=k//2 end\n"
+	" end\n"
+	" local function pop()\n"
+	"  local top=heap[1] heap[1]=heap[n] heap[n]=nil n=n-1 local k=1\n"
+	"  while k*2<=n do\n"
+	"   local c=k*2 if c<n and heap[c+1][1]<heap[c][1] then c=c+1 end\n"
+	"   if heap[k][1]<=heap[c][1] then break end\n"
+	"   heap[k],heap[c]=heap[c],heap[k] k=c\n"
+	"  end\n"
+	"  return top\n"
+	" end\n"
+	" push(s,h(s))\n"
+	" while n>0 do\n"
+	"  local e=pop() local i=e[2]\n"
+	"  if i==g then local steps=0 while i~=s do i=from[i] steps=steps+1 end return steps end\n"
+	"  if e[1]==cost[i]+h(i) then\n"
+	"   local x,y=i%%W,i//W\n"
+	"   for k=1,4 do\n"
+	"    local nx,ny=(x+DX[k])%%W,(y+DY[k])%%H\n"
+	"    if not solid(nx,ny) then\n"
+	"     local j,c=ny*W+nx,cost[i]+1\n"
+	"     if not cost[j] or c<cost[j] then cost[j]=c from[j]=i push(j,c+h(j)) end\n"
+	"    end\n"
+	"   end\n"
+	"  end\n"
+	" end\n"
+	"end\n"
+	"function TIC()\n"
+	" local r=first and {}\n"
+	" for i=0,15 do\n"
+	"  local a=(i+.5)*math.pi/8\n"
+	"  local h,cx,cy=ray(900,500,900+math.cos(a)*160,500+math.sin(a)*160)\n"
+	"  if r then r[#r+1]=h and string.format('%%d,%%d',cx,cy) or '-' end\n"
+	" end\n"
+	" for i=0,15 do\n"
+	"  local x,y=100+i*100,300 x=x+sweep(x,12,20,y,12,false) y=y+sweep(y,12,20,x,12,true)\n"
+	"  if r then r[#r+1]=string.format('%%d,%%d',x,y) end\n"
+	" end\n"
+	" local n=fill(60,34)\n"
+	" local p=path(10,10,200,120) or -1\n"
+	" if r then r[#r+1]=n r[#r+1]=p trace(table.concat(r,' ')) first=false end\n"
+	"end\n";
+
+static const char NativeCart[] =
+	"-- script: lua\n"
+	"first=true\n"
+	"function TIC()\n"
+	" local r=first and {}\n"
+	" for i=0,15 do\n"
+	"  local a=(i+.5)*math.pi/8\n"
+	"  local h,x,y,cx,cy=mray(900,500,900+math.cos(a)*160,500+math.sin(a)*160,1)\n"
+	"  if r then r[#r+1]=h and string.format('%%d,%%d',cx,cy) or '-' end\n"
+	" end\n"
+	" for i=0,15 do\n"
+	"  local x,y=msweep(100+i*100,300,12,12,20,20,1)\n"
+	"  if r then r[#r+1]=string.format('%%d,%%d',x,y) end\n"
+	" end\n"
+	" local n=mfill(60,34,1)\n"
+	" local p=mpath(10,10,200,120,1)\n"
+	" p=p and #p//2 or -1\n"
+	" if r then r[#r+1]=n r[#r+1]=p trace(table.concat(r,' ')) first=false end\n"
+	"end\n";
+
+// a quarter of the cells solid, the path ends kept clear
+static void fillCart(tic_cartridge* cart)
+{
+	tic_bank* bank = &cart->bank0;
+
+	srand(0);
+
+	for(s32 i = 0; i < sizeof bank->map.data; i++)
+		bank->map.data[i] = rand() % 4 == 0;
+
+	bank->map.data[10 * TIC_MAP_WIDTH + 10] = 0;
+	bank->map.data[120 * TIC_MAP_WIDTH + 200] = 0;
+	bank->flags.data[1] = 1;
+}
+
+static double run(const char* code, s32 frames, char* results)
+{
+	char* script = malloc(TIC_CODE_SIZE);
+	snprintf(script, TIC_CODE_SIZE, code, (s32)offsetof(tic_ram, flags));
+
+	tic_mem* tic = bench_create(script, fillCart);
+	free(script);
+
+	tic_tick_data data = bench_tick_data(results);
+	double us = bench_run(tic, frames, false, &data);
+
+	tic_close(tic);
+
+	return us;
+}
+
+int main(int argc, char** argv)
+{
+	s32 frames = argc > 1 ? atoi(argv[1]) : 100;
+
+	if(frames > 0)
+	{
+		char scriptResults[BenchTraceSize] = "";
+		char nativeResults[BenchTraceSize] = "";
+
+		double script = run(ScriptCart, frames, scriptResults);
+		double native = run(NativeCart, frames, nativeResults);
+
+		printf("mget():   %.1f us/frame\n", script);
+		printf("native:   %.1f us/frame\n", native);
+		printf("speedup:  %.2fx\n", script / native);
+
+		if(strcmp(scriptResults, nativeResults) != 0)
+		{
+			printf("results differ\n  mget():  %s\n  native:  %s\n", scriptResults, nativeResults);
+			return 1;
+		}
+
+		return 0;
+	}
+
+	printf("usage: mapbench [frames]\n");
+
+	return -1;
+}
@@ -0,0 +1,418 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "netplay.h"
+#include "cart.h"
+#include "socket.h"
+
+// runs every netplay peer in its own process over loopback UDP, with latency, jitter
+// and loss added on the sending side, and fails if any peer saw a desync or got stuck;
+// -k corrupts one player's RAM to check that the desync gets caught
+
+static const char DefaultCart[] =
+	"-- script: lua\n"
+	"-- input: gamepad\n"
+	"local ps={}\n"
+	"for i=0,3 do ps[i]={x=40+i*50,y=68,trail={}} end\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,3 do\n"
+	"  local p=ps[i]\n"
+	"  if btn(i*8) then p.y=p.y-1 end\n"
+	"  if btn(i*8+1) then p.y=p.y+1 end\n"
+	"  if btn(i*8+2) then p.x=p.x-1 end\n"
+	"  if btn(i*8+3) then p.x=p.x+1 end\n"
+	"  if btnp(i*8+4) then table.insert(p.trail,{p.x,p.y,math.random(15)}) end\n"
+	"  if #p.trail>32 then table.remove(p.trail,1) end\n"
+	"  for _,t in ipairs(p.trail) do circ(t[1],t[2],2,t[3]) end\n"
+	"  rect(p.x%240,p.y%136,6,6,i+2)\n"
+	" end\n"
+	" print(math.floor(time()/100),0,0,12)\n"
+	"end\n";
+
+enum {MaxQueue = 4096, MaxPacket = 1024, Linger = TIC80_FRAMERATE};
+
+typedef struct
+{
+	s32 players;
+	s32 spectators;
+	s32 frames;
+	s32 delay;
+	s32 rollback;
+	s32 latency;	// ms one way
+	s32 jitter;		// ms either side
+	s32 loss;		// percent
+	s32 port;
+	s32 corrupt;	// frame to poke a player's RAM at, -1 for none
+	const char* cart;
+	const char* output;
+} Options;
+
+static Options Opts = {2, 1, 600, 2, 8, 50, 20, 10, TIC_NETPLAY_PORT, -1, NULL, NULL};
+
+typedef struct
+{
+	u64 due;
+	s32 peer;
+	s32 size;
+	u8 data[MaxPacket];
+} Packet;
+
+typedef struct
+{
+	s32 socket;
+	SocketAddress addresses[TIC_NETPLAY_PEERS];
+	Packet queue[MaxQueue];
+	s32 count;
+	u32 sent;
+	u32 dropped;
+} Link;
+
+typedef struct
+{
+	tic80_netplay stats;
+	u32 sent;
+	u32 dropped;
+	u32 ticks;
+	double tickMax;		// ms, the slowest tick
+	double rollbackMax;	// ms, the slowest tick which re-simulated at least 5 frames
+	u32 deepest;		// frames re-simulated in one tick
+	bool finished;
+} Result;
+
+static u64 getMicroseconds()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (u64)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void queuePacket(void* data, s32 peer, const void* packet, s32 size)
+{
+	Link* link = data;
+
+	if(rand() % 100 < Opts.loss || link->count == MaxQueue || size > MaxPacket)
+	{
+		link->dropped++;
+		return;
+	}
+
+	Packet* item = &link->queue[link->count++];
+	s32 delay = Opts.latency + (Opts.jitter ? rand() % (Opts.jitter * 2 + 1) - Opts.jitter : 0);
+
+	item->due = getMicroseconds() + (delay > 0 ? delay : 0) * 1000;
+	item->peer = peer;
+	item->size = size;
+	memcpy(item->data, packet, size);
+}
+
+// jitter lets packets overtake each other, like on a real network
+static void flushPackets(Link* link)
+{
+	u64 now = getMicroseconds();
+
+	for(s32 i = 0; i < link->count;)
+	{
+		Packet* item = &link->queue[i];
+
+		if(item->due <= now)
+		{
+			udpSend(link->socket, &link->addresses[item->peer], item->data, item->size);
+			link->sent++;
+			*item = link->queue[--link->count];
+		}
+		else i++;
+	}
+}
+
+static u8 scriptedPad(s32 peer, u32 tick)
+{
+	// buttons change every few frames, so predictions keep missing
+	u32 hash = ((tick / 6) * 2654435761u) ^ (peer * 40503u);
+	hash ^= hash >> 13;
+
+	return (u8)(hash * 2246822519u >> 24);
+}
+
+static void onError(const char* info)
+{
+	fprintf(stderr, "error: %s\n", info);
+}
+
+static Result runPeer(s32 local, const void* cart, s32 size)
+{
+	Result result = {0};
+	static Link link;
+
+	char address[32];
+	for(s32 i = 0; i < Opts.players + Opts.spectators; i++)
+	{
+		snprintf(address, sizeof address, "127.0.0.1:%i", Opts.port + i);
+		socketAddress(address, &link.addresses[i]);
+	}
+
+	snprintf(address, sizeof address, "127.0.0.1:%i", Opts.port + local);
+	link.socket = udpOpen(address);
+
+	if(link.socket < 0)
+	{
+		fprintf(stderr, "peer %i can't bind %s\n", local, address);
+		return result;
+	}
+
+	srand(local * 7919 + 1);
+
+	tic80* tic = tic80_create(TIC80_SAMPLERATE);
+	tic->callback.error = onError;
+	tic80_load(tic, (void*)cart, size);
+
+	tic80_netplay_config config =
+	{
+		.players = Opts.players,
+		.peers = Opts.players + Opts.spectators,
+		.local = local,
+		.delay = Opts.delay,
+		.rollback = Opts.rollback,
+		.send = queuePacket,
+		.data = &link,
+	};
+
+	tic80_netplay_start(tic, &config);
+
+	enum {FrameTime = 1000000 / TIC80_FRAMERATE};
+
+	u64 next = getMicroseconds();
+	u32 deadline = Opts.frames * 4 + TIC80_FRAMERATE * 10;
+	s32 linger = -1;
+
+	for(u32 tick = 0; tick < deadline && linger != 0; tick++)
+	{
+		u8 packet[MaxPacket];
+		s32 got;
+
+		while((got = udpRecv(link.socket, packet, sizeof packet)) > 0)
+			tic80_netplay_receive(tic, packet, got);
+
+		u32 resimulated = result.stats.resimulated;
+		u64 start = getMicroseconds();
+
+		tic80_netplay_tick(tic, (tic80_gamepad){.data = scriptedPad(local, tick)});
+
+		double ms = (getMicroseconds() - start) / 1000.0;
+
+		result.stats = tic80_netplay_stats(tic);
+		result.ticks++;
+
+		u32 depth = result.stats.resimulated - resimulated;
+
+		if(ms > result.tickMax) result.tickMax = ms;
+		if(depth > result.deepest) result.deepest = depth;
+		if(depth >= 5 && ms > result.rollbackMax) result.rollbackMax = ms;
+
+		// a rollback could bring the RAM back, so it is poked on every tick
+		if(local == 1 && Opts.corrupt >= 0 && result.stats.frame >= (u32)Opts.corrupt)
+			((tic80_local*)tic)->memory->ram.persistent.data[0] = 0xbadc0de;
+
+		// keep answering for a while, the others may still miss some input
+		if(linger < 0 && result.stats.synced >= (u32)Opts.frames)
+			linger = Linger;
+		else if(linger > 0)
+			linger--;
+
+		flushPackets(&link);
+
+		next += FrameTime;
+		u64 now = getMicroseconds();
+
+		if(next > now)
+			usleep(next - now);
+		else next = now;
+	}
+
+	result.finished = linger == 0;
+	result.sent = link.sent;
+	result.dropped = link.dropped;
+
+	tic80_delete(tic);
+	socketClose(link.socket);
+
+	return result;
+}
+
+static void writeResult(FILE* file, s32 peer, const Result* r, bool last)
+{
+	fprintf(file, "\t\t{\"peer\": %i, \"spectator\": %s, \"finished\": %s, \"frame\": %u, \"synced\": %u, "
+		"\"rollbacks\": %u, \"resimulated\": %u, \"deepest\": %u, \"stalls\": %u, \"desync\": %i, "
+		"\"tick_max_ms\": %.3f, \"rollback5_max_ms\": %.3f, \"sent\": %u, \"dropped\": %u}%s\n",
+		peer, peer >= Opts.players ? "true" : "false", r->finished ? "true" : "false",
+		r->stats.frame, r->stats.synced, r->stats.rollbacks, r->stats.resimulated, r->deepest,
+		r->stats.stalls, r->stats.desync, r->tickMax, r->rollbackMax, r->sent, r->dropped, last ? "" : ",");
+}
+
+static void* loadCart(s32* size)
+{
+	if(Opts.cart)
+	{
+		FILE* file = fopen(Opts.cart, "rb");
+
+		if(!file) return NULL;
+
+		fseek(file, 0, SEEK_END);
+		*size = (s32)ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		void* data = malloc(*size);
+
+		if(data && fread(data, 1, *size, file) != (size_t)*size)
+		{
+			free(data);
+			data = NULL;
+		}
+
+		fclose(file);
+
+		return data;
+	}
+
+	tic_mem* tic = tic_create(TIC80_SAMPLERATE);
+	strcpy(tic->cart->code.data, DefaultCart);
+
+	void* data = malloc(TIC_CART_SAVE_SIZE);
+	*size = tic->api.save(tic->cart, data);
+
+	tic_close(tic);
+
+	return data;
+}
+
+static void usage()
+{
+	printf("usage: netplaysim [-p players] [-s spectators] [-n frames] [-d delay] [-r rollback]\n"
+		"\t[-l latency ms] [-j jitter ms] [-x loss %%] [-P port] [-k corrupt frame] [-c cart.tic] [-o out.json]\n");
+}
+
+int main(int argc, char** argv)
+{
+	for(s32 i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if(!value || arg[0] != '-' || strlen(arg) != 2)
+		{
+			usage();
+			return 1;
+		}
+
+		switch(arg[1])
+		{
+		case 'p': Opts.players = atoi(value); break;
+		case 's': Opts.spectators = atoi(value); break;
+		case 'n': Opts.frames = atoi(value); break;
+		case 'd': Opts.delay = atoi(value); break;
+		case 'r': Opts.rollback = atoi(value); break;
+		case 'l': Opts.latency = atoi(value); break;
+		case 'j': Opts.jitter = atoi(value); break;
+		case 'x': Opts.loss = atoi(value); break;
+		case 'P': Opts.port = atoi(value); break;
+		case 'k': Opts.corrupt = atoi(value); break;
+		case 'c': Opts.cart = value; break;
+		case 'o': Opts.output = value; break;
+		default: usage(); return 1;
+		}
+
+		i++;
+	}
+
+	s32 peers = Opts.players + Opts.spectators;
+
+	if(Opts.players < 2 || Opts.players > TIC_NETPLAY_PLAYERS || peers > TIC_NETPLAY_PEERS)
+	{
+		fprintf(stderr, "2 to %i players and up to %i peers\n", TIC_NETPLAY_PLAYERS, TIC_NETPLAY_PEERS);
+		return 1;
+	}
+
+	s32 size = 0;
+	void* cart = loadCart(&size);
+
+	if(!cart)
+	{
+		fprintf(stderr, "can't load the cart\n");
+		return 1;
+	}
+
+	s32 pipes[TIC_NETPLAY_PEERS][2];
+	pid_t pids[TIC_NETPLAY_PEERS];
+
+	for(s32 i = 0; i < peers; i++)
+	{
+		if(pipe(pipes[i]) != 0 || (pids[i] = fork()) < 0)
+		{
+			perror("netplaysim");
+			return 1;
+		}
+
+		if(pids[i] == 0)
+		{
+			close(pipes[i][0]);
+
+			Result result = runPeer(i, cart, size);
+
+			_exit(write(pipes[i][1], &result, sizeof result) == sizeof result ? 0 : 1);
+		}
+
+		close(pipes[i][1]);
+	}
+
+	Result results[TIC_NETPLAY_PEERS];
+	bool failed = false;
+	bool caught = false;
+
+	for(s32 i = 0; i < peers; i++)
+	{
+		if(read(pipes[i][0], &results[i], sizeof(Result)) != sizeof(Result))
+			memset(&results[i], 0, sizeof(Result));
+
+		waitpid(pids[i], NULL, 0);
+		close(pipes[i][0]);
+
+		if(!results[i].finished)
+			failed = true;
+
+		if(results[i].stats.desync >= 0)
+			caught = true;
+	}
+
+	FILE* file = Opts.output ? fopen(Opts.output, "w") : stdout;
+
+	if(file)
+	{
+		fprintf(file, "{\n\t\"players\": %i, \"spectators\": %i, \"frames\": %i, \"delay\": %i, \"rollback\": %i,\n"
+			"\t\"latency\": %i, \"jitter\": %i, \"loss\": %i,\n\t\"peers\": [\n",
+			Opts.players, Opts.spectators, Opts.frames, Opts.delay, Opts.rollback,
+			Opts.latency, Opts.jitter, Opts.loss);
+
+		for(s32 i = 0; i < peers; i++)
+			writeResult(file, i, &results[i], i == peers - 1);
+
+		fprintf(file, "\t]\n}\n");
+
+		if(file != stdout)
+			fclose(file);
+	}
+
+	free(cart);
+
+	// a corrupted run has to be caught, a clean one must never be
+	if(Opts.corrupt >= 0 ? !caught : caught || failed)
+	{
+		fprintf(stderr, Opts.corrupt >= 0 ? "desync went unnoticed\n" : caught ? "desync\n" : "a peer got stuck\n");
+		return 1;
+	}
+
+	return 0;
+}
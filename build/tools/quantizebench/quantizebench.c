@@ -0,0 +1,178 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "tools.h"
+
+// checks that the quantizer table gives what the exact palette search gives for every color,
+// with RGB and OKLab distance, then times the import of a cover sized image with each dithering
+
+static struct
+{
+	s32 step;
+	s32 runs;
+} Opts = {1, 10};
+
+static const u8 DB16[] = {0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6};
+
+enum {Palettes = 5, Width = TIC80_WIDTH, Height = TIC80_HEIGHT};
+
+static const char* PaletteNames[Palettes] = {"db16", "grey", "random", "duplicates", "close"};
+
+static void makePalette(s32 index, tic_rgb* palette)
+{
+	srand(index);
+
+	for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+	{
+		switch(index)
+		{
+		case 0: memcpy(&palette[i], DB16 + i * 3, sizeof(tic_rgb)); break;
+		case 1: palette[i] = (tic_rgb){i * 17, i * 17, i * 17}; break;
+		// a few colors a step apart put the boundaries inside most cells
+		case 4: palette[i] = (tic_rgb){0x80 + (i & 1), 0x80 + (i >> 1 & 1), 0x80 + (i >> 2)}; break;
+		default: palette[i] = (tic_rgb){rand() & 0xff, rand() & 0xff, rand() & 0xff}; break;
+		}
+	}
+
+	if(index == 3)
+		for(s32 i = 8; i < TIC_PALETTE_SIZE; i++)
+			palette[i] = palette[i - 8];
+}
+
+static s32 checkColors(tic_quantizer* quantizer)
+{
+	s32 errors = 0;
+
+	for(u32 i = 0; i < 1 << 24; i += Opts.step)
+	{
+		const tic_rgb color = {i >> 16, i >> 8 & 0xff, i & 0xff};
+
+		if(tic_tool_quantizer_find(quantizer, &color) != tic_tool_quantizer_search(quantizer, &color))
+			errors++;
+	}
+
+	return errors;
+}
+
+// palette colors are left as they are, so the dithering error never spreads
+static s32 checkImage(tic_quantizer* quantizer, const tic_rgb* palette, const tic_rgb* image, u8* colors)
+{
+	s32 errors = 0;
+
+	tic_tool_quantize(quantizer, image, colors, Width, Height, tic_dither_none);
+
+	for(s32 i = 0; i < Width * Height; i++)
+		if(colors[i] != tic_tool_quantizer_search(quantizer, &image[i]))
+			errors++;
+
+	tic_rgb* exact = malloc(Width * Height * sizeof(tic_rgb));
+
+	for(s32 i = 0; i < Width * Height; i++)
+		exact[i] = palette[i % TIC_PALETTE_SIZE];
+
+	tic_tool_quantize(quantizer, exact, colors, Width, Height, tic_dither_floyd_steinberg);
+
+	for(s32 i = 0; i < Width * Height; i++)
+		if(colors[i] != tic_tool_quantizer_search(quantizer, &exact[i]))
+			errors++;
+
+	free(exact);
+
+	return errors;
+}
+
+static void makeImage(tic_rgb* image)
+{
+	for(s32 y = 0; y < Height; y++)
+		for(s32 x = 0; x < Width; x++)
+			image[x + y * Width] = (tic_rgb){x * 255 / (Width - 1), y * 255 / (Height - 1), (x + y) & 0xff};
+}
+
+static void usage()
+{
+	printf("usage: quantizebench [-s color step] [-n runs]\n");
+}
+
+int main(int argc, char** argv)
+{
+	for(s32 i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if(!value || arg[0] != '-' || strlen(arg) != 2)
+		{
+			usage();
+			return 1;
+		}
+
+		switch(arg[1])
+		{
+		case 's': Opts.step = MAX(atoi(value), 1); break;
+		case 'n': Opts.runs = MAX(atoi(value), 1); break;
+		default: usage(); return 1;
+		}
+
+		i++;
+	}
+
+	static const char* DitherNames[] = {"none", "ordered", "floyd-steinberg"};
+
+	tic_rgb* image = malloc(Width * Height * sizeof(tic_rgb));
+	u8* colors = malloc(Width * Height);
+	makeImage(image);
+
+	s32 failed = 0;
+
+	printf("%-12s %-6s %10s %10s", "palette", "dist", "build us", "errors");
+	for(s32 d = 0; d < COUNT_OF(DitherNames); d++)
+		printf(" %16s", DitherNames[d]);
+	printf("\n");
+
+	for(s32 p = 0; p < Palettes; p++)
+	{
+		tic_rgb palette[TIC_PALETTE_SIZE];
+		makePalette(p, palette);
+
+		for(s32 perceptual = 0; perceptual < 2; perceptual++)
+		{
+			u64 start = tic_tool_get_microseconds();
+			tic_quantizer* quantizer = tic_tool_quantizer_create(palette, perceptual);
+			u64 build = tic_tool_get_microseconds() - start;
+
+			if(!quantizer)
+			{
+				fprintf(stderr, "out of memory\n");
+				return 1;
+			}
+
+			s32 errors = checkColors(quantizer) + checkImage(quantizer, palette, image, colors);
+			failed += errors;
+
+			printf("%-12s %-6s %10llu %10i", PaletteNames[p], perceptual ? "oklab" : "rgb", (unsigned long long)build, errors);
+
+			for(s32 d = 0; d < COUNT_OF(DitherNames); d++)
+			{
+				start = tic_tool_get_microseconds();
+
+				for(s32 r = 0; r < Opts.runs; r++)
+					tic_tool_quantize(quantizer, image, colors, Width, Height, d);
+
+				printf(" %13lluus", (unsigned long long)((tic_tool_get_microseconds() - start) / Opts.runs));
+			}
+
+			printf("\n");
+
+			tic_tool_quantizer_free(quantizer);
+		}
+	}
+
+	free(image);
+	free(colors);
+
+	if(failed)
+		printf("%i colors differ from the exact search\n", failed);
+
+	return failed ? 1 : 0;
+}
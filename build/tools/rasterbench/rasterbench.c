@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+
+// the same palette split and wavy scroll done with SCN() and with raster()
+
+static const char ScanlineCart[] =
+	"-- script: lua\n"
+	"t=0\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,15 do rect(i*15,0,15,136,i) end\n"
+	" t=t+1\n"
+	"end\n"
+	"function SCN(row)\n"
+	" if row==0 then poke(0x3fc0,0) poke(0x3fc1,0) poke(0x3fc2,0) end\n"
+	" if row==68 then poke(0x3fc0,255) poke(0x3fc1,0) poke(0x3fc2,0) end\n"
+	" poke(0x3ff9,math.floor(math.sin((row+t)/8)*4))\n"
+	"end\n";
+
+static const char RasterCart[] =
+	"-- script: lua\n"
+	"t=0\n"
+	"wave={}\n"
+	"raster(0x3fc0,255,68) raster(0x3fc1,0,68) raster(0x3fc2,0,68)\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,15 do rect(i*15,0,15,136,i) end\n"
+	" for row=0,135 do wave[row+1]=math.floor(math.sin((row+t)/8)*4)%256 end\n"
+	" raster(0x3ff9,wave)\n"
+	" t=t+1\n"
+	"end\n";
+
+static double run(const char* code, s32 frames)
+{
+	tic_mem* tic = bench_create(code, NULL);
+
+	tic_tick_data data = bench_tick_data(NULL);
+	double us = bench_run(tic, frames, true, &data);
+
+	tic_close(tic);
+
+	return us;
+}
+
+int main(int argc, char** argv)
+{
+	s32 frames = argc > 1 ? atoi(argv[1]) : 1000;
+
+	if(frames > 0)
+	{
+		double scanline = run(ScanlineCart, frames);
+		double raster = run(RasterCart, frames);
+
+		printf("SCN():    %.1f us/frame\n", scanline);
+		printf("raster(): %.1f us/frame\n", raster);
+		printf("speedup:  %.2fx\n", scanline / raster);
+
+		return 0;
+	}
+
+	printf("usage: rasterbench [frames]\n");
+
+	return -1;
+}
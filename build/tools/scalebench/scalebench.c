@@ -0,0 +1,308 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "machine.h"
+#include "scale.h"
+
+// renders a fixed frame with raster palette and scroll changes and an OVR layer,
+// scales it every way and compares the hashes with golden ones, no GPU needed
+
+typedef struct
+{
+	s32 scale;
+	tic80_scale_filter filter;
+	u8 scanlines;
+	u8 mask;
+	bool border;
+} Case;
+
+static const Case Cases[] =
+{
+	{1, TIC80_SCALE_NEAREST, 0, 0, true},
+	{1, TIC80_SCALE_NEAREST, 0, 0, false},
+	{2, TIC80_SCALE_NEAREST, 0, 0, true},
+	{3, TIC80_SCALE_NEAREST, 0, 0, false},
+	{4, TIC80_SCALE_NEAREST, 0, 0, true},
+	{5, TIC80_SCALE_NEAREST, 0, 0, true},
+	{2, TIC80_SCALE_2X, 0, 0, true},
+	{4, TIC80_SCALE_2X, 0, 0, false},
+	{3, TIC80_SCALE_3X, 0, 0, true},
+	{6, TIC80_SCALE_3X, 0, 0, true},
+	{2, TIC80_SCALE_NEAREST, 128, 0, true},
+	{3, TIC80_SCALE_NEAREST, 96, 64, true},
+	{4, TIC80_SCALE_2X, 96, 64, false},
+	{3, TIC80_SCALE_3X, 64, 96, true},
+};
+
+static const struct {tic80_pixel_color_format format; const char* name;} Formats[] =
+{
+	{TIC80_PIXEL_COLOR_ABGR8888, "abgr8888"},
+	{TIC80_PIXEL_COLOR_XRGB8888, "xrgb8888"},
+	{TIC80_PIXEL_COLOR_RGB565, "rgb565"},
+};
+
+static const char* FilterNames[] = {"nearest", "scale2x", "scale3x"};
+
+enum {Pad = 12};
+
+static struct
+{
+	const char* golden;
+	const char* update;
+	const char* images;
+	s32 runs;
+} Opts = {NULL, NULL, NULL, 100};
+
+static void ovrPixel(tic_machine* machine, s32 x, s32 y, u8 color)
+{
+	s32 index = y * TIC80_WIDTH + x;
+
+	tic_tool_poke4(machine->state.ovr.data, index, color);
+	machine->state.ovr.mask[index >> 3] |= 1 << (index & 7);
+}
+
+static void overline(tic_mem* tic, void* data)
+{
+	tic_machine* machine = (tic_machine*)tic;
+
+	for(s32 i = 0; i < 60; i++)
+	{
+		ovrPixel(machine, 150 + i, 20 + i, 1 + i % 15);
+		ovrPixel(machine, 151 + i, 20 + i, 1 + i % 15);
+	}
+
+	for(s32 y = 100; y < 120; y++)
+		for(s32 x = 10; x < 40; x++)
+			if((x ^ y) & 4)
+				ovrPixel(machine, x, y, 12);
+}
+
+static void scanline(tic_mem* tic, s32 row, void* data)
+{
+	tic->ram.vram.vars.border = row < 68 ? 1 : 9;
+}
+
+static void drawFrame(tic_mem* tic)
+{
+	static const u8 Sweetie[] = 
+	{
+		0x1a, 0x1c, 0x2c, 0x5d, 0x27, 0x5d, 0xb1, 0x3e, 0x53, 0xef, 0x7d, 0x57, 
+		0xff, 0xcd, 0x75, 0xa7, 0xf0, 0x70, 0x38, 0xb7, 0x64, 0x25, 0x71, 0x79, 
+		0x29, 0x36, 0x6f, 0x3b, 0x5d, 0xc9, 0x41, 0xa6, 0xf6, 0x73, 0xef, 0xf7, 
+		0xf4, 0xf4, 0xf4, 0x94, 0xb0, 0xc2, 0x56, 0x6c, 0x86, 0x33, 0x3c, 0x57,
+	};
+
+	memcpy(tic->ram.vram.palette.data, Sweetie, sizeof Sweetie);
+
+	tic->api.clear(tic, 0);
+
+	for(s32 i = 0; i < 16; i++)
+		tic->api.rect(tic, i * 15, 0, 15, 8, i);
+
+	tic->api.circle(tic, 40, 50, 24, 6);
+	tic->api.circle_border(tic, 40, 50, 30, 12);
+	tic->api.tri(tic, 80, 90, 130, 20, 140, 100, 3);
+
+	for(s32 i = 0; i < 40; i++)
+		tic->api.line(tic, 150, 130, 150 + i * 2, 60, 4 + i % 12);
+
+	tic->api.text(tic, "TIC-80 SCALE 0123", 8, 124, 12, false);
+
+	// second half gets another background colour, a few rows scroll
+	tic->api.raster(tic, offsetof(tic_ram, vram.palette) + 0, 0x40, 68, TIC80_HEIGHT - 68);
+	tic->api.raster(tic, offsetof(tic_ram, vram.palette) + 2, 0x20, 68, TIC80_HEIGHT - 68);
+	tic->api.raster(tic, offsetof(tic_ram, vram.vars.offset.x), 3, 90, 10);
+
+	tic->api.blit(tic, scanline, overline, NULL);
+}
+
+static u32 hashPixels(const u8* pixels, s32 pitch, s32 rowBytes, s32 height)
+{
+	u32 hash = 2166136261u;
+
+	for(s32 y = 0; y < height; y++, pixels += pitch)
+		for(s32 x = 0; x < rowBytes; x++)
+			hash = (hash ^ pixels[x]) * 16777619u;
+
+	return hash;
+}
+
+static void writeImage(const char* path, tic80_pixel_color_format format, const u8* pixels, s32 pitch, s32 width, s32 height)
+{
+	FILE* file = fopen(path, "wb");
+
+	if(!file) return;
+
+	fprintf(file, "P6\n%i %i\n255\n", width, height);
+
+	for(s32 y = 0; y < height; y++, pixels += pitch)
+		for(s32 x = 0; x < width; x++)
+		{
+			u8 rgb[3];
+
+			if(format == TIC80_PIXEL_COLOR_RGB565)
+			{
+				u16 c = ((const u16*)pixels)[x];
+				rgb[0] = (c >> 11) << 3, rgb[1] = (c >> 5 & 0x3f) << 2, rgb[2] = (c & 0x1f) << 3;
+			}
+			else if(format == TIC80_PIXEL_COLOR_XRGB8888)
+			{
+				u32 c = ((const u32*)pixels)[x];
+				rgb[0] = c >> 16, rgb[1] = c >> 8, rgb[2] = c;
+			}
+			else memcpy(rgb, pixels + x * sizeof(u32), sizeof rgb);
+
+			fwrite(rgb, sizeof rgb, 1, file);
+		}
+
+	fclose(file);
+}
+
+static bool findGolden(FILE* file, const char* name, u32* hash)
+{
+	char line[256], key[128];
+	u32 value;
+
+	rewind(file);
+
+	while(fgets(line, sizeof line, file))
+		if(sscanf(line, "%127s %x", key, &value) == 2 && strcmp(key, name) == 0)
+		{
+			*hash = value;
+			return true;
+		}
+
+	return false;
+}
+
+// scale 1 with the border has to be what the blit draws
+static bool checkBlit(tic_mem* tic, const tic_indexed_frame* frame, tic80_pixel_color_format format, u8* pixels)
+{
+	const tic80_scale config = {1, TIC80_SCALE_NEAREST, 0, 0, true};
+	s32 size = format == TIC80_PIXEL_COLOR_RGB565 ? sizeof(u16) : sizeof(u32);
+
+	tic_output(tic, format, NULL, 0);
+	drawFrame(tic);
+	tic_scale(frame, &config, format, pixels, TIC80_FULLWIDTH * size);
+
+	return memcmp(pixels, tic->screen, TIC80_FULLWIDTH * TIC80_FULLHEIGHT * size) == 0;
+}
+
+static void usage()
+{
+	printf("usage: scalebench [-g golden.txt] [-u golden.txt] [-i image dir] [-n runs]\n");
+}
+
+int main(int argc, char** argv)
+{
+	for(s32 i = 1; i < argc; i++)
+	{
+		const char* arg = argv[i];
+		const char* value = i + 1 < argc ? argv[i + 1] : NULL;
+
+		if(!value || arg[0] != '-' || strlen(arg) != 2)
+		{
+			usage();
+			return 1;
+		}
+
+		switch(arg[1])
+		{
+		case 'g': Opts.golden = value; break;
+		case 'u': Opts.update = value; break;
+		case 'i': Opts.images = value; break;
+		case 'n': Opts.runs = atoi(value); break;
+		default: usage(); return 1;
+		}
+
+		i++;
+	}
+
+	FILE* golden = Opts.golden ? fopen(Opts.golden, "r") : NULL;
+	FILE* update = Opts.update ? fopen(Opts.update, "w") : NULL;
+
+	if((Opts.golden && !golden) || (Opts.update && !update))
+	{
+		fprintf(stderr, "can't open the golden file\n");
+		return 1;
+	}
+
+	tic_mem* tic = tic_create(44100);
+	tic_indexed_frame* frame = malloc(sizeof(tic_indexed_frame));
+	enum {MaxSize = (TIC80_FULLWIDTH * TIC80_SCALE_MAX * sizeof(u32) + Pad) * TIC80_FULLHEIGHT * TIC80_SCALE_MAX};
+	u8* pixels = malloc(MaxSize);
+
+	tic_output_indexed(tic, frame, false);
+
+	s32 failed = 0;
+
+	for(s32 f = 0; f < COUNT_OF(Formats); f++)
+	{
+		if(!checkBlit(tic, frame, Formats[f].format, pixels))
+		{
+			printf("%s: scale 1 differs from the blit\n", Formats[f].name);
+			failed++;
+		}
+
+		for(s32 c = 0; c < COUNT_OF(Cases); c++)
+		{
+			const Case* test = &Cases[c];
+			const tic80_scale config = {test->scale, test->filter, test->scanlines, test->mask, test->border};
+			const s32 size = Formats[f].format == TIC80_PIXEL_COLOR_RGB565 ? sizeof(u16) : sizeof(u32);
+			const s32 width = tic_scale_width(&config), height = tic_scale_height(&config);
+			const s32 pitch = width * size + Pad;
+
+			char name[128];
+			snprintf(name, sizeof name, "%s-%ix-%s%s%s", Formats[f].name, test->scale, FilterNames[test->filter],
+				test->scanlines || test->mask ? "-crt" : "", test->border ? "-border" : "");
+
+			clock_t start = clock();
+
+			for(s32 r = 0; r < Opts.runs; r++)
+				tic_scale(frame, &config, Formats[f].format, pixels, pitch);
+
+			double us = Opts.runs ? (double)(clock() - start) * 1000000 / CLOCKS_PER_SEC / Opts.runs : 0;
+
+			memset(pixels, 0, MaxSize);
+			tic_scale(frame, &config, Formats[f].format, pixels, pitch);
+
+			u32 hash = hashPixels(pixels, pitch, width * size, height);
+			u32 expected = 0;
+
+			const char* status = "";
+
+			if(golden)
+			{
+				if(!findGolden(golden, name, &expected))
+					status = " MISSING", failed++;
+				else if(expected != hash)
+					status = " FAILED", failed++;
+			}
+
+			printf("%-36s %4ix%-4i %08x %8.1f us%s\n", name, width, height, hash, us, status);
+
+			if(update)
+				fprintf(update, "%s %08x\n", name, hash);
+
+			if(Opts.images)
+			{
+				char path[1024];
+				snprintf(path, sizeof path, "%s/%s.ppm", Opts.images, name);
+				writeImage(path, Formats[f].format, pixels, pitch, width, height);
+			}
+		}
+	}
+
+	if(golden) fclose(golden);
+	if(update) fclose(update);
+
+	free(pixels);
+	free(frame);
+	tic_close(tic);
+
+	printf("%s\n", failed ? "FAILED" : "OK");
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "system.h"
+
+// starts the studio with the given arguments and reports how long that took
+// and how much resident memory it needed, then does the same for a few frames
+
+enum {MaxArgs = 32};
+
+static u64 getMicroseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+// resident set in KB, 0 where /proc is not available
+static u32 getResident()
+{
+	u32 pages = 0;
+	FILE* file = fopen("/proc/self/statm", "r");
+
+	if(file)
+	{
+		if(fscanf(file, "%*u %u", &pages) != 1)
+			pages = 0;
+
+		fclose(file);
+	}
+
+	return pages * (u32)(sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void setClipboardText(const char* text) {}
+static bool hasClipboardText() {return false;}
+static char* getClipboardText() {return NULL;}
+static void freeClipboardText(const char* text) {}
+static u64 getPerformanceCounter() {return getMicroseconds();}
+static u64 getPerformanceFrequency() {return 1000000;}
+static void* getUrlRequest(const char* url, s32* size) {return NULL;}
+static void fileDialogLoad(file_dialog_load_callback callback, void* data) {}
+static void fileDialogSave(file_dialog_save_callback callback, const char* name, const u8* buffer, size_t size, void* data, u32 mode) {}
+static void goFullscreen() {}
+static void showMessageBox(const char* title, const char* message) {}
+static void setWindowTitle(const char* title) {}
+static void openSystemPath(const char* path) {}
+static void preseed() {}
+static void poll() {}
+static void updateConfig() {}
+
+static System BenchSystem =
+{
+	.setClipboardText = setClipboardText,
+	.hasClipboardText = hasClipboardText,
+	.getClipboardText = getClipboardText,
+	.freeClipboardText = freeClipboardText,
+	.getPerformanceCounter = getPerformanceCounter,
+	.getPerformanceFrequency = getPerformanceFrequency,
+	.getUrlRequest = getUrlRequest,
+	.fileDialogLoad = fileDialogLoad,
+	.fileDialogSave = fileDialogSave,
+	.goFullscreen = goFullscreen,
+	.showMessageBox = showMessageBox,
+	.setWindowTitle = setWindowTitle,
+	.openSystemPath = openSystemPath,
+	.preseed = preseed,
+	.poll = poll,
+	.updateConfig = updateConfig,
+};
+
+int main(int argc, char** argv)
+{
+	const char* folder = "./";
+	s32 frames = 60;
+
+	char* args[MaxArgs] = {"tic80"};
+	s32 count = 1;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(i + 1 < argc && strcmp(argv[i], "-d") == 0) folder = argv[++i];
+		else if(i + 1 < argc && strcmp(argv[i], "-n") == 0) frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "--") == 0)
+		{
+			while(++i < argc && count < MaxArgs)
+				args[count++] = argv[i];
+		}
+		else
+		{
+			printf("usage: studiobench [-d app folder] [-n frames] [-- studio arguments, e.g. cart.tic -skip]\n");
+			return -1;
+		}
+	}
+
+	u32 rssStart = getResident();
+	u64 start = getMicroseconds();
+
+	Studio* studio = studioInit(count, args, TIC80_SAMPLERATE, folder, &BenchSystem);
+
+	u64 init = getMicroseconds() - start;
+	u32 rssInit = getResident();
+
+	start = getMicroseconds();
+
+	for(s32 i = 0; i < frames && !studio->quit; i++)
+		studio->tick();
+
+	u64 ticks = getMicroseconds() - start;
+	u32 rssFrames = getResident();
+
+	studio->close();
+
+	fprintf(stderr, "init %12llu us %8u KB\n", (unsigned long long)init, rssInit - rssStart);
+	fprintf(stderr, "%-4i frames %6llu us %8u KB\n", frames, (unsigned long long)ticks, rssFrames - rssStart);
+
+	printf("{\n\t\"init_us\": %llu,\n\t\"init_kb\": %u,\n\t\"frames\": %i,\n\t\"frames_us\": %llu,\n\t\"frames_kb\": %u\n}\n",
+		(unsigned long long)init, rssInit - rssStart, frames, (unsigned long long)ticks, rssFrames - rssStart);
+
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "machine.h"
+
+// a cart flipping map and tile banks every frame, with sync() switching them by pointer and
+// with every switched section copied into ram the way sync() used to
+
+enum {Banks = 4};
+
+static void fillCart(tic_cartridge* cart)
+{
+	for(s32 b = 0; b < Banks; b++)
+	{
+		tic_bank* bank = &cart->banks[b];
+
+		for(s32 i = 0; i < sizeof bank->map.data; i++)
+			bank->map.data[i] = (u8)(i * 7 + b * 31);
+
+		for(s32 i = 0; i < sizeof bank->tiles; i++)
+			((u8*)&bank->tiles)[i] = (u8)(i * 13 + b);
+
+		memcpy(&bank->sprites, &bank->tiles, sizeof bank->sprites);
+	}
+}
+
+static u32 hashScreen(const tic_mem* tic)
+{
+	u32 hash = 2166136261u;
+
+	for(s32 i = 0; i < TIC80_FULLWIDTH * TIC80_FULLHEIGHT; i++)
+		hash = (hash ^ tic->screen[i]) * 16777619u;
+
+	return hash;
+}
+
+static double run(bool copy, bool draw, s32 frames, u32* hash)
+{
+	tic_mem* tic = tic_create(44100);
+	fillCart(tic->cart);
+
+	enum {Tiles = 1 << 0, Sprites = 1 << 1, Map = 1 << 2};
+
+	*hash = 2166136261u;
+	clock_t start = clock();
+
+	for(s32 i = 0; i < frames; i++)
+	{
+		// sync() only switches once per frame
+		((tic_machine*)tic)->state.synced = 0;
+
+		tic->api.sync(tic, Tiles | Sprites | Map, i % Banks, false);
+
+		if(copy)
+			tic_ram_touch(tic, offsetof(tic_ram, tiles), offsetof(tic_ram, map) + sizeof(tic_map));
+
+		if(draw)
+		{
+			tic->api.clear(tic, 0);
+			tic->api.map(tic, &tic->ram.map, &tic->ram.tiles, i % 16, 0, 30, 17, 0, 0, -1, 1);
+			tic->api.sprite_ex(tic, &tic->ram.sprites, i % 256, 100, 60, 2, 2, NULL, 0, 1, tic_no_flip, tic_no_rotate);
+			tic->api.blit(tic, NULL, NULL, NULL);
+
+			*hash = (*hash ^ hashScreen(tic)) * 16777619u;
+		}
+		else *hash ^= tic->api.map_get(tic, &tic->ram.map, i % TIC_MAP_WIDTH, 0);
+	}
+
+	double us = (double)(clock() - start) * 1000000 / CLOCKS_PER_SEC / frames;
+
+	tic_close(tic);
+
+	return us;
+}
+
+int main(int argc, char** argv)
+{
+	s32 frames = argc > 1 ? atoi(argv[1]) : 1000;
+
+	if(frames > 0)
+	{
+		u32 copyHash, viewHash;
+
+		for(s32 draw = 0; draw < 2; draw++)
+		{
+			double copy = run(true, draw, frames, &copyHash);
+			double view = run(false, draw, frames, &viewHash);
+
+			printf("%s\n", draw ? "switch, map and blit:" : "switch only:");
+			printf("  memcpy:  %.2f us/frame\n", copy);
+			printf("  pointer: %.2f us/frame\n", view);
+			printf("  speedup: %.2fx\n", copy / view);
+
+			if(copyHash != viewHash)
+			{
+				printf("frames differ\n");
+				return -1;
+			}
+		}
+
+		return 0;
+	}
+
+	printf("usage: syncbench [frames]\n");
+
+	return -1;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "cart.h"
+
+// a screen full of print() in each of the text modes
+
+static const char ProportionalCart[] =
+	"-- script: lua\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,21 do print('The quick brown fox jumps over the lazy dog 0123456789',0,i*6,i%15+1) end\n"
+	"end\n";
+
+static const char FixedCart[] =
+	"-- script: lua\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,21 do print('The quick brown fox jumps over the lazy dog',0,i*6,i%15+1,true) end\n"
+	"end\n";
+
+static const char SmallCart[] =
+	"-- script: lua\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,21 do print('The quick brown fox jumps over the lazy dog 0123456789 !?',0,i*6,i%15+1,false,1,true) end\n"
+	"end\n";
+
+static const char ScaledCart[] =
+	"-- script: lua\n"
+	"function TIC()\n"
+	" cls(0)\n"
+	" for i=0,10 do print('The quick brown fox',0,i*12,i%15+1,false,2) end\n"
+	"end\n";
+
+// tic80_load() brings in the system font, so carts go through the public API
+static double run(const char* code, s32 frames)
+{
+	static u8 buffer[TIC_CART_SAVE_SIZE];
+
+	tic_mem* tic = bench_create(code, NULL);
+	s32 size = tic->api.save(tic->cart, buffer);
+	tic_close(tic);
+
+	tic80* player = tic80_create(44100);
+	tic80_load(player, buffer, size);
+
+	tic80_input input = {0};
+	clock_t start = clock();
+
+	for(s32 i = 0; i < frames; i++)
+		tic80_tick(player, input);
+
+	double us = bench_us_per_frame(start, frames);
+
+	tic80_delete(player);
+
+	return us;
+}
+
+int main(int argc, char** argv)
+{
+	s32 frames = argc > 1 ? atoi(argv[1]) : 1000;
+
+	if(frames > 0)
+	{
+		printf("proportional: %.1f us/frame\n", run(ProportionalCart, frames));
+		printf("fixed:        %.1f us/frame\n", run(FixedCart, frames));
+		printf("small font:   %.1f us/frame\n", run(SmallCart, frames));
+		printf("scale 2:      %.1f us/frame\n", run(ScaledCart, frames));
+
+		return 0;
+	}
+
+	printf("usage: textbench [frames]\n");
+
+	return -1;
+}
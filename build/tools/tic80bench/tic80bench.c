@@ -0,0 +1,545 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+
+// times every tic_api entry point and writes ns/op as JSON,
+// optionally failing when a run is slower than a baseline JSON
+
+static const char WorkloadCart[] =
+	"-- script: lua\n"
+	"t=0\n"
+	"function TIC() t=t+1 end\n"
+	"function SCN(row) end\n"
+	"function OVR() end\n";
+
+enum {RandomSize = 4096, MaxBenches = 256};
+
+static s32 Random[RandomSize];
+
+#define RND(I) Random[(I) & (RandomSize - 1)]
+
+typedef void(BenchFunc)(tic_mem* tic, s32 i, s32 arg);
+
+typedef struct
+{
+	char name[64];
+	BenchFunc* func;
+	s32 arg;
+	double ns;
+	s64 ops;
+} Bench;
+
+static Bench Benches[MaxBenches];
+static s32 BenchCount = 0;
+
+static tic_cartridge MaxCart;
+static u8* MaxCartBuffer = NULL;
+static s32 MaxCartSize = 0;
+
+static tic_tick_data TickData;
+
+static void fillRandom(void* data, s32 size)
+{
+	for(u8* ptr = data, *end = ptr + size; ptr < end; ptr++)
+		*ptr = rand();
+}
+
+static void noScanline(tic_mem* tic, s32 row, void* data) {}
+static void noOverline(tic_mem* tic, void* data) {}
+
+static void remapTile(void* data, s32 x, s32 y, RemapResult* result)
+{
+	result->index ^= 1;
+}
+
+static void fillCart(tic_cartridge* cart)
+{
+	srand(0);
+
+	for(s32 i = 0; i < TIC_BANKS; i++)
+	{
+		tic_bank* bank = &cart->banks[i];
+
+		fillRandom(&bank->tiles, sizeof bank->tiles);
+		fillRandom(&bank->sprites, sizeof bank->sprites);
+		fillRandom(&bank->map, sizeof bank->map);
+		fillRandom(&bank->sfx, sizeof bank->sfx);
+		fillRandom(&bank->music, sizeof bank->music);
+		fillRandom(&bank->palette, sizeof bank->palette);
+		fillRandom(&bank->flags, sizeof bank->flags);
+	}
+}
+
+static tic_mem* createMachine()
+{
+	tic_mem* tic = bench_create(WorkloadCart, fillCart);
+
+	fillRandom(&tic->font, sizeof tic->font);
+	tic_font_touch(tic);
+
+	tic->api.sync(tic, -1, 0, false);
+
+	tic->api.tick_start(tic, &tic->ram.sfx, &tic->ram.music);
+	tic->api.tick(tic, &TickData);
+	tic->api.tick_end(tic);
+
+	// draw calls after tick_end go to OVR, benchmark the VRAM path
+	tic->api.tick_start(tic, &tic->ram.sfx, &tic->ram.music);
+
+	return tic;
+}
+
+static void benchDrawChar(tic_mem* tic, s32 i, s32 arg) {tic->api.draw_char(tic, 'A' + i % 26, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, i & 0xf, false);}
+static void benchText(tic_mem* tic, s32 i, s32 arg) {tic->api.text(tic, "The quick brown fox", RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, i & 0xf, false);}
+static void benchFixedText(tic_mem* tic, s32 i, s32 arg) {tic->api.fixed_text(tic, "The quick brown fox", RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, i & 0xf, false);}
+static void benchTextEx(tic_mem* tic, s32 i, s32 arg) {tic->api.text_ex(tic, "The quick brown fox", RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, i & 0xf, false, arg, false);}
+static void benchClear(tic_mem* tic, s32 i, s32 arg) {tic->api.clear(tic, i & 0xf);}
+static void benchPixel(tic_mem* tic, s32 i, s32 arg) {tic->api.pixel(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, i & 0xf);}
+static void benchGetPixel(tic_mem* tic, s32 i, s32 arg) {tic->api.get_pixel(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT);}
+static void benchLine(tic_mem* tic, s32 i, s32 arg) {tic->api.line(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, RND(i+2) % TIC80_WIDTH, RND(i+3) % TIC80_HEIGHT, i & 0xf);}
+static void benchRect(tic_mem* tic, s32 i, s32 arg) {tic->api.rect(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, RND(i+2) % arg, RND(i+3) % arg, i & 0xf);}
+static void benchRectBorder(tic_mem* tic, s32 i, s32 arg) {tic->api.rect_border(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, RND(i+2) % arg, RND(i+3) % arg, i & 0xf);}
+
+static void benchSprite(tic_mem* tic, s32 i, s32 arg)
+{
+	u8 colors[] = {0};
+	tic->api.sprite(tic, &tic->ram.tiles, i % TIC_BANK_SPRITES, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, colors, COUNT_OF(colors));
+}
+
+static void benchSpriteEx(tic_mem* tic, s32 i, s32 arg)
+{
+	u8 colors[] = {0};
+	s32 scale = arg >> 4;
+	tic->api.sprite_ex(tic, &tic->ram.tiles, i % TIC_BANK_SPRITES, RND(i) % TIC80_WIDTH - 8, RND(i+1) % TIC80_HEIGHT - 8, 1, 1, colors, COUNT_OF(colors), scale, arg & 0b11, arg >> 2 & 0b11);
+}
+
+static void benchGetFlag(tic_mem* tic, s32 i, s32 arg) {tic->api.get_flag(tic, i % TIC_BANK_SPRITES, i & 7);}
+static void benchSetFlag(tic_mem* tic, s32 i, s32 arg) {tic->api.set_flag(tic, i % TIC_BANK_SPRITES, i & 7, i & 8);}
+
+static void benchMap(tic_mem* tic, s32 i, s32 arg)
+{
+	tic->api.map(tic, &tic->ram.map, &tic->ram.tiles, i % TIC_MAP_WIDTH, 0, TIC_MAP_SCREEN_WIDTH + 1, TIC_MAP_SCREEN_HEIGHT + 1, -(i & 7), -(i & 7), 0, 1);
+}
+
+static void benchRemap(tic_mem* tic, s32 i, s32 arg)
+{
+	tic->api.remap(tic, &tic->ram.map, &tic->ram.tiles, i % TIC_MAP_WIDTH, 0, TIC_MAP_SCREEN_WIDTH + 1, TIC_MAP_SCREEN_HEIGHT + 1, -(i & 7), -(i & 7), 0, 1, remapTile, NULL);
+}
+
+// the map and flags are random, so about half the cells have flag 0 set
+
+static void benchMapRay(tic_mem* tic, s32 i, s32 arg)
+{
+	tic_map_hit hit;
+	float x = RND(i) % (TIC_MAP_WIDTH * TIC_SPRITESIZE), y = RND(i+1) % (TIC_MAP_HEIGHT * TIC_SPRITESIZE);
+	tic->api.map_ray(tic, &tic->ram.map, x, y, x + RND(i+2) % (arg * 2) - arg, y + RND(i+3) % (arg * 2) - arg, 1, &hit);
+}
+
+static void benchMapSweep(tic_mem* tic, s32 i, s32 arg)
+{
+	tic_map_hit hit;
+	float x = RND(i) % (TIC_MAP_WIDTH * TIC_SPRITESIZE), y = RND(i+1) % (TIC_MAP_HEIGHT * TIC_SPRITESIZE);
+	tic->api.map_sweep(tic, &tic->ram.map, x, y, 8, 8, RND(i+2) % (arg * 2) - arg, RND(i+3) % (arg * 2) - arg, 1, &hit);
+}
+
+// no mask puts every cell in one region, the whole map is counted
+static void benchMapFill(tic_mem* tic, s32 i, s32 arg) {tic->api.map_fill(tic, &tic->ram.map, RND(i) % TIC_MAP_WIDTH, RND(i+1) % TIC_MAP_HEIGHT, arg, -1);}
+
+static void benchMapPath(tic_mem* tic, s32 i, s32 arg)
+{
+	const u16* path;
+	s32 size = arg >> 1;
+	s32 x = RND(i) % TIC_MAP_WIDTH, y = RND(i+1) % TIC_MAP_HEIGHT;
+	tic->api.map_path(tic, &tic->ram.map, x, y, x + RND(i+2) % size, y + RND(i+3) % size, arg & 1, 0, &path);
+}
+
+static void benchMapSet(tic_mem* tic, s32 i, s32 arg) {tic->api.map_set(tic, &tic->ram.map, RND(i) % TIC_MAP_WIDTH, RND(i+1) % TIC_MAP_HEIGHT, i);}
+static void benchMapGet(tic_mem* tic, s32 i, s32 arg) {tic->api.map_get(tic, &tic->ram.map, RND(i) % TIC_MAP_WIDTH, RND(i+1) % TIC_MAP_HEIGHT);}
+static void benchCircle(tic_mem* tic, s32 i, s32 arg) {tic->api.circle(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, arg, i & 0xf);}
+static void benchCircleBorder(tic_mem* tic, s32 i, s32 arg) {tic->api.circle_border(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, arg, i & 0xf);}
+
+static void benchTri(tic_mem* tic, s32 i, s32 arg)
+{
+	s32 x = RND(i) % TIC80_WIDTH, y = RND(i+1) % TIC80_HEIGHT;
+	tic->api.tri(tic, x, y, x + RND(i+2) % arg, y + RND(i+3) % arg, x - RND(i+4) % arg, y + RND(i+5) % arg, i & 0xf);
+}
+
+static void benchTextri(tic_mem* tic, s32 i, s32 arg)
+{
+	s32 size = arg >> 1;
+	float x = RND(i) % TIC80_WIDTH, y = RND(i+1) % TIC80_HEIGHT;
+	tic->api.textri(tic, x, y, x + RND(i+2) % size, y + RND(i+3) % size, x - RND(i+4) % size, y + RND(i+5) % size,
+		0, 0, 64, 0, 0, 64, arg & 1, 0);
+}
+
+static void benchClip(tic_mem* tic, s32 i, s32 arg) {tic->api.clip(tic, RND(i) % TIC80_WIDTH, RND(i+1) % TIC80_HEIGHT, RND(i+2) % TIC80_WIDTH, RND(i+3) % TIC80_HEIGHT);}
+static void benchSfx(tic_mem* tic, s32 i, s32 arg) {tic->api.sfx(tic, i % SFX_COUNT, i % NOTES, i % OCTAVES, -1, i % TIC_SOUND_CHANNELS);}
+static void benchSfxStop(tic_mem* tic, s32 i, s32 arg) {tic->api.sfx_stop(tic, i % TIC_SOUND_CHANNELS);}
+static void benchSfxEx(tic_mem* tic, s32 i, s32 arg) {tic->api.sfx_ex(tic, i % SFX_COUNT, i % NOTES, i % OCTAVES, -1, i % TIC_SOUND_CHANNELS, MAX_VOLUME, 0);}
+static void benchSfxPos(tic_mem* tic, s32 i, s32 arg) {tic->api.sfx_pos(tic, i % TIC_SOUND_CHANNELS);}
+static void benchMusic(tic_mem* tic, s32 i, s32 arg) {tic->api.music(tic, i % MUSIC_TRACKS, 0, 0, true);}
+static void benchMusicFrame(tic_mem* tic, s32 i, s32 arg) {tic->api.music_frame(tic, 0, i % MUSIC_FRAMES, 0, true);}
+static void benchTime(tic_mem* tic, s32 i, s32 arg) {tic->api.time(tic);}
+static void benchTick(tic_mem* tic, s32 i, s32 arg) {tic->api.tick(tic, &TickData);}
+static void benchScanline(tic_mem* tic, s32 i, s32 arg) {tic->api.scanline(tic, i % TIC80_HEIGHT, NULL);}
+static void benchOverline(tic_mem* tic, s32 i, s32 arg) {tic->api.overline(tic, NULL);}
+static void benchRaster(tic_mem* tic, s32 i, s32 arg) {tic->api.raster(tic, 0x3fc0 + i % sizeof(tic_palette), i & 0xff, i % TIC80_HEIGHT, 1);}
+static void benchReset(tic_mem* tic, s32 i, s32 arg) {tic->api.reset(tic);}
+static void benchPause(tic_mem* tic, s32 i, s32 arg) {tic->api.pause(tic);}
+static void benchResume(tic_mem* tic, s32 i, s32 arg) {tic->api.resume(tic);}
+static void benchSync(tic_mem* tic, s32 i, s32 arg) {tic->api.sync(tic, -1, 0, false);}
+static void benchBtnp(tic_mem* tic, s32 i, s32 arg) {tic->api.btnp(tic, i & 31, 20, 5);}
+static void benchKey(tic_mem* tic, s32 i, s32 arg) {tic->api.key(tic, i % tic_keys_count);}
+static void benchKeyp(tic_mem* tic, s32 i, s32 arg) {tic->api.keyp(tic, i % tic_keys_count, 20, 5);}
+static void benchLoad(tic_mem* tic, s32 i, s32 arg) {tic->api.load(tic->cart, MaxCartBuffer, MaxCartSize);}
+static void benchSave(tic_mem* tic, s32 i, s32 arg) {tic->api.save(&MaxCart, MaxCartBuffer);}
+
+static void benchTickFrame(tic_mem* tic, s32 i, s32 arg)
+{
+	tic->api.tick_start(tic, &tic->ram.sfx, &tic->ram.music);
+	tic->api.tick_end(tic);
+	bench_next_frame();
+}
+
+static void benchBlit(tic_mem* tic, s32 i, s32 arg)
+{
+	switch(arg)
+	{
+	case 0: tic->api.blit(tic, NULL, NULL, NULL); break;
+	case 1: tic->api.blit(tic, noScanline, NULL, NULL); break;
+	case 2: tic->api.blit(tic, noScanline, noOverline, NULL); break;
+	default: tic->api.blit(tic, tic->api.scanline, tic->api.overline, NULL); break;
+	}
+}
+
+static void benchGetScriptConfig(tic_mem* tic, s32 i, s32 arg) {tic->api.get_script_config(tic);}
+
+static void addBench(const char* name, BenchFunc* func, s32 arg)
+{
+	if(BenchCount < MaxBenches)
+	{
+		Bench* bench = &Benches[BenchCount++];
+		snprintf(bench->name, sizeof bench->name, "%s", name);
+		bench->func = func;
+		bench->arg = arg;
+	}
+}
+
+static void initBenches()
+{
+	addBench("draw_char", benchDrawChar, 0);
+	addBench("text", benchText, 0);
+	addBench("fixed_text", benchFixedText, 0);
+	addBench("text_ex/scale1", benchTextEx, 1);
+	addBench("text_ex/scale3", benchTextEx, 3);
+	addBench("clear", benchClear, 0);
+	addBench("pixel", benchPixel, 0);
+	addBench("get_pixel", benchGetPixel, 0);
+	addBench("line", benchLine, 0);
+	addBench("rect/8", benchRect, 8);
+	addBench("rect/64", benchRect, 64);
+	addBench("rect_border/8", benchRectBorder, 8);
+	addBench("rect_border/64", benchRectBorder, 64);
+	addBench("sprite", benchSprite, 0);
+	addBench("get_flag", benchGetFlag, 0);
+	addBench("set_flag", benchSetFlag, 0);
+
+	{
+		static const s32 Scales[] = {1, 2, 4};
+
+		for(s32 s = 0; s < COUNT_OF(Scales); s++)
+			for(s32 rotate = tic_no_rotate; rotate <= tic_270_rotate; rotate++)
+				for(s32 flip = tic_no_flip; flip <= (tic_horz_flip | tic_vert_flip); flip++)
+				{
+					char name[64];
+					snprintf(name, sizeof name, "sprite_ex/flip%i/rotate%i/scale%i", flip, rotate * 90, Scales[s]);
+					addBench(name, benchSpriteEx, Scales[s] << 4 | rotate << 2 | flip);
+				}
+	}
+
+	addBench("map", benchMap, 0);
+	addBench("remap", benchRemap, 0);
+	addBench("map_set", benchMapSet, 0);
+	addBench("map_get", benchMapGet, 0);
+	addBench("map_ray/16", benchMapRay, 16);
+	addBench("map_ray/160", benchMapRay, 160);
+	addBench("map_sweep/8", benchMapSweep, 8);
+	addBench("map_sweep/64", benchMapSweep, 64);
+	addBench("map_fill", benchMapFill, 1);
+	addBench("map_fill/open", benchMapFill, 0);
+	addBench("map_path/16", benchMapPath, 16 << 1 | 1);
+	addBench("map_path/open/16", benchMapPath, 16 << 1);
+	addBench("map_path/open/64", benchMapPath, 64 << 1);
+	addBench("circle/4", benchCircle, 4);
+	addBench("circle/32", benchCircle, 32);
+	addBench("circle_border/4", benchCircleBorder, 4);
+	addBench("circle_border/32", benchCircleBorder, 32);
+	addBench("tri/8", benchTri, 8);
+	addBench("tri/64", benchTri, 64);
+	addBench("textri/8", benchTextri, 8 << 1);
+	addBench("textri/64", benchTextri, 64 << 1);
+	addBench("textri/8/map", benchTextri, 8 << 1 | 1);
+	addBench("textri/64/map", benchTextri, 64 << 1 | 1);
+	addBench("clip", benchClip, 0);
+	addBench("sfx", benchSfx, 0);
+	addBench("sfx_stop", benchSfxStop, 0);
+	addBench("sfx_ex", benchSfxEx, 0);
+	addBench("sfx_pos", benchSfxPos, 0);
+	addBench("music", benchMusic, 0);
+	addBench("music_frame", benchMusicFrame, 0);
+	addBench("time", benchTime, 0);
+	addBench("tick", benchTick, 0);
+	addBench("scanline", benchScanline, 0);
+	addBench("overline", benchOverline, 0);
+	addBench("raster", benchRaster, 0);
+	addBench("reset", benchReset, 0);
+	addBench("pause", benchPause, 0);
+	addBench("resume", benchResume, 0);
+	addBench("sync", benchSync, 0);
+	addBench("btnp", benchBtnp, 0);
+	addBench("key", benchKey, 0);
+	addBench("keyp", benchKeyp, 0);
+	addBench("load", benchLoad, 0);
+	addBench("save", benchSave, 0);
+	addBench("tick_start+tick_end/4ch", benchTickFrame, 0);
+	addBench("blit", benchBlit, 0);
+	addBench("blit/scanline", benchBlit, 1);
+	addBench("blit/scanline+overline", benchBlit, 2);
+	addBench("blit/script", benchBlit, 3);
+	addBench("get_script_config", benchGetScriptConfig, 0);
+}
+
+static void initMaxCart()
+{
+	srand(1);
+
+	fillRandom(&MaxCart, sizeof MaxCart);
+
+	for(s32 i = 0; i < TIC_CODE_SIZE - 1; i++)
+		MaxCart.code.data[i] = 'a' + i % 26;
+
+	MaxCart.code.data[TIC_CODE_SIZE - 1] = '\0';
+	MaxCart.cover.size = sizeof MaxCart.cover.data;
+
+	MaxCartBuffer = malloc(sizeof(tic_cartridge) * 2);
+
+	{
+		tic_mem* tic = tic_create(44100);
+		MaxCartSize = tic->api.save(&MaxCart, MaxCartBuffer);
+		tic_close(tic);
+	}
+}
+
+static void measure(Bench* bench, double seconds, double* ns, s64* ops)
+{
+	enum {Batch = 1000};
+
+	tic_mem* tic = createMachine();
+
+	if(bench->func == benchResume)
+		tic->api.pause(tic);
+
+	if(bench->func == benchTickFrame)
+		for(s32 i = 0; i < TIC_SOUND_CHANNELS; i++)
+			tic->api.sfx(tic, i, i, 4, -1, i);
+
+	clock_t limit = (clock_t)(seconds * CLOCKS_PER_SEC);
+	clock_t start = clock();
+	clock_t elapsed = 0;
+	s64 count = 0;
+
+	do
+	{
+		for(s32 i = 0; i < Batch; i++, count++)
+			bench->func(tic, (s32)count, bench->arg);
+
+		elapsed = clock() - start;
+	}
+	while(elapsed < limit);
+
+	*ops = count;
+	*ns = (double)elapsed * 1000000000 / CLOCKS_PER_SEC / count;
+
+	tic_close(tic);
+}
+
+// keeps the fastest of several runs, a single short run is too noisy for the threshold
+static void run(Bench* bench, double seconds, s32 repeats)
+{
+	bench->ns = 0;
+
+	for(s32 r = 0; r < repeats; r++)
+	{
+		double ns;
+		s64 ops;
+
+		measure(bench, seconds, &ns, &ops);
+
+		if(r == 0 || ns < bench->ns)
+		{
+			bench->ns = ns;
+			bench->ops = ops;
+		}
+	}
+}
+
+static void writeJson(FILE* file)
+{
+	fprintf(file, "{\n\t\"benchmarks\": [\n");
+
+	for(s32 i = 0; i < BenchCount; i++)
+		fprintf(file, "\t\t{\"name\": \"%s\", \"ns\": %.1f, \"ops\": %lli}%s\n",
+			Benches[i].name, Benches[i].ns, (long long)Benches[i].ops, i < BenchCount - 1 ? "," : "");
+
+	fprintf(file, "\t]\n}\n");
+}
+
+static char* loadFile(const char* path)
+{
+	FILE* file = fopen(path, "rb");
+	char* buffer = NULL;
+
+	if(file)
+	{
+		fseek(file, 0, SEEK_END);
+		s32 size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		buffer = malloc(size + 1);
+
+		if(buffer)
+		{
+			buffer[fread(buffer, 1, size, file)] = '\0';
+		}
+
+		fclose(file);
+	}
+
+	return buffer;
+}
+
+// only reads back what writeJson() writes
+static bool findBaseline(const char* json, const Bench* bench, double* ns)
+{
+	char key[sizeof bench->name + 16];
+	snprintf(key, sizeof key, "\"name\": \"%.*s\"", (s32)sizeof bench->name, bench->name);
+
+	const char* pos = strstr(json, key);
+
+	if(pos && (pos = strstr(pos, "\"ns\":")))
+		return sscanf(pos + strlen("\"ns\":"), "%lf", ns) == 1;
+
+	return false;
+}
+
+static s32 compare(const char* baseline, double threshold)
+{
+	s32 regressions = 0;
+
+	for(s32 i = 0; i < BenchCount; i++)
+	{
+		double ns = 0;
+
+		if(findBaseline(baseline, &Benches[i], &ns) && ns > 0)
+		{
+			double change = (Benches[i].ns - ns) * 100 / ns;
+
+			if(change > threshold)
+			{
+				fprintf(stderr, "regression: %s %.1f -> %.1f ns/op (+%.1f%%)\n", Benches[i].name, ns, Benches[i].ns, change);
+				regressions++;
+			}
+		}
+	}
+
+	return regressions;
+}
+
+int main(int argc, char** argv)
+{
+	const char* output = NULL;
+	const char* baseline = NULL;
+	const char* filter = NULL;
+	double threshold = 10;
+	double seconds = 0.2;
+	s32 repeats = 5;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(i + 1 < argc && strcmp(argv[i], "-o") == 0) output = argv[++i];
+		else if(i + 1 < argc && strcmp(argv[i], "-b") == 0) baseline = argv[++i];
+		else if(i + 1 < argc && strcmp(argv[i], "-f") == 0) filter = argv[++i];
+		else if(i + 1 < argc && strcmp(argv[i], "-t") == 0) threshold = atof(argv[++i]);
+		else if(i + 1 < argc && strcmp(argv[i], "-s") == 0) seconds = atof(argv[++i]);
+		else if(i + 1 < argc && strcmp(argv[i], "-r") == 0) repeats = MAX(atoi(argv[++i]), 1);
+		else
+		{
+			printf("usage: tic80bench [-o out.json] [-b baseline.json] [-t threshold %%] [-s seconds per run] [-r runs per bench] [-f name filter]\n");
+			return -1;
+		}
+	}
+
+	TickData = bench_tick_data(NULL);
+
+	srand(2);
+	for(s32 i = 0; i < RandomSize; i++)
+		Random[i] = rand() & 0xffff;
+
+	initBenches();
+	initMaxCart();
+
+	{
+		s32 count = 0;
+
+		for(s32 i = 0; i < BenchCount; i++)
+		{
+			if(filter && !strstr(Benches[i].name, filter)) continue;
+
+			run(&Benches[i], seconds, repeats);
+			fprintf(stderr, "%-40s %12.1f ns/op\n", Benches[i].name, Benches[i].ns);
+
+			Benches[count++] = Benches[i];
+		}
+
+		BenchCount = count;
+	}
+
+	free(MaxCartBuffer);
+
+	{
+		FILE* file = output ? fopen(output, "w") : stdout;
+
+		if(!file)
+		{
+			fprintf(stderr, "can't write %s\n", output);
+			return -1;
+		}
+
+		writeJson(file);
+
+		if(output)
+			fclose(file);
+	}
+
+	if(baseline)
+	{
+		char* json = loadFile(baseline);
+
+		if(!json)
+		{
+			fprintf(stderr, "can't read %s\n", baseline);
+			return -1;
+		}
+
+		s32 regressions = compare(json, threshold);
+		free(json);
+
+		if(regressions)
+			return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,31 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "capture.h"
+
+int main(int argc, char** argv)
+{
+	if(argc >= 3)
+	{
+		const char* y4m = NULL;
+		const char* wav = NULL;
+
+		for(int i = 2; i < argc; i++)
+		{
+			if(strstr(argv[i], ".y4m")) y4m = argv[i];
+			else if(strstr(argv[i], ".wav")) wav = argv[i];
+		}
+
+		if(y4m || wav)
+		{
+			if(tic_capture_export(argv[1], y4m, wav))
+				return 0;
+
+			printf("cannot convert capture file\n");
+		}
+		else printf("no .y4m or .wav output given\n");
+	}
+	else printf("usage: ticcap <capture" TIC_CAPTURE_EXT "> [video.y4m] [audio.wav]\n");
+
+	return -1;
+}
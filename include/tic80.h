@@ -38,6 +38,13 @@ extern "C" {
 #define TIC80_SAMPLERATE 44100
 #define TIC80_FRAMERATE 60
 
+typedef enum
+{
+	TIC80_PIXEL_COLOR_ABGR8888,	// R, G, B, A bytes in memory
+	TIC80_PIXEL_COLOR_XRGB8888,	// 0xffRRGGBB words
+	TIC80_PIXEL_COLOR_RGB565,	// 16 bit words
+} tic80_pixel_color_format;
+
 typedef struct 
 {
 	struct
@@ -53,7 +60,10 @@ typedef struct
 		s32 count;
 	} sound;
 
+	// TIC80_FULLWIDTH x TIC80_FULLHEIGHT pixels in ABGR8888 or the format given to tic80_create_ex,
+	// u16 ones for TIC80_PIXEL_COLOR_RGB565, rows are pitch bytes apart
 	u32* screen;
+	s32 pitch;
 	
 } tic80;
 
@@ -126,11 +136,186 @@ typedef struct
 
 } tic80_input;
 
+typedef struct
+{
+	u32 limit;	// script VM memory cap in bytes, 0 means no cap
+	u32 used;	// bytes taken by the script VM
+	u32 peak;	// the most it took since the cart was started
+	u32 allocs;	// allocations made during the last tick
+	u32 gc;		// microseconds spent collecting garbage after the last tick
+} tic80_heap;
+
+typedef struct
+{
+	s32 players;	// 2 to 4, each one drives the gamepad of its index
+	s32 peers;		// players first, then spectators, up to 8 in all
+	s32 local;		// this peer, a spectator unless it is below players
+	s32 delay;		// frames local input is held back before it is used, at least 1
+	s32 rollback;	// frames run ahead on predicted input, up to 15, 0 waits for every input
+
+	// called during tic80_netplay_tick with a packet for every other peer
+	void (*send)(void* data, s32 peer, const void* packet, s32 size);
+	void* data;
+} tic80_netplay_config;
+
+typedef struct
+{
+	u32 frame;			// frames simulated
+	u32 confirmed;		// frames every player's input is known for
+	u32 synced;			// confirmed frames that were simulated with it
+	u32 rollbacks;		// times late input differed from the prediction
+	u32 resimulated;	// frames run again because of it
+	u32 stalls;			// ticks spent waiting for late input
+	s32 desync;			// first frame a peer's RAM differed on, -1 while in sync
+} tic80_netplay;
+
+typedef struct
+{
+	u32 machine;	// the machine itself, with RAM and sound state
+	u32 cart;		// the cart owned by this instance
+	u32 shared;		// this instance's part of a cart shared with others running the same one
+	u32 screen;		// output frame, allocated on the first tick unless the host gave its own
+	u32 pause;		// machine copy, allocated on the first pause
+	u32 snapshot;	// post-init copy used for resets
+	u32 heap;		// script VM memory
+	u32 samples;	// sound buffer
+	u32 query;		// map query scratch, allocated on the first mfill() or mpath()
+	u32 total;
+} tic80_memory;
+
+#define TIC80_PACER_HISTORY 128
+#define TIC80_PACER_GRAPH_HEIGHT 32
+
+typedef struct
+{
+	u32 period;		// microseconds per frame, 0 for TIC80_FRAMERATE
+	u32 spin;		// the end of every wait busy-waits instead of sleeping, in microseconds
+	bool vsync;		// the host's present blocks on vsync, waits only count the frames due
+} tic80_pacer_config;
+
+typedef struct
+{
+	u32 frames;		// waits so far
+	u32 missed;		// deadlines already passed when the wait began, or extra frames run with vsync
+	u32 frame;		// microseconds between the last two waits returning
+	u32 average;	// mean frame time over the last TIC80_PACER_HISTORY frames
+	u32 jitter;		// mean distance of those frame times from the average
+	u32 overshoot;	// how much later than asked the last sleep woke, in microseconds
+	u32 worst;		// the largest overshoot so far
+} tic80_pacer_stats;
+
+typedef struct tic80_pacer tic80_pacer;
+
+// the largest change tic80_sound_rate takes either way, in millionths of the rate
+#define TIC80_SOUND_RATE_MAX 10000
+
+typedef struct
+{
+	s32 samplerate;	// sample frames the device plays per second
+	u32 latency;	// queue depth to hold, in microseconds, 0 for three frames
+	u32 range;		// largest rate change asked for, in millionths, 0 for 5000
+} tic80_audio_sync_config;
+
+typedef struct
+{
+	u32 updates;	// queue depths read so far
+	u32 queued;		// sample frames queued at the last reading
+	u32 average;	// the smoothed depth the rate follows
+	u32 target;		// the depth held, in sample frames
+	s32 correction;	// rate change for the next frames, in millionths
+	s32 low;		// the smallest and largest corrections since the queue first filled
+	s32 high;
+	u32 underruns;	// readings that found the queue empty after it first filled
+	bool filling;	// the queue is short of the target at the start or after running dry,
+					// keep the device paused until this clears
+} tic80_audio_sync_stats;
+
+typedef struct tic80_audio_sync tic80_audio_sync;
+
+#define TIC80_SCALE_MAX 8
+
+typedef enum
+{
+	TIC80_SCALE_NEAREST,
+	TIC80_SCALE_2X,		// Scale2x edge smoothing, needs an even scale
+	TIC80_SCALE_3X,		// Scale3x, needs a scale divisible by 3
+} tic80_scale_filter;
+
+typedef struct
+{
+	s32 scale;						// 1 to TIC80_SCALE_MAX
+	tic80_scale_filter filter;		// falls back to nearest when the scale doesn't fit it
+	u8 scanlines;					// how much the last line of every scaled row is darkened
+	u8 mask;						// how much an aperture grille darkens the other channels
+	bool border;					// full frame, otherwise TIC80_WIDTH x TIC80_HEIGHT
+} tic80_scale;
+
+// instances loaded with the same cart bytes share the decoded cart without any locking,
+// so every instance has to be created, loaded, ticked and deleted from one thread
 TIC80_API tic80* tic80_create(s32 samplerate);
+// same, with frames blitted in the given format instead of ABGR8888
+TIC80_API tic80* tic80_create_ex(s32 samplerate, tic80_pixel_color_format format);
 TIC80_API void tic80_load(tic80* tic, void* cart, s32 size);
+// maps the cart where the system can, banks are decoded when first used
+TIC80_API bool tic80_load_file(tic80* tic, const char* path);
 TIC80_API void tic80_tick(tic80* tic, tic80_input input);
 TIC80_API void tic80_delete(tic80* tic);
 
+// draw frames straight into the host buffer, NULL goes back to the internal one
+TIC80_API void tic80_framebuffer(tic80* tic, void* pixels, s32 pitch);
+
+// scales frames on the CPU straight from VRAM, the screen becomes the scaled one,
+// drawn into pixels if they are given; a NULL config goes back to the plain blit
+TIC80_API void tic80_scaler(tic80* tic, const tic80_scale* config, void* pixels, s32 pitch);
+
+// "-" as the path pipes y4m video to stdout without the sound; the capture stops
+// with a message on stderr if the output stops being packed ABGR
+TIC80_API bool tic80_capture_start(tic80* tic, const char* path, bool compress);
+TIC80_API void tic80_capture_stop(tic80* tic);
+
+// delta-encoded frames for thin clients, starting again sends everything in the next packet
+TIC80_API bool tic80_stream_start(tic80* tic);
+// packet for the last tick, valid until the next call
+TIC80_API s32 tic80_stream_frame(tic80* tic, const void** packet);
+TIC80_API void tic80_stream_stop(tic80* tic);
+
+// rollback netplay over a host transport, replaces tic80_tick once the cart is loaded,
+// packets from other peers go to tic80_netplay_receive
+TIC80_API bool tic80_netplay_start(tic80* tic, const tic80_netplay_config* config);
+TIC80_API void tic80_netplay_receive(tic80* tic, const void* packet, s32 size);
+// false when it waited for late input, the screen and the sound are left from the last frame
+TIC80_API bool tic80_netplay_tick(tic80* tic, tic80_gamepad pad);
+TIC80_API tic80_netplay tic80_netplay_stats(tic80* tic);
+TIC80_API void tic80_netplay_stop(tic80* tic);
+
+TIC80_API void tic80_heap_limit(tic80* tic, u32 bytes);
+TIC80_API tic80_heap tic80_heap_stats(tic80* tic);
+
+TIC80_API tic80_memory tic80_memory_report(tic80* tic);
+
+// makes a few more or fewer samples than the rate tic80_create was given, in millionths
+// up to TIC80_SOUND_RATE_MAX either way, sound.count follows it from the next tick
+TIC80_API void tic80_sound_rate(tic80* tic, s32 correction);
+
+// frame pacing for hosts that run their own loop
+TIC80_API tic80_pacer* tic80_pacer_create(const tic80_pacer_config* config);
+// sleeps and then spins until the next frame is due and returns 1, with vsync returns right
+// away how many frames the time since the last call is worth, 0 on displays faster than that
+TIC80_API s32 tic80_pacer_wait(tic80_pacer* pacer);
+TIC80_API tic80_pacer_stats tic80_pacer_report(const tic80_pacer* pacer);
+// the recent frame times as TIC80_PACER_HISTORY x TIC80_PACER_GRAPH_HEIGHT pixels from the top left of pixels
+TIC80_API void tic80_pacer_graph(const tic80_pacer* pacer, tic80_pixel_color_format format, void* pixels, s32 pitch);
+TIC80_API void tic80_pacer_delete(tic80_pacer* pacer);
+
+// rate control for hosts that queue every frame's samples, holds the queue at the latency
+// by making sound a little faster or slower instead of letting it drift or run dry
+TIC80_API tic80_audio_sync* tic80_audio_sync_create(const tic80_audio_sync_config* config);
+// takes the sample frames still queued just before a frame's samples are, returns the
+// correction to make the next frames with, for tic80_sound_rate
+TIC80_API s32 tic80_audio_sync_update(tic80_audio_sync* sync, s32 queued);
+TIC80_API tic80_audio_sync_stats tic80_audio_sync_report(const tic80_audio_sync* sync);
+TIC80_API void tic80_audio_sync_delete(tic80_audio_sync* sync);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,133 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "tools.h"
+
+#include <stdlib.h>
+
+// the smoothed depth moves this fraction of the way to every reading, the device drains
+// the queue a whole buffer at a time and that sawtooth mustn't reach the pitch
+#define SMOOTHING 16
+// frames the drift estimate takes to move the whole range at full error, slow enough
+// to settle without overshooting the proportional part
+#define DRIFT_FRAMES 2400
+
+struct tic80_audio_sync
+{
+	tic80_audio_sync_config config;
+	tic80_audio_sync_stats stats;
+
+	double average;
+	// the correction that holds the depth once it's on target, the clock skew
+	// between the device and the frames
+	double drift;
+	bool started;
+};
+
+tic80_audio_sync* tic80_audio_sync_create(const tic80_audio_sync_config* config)
+{
+	tic80_audio_sync* sync = calloc(1, sizeof(tic80_audio_sync));
+
+	if(sync)
+	{
+		sync->config = *config;
+
+		if(!sync->config.latency)
+			sync->config.latency = 3 * 1000000 / TIC80_FRAMERATE;
+
+		if(!sync->config.range)
+			sync->config.range = 5000;
+
+		sync->config.range = MIN(sync->config.range, TIC80_SOUND_RATE_MAX);
+		sync->stats.target = (u32)((u64)sync->config.samplerate * sync->config.latency / 1000000);
+		sync->stats.filling = true;
+	}
+
+	return sync;
+}
+
+void tic80_audio_sync_delete(tic80_audio_sync* sync)
+{
+	free(sync);
+}
+
+// the queue is kept paused until it holds the target, at the start and after running dry,
+// no rate change could win that back in any reasonable time
+static void fill(tic80_audio_sync* sync, u32 queued)
+{
+	tic80_audio_sync_stats* stats = &sync->stats;
+
+	if(queued == 0 && !stats->filling)
+	{
+		stats->underruns++;
+		stats->filling = true;
+	}
+	else if(queued >= stats->target && stats->filling)
+	{
+		stats->filling = false;
+		sync->average = queued;
+
+		if(!sync->started)
+		{
+			sync->started = true;
+			stats->low = stats->high = stats->correction;
+		}
+	}
+}
+
+s32 tic80_audio_sync_update(tic80_audio_sync* sync, s32 queued)
+{
+	tic80_audio_sync_stats* stats = &sync->stats;
+	const double range = sync->config.range;
+
+	stats->updates++;
+	stats->queued = MAX(queued, 0);
+
+	fill(sync, stats->queued);
+
+	if(stats->filling || !stats->target)
+		return stats->correction;
+
+	sync->average += (stats->queued - sync->average) / SMOOTHING;
+	stats->average = (u32)sync->average;
+
+	// too deep makes fewer samples, too shallow more
+	double error = (sync->average - stats->target) / stats->target;
+	error = MIN(MAX(error, -1.0), 1.0);
+
+	sync->drift -= error * range / DRIFT_FRAMES;
+	sync->drift = MIN(MAX(sync->drift, -range), range);
+
+	double correction = sync->drift - error * range;
+	correction = MIN(MAX(correction, -range), range);
+
+	stats->correction = (s32)(correction < 0 ? correction - 0.5 : correction + 0.5);
+	stats->low = MIN(stats->low, stats->correction);
+	stats->high = MAX(stats->high, stats->correction);
+
+	return stats->correction;
+}
+
+tic80_audio_sync_stats tic80_audio_sync_report(const tic80_audio_sync* sync)
+{
+	return sync->stats;
+}
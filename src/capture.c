@@ -0,0 +1,367 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "capture.h"
+#include "machine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define CAPTURE_MAGIC "TIC80CAP"
+#define CAPTURE_VERSION 1
+#define SCREEN_PIXELS (TIC80_FULLWIDTH * TIC80_FULLHEIGHT)
+#define SCREEN_SIZE (SCREEN_PIXELS * sizeof(u32))
+
+typedef enum
+{
+	CAPTURE_CHUNK_VRAM,		// 4bpp screen, palette and registers
+	CAPTURE_CHUNK_SCREEN,	// full RGBA screen, used when the frame differs from VRAM (OVR, SCN)
+	CAPTURE_CHUNK_SOUND,	// interleaved stereo s16 samples
+} CaptureChunkType;
+
+typedef struct
+{
+	u8 type;
+	u8 compressed;
+	u16 temp;
+	u32 size;
+	u32 rawsize;
+} CaptureChunk;
+
+typedef struct
+{
+	char magic[8];
+	u32 version;
+	u32 samplerate;
+	u16 width;
+	u16 height;
+	u16 fps;
+	u16 temp;
+} CaptureHeader;
+
+typedef struct
+{
+	tic_screen screen;
+	tic_palette palette;
+	u8 border;
+	s8 x;
+	s8 y;
+} CaptureVram;
+
+STATIC_ASSERT(capture_chunk_size, sizeof(CaptureChunk) == 12);
+STATIC_ASSERT(capture_header_size, sizeof(CaptureHeader) == 24);
+
+struct tic_capture
+{
+	FILE* file;
+	bool pipe;
+	bool compress;
+
+	u8* packed;
+	uLong packedSize;
+
+	u32* frame;
+	u8* yuv;
+};
+
+static void blitVram(const CaptureVram* vram, u32* out)
+{
+	enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2, Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2};
+
+	const u32* pal = tic_palette_blit(&vram->palette);
+	u32 border = pal[vram->border & 0xf];
+
+	for(s32 i = 0; i < SCREEN_PIXELS; i++)
+		out[i] = border;
+
+	for(s32 r = 0; r < TIC80_HEIGHT; r++)
+	{
+		u32* row = out + (r + Top) * TIC80_FULLWIDTH + Left;
+		s32 pos = (r + vram->y + TIC80_HEIGHT) % TIC80_HEIGHT * TIC80_WIDTH;
+		u32 x = (-vram->x + TIC80_WIDTH) % TIC80_WIDTH;
+
+		for(s32 c = 0; c < TIC80_WIDTH; c++)
+			row[x++ % TIC80_WIDTH] = pal[tic_tool_peek4(vram->screen.data, pos + c)];
+	}
+}
+
+static void writeChunk(tic_capture* capture, CaptureChunkType type, const void* data, u32 size)
+{
+	CaptureChunk chunk = {.type = type, .compressed = 0, .temp = 0, .size = size, .rawsize = size};
+
+	if(capture->compress)
+	{
+		uLongf packedSize = capture->packedSize;
+
+		if(compress2(capture->packed, &packedSize, data, size, Z_BEST_SPEED) == Z_OK && packedSize < size)
+		{
+			chunk.compressed = 1;
+			chunk.size = (u32)packedSize;
+			data = capture->packed;
+		}
+	}
+
+	fwrite(&chunk, sizeof chunk, 1, capture->file);
+	fwrite(data, chunk.size, 1, capture->file);
+}
+
+static void rgb2yuv(const u32* frame, u8* yuv)
+{
+	u8* py = yuv;
+	u8* pu = py + SCREEN_PIXELS;
+	u8* pv = pu + SCREEN_PIXELS;
+
+	for(s32 i = 0; i < SCREEN_PIXELS; i++)
+	{
+		const u8* rgb = (const u8*)(frame + i);
+		s32 r = rgb[0], g = rgb[1], b = rgb[2];
+
+		*py++ = (77*r + 150*g + 29*b) >> 8;
+		*pu++ = ((-43*r - 85*g + 128*b) >> 8) + 128;
+		*pv++ = ((128*r - 107*g - 21*b) >> 8) + 128;
+	}
+}
+
+static void writeY4mHeader(FILE* file)
+{
+	fprintf(file, "YUV4MPEG2 W%i H%i F%i:1 Ip A1:1 C444 XCOLORRANGE=FULL\n", TIC80_FULLWIDTH, TIC80_FULLHEIGHT, TIC80_FRAMERATE);
+}
+
+static void writeY4mFrame(FILE* file, const u32* frame, u8* yuv)
+{
+	rgb2yuv(frame, yuv);
+
+	fprintf(file, "FRAME\n");
+	fwrite(yuv, SCREEN_PIXELS * 3, 1, file);
+}
+
+tic_capture* tic_capture_open(const char* path, s32 samplerate, bool compress)
+{
+	tic_capture* capture = calloc(1, sizeof(tic_capture));
+
+	if(capture)
+	{
+		capture->pipe = strcmp(path, TIC_CAPTURE_PIPE) == 0;
+		capture->compress = compress;
+		capture->file = capture->pipe ? stdout : fopen(path, "wb");
+		capture->frame = malloc(SCREEN_SIZE);
+		capture->packedSize = compressBound(SCREEN_SIZE);
+		capture->packed = malloc(capture->packedSize);
+		capture->yuv = capture->pipe ? malloc(SCREEN_PIXELS * 3) : NULL;
+
+		if(capture->file && capture->frame && capture->packed && (capture->yuv || !capture->pipe))
+		{
+			if(capture->pipe)
+			{
+				// y4m has no room for sound, stdout is the video so the warning goes to stderr
+				fprintf(stderr, "capture: piping video only, capture to a " TIC_CAPTURE_EXT " file to keep the sound\n");
+				writeY4mHeader(capture->file);
+			}
+			else
+			{
+				CaptureHeader header = 
+				{
+					.version = CAPTURE_VERSION, 
+					.samplerate = samplerate,
+					.width = TIC80_FULLWIDTH,
+					.height = TIC80_FULLHEIGHT,
+					.fps = TIC80_FRAMERATE,
+				};
+
+				memcpy(header.magic, CAPTURE_MAGIC, sizeof header.magic);
+				fwrite(&header, sizeof header, 1, capture->file);
+			}
+
+			return capture;
+		}
+
+		tic_capture_close(capture);
+	}
+
+	return NULL;
+}
+
+void tic_capture_frame(tic_capture* capture, tic_mem* tic)
+{
+	if(capture->pipe)
+	{
+		writeY4mFrame(capture->file, tic->screen, capture->yuv);
+		fflush(capture->file);
+		return;
+	}
+
+	CaptureVram vram;
+	memcpy(&vram.screen, &tic->ram.vram.screen, sizeof(tic_screen));
+	memcpy(&vram.palette, &tic->ram.vram.palette, sizeof(tic_palette));
+	vram.border = tic->ram.vram.vars.border;
+	vram.x = tic->ram.vram.vars.offset.x;
+	vram.y = tic->ram.vram.vars.offset.y;
+
+	// scanline palette tricks and OVR drawing don't survive the 4bpp dump,
+	// so compare with the real output and fall back to RGBA for such frames
+	blitVram(&vram, capture->frame);
+
+	if(memcmp(capture->frame, tic->screen, SCREEN_SIZE) == 0)
+		writeChunk(capture, CAPTURE_CHUNK_VRAM, &vram, sizeof vram);
+	else
+		writeChunk(capture, CAPTURE_CHUNK_SCREEN, tic->screen, SCREEN_SIZE);
+
+	writeChunk(capture, CAPTURE_CHUNK_SOUND, tic->samples.buffer, tic->samples.size);
+}
+
+void tic_capture_close(tic_capture* capture)
+{
+	if(capture)
+	{
+		if(capture->file && !capture->pipe)
+			fclose(capture->file);
+
+		free(capture->frame);
+		free(capture->packed);
+		free(capture->yuv);
+		free(capture);
+	}
+}
+
+static void writeWavHeader(FILE* file, u32 samplerate, u32 dataSize)
+{
+	enum {Channels = TIC_STEREO_CHANNELS, Bits = sizeof(s16) * BITS_IN_BYTE};
+
+	const u32 byteRate = samplerate * Channels * sizeof(s16);
+	const u16 blockAlign = Channels * sizeof(s16);
+	const u32 riffSize = 36 + dataSize;
+	const u32 fmtSize = 16;
+	const u16 format = 1, channels = Channels, bits = Bits;
+
+	fseek(file, 0, SEEK_SET);
+	fwrite("RIFF", 4, 1, file);
+	fwrite(&riffSize, sizeof riffSize, 1, file);
+	fwrite("WAVEfmt ", 8, 1, file);
+	fwrite(&fmtSize, sizeof fmtSize, 1, file);
+	fwrite(&format, sizeof format, 1, file);
+	fwrite(&channels, sizeof channels, 1, file);
+	fwrite(&samplerate, sizeof samplerate, 1, file);
+	fwrite(&byteRate, sizeof byteRate, 1, file);
+	fwrite(&blockAlign, sizeof blockAlign, 1, file);
+	fwrite(&bits, sizeof bits, 1, file);
+	fwrite("data", 4, 1, file);
+	fwrite(&dataSize, sizeof dataSize, 1, file);
+}
+
+bool tic_capture_export(const char* path, const char* y4m, const char* wav)
+{
+	bool done = false;
+
+	FILE* src = fopen(path, "rb");
+	FILE* video = y4m ? fopen(y4m, "wb") : NULL;
+	FILE* audio = wav ? fopen(wav, "wb") : NULL;
+
+	const uLong packedSize = compressBound(SCREEN_SIZE);
+	u8* packed = malloc(packedSize);
+	u8* raw = malloc(SCREEN_SIZE);
+	u32* frame = malloc(SCREEN_SIZE);
+	u8* yuv = malloc(SCREEN_PIXELS * 3);
+
+	CaptureHeader header;
+
+	if(src && packed && raw && frame && yuv
+		&& (video || !y4m) && (audio || !wav)
+		&& fread(&header, sizeof header, 1, src) == 1
+		&& memcmp(header.magic, CAPTURE_MAGIC, sizeof header.magic) == 0
+		&& header.version == CAPTURE_VERSION)
+	{
+		u32 audioSize = 0;
+
+		if(video) writeY4mHeader(video);
+		if(audio) writeWavHeader(audio, header.samplerate, audioSize);
+
+		done = true;
+
+		CaptureChunk chunk;
+		while(fread(&chunk, sizeof chunk, 1, src) == 1)
+		{
+			if(chunk.size > packedSize || chunk.rawsize > SCREEN_SIZE 
+				|| fread(packed, chunk.size, 1, src) != 1)
+			{
+				done = false;
+				break;
+			}
+
+			const u8* data = packed;
+
+			if(chunk.compressed)
+			{
+				uLongf rawSize = chunk.rawsize;
+				if(uncompress(raw, &rawSize, packed, chunk.size) != Z_OK || rawSize != chunk.rawsize)
+				{
+					done = false;
+					break;
+				}
+
+				data = raw;
+			}
+
+			switch(chunk.type)
+			{
+			case CAPTURE_CHUNK_VRAM:
+				if(video && chunk.rawsize == sizeof(CaptureVram))
+				{
+					CaptureVram vram;
+					memcpy(&vram, data, sizeof vram);
+					blitVram(&vram, frame);
+					writeY4mFrame(video, frame, yuv);
+				}
+				break;
+			case CAPTURE_CHUNK_SCREEN:
+				if(video && chunk.rawsize == SCREEN_SIZE)
+				{
+					memcpy(frame, data, SCREEN_SIZE);
+					writeY4mFrame(video, frame, yuv);
+				}
+				break;
+			case CAPTURE_CHUNK_SOUND:
+				if(audio)
+				{
+					fwrite(data, chunk.rawsize, 1, audio);
+					audioSize += chunk.rawsize;
+				}
+				break;
+			default: break;
+			}
+		}
+
+		if(audio) writeWavHeader(audio, header.samplerate, audioSize);
+	}
+
+	if(src) fclose(src);
+	if(video) fclose(video);
+	if(audio) fclose(audio);
+
+	free(packed);
+	free(raw);
+	free(frame);
+	free(yuv);
+
+	return done;
+}
@@ -0,0 +1,44 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// Streaming capture of the machine output.
+// Every frame stores the 4bpp VRAM, the palette and the border/offset registers
+// (or the full RGBA screen if the cart uses scanline effects) plus the PCM samples
+// into a chunked, optionally zlib-compressed file, so nothing is kept in memory.
+// Passing "-" as a path streams YUV4MPEG2 frames to stdout instead (ffmpeg -i -),
+// that is video only and the sound is dropped with a warning on stderr.
+
+#define TIC_CAPTURE_EXT ".ticcap"
+#define TIC_CAPTURE_PIPE "-"
+
+typedef struct tic_capture tic_capture;
+
+tic_capture* tic_capture_open(const char* path, s32 samplerate, bool compress);
+void tic_capture_frame(tic_capture* capture, tic_mem* tic);
+void tic_capture_close(tic_capture* capture);
+
+// converts a capture file to y4m video and/or wav audio, pass NULL to skip one of them
+bool tic_capture_export(const char* path, const char* y4m, const char* wav);
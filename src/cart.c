@@ -0,0 +1,500 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "cart.h"
+#include "defines.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CART_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define CART_MAGIC "TIC2"
+#define CART_VERSION 2
+
+typedef enum
+{
+	CHUNK_DUMMY, 	// 0
+	CHUNK_TILES, 	// 1
+	CHUNK_SPRITES, 	// 2
+	CHUNK_COVER, 	// 3
+	CHUNK_MAP, 		// 4
+	CHUNK_CODE, 	// 5
+	CHUNK_FLAGS,	// 6
+	CHUNK_TEMP2, 	// 7
+	CHUNK_TEMP3,	// 8
+	CHUNK_SAMPLES,	// 9
+	CHUNK_WAVEFORM,	// 10
+	CHUNK_TEMP4,	// 11
+	CHUNK_PALETTE, 	// 12
+	CHUNK_PATTERNS_DEP, // 13 - deprecated chunk
+	CHUNK_MUSIC,	// 14
+	CHUNK_PATTERNS, // 15
+} ChunkType;
+
+// the old format is a list of these, each followed by its data
+typedef struct
+{
+	ChunkType type:5;
+	u32 bank:TIC_BANK_BITS;
+	u32 size:16; // max chunk size is 64K
+	u32 temp:8;
+} Chunk;
+
+typedef enum
+{
+	CART_CODEC_RAW,
+	CART_CODEC_ZLIB,
+} CartCodec;
+
+typedef struct
+{
+	char magic[4];
+	u16 version;
+	u16 count;
+} CartHeader;
+
+typedef struct
+{
+	u8 type;
+	u8 bank;
+	u8 codec;
+	u8 temp;
+	u32 offset;		// from the start of the cart
+	u32 size;		// stored
+	u32 rawsize;	// decoded
+	u32 hash;		// FNV-1a of the decoded bytes
+} CartEntry;
+
+STATIC_ASSERT(tic_bank_bits, TIC_BANK_BITS == 3);
+STATIC_ASSERT(tic_chunk_size, sizeof(Chunk) == 4);
+STATIC_ASSERT(cart_header_size, sizeof(CartHeader) == 8);
+STATIC_ASSERT(cart_entry_size, sizeof(CartEntry) == 20);
+
+// walks the index of a v2 cart or the chunk list of an old one
+typedef struct
+{
+	const u8* buffer;
+	s32 size;
+	bool container;
+	s32 count;
+	s32 index;
+	const u8* ptr;
+} ChunkReader;
+
+static u32 hashData(const void* data, s32 size)
+{
+	const u8* ptr = data;
+	u32 hash = 2166136261u;
+
+	while(size--)
+		hash = (hash ^ *ptr++) * 16777619u;
+
+	return hash;
+}
+
+static ChunkReader openReader(const u8* buffer, s32 size)
+{
+	ChunkReader reader = {.buffer = buffer, .size = size, .ptr = buffer};
+
+	if(size >= (s32)sizeof(CartHeader))
+	{
+		CartHeader header;
+		memcpy(&header, buffer, sizeof header);
+
+		if(memcmp(header.magic, CART_MAGIC, sizeof header.magic) == 0
+			&& sizeof(CartHeader) + header.count * sizeof(CartEntry) <= (size_t)size)
+		{
+			reader.container = true;
+			reader.count = header.count;
+		}
+	}
+
+	return reader;
+}
+
+// the v2 index already holds the sizes and hashes of every chunk, so hashing it stands for the cart
+u32 tic_cart_hash(const u8* buffer, s32 size)
+{
+	ChunkReader reader = openReader(buffer, size);
+
+	return reader.container 
+		? hashData(buffer, sizeof(CartHeader) + reader.count * sizeof(CartEntry)) 
+		: hashData(buffer, size);
+}
+
+// old chunks come out as raw entries
+static bool nextChunk(ChunkReader* reader, CartEntry* entry)
+{
+	if(reader->container)
+	{
+		if(reader->index == reader->count)
+			return false;
+
+		memcpy(entry, reader->buffer + sizeof(CartHeader) + reader->index++ * sizeof(CartEntry), sizeof(CartEntry));
+		return true;
+	}
+
+	const u8* end = reader->buffer + reader->size;
+
+	if(end - reader->ptr < (s32)sizeof(Chunk))
+		return false;
+
+	Chunk chunk;
+	memcpy(&chunk, reader->ptr, sizeof chunk);
+	reader->ptr += sizeof chunk;
+
+	u32 size = MIN(chunk.size, end - reader->ptr);
+	*entry = (CartEntry){.type = chunk.type, .bank = chunk.bank, .codec = CART_CODEC_RAW,
+		.offset = (u32)(reader->ptr - reader->buffer), .size = size, .rawsize = size};
+	reader->ptr += size;
+
+	return true;
+}
+
+// keeps what fits, a chunk that fails its hash is left out
+static bool decodeChunk(const ChunkReader* reader, const CartEntry* entry, void* dst, s32 capacity)
+{
+	if(entry->offset > (u32)reader->size || entry->size > reader->size - entry->offset)
+		return false;
+
+	const u8* src = reader->buffer + entry->offset;
+
+	switch(entry->codec)
+	{
+	case CART_CODEC_RAW:
+		if(entry->size != entry->rawsize || (reader->container && hashData(src, entry->size) != entry->hash))
+			return false;
+
+		memcpy(dst, src, MIN(entry->size, (u32)capacity));
+		return true;
+	case CART_CODEC_ZLIB:
+		{
+			u8* out = entry->rawsize <= (u32)capacity ? dst : malloc(entry->rawsize);
+			uLongf size = entry->rawsize;
+			bool done = false;
+
+			if(out)
+			{
+				done = uncompress(out, &size, src, entry->size) == Z_OK
+					&& size == entry->rawsize && hashData(out, size) == entry->hash;
+
+				if(out != dst)
+				{
+					if(done) memcpy(dst, out, capacity);
+					free(out);
+				}
+				else if(!done) memset(dst, 0, capacity);
+			}
+
+			return done;
+		}
+	default:
+		return false;
+	}
+}
+
+static void* chunkTarget(tic_cartridge* cart, ChunkType type, s32 bank, s32* capacity)
+{
+	tic_bank* data = &cart->banks[bank];
+
+#define TARGET(to) (*capacity = sizeof(to), (void*)&(to))
+
+	switch(type)
+	{
+	case CHUNK_TILES: 			return TARGET(data->tiles);
+	case CHUNK_SPRITES: 		return TARGET(data->sprites);
+	case CHUNK_MAP: 			return TARGET(data->map);
+	case CHUNK_SAMPLES: 		return TARGET(data->sfx.samples);
+	case CHUNK_WAVEFORM:		return TARGET(data->sfx.waveform);
+	case CHUNK_MUSIC:			return TARGET(data->music.tracks);
+	case CHUNK_PATTERNS:		return TARGET(data->music.patterns);
+	case CHUNK_PATTERNS_DEP:	return TARGET(data->music.patterns);
+	case CHUNK_PALETTE:			return TARGET(data->palette);
+	case CHUNK_FLAGS:			return TARGET(data->flags);
+	case CHUNK_CODE: 			return bank == 0 ? TARGET(cart->code) : NULL;
+	case CHUNK_COVER:			return TARGET(cart->cover.data);
+	default: 					return NULL;
+	}
+
+#undef TARGET
+}
+
+static void chunkLoaded(tic_cartridge* cart, ChunkType type, s32 bank, s32 size)
+{
+	switch(type)
+	{
+	case CHUNK_COVER:
+		cart->cover.size = MIN(size, (s32)sizeof cart->cover.data);
+		break;
+	case CHUNK_PATTERNS_DEP:
+		{
+			// workaround to load deprecated music patterns section
+			// and automatically convert volume value to a command
+			tic_patterns* ptrns = &cart->banks[bank].music.patterns;
+			for(s32 i = 0; i < MUSIC_PATTERNS; i++)
+				for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
+				{
+					tic_track_row* row = &ptrns->data[i].rows[r];
+					if(row->note >= NoteStart && row->command == tic_music_cmd_empty)
+					{
+						row->command = tic_music_cmd_volume;
+						row->param2 = row->param1 = MAX_VOLUME - row->param1;
+					}
+				}
+		}
+		break;
+	default: break;
+	}
+}
+
+static void loadChunks(tic_cartridge* cart, const u8* buffer, s32 size, u8 banks)
+{
+	ChunkReader reader = openReader(buffer, size);
+	CartEntry entry;
+
+	bool paletteExists = false;
+
+	while(nextChunk(&reader, &entry))
+	{
+		if(entry.bank >= TIC_BANKS || !(banks & 1 << entry.bank))
+			continue;
+
+		s32 capacity = 0;
+		void* dst = chunkTarget(cart, entry.type, entry.bank, &capacity);
+
+		if(dst && decodeChunk(&reader, &entry, dst, capacity))
+		{
+			chunkLoaded(cart, entry.type, entry.bank, entry.rawsize);
+
+			if(entry.bank == 0 && entry.type == CHUNK_PALETTE)
+				paletteExists = true;
+		}
+	}
+
+	// workaround to support ancient carts without palette
+	// load DB16 palette if it not exists
+	if((banks & 1) && !paletteExists)
+	{
+		static const u8 DB16[] = {0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6};
+		memcpy(cart->bank0.palette.data, DB16, sizeof(tic_palette));
+	}
+}
+
+void tic_cart_load(tic_cartridge* cart, const u8* buffer, s32 size)
+{
+	memset(cart, 0, sizeof(tic_cartridge));
+	loadChunks(cart, buffer, size, (1 << TIC_BANKS) - 1);
+}
+
+void tic_cart_load_bank(tic_cartridge* cart, const u8* buffer, s32 size, s32 bank)
+{
+	memset(&cart->banks[bank], 0, sizeof(tic_bank));
+
+	if(bank == 0)
+	{
+		memset(&cart->code, 0, sizeof cart->code);
+		memset(&cart->cover, 0, sizeof cart->cover);
+	}
+
+	loadChunks(cart, buffer, size, 1 << bank);
+}
+
+bool tic_cart_load_cover(tic_cover_image* cover, const u8* buffer, s32 size)
+{
+	ChunkReader reader = openReader(buffer, size);
+	CartEntry entry;
+
+	while(nextChunk(&reader, &entry))
+		if(entry.type == CHUNK_COVER && entry.rawsize && decodeChunk(&reader, &entry, cover->data, sizeof cover->data))
+		{
+			cover->size = MIN(entry.rawsize, sizeof cover->data);
+			return true;
+		}
+
+	return false;
+}
+
+static s32 calcBufferSize(const void* buffer, s32 size)
+{
+	const u8* ptr = (u8*)buffer + size - 1;
+	const u8* end = (u8*)buffer;
+
+	while(ptr >= end)
+	{
+		if(*ptr) break;
+
+		ptr--;
+		size--;
+	}
+
+	return size;
+}
+
+typedef struct
+{
+	ChunkType type;
+	s32 bank;
+	const void* data;
+	s32 size;
+} SaveChunk;
+
+static void addChunk(SaveChunk* chunks, s32* count, ChunkType type, const void* data, s32 size, s32 bank)
+{
+	if(size)
+		chunks[(*count)++] = (SaveChunk){type, bank, data, size};
+}
+
+s32 tic_cart_save(const tic_cartridge* cart, u8* buffer)
+{
+	enum {BankChunks = 9, MaxChunks = TIC_BANKS * BankChunks + 2};
+
+	SaveChunk chunks[MaxChunks];
+	s32 count = 0;
+
+	#define ADD_CHUNK(ID, FROM, BANK) addChunk(chunks, &count, ID, &FROM, calcBufferSize(&FROM, sizeof(FROM)), BANK)
+
+	for(s32 i = 0; i < TIC_BANKS; i++)
+	{
+		ADD_CHUNK(CHUNK_TILES, 		cart->banks[i].tiles, 			i);
+		ADD_CHUNK(CHUNK_SPRITES, 	cart->banks[i].sprites, 		i);
+		ADD_CHUNK(CHUNK_MAP, 		cart->banks[i].map, 			i);
+		ADD_CHUNK(CHUNK_SAMPLES, 	cart->banks[i].sfx.samples, 	i);
+		ADD_CHUNK(CHUNK_WAVEFORM, 	cart->banks[i].sfx.waveform, 	i);
+		ADD_CHUNK(CHUNK_PATTERNS, 	cart->banks[i].music.patterns, 	i);
+		ADD_CHUNK(CHUNK_MUSIC, 		cart->banks[i].music.tracks, 	i);
+		ADD_CHUNK(CHUNK_PALETTE, 	cart->banks[i].palette, 		i);
+		ADD_CHUNK(CHUNK_FLAGS, 		cart->banks[i].flags, 			i);
+	}
+
+	ADD_CHUNK(CHUNK_CODE, cart->code, 0);
+	addChunk(chunks, &count, CHUNK_COVER, cart->cover.data, MIN(cart->cover.size, (s32)sizeof cart->cover.data), 0);
+
+	#undef ADD_CHUNK
+
+	CartHeader header = {.version = CART_VERSION, .count = count};
+	memcpy(header.magic, CART_MAGIC, sizeof header.magic);
+	memcpy(buffer, &header, sizeof header);
+
+	u8* ptr = buffer + sizeof header + count * sizeof(CartEntry);
+
+	const uLong bound = compressBound(sizeof cart->cover.data);
+	u8* packed = malloc(bound);
+
+	for(s32 i = 0; i < count; i++)
+	{
+		const SaveChunk* chunk = &chunks[i];
+		const void* data = chunk->data;
+
+		CartEntry entry =
+		{
+			.type = chunk->type,
+			.bank = chunk->bank,
+			.codec = CART_CODEC_RAW,
+			.offset = (u32)(ptr - buffer),
+			.size = chunk->size,
+			.rawsize = chunk->size,
+			.hash = hashData(chunk->data, chunk->size),
+		};
+
+		uLongf packedSize = bound;
+
+		if(packed && compress2(packed, &packedSize, data, chunk->size, Z_BEST_COMPRESSION) == Z_OK
+			&& packedSize < (uLongf)chunk->size)
+		{
+			entry.codec = CART_CODEC_ZLIB;
+			entry.size = (u32)packedSize;
+			data = packed;
+		}
+
+		memcpy(ptr, data, entry.size);
+		ptr += entry.size;
+
+		memcpy(buffer + sizeof header + i * sizeof entry, &entry, sizeof entry);
+	}
+
+	free(packed);
+
+	return (s32)(ptr - buffer);
+}
+
+void* tic_cart_map(const char* path, s32* size)
+{
+#if defined(CART_MMAP)
+	void* data = NULL;
+	s32 file = open(path, O_RDONLY);
+
+	if(file >= 0)
+	{
+		struct stat info;
+
+		if(fstat(file, &info) == 0 && info.st_size > 0 && info.st_size < INT32_MAX)
+		{
+			data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+			if(data == MAP_FAILED) data = NULL;
+			else *size = (s32)info.st_size;
+		}
+
+		close(file);
+	}
+
+	return data;
+#else
+	FILE* file = fopen(path, "rb");
+	void* data = NULL;
+
+	if(file)
+	{
+		fseek(file, 0, SEEK_END);
+		*size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+
+		if(*size > 0 && (data = malloc(*size)) && fread(data, *size, 1, file) != 1)
+		{
+			free(data);
+			data = NULL;
+		}
+
+		fclose(file);
+	}
+
+	return data;
+#endif
+}
+
+void tic_cart_unmap(void* data, s32 size)
+{
+#if defined(CART_MMAP)
+	if(data) munmap(data, size);
+#else
+	free(data);
+#endif
+}
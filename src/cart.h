@@ -0,0 +1,48 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// Cart container v2. An index at the head lists every chunk with its bank, its stored and
+// decoded sizes and a hash of the decoded bytes; chunks are zlib-compressed when that makes
+// them smaller. A reader after one bank or the cover goes straight to its chunks, so banks can
+// stay packed until they're first used. Carts with the old chunk list load through the same calls.
+
+// room for the index on top of a cart that doesn't compress at all
+#define TIC_CART_SAVE_SIZE (sizeof(tic_cartridge) + 2048)
+
+// decodes the whole cart
+void tic_cart_load(tic_cartridge* cart, const u8* buffer, s32 size);
+// decodes one bank over the cart, bank 0 brings the code and the cover along
+void tic_cart_load_bank(tic_cartridge* cart, const u8* buffer, s32 size, s32 bank);
+// just the cover, false if there is none
+bool tic_cart_load_cover(tic_cover_image* cover, const u8* buffer, s32 size);
+// FNV-1a of the v2 index or of the whole of an old cart, equal carts hash the same
+u32 tic_cart_hash(const u8* buffer, s32 size);
+// writes the v2 container into a buffer of TIC_CART_SAVE_SIZE, returns the size
+s32 tic_cart_save(const tic_cartridge* cart, u8* buffer);
+
+// maps a cart file read-only where the system can, reads it in otherwise
+void* tic_cart_map(const char* path, s32* size);
+void tic_cart_unmap(void* data, s32 size);
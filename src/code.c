@@ -40,10 +40,36 @@ struct OutlineItem
 #define OUTLINE_SIZE ((TIC80_HEIGHT - TOOLBAR_SIZE*2)/TIC_FONT_HEIGHT)
 #define OUTLINE_ITEMS_SIZE (OUTLINE_SIZE * sizeof(OutlineItem))
 
-static void history(Code* code)
+// line start offsets and the lexer state each line starts in,
+// built for the copy of the code kept in text, all grown to what the code needs
+struct CodeLines
 {
-	if(history_add(code->history))
+	s32* start;
+	u8* state;
+	s32 count;
+	s32 capacity;
+
+	char* text;
+	s32 size;
+	s32 textCapacity;
+
+	const tic_script_config* config;
+	tic_code_theme theme;
+};
+
+static void history(Code* code, const char* pos)
+{
+	// an edit at pos can only touch the code up to the end of the old or the new text
+	u32 start = pos - code->src;
+	u32 end = MAX(code->lines->size, start + strlen(pos)) + 1;
+
+	if(history_add_range(code->history, start, end))
+	{
 		history_add(code->cursorHistory);
+
+		// the code history evicts by the size of its diffs, the cursors go with those steps
+		history_keep(code->cursorHistory, history_depth(code->history));
+	}
 }
 
 static void drawStatus(Code* code)
@@ -83,12 +109,19 @@ static void drawCode(Code* code, bool withCursor)
 {
 	drawBookmarks(code);
 
+	const CodeLines* lines = code->lines;
+
+	if(lines->count == 0)
+		return;
+
+	s32 first = MAX(0, MIN(code->scroll.y, lines->count - 1));
+
 	s32 xStart = code->rect.x - code->scroll.x * (getFontWidth(code));
 	s32 x = xStart;
-	s32 y = code->rect.y - code->scroll.y * STUDIO_TEXT_HEIGHT;
-	char* pointer = code->src;
+	s32 y = code->rect.y + (first - code->scroll.y) * STUDIO_TEXT_HEIGHT;
+	char* pointer = code->src + lines->start[first];
 
-	u8* colorPointer = code->colorBuffer;
+	u8* colorPointer = code->colorBuffer + lines->start[first];
 
 	struct { char* start; char* end; } selection = {MIN(code->cursor.selection, code->cursor.position),
 		MAX(code->cursor.selection, code->cursor.position)};
@@ -130,6 +163,10 @@ static void drawCode(Code* code, bool withCursor)
 
 		pointer++;
 		colorPointer++;
+
+		// past the last visible line, a cursor there is off screen either way
+		if(y >= TIC80_HEIGHT)
+			break;
 	}
 
 	if(code->cursor.position == pointer)
@@ -139,38 +176,33 @@ static void drawCode(Code* code, bool withCursor)
 		drawCursor(code, cursor.x, cursor.y, cursor.symbol);
 }
 
-static void getCursorPosition(Code* code, s32* x, s32* y)
+static s32 getLineIndex(Code* code, const char* pos)
 {
-	*x = 0;
-	*y = 0;
+	const CodeLines* lines = code->lines;
+	s32 offset = pos - code->src;
+	s32 low = 0;
+	s32 high = lines->count - 1;
 
-	const char* pointer = code->src;
-
-	while(*pointer)
+	while(low < high)
 	{
-		if(code->cursor.position == pointer) return;
+		s32 mid = (low + high + 1) / 2;
 
-		if(*pointer == '\n')
-		{
-			*x = 0;
-			(*y)++;
-		}
-		else (*x)++;
-
-		pointer++;
+		if(lines->start[mid] <= offset) low = mid;
+		else high = mid - 1;
 	}
+
+	return low;
 }
 
-static s32 getLinesCount(Code* code)
+static void getCursorPosition(Code* code, s32* x, s32* y)
 {
-	char* text = code->src;
-	s32 count = 0;
-
-	while(*text)
-		if(*text++ == '\n')
-			count++;
+	*y = getLineIndex(code, code->cursor.position);
+	*x = code->cursor.position - (code->src + code->lines->start[*y]);
+}
 
-	return count;
+static s32 getLinesCount(Code* code)
+{
+	return code->lines->count - 1;
 }
 
 static void removeInvalidChars(char* code)
@@ -217,28 +249,11 @@ static void updateEditor(Code* code)
 
 static inline bool isalnum_(char c) {return isalnum(c) || c == '_';}
 
-static void parseSyntaxColor(Code* code)
-{
-	memset(code->colorBuffer, getConfig()->theme.code.syntax.var, sizeof(code->colorBuffer));
-
-	tic_mem* tic = code->tic;
-
-	const tic_script_config* config = tic->api.get_script_config(tic);
-
-	if(config->parse)
-		config->parse(config, code->src, code->colorBuffer, &getConfig()->theme.code.syntax);
-}
-
 static char* getLineByPos(Code* code, char* pos)
 {
-	char* text = code->src;
-	char* line = text;
-
-	while(text < pos)
-		if(*text++ == '\n')
-			line = text;
+	while(pos > code->src && *(pos-1) != '\n') pos--;
 
-	return line;
+	return pos;
 }
 
 static char* getLine(Code* code)
@@ -248,19 +263,9 @@ static char* getLine(Code* code)
 
 static char* getPrevLine(Code* code)
 {
-	char* text = code->src;
-	char* pos = code->cursor.position;
-	char* prevLine = text;
-	char* line = text;
-
-	while(text < pos)
-		if(*text++ == '\n')
-		{
-			prevLine = line;
-			line = text;
-		}
+	char* line = getLine(code);
 
-	return prevLine;
+	return line > code->src ? getLineByPos(code, line - 1) : line;
 }
 
 static char* getNextLineByPos(Code* code, char* pos)
@@ -283,6 +288,139 @@ static s32 getLineSize(const char* line)
 	return size;
 }
 
+static bool reserveLines(CodeLines* lines, s32 count, s32 size)
+{
+	enum {MinLines = 256};
+
+	if(count > lines->capacity)
+	{
+		s32 capacity = MAX(MinLines, MAX(count, lines->capacity * 2));
+		s32* start = realloc(lines->start, capacity * sizeof lines->start[0]);
+		u8* state = start ? realloc(lines->state, capacity * sizeof lines->state[0]) : NULL;
+
+		if(start) lines->start = start;
+		if(state) lines->state = state;
+
+		if(!start || !state)
+			return false;
+
+		lines->capacity = capacity;
+	}
+
+	if(size > lines->textCapacity)
+	{
+		s32 capacity = MIN(TIC_CODE_SIZE, MAX(size, lines->textCapacity * 2));
+		char* text = realloc(lines->text, capacity);
+
+		if(!text)
+			return false;
+
+		lines->text = text;
+		lines->textCapacity = capacity;
+	}
+
+	return true;
+}
+
+static s32 parseLine(Code* code, const tic_script_config* config, s32 index)
+{
+	const CodeLines* lines = code->lines;
+	const char* line = code->src + lines->start[index];
+	u8* color = code->colorBuffer + lines->start[index];
+
+	// line symbols including '\n'
+	memset(color, lines->theme.var, getLineSize(line) + 1);
+
+	return config->parse
+		? config->parse(config, line, color, lines->state[index], &lines->theme)
+		: 0;
+}
+
+static void parseSyntaxColor(Code* code)
+{
+	tic_mem* tic = code->tic;
+	CodeLines* lines = code->lines;
+
+	const tic_script_config* config = tic->api.get_script_config(tic);
+	const tic_code_theme* theme = &getConfig()->theme.code.syntax;
+	const char* src = code->src;
+
+	s32 size = strlen(src);
+	s32 prefix = 0;
+	s32 suffix = 0;
+
+	if(lines->count == 0 || lines->config != config || memcmp(&lines->theme, theme, sizeof(tic_code_theme)))
+	{
+		if(!reserveLines(lines, 1, 1))
+			return;
+
+		lines->count = 1;
+		lines->start[0] = 0;
+		lines->state[0] = 0;
+		lines->size = 0;
+		lines->config = config;
+		lines->theme = *theme;
+	}
+	else
+	{
+		s32 common = MIN(size, lines->size);
+
+		while(prefix < common && src[prefix] == lines->text[prefix]) prefix++;
+
+		if(prefix == common && size == lines->size)
+			return;
+
+		while(suffix < common - prefix 
+			&& src[size - suffix - 1] == lines->text[lines->size - suffix - 1]) suffix++;
+	}
+
+	// lines before the edited one are untouched, lines after the edit only move
+	s32 edited = getLineIndex(code, src + prefix);
+	s32 moved = getLineIndex(code, src + lines->size - suffix) + 1;
+	s32 delta = size - lines->size;
+
+	s32 inserted = 0;
+	for(const char* ptr = src + lines->start[edited]; ptr < src + size - suffix; ptr++)
+		if(*ptr == '\n')
+			inserted++;
+
+	s32 tail = edited + 1 + inserted;
+	s32 tailCount = lines->count - moved;
+
+	if(!reserveLines(lines, tail + tailCount, size + 1))
+		return;
+
+	memmove(lines->start + tail, lines->start + moved, tailCount * sizeof lines->start[0]);
+	memmove(lines->state + tail, lines->state + moved, tailCount * sizeof lines->state[0]);
+	memmove(code->colorBuffer + size - suffix, code->colorBuffer + lines->size - suffix, suffix + 1);
+
+	for(s32 i = tail; i < tail + tailCount; i++)
+		lines->start[i] += delta;
+
+	{
+		s32 index = edited + 1;
+		for(const char* ptr = src + lines->start[edited]; ptr < src + size - suffix; ptr++)
+			if(*ptr == '\n')
+				lines->start[index++] = ptr - src + 1;
+	}
+
+	lines->count = tail + tailCount;
+
+	// re-lex until a moved line starts in the state it was colored with
+	for(s32 i = edited; i < lines->count; i++)
+	{
+		s32 state = parseLine(code, config, i);
+
+		if(i + 1 == lines->count || (i + 1 >= tail && lines->state[i + 1] == state))
+			break;
+
+		lines->state[i + 1] = state;
+	}
+
+	memcpy(lines->text + prefix, src + prefix, size - prefix + 1);
+	lines->size = size;
+}
+
 static void updateColumn(Code* code)
 {
 	code->cursor.column = code->cursor.position - getLine(code);
@@ -297,35 +435,12 @@ static void updateCursorPosition(Code* code, char* position)
 
 static void setCursorPosition(Code* code, s32 cx, s32 cy)
 {
-	s32 x = 0;
-	s32 y = 0;
-	char* pointer = code->src;
-
-	while(*pointer)
+	if(cy >= 0 && cy < code->lines->count)
 	{
-		if(y == cy && x == cx)
-		{
-			updateCursorPosition(code, pointer);
-			return;
-		}
-
-		if(*pointer == '\n')
-		{
-			if(y == cy && cx > x)
-			{
-				updateCursorPosition(code, pointer);
-				return;
-			}
-
-			x = 0;
-			y++;
-		}
-		else x++;
-
-		pointer++;
+		char* line = code->src + code->lines->start[cy];
+		updateCursorPosition(code, line + MIN(MAX(cx, 0), getLineSize(line)));
 	}
-
-	updateCursorPosition(code, pointer);
+	else updateCursorPosition(code, code->src + strlen(code->src));
 }
 
 static void upLine(Code* code)
@@ -458,7 +573,7 @@ static bool replaceSelection(Code* code)
 		code->cursor.position = start;
 		code->cursor.selection = NULL;
 
-		history(code);
+		history(code, start);
 
 		parseSyntaxColor(code);
 
@@ -474,7 +589,7 @@ static void deleteChar(Code* code)
 	{
 		char* pos = code->cursor.position;
 		memmove(pos, pos + 1, strlen(pos));
-		history(code);
+		history(code, pos);
 		parseSyntaxColor(code);
 	}
 }
@@ -485,7 +600,7 @@ static void backspaceChar(Code* code)
 	{
 		char* pos = --code->cursor.position;
 		memmove(pos, pos + 1, strlen(pos));
-		history(code);
+		history(code, pos);
 		parseSyntaxColor(code);
 	}
 }
@@ -500,7 +615,7 @@ static void deleteWord(Code* code)
 		if(isalnum_(*pos)) while(pos < end && isalnum_(*pos)) pos++;
 		else while(pos < end && !isalnum_(*pos)) pos++;
 		memmove(code->cursor.position, pos, strlen(pos) + 1);
-		history(code);
+		history(code, code->cursor.position);
 		parseSyntaxColor(code);
 	}
 }
@@ -516,7 +631,7 @@ static void backspaceWord(Code* code)
 		else while(pos > start && !isalnum_(*(pos-1))) pos--;
 		memmove(pos, code->cursor.position, strlen(code->cursor.position) + 1);
 		code->cursor.position = pos;
-		history(code);
+		history(code, pos);
 		parseSyntaxColor(code);
 	}
 }
@@ -532,7 +647,7 @@ static void inputSymbolBase(Code* code, char sym)
 
 	*code->cursor.position++ = sym;
 
-	history(code);
+	history(code, pos);
 
 	updateColumn(code);
 
@@ -611,7 +726,7 @@ static void cutToClipboard(Code* code)
 	
 	copyToClipboard(code);
 	replaceSelection(code);
-	history(code);
+	history(code, code->cursor.position);
 }
 
 static void copyFromClipboard(Code* code)
@@ -647,7 +762,7 @@ static void copyFromClipboard(Code* code)
 
 				code->cursor.position += size;
 
-				history(code);
+				history(code, pos);
 
 				parseSyntaxColor(code);
 			}
@@ -659,22 +774,30 @@ static void copyFromClipboard(Code* code)
 
 static void update(Code* code)
 {
-	updateEditor(code);
+	// code changed outside the editor, by a reload or a watched file, starts the history
+	// again instead of becoming a step, only edits made here can be undone
+	if(history_rebase(code->history))
+	{
+		history_keep(code->cursorHistory, 0);
+		history_rebase(code->cursorHistory);
+	}
+
 	parseSyntaxColor(code);
+	updateEditor(code);
 }
 
 static void undo(Code* code)
 {
-	history_undo(code->history);
-	history_undo(code->cursorHistory);
+	if(history_undo(code->history))
+		history_undo(code->cursorHistory);
 
 	update(code);
 }
 
 static void redo(Code* code)
 {
-	history_redo(code->history);
-	history_redo(code->cursorHistory);
+	if(history_redo(code->history))
+		history_redo(code->cursorHistory);
 
 	update(code);
 }
@@ -735,7 +858,7 @@ static void doTab(Code* code, bool shift, bool crtl)
 			}
 			else if (start <= end) code->cursor.position = end;
 			
-			history(code);
+			history(code, start);
 			parseSyntaxColor(code);
 		}
 	}
@@ -969,7 +1092,7 @@ static void commentLine(Code* code)
 
 	code->cursor.selection = NULL;	
 
-	history(code);
+	history(code, line);
 
 	parseSyntaxColor(code);
 }
@@ -1592,6 +1715,12 @@ void initCode(Code* code, tic_mem* tic, tic_code* src)
 	if(code->outline.items == NULL)
 		code->outline.items = (OutlineItem*)malloc(OUTLINE_ITEMS_SIZE);
 
+	if(code->lines == NULL)
+		code->lines = (CodeLines*)calloc(1, sizeof(CodeLines));
+
+	code->lines->count = 0;
+	code->lines->size = 0;
+
 	if(code->history) history_delete(code->history);
 	if(code->cursorHistory) history_delete(code->cursorHistory);
 
@@ -1619,6 +1748,7 @@ void initCode(Code* code, tic_mem* tic, tic_code* src)
 			.items = code->outline.items,
 			.index = 0,
 		},
+		.lines = code->lines,
 		.altFont = getConfig()->theme.code.altFont,
 		.event = onStudioEvent,
 		.update = update,
@@ -1629,3 +1759,24 @@ void initCode(Code* code, tic_mem* tic, tic_code* src)
 
 	update(code);
 }
+
+void freeCode(Code* code)
+{
+	if(code)
+	{
+		free(code->outline.items);
+
+		if(code->lines)
+		{
+			free(code->lines->start);
+			free(code->lines->state);
+			free(code->lines->text);
+			free(code->lines);
+		}
+
+		history_delete(code->history);
+		history_delete(code->cursorHistory);
+
+		free(code);
+	}
+}
@@ -26,6 +26,7 @@
 
 typedef struct Code Code;
 typedef struct OutlineItem OutlineItem;
+typedef struct CodeLines CodeLines;
 
 struct Code
 {
@@ -62,6 +63,8 @@ struct Code
 
 	u8 colorBuffer[TIC_CODE_SIZE];
 
+	CodeLines* lines;
+
 	char status[STUDIO_TEXT_BUFFER_WIDTH+1];
 
 	u32 tickCounter;
@@ -107,3 +110,4 @@ struct Code
 };
 
 void initCode(Code*, tic_mem*, tic_code* src);
+void freeCode(Code*);
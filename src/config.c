@@ -22,6 +22,7 @@
 
 #include "config.h"
 #include "fs.h"
+#include "cart.h"
 #include <lua.h>
 #include <lauxlib.h>
 #include <lualib.h>
@@ -86,6 +87,26 @@ static void readConfigCrtMonitor(Config* config, lua_State* lua)
 	lua_pop(lua, 1);
 }
 
+static void readConfigVsync(Config* config, lua_State* lua)
+{
+	lua_getglobal(lua, "VSYNC");
+
+	if(lua_isboolean(lua, -1))
+		config->data.vsync = lua_toboolean(lua, -1);
+
+	lua_pop(lua, 1);
+}
+
+static void readConfigFrameSpin(Config* config, lua_State* lua)
+{
+	lua_getglobal(lua, "FRAME_SPIN");
+
+	if(lua_isinteger(lua, -1))
+		config->data.frameSpin = (s32)lua_tointeger(lua, -1);
+
+	lua_pop(lua, 1);
+}
+
 static void readConfigUiScale(Config* config, lua_State* lua)
 {
 	lua_getglobal(lua, "UI_SCALE");
@@ -267,6 +288,8 @@ static void readConfig(Config* config)
 			readConfigNoSound(config, lua);
 			readConfigShowSync(config, lua);
 			readConfigCrtMonitor(config, lua);
+			readConfigVsync(config, lua);
+			readConfigFrameSpin(config, lua);
 			readConfigUiScale(config, lua);
 			readTheme(config, lua);
 			readConfigCrtShader(config, lua);
@@ -289,6 +312,7 @@ static void setDefault(Config* config)
 	memset(&config->data, 0, sizeof(StudioConfig));
 
 	config->data.cart = &config->cart;
+	config->data.frameSpin = 2000;
 
 	{
 		static const u8 DefaultBiosZip[] = 
@@ -310,7 +334,7 @@ static void setDefault(Config* config)
 
 static void saveConfig(Config* config, bool overwrite)
 {
-	u8* buffer = malloc(sizeof(tic_cartridge));
+	u8* buffer = malloc(TIC_CART_SAVE_SIZE);
 
 	if(buffer)
 	{
@@ -330,34 +354,47 @@ static void reset(Config* config)
 
 static void save(Config* config)
 {
-	memcpy(&config->cart, &config->tic->cart, sizeof(tic_cartridge));
+	memcpy(&config->cart, config->tic->cart, sizeof(tic_cartridge));
 	readConfig(config);
 	saveConfig(config, true);
 
 	studioConfigChanged();
 }
 
+static bool load(Config* config)
+{
+	s32 size = 0;
+	u8* data = (u8*)fsLoadRootFile(config->fs, CONFIG_TIC_PATH, &size);
+
+	if(data)
+	{
+		update(config, data, size);
+
+		free(data);
+	}
+
+	return data != NULL;
+}
+
+static void reload(Config* config)
+{
+	load(config);
+}
+
 void initConfig(Config* config, tic_mem* tic, FileSystem* fs)
 {
 	{
 		config->tic = tic;
 		config->save = save;
 		config->reset = reset;
+		config->reload = reload;
 		config->fs = fs;
 	}
 
 	setDefault(config);
 
-	s32 size = 0;
-	u8* data = (u8*)fsLoadRootFile(fs, CONFIG_TIC_PATH, &size);
-
-	if(data)
-	{
-		update(config, data, size);
-
-		free(data);
-	}
-	else saveConfig(config, false);
+	if(!load(config))
+		saveConfig(config, false);
 
 	tic->api.reset(tic);
 }
@@ -36,6 +36,7 @@ struct Config
 
 	void(*save)(Config*);
 	void(*reset)(Config*);
+	void(*reload)(Config*);
 };
 
 void initConfig(Config* config, tic_mem* tic, struct FileSystem* fs);
\ No newline at end of file
@@ -23,6 +23,7 @@
 #include "console.h"
 #include "fs.h"
 #include "config.h"
+#include "cart.h"
 #include "ext/gif.h"
 #include "ext/file_dialog.h"
 
@@ -376,7 +377,7 @@ static s32 writeGifData(const tic_mem* tic, u8* dst, const u8* src, s32 width, s
 
 static bool loadRom(tic_mem* tic, const void* data, s32 size)
 {
-	tic->api.load(&tic->cart, data, size);
+	tic->api.load(tic->cart, data, size);
 	tic->api.reset(tic);
 
 	return true;
@@ -424,13 +425,13 @@ static bool onConsoleLoadSectionCommand(Console* console, const char* param)
 
 						switch(i)
 						{
-						case 0: memcpy(&tic->cart.cover, 			&cart->cover, 			sizeof cart->cover); break;
-						case 1: memcpy(&tic->cart.bank0.tiles, 		&cart->bank0.tiles, 	sizeof(tic_tiles)*2); break;
-						case 2: memcpy(&tic->cart.bank0.map, 		&cart->bank0.map, 		sizeof(tic_map)); break;
-						case 3: memcpy(&tic->cart.code, 			&cart->code, 			sizeof(tic_code)); break;
-						case 4: memcpy(&tic->cart.bank0.sfx, 		&cart->bank0.sfx, 		sizeof(tic_sfx)); break;
-						case 5: memcpy(&tic->cart.bank0.music, 		&cart->bank0.music, 	sizeof(tic_music)); break;
-						case 6: memcpy(&tic->cart.bank0.palette, 	&cart->bank0.palette,	sizeof(tic_palette)); break;
+						case 0: memcpy(&tic->cart->cover, 			&cart->cover, 			sizeof cart->cover); break;
+						case 1: memcpy(&tic->cart->bank0.tiles, 		&cart->bank0.tiles, 	sizeof(tic_tiles)*2); break;
+						case 2: memcpy(&tic->cart->bank0.map, 		&cart->bank0.map, 		sizeof(tic_map)); break;
+						case 3: memcpy(&tic->cart->code, 			&cart->code, 			sizeof(tic_code)); break;
+						case 4: memcpy(&tic->cart->bank0.sfx, 		&cart->bank0.sfx, 		sizeof(tic_sfx)); break;
+						case 5: memcpy(&tic->cart->bank0.music, 		&cart->bank0.music, 	sizeof(tic_music)); break;
+						case 6: memcpy(&tic->cart->bank0.palette, 	&cart->bank0.palette,	sizeof(tic_palette)); break;
 						}
 
 						studioRomLoaded();
@@ -803,7 +804,7 @@ static s32 saveProject(Console* console, void* buffer, const char* comment)
 	tic_mem* tic = console->tic;
 
 	char* stream = buffer;
-	char* ptr = saveTextSection(stream, tic->cart.code.data);
+	char* ptr = saveTextSection(stream, tic->cart->code.data);
 	char tag[16];
 
 	for(s32 i = 0; i < COUNT_OF(BinarySections); i++)
@@ -815,11 +816,11 @@ static s32 saveProject(Console* console, void* buffer, const char* comment)
 			makeTag(section->tag, tag, b);
 
 			ptr = saveBinarySection(ptr, comment, tag, section->count, 
-				(u8*)&tic->cart.banks[b] + section->offset, section->size, section->flip);
+				(u8*)&tic->cart->banks[b] + section->offset, section->size, section->flip);
 		}
 	}		
 
-	ptr = saveBinarySection(ptr, comment, "COVER", 1, &tic->cart.cover, tic->cart.cover.size + sizeof(s32), true);
+	ptr = saveBinarySection(ptr, comment, "COVER", 1, &tic->cart->cover, tic->cart->cover.size + sizeof(s32), true);
 
 	return strlen(stream);
 }
@@ -998,8 +999,6 @@ static bool loadProject(Console* console, const char* name, const char* data, s3
 
 static void updateProject(Console* console)
 {
-	tic_mem* tic = console->tic;
-
 	if(strlen(console->romName) && hasProjectExt(console->romName))
 	{
 		s32 size = 0;
@@ -1012,11 +1011,7 @@ static void updateProject(Console* console)
 			if(cart)
 			{
 				if(loadProject(console, console->romName, data, size, cart))
-				{
-					memcpy(&tic->cart, cart, sizeof(tic_cartridge));
-
-					studioRomLoaded();
-				}
+					studioRomUpdated(cart);
 				
 				free(cart);
 			}
@@ -1075,7 +1070,7 @@ static void onConsoleLoadCommandConfirmed(Console* console, const char* param)
 
 			if(data)
 			{
-				loadProject(console, name, data, size, &console->tic->cart);
+				loadProject(console, name, data, size, console->tic->cart);
 				onCartLoaded(console, name);
 
 				free(data);
@@ -1593,6 +1588,35 @@ static void onFileDownloaded(GetResult result, void* data)
 	commandDone(console);
 }
 
+// with import options the cover is stored already mapped to the palette
+static s32 importCover(Console* console, const gif_image* image)
+{
+	enum {Size = TIC80_WIDTH * TIC80_HEIGHT};
+
+	s32 size = 0;
+	tic_rgb* rgb = malloc(Size * sizeof(tic_rgb));
+	u8* colors = malloc(Size);
+	tic_quantizer* quantizer = tic_tool_quantizer_create(getBankPalette()->colors, console->import.perceptual);
+
+	if(rgb && colors && quantizer)
+	{
+		for (s32 i = 0; i < Size; i++)
+		{
+			const gif_color* c = &image->palette[image->buffer[i]];
+			rgb[i] = (tic_rgb){c->r, c->g, c->b};
+		}
+
+		tic_tool_quantize(quantizer, rgb, colors, TIC80_WIDTH, TIC80_HEIGHT, console->import.dither);
+		size = writeGifData(console->tic, console->tic->cart->cover.data, colors, TIC80_WIDTH, TIC80_HEIGHT);
+	}
+
+	tic_tool_quantizer_free(quantizer);
+	free(rgb);
+	free(colors);
+
+	return size;
+}
+
 static void onImportCover(const char* name, const void* buffer, size_t size, void* data)
 {
 	Console* console = (Console*)data;
@@ -1618,10 +1642,26 @@ static void onImportCover(const char* name, const void* buffer, size_t size, voi
 
 				if(image->width == Width && image->height == Height)
 				{
-					if(size <= sizeof console->tic->cart.cover.data)
+					if(console->import.dither != tic_dither_none || console->import.perceptual)
 					{
-						console->tic->cart.cover.size = size;
-						memcpy(console->tic->cart.cover.data, buffer, size);
+						s32 coverSize = importCover(console, image);
+
+						if(coverSize)
+						{
+							console->tic->cart->cover.size = coverSize;
+							studioCartEdited();
+
+							printLine(console);
+							printBack(console, name);
+							printBack(console, " successfully imported");
+						}
+						else printError(console, "\ncover image importing error :(");
+					}
+					else if(size <= sizeof console->tic->cart->cover.data)
+					{
+						console->tic->cart->cover.size = size;
+						memcpy(console->tic->cart->cover.data, buffer, size);
+						studioCartEdited();
 
 						printLine(console);
 						printBack(console, name);
@@ -1642,6 +1682,43 @@ static void onImportCover(const char* name, const void* buffer, size_t size, voi
 	commandDone(console);
 }
 
+static void importSprites(tic_tile* tiles, const tic_palette* palette, const gif_image* image, tic_dither dither, bool perceptual)
+{
+	enum
+	{
+		Width = TIC_SPRITESHEET_SIZE,
+		Height = TIC_SPRITESHEET_SIZE*2,
+	};
+
+	s32 w = MIN(Width, image->width);
+	s32 h = MIN(Height, image->height);
+
+	tic_rgb* rgb = malloc(w * h * sizeof(tic_rgb));
+	u8* colors = malloc(w * h);
+	tic_quantizer* quantizer = tic_tool_quantizer_create(palette->colors, perceptual);
+
+	if(rgb && colors && quantizer)
+	{
+		for (s32 y = 0; y < h; y++)
+			for (s32 x = 0; x < w; x++)
+			{
+				u8 src = image->buffer[x + y * image->width];
+				const gif_color* c = &image->palette[src];
+				rgb[x + y * w] = (tic_rgb){c->r, c->g, c->b};
+			}
+
+		tic_tool_quantize(quantizer, rgb, colors, w, h, dither);
+
+		for (s32 y = 0; y < h; y++)
+			for (s32 x = 0; x < w; x++)
+				setSpritePixel(tiles, x, y, colors[x + y * w]);
+	}
+
+	tic_tool_quantizer_free(quantizer);
+	free(rgb);
+	free(colors);
+}
+
 static void onImportSprites(const char* name, const void* buffer, size_t size, void* data)
 {
 	Console* console = (Console*)data;
@@ -1658,25 +1735,8 @@ static void onImportSprites(const char* name, const void* buffer, size_t size, v
 
 			if (image)
 			{
-				enum
-				{
-					Width = TIC_SPRITESHEET_SIZE,
-					Height = TIC_SPRITESHEET_SIZE*2,
-				};
-
-				s32 w = MIN(Width, image->width);
-				s32 h = MIN(Height, image->height);
-
-				for (s32 y = 0; y < h; y++)
-					for (s32 x = 0; x < w; x++)
-					{
-						u8 src = image->buffer[x + y * image->width];
-						const gif_color* c = &image->palette[src];
-						tic_rgb rgb = {c->r, c->g, c->b};
-						u8 color = tic_tool_find_closest_color(getBankPalette()->colors, &rgb);
-
-						setSpritePixel(getBankTiles()->data, x, y, color);
-					}
+				importSprites(getBankTiles()->data, getBankPalette(), image, console->import.dither, console->import.perceptual);
+				studioCartEdited();
 
 				gif_close(image);
 
@@ -1699,6 +1759,8 @@ static void injectMap(Console* console, const void* buffer, s32 size)
 
 	memset(getBankMap(), 0, Size);
 	memcpy(getBankMap(), buffer, MIN(size, Size));
+
+	studioCartEdited();
 }
 
 static void onImportMap(const char* name, const void* buffer, size_t size, void* data)
@@ -1717,18 +1779,46 @@ static void onImportMap(const char* name, const void* buffer, size_t size, void*
 	commandDone(console);
 }
 
+static bool isImportKind(const char* param, size_t len, const char* kind)
+{
+	return strlen(kind) == len && strncmp(param, kind, len) == 0;
+}
+
+// the words after sprites or cover pick the gif colors mapping:
+// 'dither' for Floyd-Steinberg, 'ordered' for Bayer dithering, 'oklab' for perceptual distance
+static void setImportOptions(Console* console, const char* options)
+{
+	console->import.dither = tic_dither_none;
+	console->import.perceptual = false;
+
+	if(options)
+	{
+		if(strstr(options, "ordered"))
+			console->import.dither = tic_dither_ordered;
+		else if(strstr(options, "dither"))
+			console->import.dither = tic_dither_floyd_steinberg;
+
+		console->import.perceptual = strstr(options, "oklab") != NULL;
+	}
+}
+
 static void onConsoleImportCommand(Console* console, const char* param)
 {
+	const char* options = param ? strchr(param, ' ') : NULL;
+	size_t len = options ? options - param : param ? strlen(param) : 0;
+
+	setImportOptions(console, options);
+
 	if(param == NULL)
 	{
-		printBack(console, "\nusage: import sprites|cover|map");
+		printBack(console, "\nusage: import sprites|cover [dither|ordered] [oklab]|map");
 		commandDone(console);
 	}
-	else if(param && strcmp(param, "sprites") == 0)
+	else if(isImportKind(param, len, "sprites"))
 		fsOpenFileData(onImportSprites, console);
-	else if(param && strcmp(param, "map") == 0)
+	else if(isImportKind(param, len, "map"))
 		fsOpenFileData(onImportMap, console);
-	else if(param && strcmp(param, "cover") == 0)
+	else if(isImportKind(param, len, "cover"))
 		fsOpenFileData(onImportCover, console);
 	else
 	{
@@ -1764,7 +1854,7 @@ static void onCoverExported(GetResult result, void* data)
 
 static void exportCover(Console* console)
 {
-	tic_cover_image* cover = &console->tic->cart.cover;
+	tic_cover_image* cover = &console->tic->cart->cover;
 
 	if(cover->size)
 	{
@@ -1902,14 +1992,14 @@ static void* embedCart(Console* console, s32* size)
 
 	if(app)
 	{
-		void* cart = malloc(sizeof(tic_cartridge));
+		void* cart = malloc(TIC_CART_SAVE_SIZE);
 
 		if(cart)
 		{
-			s32 cartSize = tic->api.save(&tic->cart, cart);
+			s32 cartSize = tic->api.save(tic->cart, cart);
 
 			{
-				unsigned long zipSize = sizeof(tic_cartridge);
+				unsigned long zipSize = TIC_CART_SAVE_SIZE;
 				u8* zip = (u8*)malloc(zipSize);
 
 				if(zip)
@@ -2055,7 +2145,7 @@ static CartSaveResult saveCartName(Console* console, const char* name)
 #endif
 				{
 					name = getCartName(name);
-					size = tic->api.save(&tic->cart, buffer);
+					size = tic->api.save(tic->cart, buffer);
 				}
 
 				if(size && fsSaveFile(console->fs, name, buffer, size, true))
@@ -2138,7 +2228,7 @@ static void onConsoleResumeCommand(Console* console, const char* param)
 	const tic_script_config* script_config = console->tic->api.get_script_config(console->tic);
 	if (script_config->eval && console->codeLiveReload.active)
 	{
-		script_config->eval(console->tic, console->tic->cart.code.data);
+		script_config->eval(console->tic, console->tic->cart->code.data);
 	}
 	console->tic->api.resume(console->tic);
 
@@ -2845,7 +2935,7 @@ static void tick(Console* console)
 			if(!console->skipStart)
 				console->showGameMenu = true;
 
-			memcpy(&tic->cart, console->embed.file, sizeof(tic_cartridge));
+			memcpy(tic->cart, console->embed.file, sizeof(tic_cartridge));
 			setStudioMode(TIC_RUN_MODE);
 			console->embed.yes = false;
 			console->skipStart = false;
@@ -2983,51 +3073,81 @@ static bool cmdInjectCode(Console* console, const char* param, const char* name)
 	return done;
 }
 
-static bool cmdInjectSprites(Console* console, const char* param, const char* name)
+static bool loadSpritesFile(tic_cartridge* cart, const char* name)
 {
 	bool done = false;
+	s32 size = 0;
+	void* sprites = fsReadFile(name, &size);
 
-	if(strcmp(param, "-sprites") == 0)
+	if(sprites)
 	{
-		s32 size = 0;
-		void* sprites = fsReadFile(name, &size);
+		gif_image* image = gif_read_data(sprites, size);
 
-		if(sprites)
+		if (image)
 		{
-			gif_image* image = gif_read_data(sprites, size);
+			importSprites(cart->bank0.tiles.data, &cart->bank0.palette, image, tic_dither_none, false);
 
-			if (image)
-			{
-				enum
-				{
-					Width = TIC_SPRITESHEET_SIZE,
-					Height = TIC_SPRITESHEET_SIZE*2,
-				};
+			gif_close(image);
+		}
 
-				s32 w = MIN(Width, image->width);
-				s32 h = MIN(Height, image->height);
+		free(sprites);
+		done = true;
+	}
 
-				for (s32 y = 0; y < h; y++)
-					for (s32 x = 0; x < w; x++)
-					{
-						u8 src = image->buffer[x + y * image->width];
-						const gif_color* c = &image->palette[src];
-						tic_rgb rgb = {c->r, c->g, c->b};
-						u8 color = tic_tool_find_closest_color(console->embed.file->bank0.palette.colors, &rgb);
+	return done;
+}
 
-						setSpritePixel(console->embed.file->bank0.tiles.data, x, y, color);
-					}
+static bool loadMapFile(Console* console, const char* name)
+{
+	bool done = false;
+	s32 size = 0;
+	void* map = fsReadFile(name, &size);
 
-				gif_close(image);
-			}
+	if(map)
+	{
+		if(size <= sizeof(tic_map))
+		{
+			injectMap(console, map, size);
+			done = true;
+		}
 
-			free(sprites);
+		free(map);
+	}
 
+	return done;
+}
+
+static void tryReloadSprites(Console* console)
+{
+	if(strlen(console->injectLiveReload.sprites))
+	{
+		loadSpritesFile(console->tic->cart, console->injectLiveReload.sprites);
+		studioCartEdited();
+	}
+}
+
+static void tryReloadMap(Console* console)
+{
+	if(strlen(console->injectLiveReload.map))
+		loadMapFile(console, console->injectLiveReload.map);
+}
+
+static bool cmdInjectSprites(Console* console, const char* param, const char* name)
+{
+	bool done = false;
+
+	bool watch = strcmp(param, "-sprites-watch") == 0;
+	if(watch || strcmp(param, "-sprites") == 0)
+	{
+		if(loadSpritesFile(console->embed.file, name))
+		{
 			console->embed.yes = true;
 			console->skipStart = true;
 			done = true;
-		}
 
+			if(watch)
+				strcpy(console->injectLiveReload.sprites, name);
+		}
 	}
 
 	return done;
@@ -3037,29 +3157,36 @@ static bool cmdInjectMap(Console* console, const char* param, const char* name)
 {
 	bool done = false;
 
-	if(strcmp(param, "-map") == 0)
+	bool watch = strcmp(param, "-map-watch") == 0;
+	if(watch || strcmp(param, "-map") == 0)
 	{
-		s32 size = 0;
-		void* map = fsReadFile(name, &size);
-
-		if(map)
+		if(loadMapFile(console, name))
 		{
-			if(size <= sizeof(tic_map))
-			{
-				injectMap(console, map, size);
-
-				console->embed.yes = true;
-				console->skipStart = true;
-				done = true;
-			}
+			console->embed.yes = true;
+			console->skipStart = true;
+			done = true;
 
-			free(map);
+			if(watch)
+				strcpy(console->injectLiveReload.map, name);
 		}
 	}
 
 	return done;
 }
 
+static bool cmdCapture(Console* console, const char* param, const char* path)
+{
+	bool done = false;
+
+	if(strcmp(param, "-capture") == 0)
+	{
+		strncpy(console->capturePath, path, FILENAME_MAX-1);
+		done = true;
+	}
+
+	return done;
+}
+
 static bool checkUIScale(Console* console, const char* param, const char* value)
 {
 	bool done = false;
@@ -3113,6 +3240,11 @@ void initConsole(Console* console, tic_mem* tic, FileSystem* fs, Config* config,
 			.active = false,
 			.reload = tryReloadCode,
 		},
+		.injectLiveReload =
+		{
+			.reloadSprites = tryReloadSprites,
+			.reloadMap = tryReloadMap,
+		},
 		.embed =
 		{
 			.yes = false,
@@ -3137,6 +3269,8 @@ void initConsole(Console* console, tic_mem* tic, FileSystem* fs, Config* config,
 	memset(console->colorBuffer, TIC_COLOR_BG, CONSOLE_BUFFER_SIZE);
 
 	memset(console->codeLiveReload.fileName, 0, FILENAME_MAX);
+	memset(console->injectLiveReload.sprites, 0, FILENAME_MAX);
+	memset(console->injectLiveReload.map, 0, FILENAME_MAX);
 
 	if(argc)
 	{
@@ -3182,6 +3316,7 @@ void initConsole(Console* console, tic_mem* tic, FileSystem* fs, Config* config,
 				if(cmdInjectCode(console, first, second)
 					|| cmdInjectSprites(console, first, second)
 					|| cmdInjectMap(console, first, second)
+					|| cmdCapture(console, first, second)
 					|| checkUIScale(console, first, second))
 					argp |= mask;
 			}
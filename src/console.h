@@ -69,12 +69,29 @@ struct Console
 		void(*reload)(Console*, char*);
 	} codeLiveReload;
 
+	// -sprites-watch and -map-watch files, imported into the cart again when they change
+	struct
+	{
+		char sprites[FILENAME_MAX];
+		char map[FILENAME_MAX];
+
+		void(*reloadSprites)(Console*);
+		void(*reloadMap)(Console*);
+	} injectLiveReload;
+
 	struct
 	{
 		bool yes;
 		tic_cartridge* file;
 	} embed;
 
+	// options given after "import sprites|cover", read when the file arrives
+	struct
+	{
+		tic_dither dither;
+		bool perceptual;
+	} import;
+
 	char* buffer;
 	u8* colorBuffer;
 
@@ -87,6 +104,7 @@ struct Console
 
 	char romName[FILENAME_MAX];
 	char appPath[FILENAME_MAX];
+	char capturePath[FILENAME_MAX];
 
 	HistoryItem* history;
 	HistoryItem* historyHead;
@@ -1024,6 +1024,24 @@ u64 fsMDate(FileSystem* fs, const char* name)
 #endif
 }
 
+const char* fsGetFilePath(FileSystem* fs, const char* name)
+{
+	return getFilePath(fs, name);
+}
+
+const char* fsGetRootFilePath(FileSystem* fs, const char* name)
+{
+	char work[FILENAME_MAX];
+	strcpy(work, fs->work);
+	fsHomeDir(fs);
+
+	const char* path = getFilePath(fs, name);
+
+	strcpy(fs->work, work);
+
+	return path;
+}
+
 bool fsSaveFile(FileSystem* fs, const char* name, const void* data, size_t size, bool overwrite)
 {
 	if(!overwrite)
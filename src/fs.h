@@ -60,6 +60,8 @@ void* fsLoadRootFile(FileSystem* fs, const char* name, s32* size);
 void fsMakeDir(FileSystem* fs, const char* name);
 bool fsExistsFile(FileSystem* fs, const char* name);
 u64 fsMDate(FileSystem* fs, const char* name);
+const char* fsGetFilePath(FileSystem* fs, const char* name);
+const char* fsGetRootFilePath(FileSystem* fs, const char* name);
 
 void fsBasename(const char *path, char* out);
 void fsFilename(const char *path, char* out);
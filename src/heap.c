@@ -0,0 +1,498 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "heap.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+	LargeClass = 0xff,
+	SmallSize = TIC_HEAP_GRANULE * TIC_HEAP_CLASSES,
+};
+
+typedef struct
+{
+	u32 size;
+	u32 cls;
+} Header;
+
+// what keeps a chunk or a large block allocated, images don't copy it
+typedef struct
+{
+	void* block;
+	size_t size;	// taken from the system
+	u32 images;		// images holding the block
+	bool live;		// the heap uses it
+	bool keep;		// held by the image being restored
+} Refs;
+
+// the refs of a chunk follow its data
+struct tic_heap_chunk
+{
+	tic_heap_chunk* next;
+	u64 data[];
+};
+
+struct tic_heap_large
+{
+	Refs refs;
+	tic_heap_large* prev;
+	tic_heap_large* next;
+	size_t size;
+	u64 data[];
+};
+
+struct tic_heap_free
+{
+	tic_heap_free* next;
+};
+
+typedef struct
+{
+	Refs* refs;
+	void* ptr;
+	size_t size;
+} Region;
+
+struct tic_heap_image
+{
+	tic_heap heap;
+	tic_heap_image* next;
+	u32 id;
+	size_t size;
+	s32 count;
+	Region regions[];
+};
+
+static inline Header* getHeader(void* ptr)
+{
+	return (Header*)ptr - 1;
+}
+
+static inline size_t blockSize(const Header* header)
+{
+	return header->cls == LargeClass 
+		? sizeof(tic_heap_large) + sizeof(Header) + header->size
+		: (header->cls + 1) * TIC_HEAP_GRANULE;
+}
+
+static inline tic_heap_large* getLarge(void* ptr)
+{
+	return (tic_heap_large*)((u8*)getHeader(ptr) - sizeof(tic_heap_large));
+}
+
+static inline Refs* chunkRefs(tic_heap_chunk* chunk)
+{
+	return (Refs*)((u8*)chunk->data + TIC_HEAP_CHUNK);
+}
+
+static void letGo(tic_heap* heap, Refs* refs)
+{
+	refs->live = false;
+
+	// an image needs the memory to stay where it was
+	if(refs->images)
+		heap->pinned += refs->size;
+	else free(refs->block);
+}
+
+static bool reserve(tic_heap* heap, size_t size, bool force)
+{
+	if(heap->limit && heap->used + size > heap->limit)
+	{
+		heap->overflow = true;
+
+		if(!force) return false;
+	}
+
+	heap->used += size;
+
+	if(heap->used > heap->peak)
+		heap->peak = heap->used;
+
+	heap->allocs++;
+	heap->frameAllocs++;
+
+	return true;
+}
+
+static void* allocSmall(tic_heap* heap, u32 cls)
+{
+	tic_heap_free* block = heap->free[cls];
+
+	if(block)
+		heap->free[cls] = block->next;
+	else
+	{
+		size_t size = (cls + 1) * TIC_HEAP_GRANULE;
+
+		if(heap->top + size > heap->end)
+		{
+			enum {ChunkSize = sizeof(tic_heap_chunk) + TIC_HEAP_CHUNK + sizeof(Refs)};
+			tic_heap_chunk* chunk = malloc(ChunkSize);
+
+			if(!chunk) return NULL;
+
+			*chunkRefs(chunk) = (Refs){.block = chunk, .size = ChunkSize, .live = true};
+
+			chunk->next = heap->chunks;
+			heap->chunks = chunk;
+			heap->top = (u8*)chunk->data;
+			heap->end = heap->top + TIC_HEAP_CHUNK;
+		}
+
+		block = (tic_heap_free*)heap->top;
+		heap->top += size;
+	}
+
+	Header* header = (Header*)block;
+	header->cls = cls;
+
+	return header + 1;
+}
+
+static void* allocLarge(tic_heap* heap, size_t size)
+{
+	size_t largeSize = sizeof(tic_heap_large) + sizeof(Header) + size;
+	tic_heap_large* large = malloc(largeSize);
+
+	if(!large) return NULL;
+
+	large->refs = (Refs){.block = large, .size = largeSize, .live = true};
+	large->prev = NULL;
+	large->next = heap->large;
+	large->size = size;
+
+	if(heap->large)
+		heap->large->prev = large;
+
+	heap->large = large;
+
+	Header* header = (Header*)large->data;
+	header->cls = LargeClass;
+
+	return header + 1;
+}
+
+static void* heapAlloc(tic_heap* heap, size_t size, bool force)
+{
+	size_t total = size + sizeof(Header);
+	bool small = total <= SmallSize;
+	u32 cls = small ? (u32)((total - 1) / TIC_HEAP_GRANULE) : LargeClass;
+	size_t reserved = small ? (cls + 1) * TIC_HEAP_GRANULE : sizeof(tic_heap_large) + total;
+
+	if(size > UINT32_MAX || !reserve(heap, reserved, force))
+		return NULL;
+
+	void* ptr = small ? allocSmall(heap, cls) : allocLarge(heap, size);
+
+	if(ptr)
+		getHeader(ptr)->size = (u32)size;
+	else
+		heap->used -= reserved;
+
+	return ptr;
+}
+
+static void heapFree(tic_heap* heap, void* ptr)
+{
+	Header* header = getHeader(ptr);
+
+	heap->used -= blockSize(header);
+
+	if(header->cls == LargeClass)
+	{
+		tic_heap_large* large = getLarge(ptr);
+
+		if(large->prev) large->prev->next = large->next;
+		else heap->large = large->next;
+
+		if(large->next) large->next->prev = large->prev;
+
+		letGo(heap, &large->refs);
+	}
+	else
+	{
+		u32 cls = header->cls;
+		tic_heap_free* block = (tic_heap_free*)header;
+
+		block->next = heap->free[cls];
+		heap->free[cls] = block;
+	}
+}
+
+static void* heapRealloc(tic_heap* heap, void* ptr, size_t size, bool force)
+{
+	if(!ptr)
+		return size ? heapAlloc(heap, size, force) : NULL;
+
+	if(!size)
+	{
+		heapFree(heap, ptr);
+		return NULL;
+	}
+
+	Header* header = getHeader(ptr);
+
+	// shrinking keeps the block, so it never fails
+	if(header->cls == LargeClass ? size <= header->size : size + sizeof(Header) <= blockSize(header))
+	{
+		if(header->cls != LargeClass)
+			header->size = (u32)size;
+
+		return ptr;
+	}
+
+	void* result = heapAlloc(heap, size, force);
+
+	if(result)
+	{
+		memcpy(result, ptr, header->size);
+		heapFree(heap, ptr);
+	}
+
+	return result;
+}
+
+void* tic_heap_realloc(tic_heap* heap, void* ptr, size_t size)
+{
+	return heapRealloc(heap, ptr, size, false);
+}
+
+void* tic_heap_force_realloc(tic_heap* heap, void* ptr, size_t size)
+{
+	return heapRealloc(heap, ptr, size, true);
+}
+
+static tic_heap_image** findImage(tic_heap* heap, u32 id)
+{
+	tic_heap_image** link = &heap->images;
+
+	while(*link && (*link)->id != id)
+		link = &(*link)->next;
+
+	return link;
+}
+
+static void dropImage(tic_heap* heap, tic_heap_image** link)
+{
+	tic_heap_image* image = *link;
+
+	*link = image->next;
+
+	for(s32 i = 0; i < image->count; i++)
+	{
+		Refs* refs = image->regions[i].refs;
+
+		if(--refs->images == 0 && !refs->live)
+		{
+			heap->pinned -= refs->size;
+			free(refs->block);
+		}
+	}
+
+	free(image);
+}
+
+// the refs stay out of the copied part of a large block
+static inline void* largeRegion(tic_heap_large* large)
+{
+	return &large->prev;
+}
+
+static inline size_t largeRegionSize(const tic_heap_large* large)
+{
+	return large->refs.size - offsetof(tic_heap_large, prev);
+}
+
+static inline size_t chunkSize(const tic_heap* heap, const tic_heap_chunk* chunk)
+{
+	return chunk == heap->chunks 
+		? heap->top - (u8*)chunk 
+		: sizeof(tic_heap_chunk) + TIC_HEAP_CHUNK;
+}
+
+void tic_heap_release(tic_heap* heap)
+{
+	while(heap->images)
+		dropImage(heap, &heap->images);
+
+	for(tic_heap_chunk* chunk = heap->chunks, *next; chunk; chunk = next)
+	{
+		next = chunk->next;
+		free(chunk);
+	}
+
+	for(tic_heap_large* large = heap->large, *next; large; large = next)
+	{
+		next = large->next;
+		free(large);
+	}
+
+	size_t limit = heap->limit;
+	u32 serial = heap->serial;
+
+	memset(heap, 0, sizeof(tic_heap));
+
+	// ids of dropped images never come back
+	heap->limit = limit;
+	heap->serial = serial;
+}
+
+static inline void addRegion(tic_heap_image* image, Refs* refs, void* ptr, size_t size)
+{
+	refs->images++;
+	image->regions[image->count++] = (Region){refs, ptr, size};
+}
+
+u32 tic_heap_save(tic_heap* heap)
+{
+	s32 count = 0;
+	size_t size = 0;
+
+	for(tic_heap_chunk* chunk = heap->chunks; chunk; chunk = chunk->next)
+		count++, size += chunkSize(heap, chunk);
+
+	for(tic_heap_large* large = heap->large; large; large = large->next)
+		count++, size += largeRegionSize(large);
+
+	tic_heap_image* image = malloc(sizeof(tic_heap_image) + count * sizeof(Region) + size);
+
+	if(!image) return 0;
+
+	image->heap = *heap;
+	image->size = sizeof(tic_heap_image) + count * sizeof(Region) + size;
+	image->count = 0;
+
+	u8* data = (u8*)(image->regions + count);
+
+	for(tic_heap_chunk* chunk = heap->chunks; chunk; chunk = chunk->next)
+		addRegion(image, chunkRefs(chunk), chunk, chunkSize(heap, chunk));
+
+	for(tic_heap_large* large = heap->large; large; large = large->next)
+		addRegion(image, &large->refs, largeRegion(large), largeRegionSize(large));
+
+	for(s32 i = 0; i < count; i++)
+	{
+		memcpy(data, image->regions[i].ptr, image->regions[i].size);
+		data += image->regions[i].size;
+	}
+
+	if(++heap->serial == 0)
+		heap->serial++;
+
+	image->id = heap->serial;
+	image->next = heap->images;
+	heap->images = image;
+
+	return image->id;
+}
+
+bool tic_heap_restore(tic_heap* heap, u32 id)
+{
+	tic_heap_image* image = *findImage(heap, id);
+
+	if(!image) return false;
+
+	for(s32 i = 0; i < image->count; i++)
+		image->regions[i].refs->keep = true;
+
+	// blocks the image doesn't have go away, unless another image holds them
+	for(tic_heap_chunk* chunk = heap->chunks, *next; chunk; chunk = next)
+	{
+		next = chunk->next;
+
+		if(!chunkRefs(chunk)->keep)
+			letGo(heap, chunkRefs(chunk));
+	}
+
+	for(tic_heap_large* large = heap->large, *next; large; large = next)
+	{
+		next = large->next;
+
+		if(!large->refs.keep)
+			letGo(heap, &large->refs);
+	}
+
+	// and the ones it has come back where they were
+	const u8* data = (const u8*)(image->regions + image->count);
+
+	for(s32 i = 0; i < image->count; i++)
+	{
+		Refs* refs = image->regions[i].refs;
+
+		if(!refs->live)
+		{
+			refs->live = true;
+			heap->pinned -= refs->size;
+		}
+
+		refs->keep = false;
+
+		memcpy(image->regions[i].ptr, data, image->regions[i].size);
+		data += image->regions[i].size;
+	}
+
+	tic_heap current = *heap;
+
+	*heap = image->heap;
+
+	heap->limit = current.limit;
+	heap->images = current.images;
+	heap->pinned = current.pinned;
+	heap->serial = current.serial;
+
+	return true;
+}
+
+void tic_heap_drop(tic_heap* heap, u32 id)
+{
+	tic_heap_image** link = findImage(heap, id);
+
+	if(*link)
+		dropImage(heap, link);
+}
+
+size_t tic_heap_footprint(const tic_heap* heap)
+{
+	size_t size = 0;
+
+	for(tic_heap_chunk* chunk = heap->chunks; chunk; chunk = chunk->next)
+		size += chunkRefs(chunk)->size;
+
+	for(const tic_heap_large* large = heap->large; large; large = large->next)
+		size += large->refs.size;
+
+	return size;
+}
+
+size_t tic_heap_image_size(const tic_heap* heap)
+{
+	size_t size = heap->pinned;
+
+	for(const tic_heap_image* image = heap->images; image; image = image->next)
+		size += image->size;
+
+	return size;
+}
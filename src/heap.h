@@ -0,0 +1,89 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "tic.h"
+
+#include <stddef.h>
+
+// Arena for the script VMs of one machine.
+// Small blocks come from per size class free lists carved out of big chunks,
+// larger ones are malloc'ed and kept in a list, so the whole VM is thrown away
+// at once instead of freeing every object. Allocations past the limit fail
+// like a regular out of memory. Saved images of the heap let the VM be rolled
+// back to the moment any of them was taken, in any order.
+
+enum
+{
+	TIC_HEAP_GRANULE = 16,
+	TIC_HEAP_CLASSES = 32,
+	TIC_HEAP_CHUNK = 256 * 1024,
+};
+
+typedef struct tic_heap_chunk tic_heap_chunk;
+typedef struct tic_heap_large tic_heap_large;
+typedef struct tic_heap_free tic_heap_free;
+typedef struct tic_heap_image tic_heap_image;
+
+typedef struct
+{
+	size_t limit; // 0 means no limit
+	size_t used;
+	size_t peak;
+	u32 allocs;
+	u32 frameAllocs;
+	bool overflow;
+
+	tic_heap_chunk* chunks;
+	u8* top;
+	u8* end;
+
+	tic_heap_free* free[TIC_HEAP_CLASSES];
+	tic_heap_large* large;
+
+	// images by age, blocks the heap let go of stay allocated while an image holds them
+	tic_heap_image* images;
+	size_t pinned;
+	u32 serial;
+} tic_heap;
+
+// realloc semantics, returns NULL and sets overflow when the limit is hit
+void* tic_heap_realloc(tic_heap* heap, void* ptr, size_t size);
+
+// the same, but goes over the limit instead of failing, for VMs which don't check for NULL
+void* tic_heap_force_realloc(tic_heap* heap, void* ptr, size_t size);
+
+// frees every block at once and drops the images, keeps the limit
+void tic_heap_release(tic_heap* heap);
+
+// copies every block aside, returns the image id or 0 when out of memory
+u32 tic_heap_save(tic_heap* heap);
+
+// brings back every block as it was when the image was saved, false if there is no such image,
+// the other images stay valid
+bool tic_heap_restore(tic_heap* heap, u32 image);
+void tic_heap_drop(tic_heap* heap, u32 image);
+
+// memory taken from the system by the blocks, and by the images with the blocks they keep alive
+size_t tic_heap_footprint(const tic_heap* heap);
+size_t tic_heap_image_size(const tic_heap* heap);
@@ -26,87 +26,74 @@
 #include <stdio.h>
 #include <string.h>
 
+// every history keeps at most HistorySteps steps and evicts the oldest ones
+// when their diffs don't fit the arena of HistoryScale tracked buffers
+enum
+{
+	HistorySteps = 1024,
+	HistoryScale = 4,
+	HistoryMinArena = 16 * 1024,
+};
+
 typedef struct
 {
-	u8* buffer;
+	u32 offset;
 	u32 start;
 	u32 end;
-} Data;
+} Item;
 
-typedef struct Item Item;
-
-struct Item
+struct History
 {
-	Item* next;
-	Item* prev;
+	// applied steps are [first, current), redo steps are [current, last)
+	Item* items;
+	u32 first;
+	u32 current;
+	u32 last;
 
-	Data data;
-};
+	u8* arena;
+	u32 arenaSize;
 
-static void list_delete(Item* list, Item* from)
-{
-	Item* it = from;
+	u32 size;
+	u8* state;
 
-	while(it)
-	{
-		Item* next = it->next;
+	void* data;
 
-		if(it->data.buffer) free(it->data.buffer);
-		if(it) free(it);
+	u32 generation;
+};
 
-		it = next;
-	}
-}
+// shared by all the histories, so a new one never repeats a generation seen before
+static u32 Generation = 0;
 
-static Item* list_insert(Item* list, Data* data)
+static inline Item* getItem(History* history, u32 index)
 {
-	Item* item = (Item*)malloc(sizeof(Item));
-	item->next = NULL;
-	item->prev = NULL;
-	item->data = *data;
-
-	if(list)
-	{
-		list_delete(list, list->next);
-
-		list->next = item;
-		item->prev = list;
-	}
-
-	return item;
+	return &history->items[index % HistorySteps];
 }
 
-static Item* list_first(Item* list)
+static inline u32 getItemSize(const Item* item)
 {
-	Item* it = list;
-	while(it->prev) it = it->prev;
-
-	return it;
+	return item->end - item->start;
 }
 
-struct History
-{
-	Item* list;
-
-	u32 size;
-	u8* state;
-
-	void* data;
-};
-
 History* history_create(void* data, u32 size)
 {
 	History* history = (History*)malloc(sizeof(History));
 	history->data = data;
 
-	history->list = NULL;
+	history->items = NULL;
+	history->first = history->current = history->last = 0;
+
+	history->arena = NULL;
+	history->arenaSize = size * HistoryScale;
+
+	if(history->arenaSize < HistoryMinArena)
+		history->arenaSize = HistoryMinArena;
+
 	history->size = size;
 
 	history->state = malloc(size);
 	memcpy(history->state, data, history->size);
 
-	// empty diff
-	history->list = list_insert(history->list, &(Data){NULL, 0, 0});
+	history->generation = ++Generation;
 
 	return history;
 }
@@ -116,78 +103,167 @@ void history_delete(History* history)
 	if(history)
 	{
 		free(history->state);
-
-		list_delete(history->list, list_first(history->list));
+		free(history->items);
+		free(history->arena);
 
 		free(history);
 	}
 }
 
-static void history_diff(History* history, Data* data)
+static void history_diff(History* history, const Item* item)
 {
-	for (u32 i = data->start, k = 0; i < data->end; ++i, ++k)
-		history->state[i] ^= data->buffer[k];
+	const u8* buffer = history->arena + item->offset;
+
+	for (u32 i = item->start, k = 0; i < item->end; ++i, ++k)
+		history->state[i] ^= buffer[k];
 }
 
-static u32 trim_left(u8* data, u32 size)
+static u8* history_alloc(History* history, u32 size)
 {
-	for(u32 i = 0; i < size; i++)
-		if(data[i]) return i;
+	if(size > history->arenaSize)
+	{
+		history->first = history->current = history->last;
+		return NULL;
+	}
 
-	return size;
-}
+	// items and the arena are allocated with the first step
+	if(!history->items)
+	{
+		history->items = malloc(HistorySteps * sizeof(Item));
+		history->arena = malloc(history->arenaSize);
+
+		if(!history->items || !history->arena)
+		{
+			free(history->items);
+			free(history->arena);
+			history->items = NULL;
+			history->arena = NULL;
+
+			return NULL;
+		}
+	}
 
-static u32 trim_right(u8* data, u32 size)
-{
-	for(u32 i = 0; i < size; i++)
-		if(data[size - i - 1]) return size - i;
+	if(history->last - history->first == HistorySteps)
+		history->first++;
 
-	return 0;
+	// diffs are stored in step order, so the arena works as a ring buffer
+	while(history->first != history->last)
+	{
+		const Item* oldest = getItem(history, history->first);
+		const Item* newest = getItem(history, history->last - 1);
+
+		u32 head = newest->offset + getItemSize(newest);
+
+		if(newest->offset < oldest->offset)
+		{
+			if(oldest->offset - head >= size) 
+				return history->arena + head;
+		}
+		else
+		{
+			if(history->arenaSize - head >= size) 
+				return history->arena + head;
+
+			if(oldest->offset >= size) 
+				return history->arena;
+		}
+
+		history->first++;
+	}
+
+	return history->arena;
 }
 
-bool history_add(History* history)
+bool history_add_range(History* history, u32 start, u32 end)
 {
-	if (memcmp(history->state, history->data, history->size) == 0) return false;
+	if(end > history->size) end = history->size;
+	if(start >= end) return false;
 
-	history_diff(history, &(Data){history->data, 0, history->size});
+	const u8* data = (const u8*)history->data;
+	u8* state = history->state;
 
-	{
-		Data data;
-		data.start = trim_left(history->state, history->size);
-		data.end = trim_right(history->state, history->size);
-		u32 size = data.end - data.start;
-		data.buffer = malloc(size);
+	while(start < end && state[start] == data[start]) start++;
+	while(end > start && state[end - 1] == data[end - 1]) end--;
+
+	if(start == end) return false;
+
+	// adding a step drops the redo steps
+	history->last = history->current;
 
-		memcpy(data.buffer, (u8*)history->state + data.start, size);
+	u32 size = end - start;
+	u8* buffer = history_alloc(history, size);
+
+	if(buffer)
+	{
+		for(u32 i = start, k = 0; i < end; ++i, ++k)
+			buffer[k] = state[i] ^ data[i];
 
-		history->list = list_insert(history->list, &data);
+		*getItem(history, history->last++) = (Item){buffer - history->arena, start, end};
+		history->current = history->last;
 	}
 
-	memcpy(history->state, history->data, history->size);
+	memcpy(state + start, data + start, size);
+
+	history->generation = ++Generation;
 
 	return true;
 }
 
-void history_undo(History* history)
+bool history_add(History* history)
 {
-	if(history->list->prev)
-	{
-		history_diff(history, &history->list->data);
+	return history_add_range(history, 0, history->size);
+}
 
-		history->list = history->list->prev;
-	}
+bool history_undo(History* history)
+{
+	bool done = history->current != history->first;
+
+	if(done)
+		history_diff(history, getItem(history, --history->current));
 
 	memcpy(history->data, history->state, history->size);
+	history->generation = ++Generation;
+
+	return done;
 }
 
-void history_redo(History* history)
+bool history_redo(History* history)
 {
-	if(history->list->next)
-	{
-		history->list = history->list->next;
+	bool done = history->current != history->last;
 
-		history_diff(history, &history->list->data);
-	}
+	if(done)
+		history_diff(history, getItem(history, history->current++));
 
 	memcpy(history->data, history->state, history->size);
+	history->generation = ++Generation;
+
+	return done;
+}
+
+bool history_rebase(History* history)
+{
+	if(memcmp(history->state, history->data, history->size) == 0)
+		return false;
+
+	memcpy(history->state, history->data, history->size);
+	history->first = history->current = history->last;
+	history->generation = ++Generation;
+
+	return true;
+}
+
+u32 history_depth(const History* history)
+{
+	return history->current - history->first;
+}
+
+void history_keep(History* history, u32 depth)
+{
+	if(history->current - history->first > depth)
+		history->first = history->current - depth;
+}
+
+u32 history_generation(const History* history)
+{
+	return history ? history->generation : 0;
 }
@@ -28,6 +28,17 @@ typedef struct History History;
 
 History* history_create(void* data, u32 size);
 bool history_add(History* history);
-void history_undo(History* history);
-void history_redo(History* history);
-void history_delete(History* history);
\ No newline at end of file
+bool history_add_range(History* history, u32 start, u32 end);
+bool history_undo(History* history);
+bool history_redo(History* history);
+// takes data changed outside the history as the new starting point, the steps are dropped
+// since they no longer apply to it, false if the data is what the history has
+bool history_rebase(History* history);
+// steps that can be undone
+u32 history_depth(const History* history);
+// drops the oldest steps past depth, to keep a history paired with another in step
+void history_keep(History* history, u32 depth);
+void history_delete(History* history);
+
+// changes whenever the tracked data is committed, undone or redone
+u32 history_generation(const History* history);
\ No newline at end of file
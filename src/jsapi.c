@@ -27,6 +27,7 @@
 #include "tools.h"
 
 #include <ctype.h>
+#include <stdlib.h>
 
 #include "duktape.h"
 
@@ -36,13 +37,41 @@ static void closeJavascript(tic_mem* tic)
 {
 	tic_machine* machine = (tic_machine*)tic;
 
+	// the duktape heap lives in the machine heap and goes away with it
 	if(machine->js)
 	{
-		duk_destroy_heap(machine->js);
+		tic_heap_release(&machine->heap);
 		machine->js = NULL;
 	}
 }
 
+// duktape frees most of the garbage by refcounting, the rest takes a full mark and sweep
+static bool collectJavascript(tic_mem* tic)
+{
+	tic_machine* machine = (tic_machine*)tic;
+
+	if(machine->js)
+		duk_gc(machine->js, 0);
+
+	return true;
+}
+
+static void* jsAlloc(void* udata, duk_size_t size)
+{
+	return tic_heap_realloc(&((tic_machine*)udata)->heap, NULL, size);
+}
+
+static void* jsRealloc(void* udata, void* ptr, duk_size_t size)
+{
+	return tic_heap_realloc(&((tic_machine*)udata)->heap, ptr, size);
+}
+
+static void jsFree(void* udata, void* ptr)
+{
+	if(ptr)
+		tic_heap_realloc(&((tic_machine*)udata)->heap, ptr, 0);
+}
+
 static tic_machine* getDukMachine(duk_context* duk)
 {
 	duk_push_global_stash(duk);
@@ -437,6 +466,113 @@ static duk_ret_t duk_mget(duk_context* duk)
 	return 1;
 }
 
+static duk_ret_t duk_mray(duk_context* duk)
+{
+	tic_mem* memory = (tic_mem*)getDukMachine(duk);
+
+	float x0 = (float)duk_to_number(duk, 0);
+	float y0 = (float)duk_to_number(duk, 1);
+	float x1 = (float)duk_to_number(duk, 2);
+	float y1 = (float)duk_to_number(duk, 3);
+	u8 mask = duk_is_null_or_undefined(duk, 4) ? 0xff : duk_to_int(duk, 4);
+
+	tic_map_hit hit;
+	bool done = memory->api.map_ray(memory, &memory->ram.map, x0, y0, x1, y1, mask, &hit);
+
+	duk_idx_t idx = duk_push_array(duk);
+	duk_push_boolean(duk, done);
+	duk_put_prop_index(duk, idx, 0);
+	duk_push_number(duk, hit.x);
+	duk_put_prop_index(duk, idx, 1);
+	duk_push_number(duk, hit.y);
+	duk_put_prop_index(duk, idx, 2);
+	duk_push_int(duk, hit.cellx);
+	duk_put_prop_index(duk, idx, 3);
+	duk_push_int(duk, hit.celly);
+	duk_put_prop_index(duk, idx, 4);
+	duk_push_int(duk, hit.normalx);
+	duk_put_prop_index(duk, idx, 5);
+	duk_push_int(duk, hit.normaly);
+	duk_put_prop_index(duk, idx, 6);
+
+	return 1;
+}
+
+static duk_ret_t duk_msweep(duk_context* duk)
+{
+	tic_mem* memory = (tic_mem*)getDukMachine(duk);
+
+	float x = (float)duk_to_number(duk, 0);
+	float y = (float)duk_to_number(duk, 1);
+	float w = (float)duk_to_number(duk, 2);
+	float h = (float)duk_to_number(duk, 3);
+	float dx = (float)duk_to_number(duk, 4);
+	float dy = (float)duk_to_number(duk, 5);
+	u8 mask = duk_is_null_or_undefined(duk, 6) ? 0xff : duk_to_int(duk, 6);
+
+	tic_map_hit hit;
+	memory->api.map_sweep(memory, &memory->ram.map, x, y, w, h, dx, dy, mask, &hit);
+
+	duk_idx_t idx = duk_push_array(duk);
+	duk_push_number(duk, hit.x);
+	duk_put_prop_index(duk, idx, 0);
+	duk_push_number(duk, hit.y);
+	duk_put_prop_index(duk, idx, 1);
+	duk_push_int(duk, hit.normalx);
+	duk_put_prop_index(duk, idx, 2);
+	duk_push_int(duk, hit.normaly);
+	duk_put_prop_index(duk, idx, 3);
+
+	return 1;
+}
+
+static duk_ret_t duk_mfill(duk_context* duk)
+{
+	tic_mem* memory = (tic_mem*)getDukMachine(duk);
+
+	s32 x = duk_is_null_or_undefined(duk, 0) ? 0 : duk_to_int(duk, 0);
+	s32 y = duk_is_null_or_undefined(duk, 1) ? 0 : duk_to_int(duk, 1);
+	u8 mask = duk_is_null_or_undefined(duk, 2) ? 0xff : duk_to_int(duk, 2);
+	s32 tile = duk_is_null_or_undefined(duk, 3) ? -1 : (u8)duk_to_int(duk, 3);
+
+	duk_push_int(duk, memory->api.map_fill(memory, &memory->ram.map, x, y, mask, tile));
+
+	return 1;
+}
+
+static duk_ret_t duk_mpath(duk_context* duk)
+{
+	tic_mem* memory = (tic_mem*)getDukMachine(duk);
+
+	s32 x0 = duk_is_null_or_undefined(duk, 0) ? 0 : duk_to_int(duk, 0);
+	s32 y0 = duk_is_null_or_undefined(duk, 1) ? 0 : duk_to_int(duk, 1);
+	s32 x1 = duk_is_null_or_undefined(duk, 2) ? 0 : duk_to_int(duk, 2);
+	s32 y1 = duk_is_null_or_undefined(duk, 3) ? 0 : duk_to_int(duk, 3);
+	u8 mask = duk_is_null_or_undefined(duk, 4) ? 0xff : duk_to_int(duk, 4);
+	u8 cost = duk_is_null_or_undefined(duk, 5) ? 0 : duk_to_int(duk, 5);
+
+	const u16* path = NULL;
+	s32 steps = memory->api.map_path(memory, &memory->ram.map, x0, y0, x1, y1, mask, cost, &path);
+
+	if(steps < 0)
+	{
+		duk_push_null(duk);
+		return 1;
+	}
+
+	duk_idx_t idx = duk_push_array(duk);
+
+	for(s32 i = 0; i < steps; i++)
+	{
+		duk_push_int(duk, path[i] % TIC_MAP_WIDTH);
+		duk_put_prop_index(duk, idx, i * 2);
+		duk_push_int(duk, path[i] / TIC_MAP_WIDTH);
+		duk_put_prop_index(duk, idx, i * 2 + 1);
+	}
+
+	return 1;
+}
+
 static duk_ret_t duk_mset(duk_context* duk)
 {
 	s32 x = duk_is_null_or_undefined(duk, 0) ? 0 : duk_to_int(duk, 0);
@@ -458,6 +594,7 @@ static duk_ret_t duk_peek(duk_context* duk)
 	if(address >= 0 && address < sizeof(tic_ram))
 	{
 		tic_machine* machine = getDukMachine(duk);
+		tic_ram_touch(&machine->memory, address, 1);
 		duk_push_uint(duk, *((u8*)&machine->memory.ram + address));
 		return 1;
 	}
@@ -474,6 +611,7 @@ static duk_ret_t duk_poke(duk_context* duk)
 	if(address >= 0 && address < sizeof(tic_ram))
 	{
 		tic_machine* machine = getDukMachine(duk);
+		tic_ram_touch(&machine->memory, address, 1);
 		*((u8*)&machine->memory.ram + address) = value;
 	}
 
@@ -489,6 +627,7 @@ static duk_ret_t duk_peek4(duk_context* duk)
 	{
 		tic_mem* memory = (tic_mem*)getDukMachine(duk);
 
+		tic_ram_touch(memory, address / 2, 1);
 		duk_push_uint(duk, tic_tool_peek4((u8*)&memory->ram, address));
 		return 1;
 	}
@@ -506,6 +645,7 @@ static duk_ret_t duk_poke4(duk_context* duk)
 	{
 		tic_mem* memory = (tic_mem*)getDukMachine(duk);
 
+		tic_ram_touch(memory, address / 2, 1);
 		tic_tool_poke4((u8*)&memory->ram, address, value);
 	}
 
@@ -522,6 +662,8 @@ static duk_ret_t duk_memcpy(duk_context* duk)
 	if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && src >= 0 && dest <= bound && src <= bound)
 	{
 		u8* base = (u8*)&getDukMachine(duk)->memory;
+		tic_ram_touch(&getDukMachine(duk)->memory, dest, size);
+		tic_ram_touch(&getDukMachine(duk)->memory, src, size);
 		memcpy(base + dest, base + src, size);
 	}
 
@@ -538,6 +680,7 @@ static duk_ret_t duk_memset(duk_context* duk)
 	if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && dest <= bound)
 	{
 		u8* base = (u8*)&getDukMachine(duk)->memory;
+		tic_ram_touch(&getDukMachine(duk)->memory, dest, size);
 		memset(base + dest, value, size);
 	}
 
@@ -772,6 +915,49 @@ static duk_ret_t duk_sync(duk_context* duk)
 	return 0;
 }
 
+// a null value clears the register, values go from -128 to 255
+static duk_ret_t duk_raster(duk_context* duk)
+{
+	tic_mem* memory = (tic_mem*)getDukMachine(duk);
+
+	if(!duk_is_undefined(duk, 0) && duk_is_undefined(duk, 1))
+		return duk_error(duk, DUK_ERR_ERROR, "invalid params, raster [ addr val|null|[vals] [ row [ count ] ] ]\n");
+
+	s32 address = duk_is_null_or_undefined(duk, 0) ? -1 : duk_to_int(duk, 0);
+	s32 row = duk_is_null_or_undefined(duk, 2) ? 0 : duk_to_int(duk, 2);
+
+	if(duk_is_array(duk, 1))
+	{
+		s32 count = MIN((s32)duk_get_length(duk, 1), TIC80_HEIGHT);
+
+		for(s32 i = 0; i < count; i++)
+		{
+			duk_get_prop_index(duk, 1, i);
+			bool clear = duk_is_null_or_undefined(duk, -1);
+			s32 value = clear ? 0 : duk_to_int(duk, -1);
+			duk_pop(duk);
+
+			if(!(clear 
+				? memory->api.raster_clear(memory, address, row + i, 1) 
+				: memory->api.raster(memory, address, value, row + i, 1)))
+				return duk_error(duk, DUK_ERR_ERROR, "raster() error, invalid address or value");
+		}
+
+		return 0;
+	}
+
+	bool clear = duk_is_null_or_undefined(duk, 1);
+	s32 value = clear ? 0 : duk_to_int(duk, 1);
+	s32 count = duk_is_null_or_undefined(duk, 3) ? TIC80_HEIGHT - row : duk_to_int(duk, 3);
+
+	if(!(clear 
+		? memory->api.raster_clear(memory, address, row, count) 
+		: memory->api.raster(memory, address, value, row, count)))
+		return duk_error(duk, DUK_ERR_ERROR, "raster() error, invalid address or value");
+
+	return 0;
+}
+
 static duk_ret_t duk_reset(duk_context* duk)
 {
 	tic_machine* machine = getDukMachine(duk);
@@ -822,6 +1008,11 @@ static const struct{duk_c_function func; s32 params;} ApiFunc[] =
 	{duk_reset, 0},
 	{duk_key, 1},
 	{duk_keyp, 3},
+	{duk_raster, 4},
+	{duk_mray, 5},
+	{duk_msweep, 7},
+	{duk_mfill, 4},
+	{duk_mpath, 6},
 };
 
 STATIC_ASSERT(api_func, COUNT_OF(ApiKeywords) == COUNT_OF(ApiFunc));
@@ -836,11 +1027,19 @@ s32 duk_timeout_check(void* udata)
 	return ForceExitCounter++ > 1000 ? tick->forceExit && tick->forceExit(tick->data) : false;
 }
 
+// Duktape keeps the Math.random state in its heap, a snapshot restore would replay the same
+// numbers after every reset, so it uses the C library generator the way Lua does
+static duk_ret_t duk_random(duk_context* duk)
+{
+	duk_push_number(duk, (double)rand() / ((double)RAND_MAX + 1));
+	return 1;
+}
+
 static void initDuktape(tic_machine* machine)
 {
 	closeJavascript((tic_mem*)machine);
 
-	duk_context* duk = machine->js = duk_create_heap(NULL, NULL, NULL, machine, NULL);
+	duk_context* duk = machine->js = duk_create_heap(jsAlloc, jsRealloc, jsFree, machine, NULL);
 
 	{
 		duk_push_global_stash(duk);
@@ -855,6 +1054,14 @@ static void initDuktape(tic_machine* machine)
 			duk_push_c_function(machine->js, ApiFunc[i].func, ApiFunc[i].params);
 			duk_put_global_string(machine->js, ApiKeywords[i]);
 		}
+
+	if(duk_get_global_string(duk, "Math"))
+	{
+		duk_push_c_function(duk, duk_random, 0);
+		duk_put_prop_string(duk, -2, "random");
+	}
+
+	duk_pop(duk);
 }
 
 static bool initJavascript(tic_mem* tic, const char* code)
@@ -1019,6 +1226,8 @@ static const tic_script_config JsSyntaxConfig =
 	.tick 				= callJavascriptTick,
 	.scanline 			= callJavascriptScanline,
 	.overline 			= callJavascriptOverline,
+	.collect 			= collectJavascript,
+	.snapshot 			= true,
 
 	.getOutline			= getJsOutline,
 	.parse 				= parseCode,
@@ -0,0 +1,578 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "lua53.h"
+
+#if defined(TIC_BUILD_WITH_LUAJIT)
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+typedef enum
+{
+	TokenName,
+	TokenNumber,
+	TokenString,
+	TokenSymbol,
+} TokenType;
+
+typedef struct
+{
+	TokenType type;
+	s32 start;
+	s32 end;
+	s32 match;
+} Token;
+
+typedef struct
+{
+	const char* code;
+	Token* items;
+	s32 count;
+	s32 size;
+} Tokens;
+
+static const char* const Keywords[] =
+{
+	"and", "break", "do", "else", "elseif", "end", "false", "for", "function", "goto", "if", "in",
+	"local", "nil", "not", "or", "repeat", "return", "then", "true", "until", "while",
+};
+
+static const char* const Symbols[] = {"...", "..", "==", "~=", "<=", ">=", "<<", ">>", "//", "::"};
+
+static const struct {const char* op; s32 prec;} Binary[] =
+{
+	{"or", 1}, {"and", 2},
+	{"<", 3}, {">", 3}, {"<=", 3}, {">=", 3}, {"~=", 3}, {"==", 3},
+	{"|", 4}, {"~", 5}, {"&", 6}, {"<<", 7}, {">>", 7},
+	{"..", 9}, {"+", 10}, {"-", 10},
+	{"*", 11}, {"/", 11}, {"//", 11}, {"%", 11},
+	{"^", 14},
+};
+
+static const struct {const char* op; const char* func;} Targets[] =
+{
+	{"//", "__idiv"}, {"&", "__band"}, {"|", "__bor"}, {"~", "__bxor"}, {"<<", "__shl"}, {">>", "__shr"},
+};
+
+enum {UnaryPrec = 12};
+
+static bool isToken(const Tokens* tokens, s32 index, const char* text)
+{
+	if(index < 0 || index >= tokens->count) return false;
+
+	const Token* token = &tokens->items[index];
+	s32 len = token->end - token->start;
+
+	return token->type != TokenString && (s32)strlen(text) == len
+		&& memcmp(tokens->code + token->start, text, len) == 0;
+}
+
+static bool isKeyword(const Tokens* tokens, s32 index)
+{
+	if(index < 0 || index >= tokens->count || tokens->items[index].type != TokenName) return false;
+
+	for(s32 i = 0; i < COUNT_OF(Keywords); i++)
+		if(isToken(tokens, index, Keywords[i]))
+			return true;
+
+	return false;
+}
+
+static bool isVariable(const Tokens* tokens, s32 index)
+{
+	return index >= 0 && index < tokens->count 
+		&& tokens->items[index].type == TokenName && !isKeyword(tokens, index);
+}
+
+static bool isString(const Tokens* tokens, s32 index)
+{
+	return index >= 0 && index < tokens->count && tokens->items[index].type == TokenString;
+}
+
+static bool endsExpression(const Tokens* tokens, s32 index)
+{
+	if(index < 0 || index >= tokens->count) return false;
+
+	switch(tokens->items[index].type)
+	{
+	case TokenNumber:
+	case TokenString: return true;
+	case TokenName: return !isKeyword(tokens, index) 
+		|| isToken(tokens, index, "nil") || isToken(tokens, index, "true") || isToken(tokens, index, "false");
+	default: return isToken(tokens, index, ")") || isToken(tokens, index, "]") 
+		|| isToken(tokens, index, "}") || isToken(tokens, index, "...");
+	}
+}
+
+static bool isUnary(const Tokens* tokens, s32 index)
+{
+	return (isToken(tokens, index, "-") || isToken(tokens, index, "~") 
+		|| isToken(tokens, index, "#") || isToken(tokens, index, "not"))
+		&& !endsExpression(tokens, index - 1);
+}
+
+static s32 binaryPrec(const Tokens* tokens, s32 index)
+{
+	for(s32 i = 0; i < COUNT_OF(Binary); i++)
+		if(isToken(tokens, index, Binary[i].op))
+			return Binary[i].prec;
+
+	return 0;
+}
+
+static s32 longBracket(const char* code, s32 pos)
+{
+	if(code[pos] != '[') return -1;
+
+	s32 level = 0;
+	while(code[pos + 1 + level] == '=') level++;
+
+	return code[pos + 1 + level] == '[' ? level : -1;
+}
+
+static s32 skipLongBracket(const char* code, s32 pos, s32 level)
+{
+	for(pos += level + 2; code[pos]; pos++)
+	{
+		if(code[pos] == ']')
+		{
+			s32 i = 0;
+			while(i < level && code[pos + 1 + i] == '=') i++;
+
+			if(i == level && code[pos + 1 + level] == ']')
+				return pos + level + 2;
+		}
+	}
+
+	return pos;
+}
+
+static void pushToken(Tokens* tokens, TokenType type, s32 start, s32 end)
+{
+	if(tokens->count == tokens->size)
+	{
+		tokens->size = tokens->size ? tokens->size * 2 : 256;
+		tokens->items = realloc(tokens->items, tokens->size * sizeof(Token));
+	}
+
+	tokens->items[tokens->count++] = (Token){type, start, end, -1};
+}
+
+static void tokenize(Tokens* tokens, const char* code, s32 pos, s32 end)
+{
+	tokens->code = code;
+	tokens->count = 0;
+
+	while(pos < end)
+	{
+		char c = code[pos];
+		s32 start = pos;
+
+		if(isspace((u8)c))
+			pos++;
+		else if(c == '-' && code[pos + 1] == '-')
+		{
+			s32 level = longBracket(code, pos + 2);
+
+			if(level >= 0)
+				pos = skipLongBracket(code, pos + 2, level);
+			else
+				while(code[pos] && code[pos] != '\n') pos++;
+		}
+		else if(isalpha((u8)c) || c == '_')
+		{
+			while(isalnum((u8)code[pos]) || code[pos] == '_') pos++;
+			pushToken(tokens, TokenName, start, pos);
+		}
+		else if(isdigit((u8)c) || (c == '.' && isdigit((u8)code[pos + 1])))
+		{
+			bool hex = c == '0' && (code[pos + 1] == 'x' || code[pos + 1] == 'X');
+			if(hex) pos += 2;
+
+			for(;;)
+			{
+				char n = code[pos];
+
+				if((hex ? (n == 'p' || n == 'P') : (n == 'e' || n == 'E')) 
+					&& (code[pos + 1] == '+' || code[pos + 1] == '-'))
+					pos += 2;
+				else if(isalnum((u8)n) || n == '.')
+					pos++;
+				else break;
+			}
+
+			pushToken(tokens, TokenNumber, start, pos);
+		}
+		else if(c == '"' || c == '\'')
+		{
+			for(pos++; code[pos] && code[pos] != c && code[pos] != '\n'; pos++)
+				if(code[pos] == '\\' && code[pos + 1]) pos++;
+
+			if(code[pos] == c) pos++;
+			pushToken(tokens, TokenString, start, pos);
+		}
+		else if(longBracket(code, pos) >= 0)
+		{
+			pos = skipLongBracket(code, pos, longBracket(code, pos));
+			pushToken(tokens, TokenString, start, pos);
+		}
+		else
+		{
+			s32 len = 1;
+
+			for(s32 i = 0; i < COUNT_OF(Symbols); i++)
+			{
+				s32 size = (s32)strlen(Symbols[i]);
+				if(size > len && strncmp(code + pos, Symbols[i], size) == 0)
+					len = size;
+			}
+
+			pos += len;
+			pushToken(tokens, TokenSymbol, start, pos);
+		}
+	}
+
+	// pair up brackets so operands can jump over groups in both directions
+	s32* stack = malloc((tokens->count + 1) * sizeof(s32));
+	s32 depth = 0;
+
+	for(s32 i = 0; i < tokens->count; i++)
+	{
+		if(isToken(tokens, i, "(") || isToken(tokens, i, "[") || isToken(tokens, i, "{"))
+			stack[depth++] = i;
+		else if((isToken(tokens, i, ")") || isToken(tokens, i, "]") || isToken(tokens, i, "}")) && depth)
+		{
+			s32 open = stack[--depth];
+			tokens->items[open].match = i;
+			tokens->items[i].match = open;
+		}
+	}
+
+	free(stack);
+}
+
+static bool isGroup(const Tokens* tokens, s32 index)
+{
+	return index >= 0 && index < tokens->count && tokens->items[index].match >= 0;
+}
+
+// returns the first token of the operand ending at 'index', or -1
+static s32 leftOperand(const Tokens* tokens, s32 index, s32 prec)
+{
+	for(;;)
+	{
+		if(!endsExpression(tokens, index)) return -1;
+
+		// primary expression with its suffixes, walked backwards
+		for(;;)
+		{
+			s32 first = isGroup(tokens, index) ? tokens->items[index].match : index;
+
+			if(first < 0) return -1;
+
+			bool args = (isGroup(tokens, index) && !isToken(tokens, index, "]")) || isString(tokens, index);
+			bool callee = isVariable(tokens, first - 1) || isToken(tokens, first - 1, ")")
+				|| isToken(tokens, first - 1, "]") || isString(tokens, first - 1);
+
+			if(isVariable(tokens, index) && (isToken(tokens, first - 1, ".") || isToken(tokens, first - 1, ":")))
+				index = first - 2;
+			else if((args || isToken(tokens, index, "]")) && callee)
+				index = first - 1;
+			else
+			{
+				index = first;
+				break;
+			}
+
+			if(!endsExpression(tokens, index)) return -1;
+		}
+
+		while(isUnary(tokens, index - 1))
+			index--;
+
+		s32 op = index - 1;
+		s32 opPrec = binaryPrec(tokens, op);
+
+		if(opPrec >= prec && !isUnary(tokens, op))
+			index = op - 1;
+		else return index;
+	}
+}
+
+static s32 rightOperand(const Tokens* tokens, s32 index, s32 prec);
+
+// returns the last token of the primary expression starting at 'index', or -1
+static s32 rightPrimary(const Tokens* tokens, s32 index)
+{
+	if(isToken(tokens, index, "function"))
+	{
+		s32 depth = 0;
+
+		for(; index < tokens->count; index++)
+		{
+			if(isToken(tokens, index, "function") || isToken(tokens, index, "if")
+				|| isToken(tokens, index, "do") || isToken(tokens, index, "repeat"))
+				depth++;
+			else if((isToken(tokens, index, "end") || isToken(tokens, index, "until")) && --depth == 0)
+				return index;
+		}
+
+		return -1;
+	}
+
+	if(isToken(tokens, index, "(") || isToken(tokens, index, "{"))
+		return tokens->items[index].match;
+
+	return (endsExpression(tokens, index) && tokens->items[index].type != TokenSymbol)
+		|| isToken(tokens, index, "...") ? index : -1;
+}
+
+static s32 rightOperand(const Tokens* tokens, s32 index, s32 prec)
+{
+	if(isToken(tokens, index, "-") || isToken(tokens, index, "~") 
+		|| isToken(tokens, index, "#") || isToken(tokens, index, "not"))
+	{
+		// unary operators only let '^' bind tighter than themselves
+		index = rightOperand(tokens, index + 1, UnaryPrec);
+	}
+	else
+	{
+		index = rightPrimary(tokens, index);
+
+		// suffixes: .name :name(args) [key] (args) {table} "string"
+		while(index >= 0)
+		{
+			s32 next = index + 1;
+
+			if((isToken(tokens, next, ".") || isToken(tokens, next, ":")) && isVariable(tokens, next + 1))
+				index = next + 1;
+			else if(isToken(tokens, next, "(") || isToken(tokens, next, "[") || isToken(tokens, next, "{"))
+				index = tokens->items[next].match;
+			else if(isString(tokens, next))
+				index = next;
+			else break;
+		}
+	}
+
+	while(index >= 0)
+	{
+		s32 opPrec = binaryPrec(tokens, index + 1);
+
+		if(opPrec <= prec) break;
+
+		// '..' and '^' are right associative
+		s32 limit = isToken(tokens, index + 1, "..") || isToken(tokens, index + 1, "^") ? opPrec - 1 : opPrec;
+		index = rightOperand(tokens, index + 2, limit);
+	}
+
+	return index;
+}
+
+typedef struct
+{
+	char* data;
+	s32 size;
+	s32 capacity;
+} Buffer;
+
+static void append(Buffer* buffer, const char* data, s32 size)
+{
+	if(buffer->size + size + 1 > buffer->capacity)
+	{
+		buffer->capacity = (buffer->size + size + 1) * 2;
+		buffer->data = realloc(buffer->data, buffer->capacity);
+	}
+
+	memcpy(buffer->data + buffer->size, data, size);
+	buffer->size += size;
+	buffer->data[buffer->size] = '\0';
+}
+
+static void appendString(Buffer* buffer, const char* string)
+{
+	append(buffer, string, (s32)strlen(string));
+}
+
+static void appendLines(Buffer* buffer, const char* code, s32 start, s32 end)
+{
+	for(s32 i = start; i < end; i++)
+		if(code[i] == '\n')
+			appendString(buffer, "\n");
+}
+
+static const char* targetFunc(const Tokens* tokens, s32 index)
+{
+	for(s32 i = 0; i < COUNT_OF(Targets); i++)
+		if(isToken(tokens, index, Targets[i].op))
+			return Targets[i].func;
+
+	return NULL;
+}
+
+// replaces tokens [first, last] of the source with 'text' and patches the token list in place
+static void splice(Tokens* tokens, char** code, s32 first, s32 last, const char* text, s32 size)
+{
+	const char* src = *code;
+	s32 start = tokens->items[first].start;
+	s32 end = tokens->items[last].end;
+	s32 delta = size - (end - start);
+
+	Buffer out = {0};
+	append(&out, src, start);
+	append(&out, text, size);
+	appendString(&out, src + end);
+
+	Tokens inner = {0};
+	tokenize(&inner, out.data, start, start + size);
+
+	s32 removed = last - first + 1;
+	s32 shift = inner.count - removed;
+
+	if(tokens->count + shift > tokens->size)
+	{
+		tokens->size = (tokens->count + shift) * 2;
+		tokens->items = realloc(tokens->items, tokens->size * sizeof(Token));
+	}
+
+	memmove(tokens->items + first + inner.count, tokens->items + last + 1, (tokens->count - last - 1) * sizeof(Token));
+	tokens->count += shift;
+
+	for(s32 i = 0; i < inner.count; i++)
+	{
+		Token* token = &inner.items[i];
+		if(token->match >= 0) token->match += first;
+		tokens->items[first + i] = *token;
+	}
+
+	for(s32 i = 0; i < tokens->count; i++)
+	{
+		Token* token = &tokens->items[i];
+
+		if(i >= first + inner.count)
+		{
+			token->start += delta;
+			token->end += delta;
+		}
+
+		if(i < first || i >= first + inner.count)
+			if(token->match > last) token->match += shift;
+	}
+
+	free(inner.items);
+	free(*code);
+
+	*code = out.data;
+	tokens->code = out.data;
+}
+
+// rewrites the 5.3 operator at 'op'; returns the token to continue scanning from
+static s32 rewrite(Tokens* tokens, char** code, s32 op)
+{
+	const char* src = *code;
+	const char* func = targetFunc(tokens, op);
+
+	bool unary = isUnary(tokens, op);
+	s32 first = unary ? op : leftOperand(tokens, op - 1, binaryPrec(tokens, op));
+	s32 last = rightOperand(tokens, op + 1, unary ? UnaryPrec : binaryPrec(tokens, op));
+
+	if(first < 0 || last < 0)
+		return op + 1;
+
+	const Token* token = &tokens->items[op];
+	const Token* left = &tokens->items[first];
+	const Token* right = &tokens->items[last];
+	const Token* operand = &tokens->items[op + 1];
+
+	Buffer out = {0};
+
+	if(unary)
+	{
+		appendString(&out, "__bnot(");
+		append(&out, src + operand->start, right->end - operand->start);
+		appendString(&out, ")");
+	}
+	else
+	{
+		const Token* prev = &tokens->items[op - 1];
+
+		appendString(&out, func);
+		appendString(&out, "(");
+		append(&out, src + left->start, prev->end - left->start);
+		appendString(&out, ", ");
+		append(&out, src + operand->start, right->end - operand->start);
+		appendString(&out, ")");
+		appendLines(&out, src, prev->end, token->start);
+	}
+
+	appendLines(&out, src, token->end, operand->start);
+
+	splice(tokens, code, first, last, out.data, out.size);
+	free(out.data);
+
+	// the right operand may still hold operators, so look again from the call itself
+	return first;
+}
+
+char* lua53_translate(const char* code)
+{
+	char* out = malloc(strlen(code) + 1);
+	strcpy(out, code);
+
+	Tokens tokens = {0};
+	tokenize(&tokens, out, 0, (s32)strlen(out));
+
+	bool changed = false;
+
+	for(s32 op = 0; op < tokens.count;)
+	{
+		if(targetFunc(&tokens, op))
+		{
+			s32 next = rewrite(&tokens, &out, op);
+			changed |= next <= op;
+			op = next;
+		}
+		else op++;
+	}
+
+	free(tokens.items);
+
+	if(!changed)
+	{
+		free(out);
+		return NULL;
+	}
+
+	// the helpers come in as the arguments of an outer chunk and stay upvalues of the code,
+	// the prefix shares the first line so the line numbers don't move
+	Buffer wrapped = {0};
+	appendString(&wrapped, "local __idiv, __band, __bor, __bxor, __bnot, __shl, __shr = ... return function(...) ");
+	appendString(&wrapped, out);
+	appendString(&wrapped, "\nend");
+
+	free(out);
+
+	return wrapped.data;
+}
+
+#endif
@@ -25,6 +25,7 @@
 #if defined(TIC_BUILD_WITH_LUA)
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 #include <lua.h>
 #include <lauxlib.h>
@@ -33,6 +34,36 @@
 
 #define LUA_LOC_STACK 1E8 // 100.000.000
 
+// LuaJIT keeps machine code and some of its state outside of the allocator
+#if defined(TIC_BUILD_WITH_LUAJIT)
+#	define LUA_SNAPSHOT false
+#else
+#	define LUA_SNAPSHOT true
+#endif
+
+#if defined(TIC_BUILD_WITH_LUAJIT)
+
+#include "lua53.h"
+
+#ifndef LUA_OK
+#define LUA_OK 0
+#endif
+
+#ifndef lua_rawlen
+#define lua_rawlen lua_objlen
+#endif
+
+// LuaJIT numbers are doubles, integral values pass as integers
+static inline bool lua_isinteger(lua_State* lua, s32 index)
+{
+	if(lua_type(lua, index) != LUA_TNUMBER) return false;
+
+	lua_Number value = lua_tonumber(lua, index);
+	return value == (lua_Number)(lua_Integer)value;
+}
+
+#endif
+
 s32 luaopen_lpeg(lua_State *lua);
 
 // !TODO: get rid of this wrap
@@ -62,6 +93,7 @@ static s32 lua_peek(lua_State* lua)
 
 	if(address >=0 && address < sizeof(tic_ram))
 	{
+		tic_ram_touch(&machine->memory, address, 1);
 		lua_pushinteger(lua, *((u8*)&machine->memory.ram + address));
 		return 1;
 	}
@@ -78,6 +110,7 @@ static s32 lua_poke(lua_State* lua)
 
 	if(address >=0 && address < sizeof(tic_ram))
 	{
+		tic_ram_touch(&machine->memory, address, 1);
 		*((u8*)&machine->memory.ram + address) = value;
 	}
 
@@ -94,6 +127,7 @@ static s32 lua_peek4(lua_State* lua)
 
 		if(address >= 0 && address < sizeof(tic_ram)*2)
 		{
+			tic_ram_touch(&getLuaMachine(lua)->memory, address / 2, 1);
 			lua_pushinteger(lua, tic_tool_peek4((u8*)&getLuaMachine(lua)->memory.ram, address));
 			return 1;
 		}		
@@ -114,6 +148,7 @@ static s32 lua_poke4(lua_State* lua)
 
 		if(address >= 0 && address < sizeof(tic_ram)*2)
 		{
+			tic_ram_touch(&getLuaMachine(lua)->memory, address / 2, 1);
 			tic_tool_poke4((u8*)&getLuaMachine(lua)->memory.ram, address, value);
 		}
 	}
@@ -511,6 +546,132 @@ static s32 lua_mget(lua_State* lua)
 	return 0;
 }
 
+static s32 lua_mray(lua_State* lua)
+{
+	s32 top = lua_gettop(lua);
+
+	if(top >= 4)
+	{
+		tic_mem* memory = (tic_mem*)getLuaMachine(lua);
+
+		float x0 = (float)lua_tonumber(lua, 1);
+		float y0 = (float)lua_tonumber(lua, 2);
+		float x1 = (float)lua_tonumber(lua, 3);
+		float y1 = (float)lua_tonumber(lua, 4);
+		u8 mask = top >= 5 ? getLuaNumber(lua, 5) : 0xff;
+
+		tic_map_hit hit;
+		bool done = memory->api.map_ray(memory, &memory->ram.map, x0, y0, x1, y1, mask, &hit);
+
+		lua_pushboolean(lua, done);
+		lua_pushnumber(lua, hit.x);
+		lua_pushnumber(lua, hit.y);
+		lua_pushinteger(lua, hit.cellx);
+		lua_pushinteger(lua, hit.celly);
+		lua_pushinteger(lua, hit.normalx);
+		lua_pushinteger(lua, hit.normaly);
+
+		return 7;
+	}
+	else luaL_error(lua, "invalid params, mray(x0,y0,x1,y1,[mask=0xff])\n");
+
+	return 0;
+}
+
+static s32 lua_msweep(lua_State* lua)
+{
+	s32 top = lua_gettop(lua);
+
+	if(top >= 6)
+	{
+		tic_mem* memory = (tic_mem*)getLuaMachine(lua);
+
+		float x = (float)lua_tonumber(lua, 1);
+		float y = (float)lua_tonumber(lua, 2);
+		float w = (float)lua_tonumber(lua, 3);
+		float h = (float)lua_tonumber(lua, 4);
+		float dx = (float)lua_tonumber(lua, 5);
+		float dy = (float)lua_tonumber(lua, 6);
+		u8 mask = top >= 7 ? getLuaNumber(lua, 7) : 0xff;
+
+		tic_map_hit hit;
+		memory->api.map_sweep(memory, &memory->ram.map, x, y, w, h, dx, dy, mask, &hit);
+
+		lua_pushnumber(lua, hit.x);
+		lua_pushnumber(lua, hit.y);
+		lua_pushinteger(lua, hit.normalx);
+		lua_pushinteger(lua, hit.normaly);
+
+		return 4;
+	}
+	else luaL_error(lua, "invalid params, msweep(x,y,w,h,dx,dy,[mask=0xff])\n");
+
+	return 0;
+}
+
+static s32 lua_mfill(lua_State* lua)
+{
+	s32 top = lua_gettop(lua);
+
+	if(top >= 2)
+	{
+		tic_mem* memory = (tic_mem*)getLuaMachine(lua);
+
+		s32 x = getLuaNumber(lua, 1);
+		s32 y = getLuaNumber(lua, 2);
+		u8 mask = top >= 3 ? getLuaNumber(lua, 3) : 0xff;
+		s32 tile = top >= 4 && !lua_isnil(lua, 4) ? (u8)getLuaNumber(lua, 4) : -1;
+
+		lua_pushinteger(lua, memory->api.map_fill(memory, &memory->ram.map, x, y, mask, tile));
+
+		return 1;
+	}
+	else luaL_error(lua, "invalid params, mfill(x,y,[mask=0xff],[tile])\n");
+
+	return 0;
+}
+
+static s32 lua_mpath(lua_State* lua)
+{
+	s32 top = lua_gettop(lua);
+
+	if(top >= 4)
+	{
+		tic_mem* memory = (tic_mem*)getLuaMachine(lua);
+
+		s32 x0 = getLuaNumber(lua, 1);
+		s32 y0 = getLuaNumber(lua, 2);
+		s32 x1 = getLuaNumber(lua, 3);
+		s32 y1 = getLuaNumber(lua, 4);
+		u8 mask = top >= 5 ? getLuaNumber(lua, 5) : 0xff;
+		u8 cost = top >= 6 ? getLuaNumber(lua, 6) : 0;
+
+		const u16* path = NULL;
+		s32 steps = memory->api.map_path(memory, &memory->ram.map, x0, y0, x1, y1, mask, cost, &path);
+
+		if(steps < 0)
+		{
+			lua_pushnil(lua);
+			return 1;
+		}
+
+		lua_createtable(lua, steps * 2, 0);
+
+		for(s32 i = 0; i < steps; i++)
+		{
+			lua_pushinteger(lua, path[i] % TIC_MAP_WIDTH);
+			lua_rawseti(lua, -2, i * 2 + 1);
+			lua_pushinteger(lua, path[i] / TIC_MAP_WIDTH);
+			lua_rawseti(lua, -2, i * 2 + 2);
+		}
+
+		return 1;
+	}
+	else luaL_error(lua, "invalid params, mpath(x0,y0,x1,y1,[mask=0xff],[cost=0])\n");
+
+	return 0;
+}
+
 static s32 lua_mset(lua_State* lua)
 {
 	s32 top = lua_gettop(lua);
@@ -768,6 +929,69 @@ static s32 lua_sync(lua_State* lua)
 	return 0;
 }
 
+// a nil value clears the register, values go from -128 to 255
+static s32 lua_raster(lua_State* lua)
+{
+	tic_mem* memory = (tic_mem*)getLuaMachine(lua);
+
+	s32 top = lua_gettop(lua);
+
+	s32 address = -1;
+	bool clear = true;
+	s32 value = 0;
+	s32 row = 0;
+	s32 count = TIC80_HEIGHT;
+
+	if(top >= 2 && lua_istable(lua, 2))
+	{
+		address = getLuaNumber(lua, 1);
+		row = top >= 3 ? getLuaNumber(lua, 3) : 0;
+		count = MIN((s32)lua_rawlen(lua, 2), TIC80_HEIGHT);
+
+		for(s32 i = 0; i < count; i++)
+		{
+			lua_rawgeti(lua, 2, i + 1);
+			clear = lua_isnil(lua, -1);
+			value = clear ? 0 : getLuaNumber(lua, -1);
+			lua_pop(lua, 1);
+
+			if(!(clear 
+				? memory->api.raster_clear(memory, address, row + i, 1) 
+				: memory->api.raster(memory, address, value, row + i, 1)))
+			{
+				luaL_error(lua, "raster() error, invalid address or value");
+				return 0;
+			}
+		}
+
+		return 0;
+	}
+	else if(top >= 2)
+	{
+		address = getLuaNumber(lua, 1);
+		clear = lua_isnil(lua, 2);
+		value = clear ? 0 : getLuaNumber(lua, 2);
+
+		if(top >= 3)
+		{
+			row = getLuaNumber(lua, 3);
+			count = top >= 4 ? getLuaNumber(lua, 4) : TIC80_HEIGHT - row;
+		}
+	}
+	else if(top == 1)
+	{
+		luaL_error(lua, "invalid params, raster [ addr val|nil|{vals} [ row [ count ] ] ]\n");
+		return 0;
+	}
+
+	if(!(clear 
+		? memory->api.raster_clear(memory, address, row, count) 
+		: memory->api.raster(memory, address, value, row, count)))
+		luaL_error(lua, "raster() error, invalid address or value");
+
+	return 0;
+}
+
 static s32 lua_reset(lua_State* lua)
 {
 	tic_machine* machine = getLuaMachine(lua);
@@ -866,6 +1090,8 @@ static s32 lua_memcpy(lua_State* lua)
 		if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && src >= 0 && dest <= bound && src <= bound)
 		{
 			u8* base = (u8*)&getLuaMachine(lua)->memory;
+			tic_ram_touch(&getLuaMachine(lua)->memory, dest, size);
+			tic_ram_touch(&getLuaMachine(lua)->memory, src, size);
 			memcpy(base + dest, base + src, size);
 			return 0;
 		}
@@ -890,6 +1116,7 @@ static s32 lua_memset(lua_State* lua)
 		if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && dest <= bound)
 		{
 			u8* base = (u8*)&getLuaMachine(lua)->memory;
+			tic_ram_touch(&getLuaMachine(lua)->memory, dest, size);
 			memset(base + dest, value, size);
 			return 0;
 		}
@@ -1141,6 +1368,107 @@ static s32 lua_loadfile(lua_State *lua)
 	return 0;
 }
 
+#if defined(TIC_BUILD_WITH_LUAJIT)
+
+#define LUA53_CODE(...) #__VA_ARGS__
+
+// Lua 5.3 functions and operators the carts expect, 5.1 is all LuaJIT has
+static const char* lua53_prelude_src = LUA53_CODE(
+	local translate = ...
+	local floor, unpack = math.floor, unpack
+
+	local ops = {function(a, b) return floor(a / b) end,
+		bit.band, bit.bor, bit.bxor, bit.bnot, bit.lshift, bit.rshift}
+
+	function math.type(x)
+		if type(x) ~= 'number' then return nil end
+		return x == floor(x) and 'integer' or 'float'
+	end
+
+	function math.tointeger(x)
+		return type(x) == 'number' and x == floor(x) and x or nil
+	end
+
+	function math.ult(a, b)
+		if (a < 0) == (b < 0) then return a < b end
+		return b < 0
+	end
+
+	math.maxinteger, math.mininteger = 2^53, -2^53
+	table.unpack = table.unpack or unpack
+	table.pack = table.pack or function(...) return {n = select('#', ...), ...} end
+
+	local function wrap(load)
+		return function(chunk, ...)
+			if type(chunk) == 'string' then
+				local code = translate(chunk)
+
+				if code ~= chunk then
+					local outer, err = load(code, ...)
+					if not outer then return outer, err end
+					return outer(unpack(ops))
+				end
+			end
+
+			return load(chunk, ...)
+		end
+	end
+
+	load, loadstring = wrap(load), wrap(loadstring)
+
+	return ops
+);
+
+static const char* Lua53Ops = "lua53";
+
+static s32 lua_lua53(lua_State* lua)
+{
+	const char* code = lua_tostring(lua, 1);
+	char* translated = code ? lua53_translate(code) : NULL;
+
+	if(translated)
+	{
+		lua_pushstring(lua, translated);
+		free(translated);
+	}
+	else lua_pushvalue(lua, 1);
+
+	return 1;
+}
+
+static void lua_open_builtins(lua_State *lua)
+{
+	static const luaL_Reg loadedlibs[] =
+	{
+		{ "", luaopen_base },
+		{ LUA_LOADLIBNAME, luaopen_package },
+		{ LUA_TABLIBNAME, luaopen_table },
+		{ LUA_STRLIBNAME, luaopen_string },
+		{ LUA_MATHLIBNAME, luaopen_math },
+		{ LUA_DBLIBNAME, luaopen_debug },
+		{ LUA_BITLIBNAME, luaopen_bit },
+		{ LUA_JITLIBNAME, luaopen_jit },
+		{ NULL, NULL }
+	};
+
+	for (const luaL_Reg *lib = loadedlibs; lib->func; lib++)
+	{
+		lua_pushcfunction(lua, lib->func);
+		lua_pushstring(lua, lib->name);
+		lua_call(lua, 1, 0);
+	}
+
+	if(luaL_loadbuffer(lua, lua53_prelude_src, strlen(lua53_prelude_src), "lua53") == LUA_OK)
+	{
+		lua_pushcfunction(lua, lua_lua53);
+		lua_call(lua, 1, 1);
+		lua_setfield(lua, LUA_REGISTRYINDEX, Lua53Ops);
+	}
+	else lua_pop(lua, 1);
+}
+
+#else
+
 static void lua_open_builtins(lua_State *lua)
 {
 	static const luaL_Reg loadedlibs[] =
@@ -1162,6 +1490,40 @@ static void lua_open_builtins(lua_State *lua)
 	}
 }
 
+#endif
+
+// loads the cart source, translating 5.3 operators when running on LuaJIT
+static s32 loadLuaCode(lua_State* lua, const char* code)
+{
+#if defined(TIC_BUILD_WITH_LUAJIT)
+	char* translated = lua53_translate(code);
+
+	if(translated)
+	{
+		s32 status = luaL_loadbuffer(lua, translated, strlen(translated), code);
+		free(translated);
+
+		// run the outer chunk to hand the operator helpers to the cart code
+		if(status == LUA_OK)
+		{
+			enum {Ops = 7};
+
+			lua_getfield(lua, LUA_REGISTRYINDEX, Lua53Ops);
+
+			for(s32 i = 1; i <= Ops; i++)
+				lua_rawgeti(lua, -i, i);
+
+			lua_remove(lua, -Ops - 1);
+			status = lua_pcall(lua, Ops, 1, 0);
+		}
+
+		return status;
+	}
+#endif
+
+	return luaL_loadstring(lua, code);
+}
+
 static const char* const ApiKeywords[] = API_KEYWORDS;
 static const lua_CFunction ApiFunc[] = 
 {
@@ -1170,7 +1532,7 @@ static const lua_CFunction ApiFunc[] =
 	lua_mset, lua_peek, lua_poke, lua_peek4, lua_poke4, lua_memcpy, 
 	lua_memset, lua_trace, lua_pmem, lua_time, lua_exit, lua_font, lua_mouse, 
 	lua_circ, lua_circb, lua_tri, lua_textri, lua_clip, lua_music, lua_sync, lua_reset,
-	lua_key, lua_keyp
+	lua_key, lua_keyp, lua_raster, lua_mray, lua_msweep, lua_mfill, lua_mpath
 };
 
 STATIC_ASSERT(api_func, COUNT_OF(ApiKeywords) == COUNT_OF(ApiFunc));
@@ -1196,16 +1558,61 @@ static void initAPI(tic_machine* machine)
 	registerLuaFunction(machine, lua_dofile, "dofile");
 	registerLuaFunction(machine, lua_loadfile, "loadfile");
 
+	// LuaJIT only checks the hook outside of compiled traces, a runaway loop can still be
+	// interrupted once it leaves the trace
 	lua_sethook(machine->lua, &checkForceExit, LUA_MASKCOUNT, LUA_LOC_STACK);
 }
 
+static void* luaAlloc(void* ud, void* ptr, size_t osize, size_t nsize)
+{
+	return tic_heap_realloc(ud, ptr, nsize);
+}
+
+static s32 luaPanic(lua_State* lua)
+{
+	fprintf(stderr, "PANIC: unprotected error in call to Lua API (%s)\n", lua_tostring(lua, -1));
+	return 0;
+}
+
+static lua_State* newLuaState(tic_machine* machine)
+{
+	lua_State* lua = lua_newstate(luaAlloc, &machine->heap);
+
+	// 64-bit LuaJIT without GC64 refuses custom allocators
+	if(lua)
+		lua_atpanic(lua, luaPanic);
+	else
+		lua = luaL_newstate();
+
+	// most of the collecting is done after the tick, the collector starts on its own
+	// only when the heap tripled and then finishes in a few big steps
+	lua_gc(lua, LUA_GCSETPAUSE, 300);
+	lua_gc(lua, LUA_GCSETSTEPMUL, 400);
+
+	return lua;
+}
+
+static bool collectLua(tic_mem* tic)
+{
+	lua_State* lua = ((tic_machine*)tic)->lua;
+
+	return lua ? lua_gc(lua, LUA_GCSTEP, 0) : true;
+}
+
 static void closeLua(tic_mem* tic)
 {
 	tic_machine* machine = (tic_machine*)tic;
 
 	if(machine->lua)
 	{
-		lua_close(machine->lua);
+		void* ud = NULL;
+
+		// the whole state lives in the machine heap, no need to free it object by object
+		if(lua_getallocf(machine->lua, &ud) == luaAlloc)
+			tic_heap_release(&machine->heap);
+		else
+			lua_close(machine->lua);
+
 		machine->lua = NULL;
 		CurrentMachine = NULL;
 	}
@@ -1217,7 +1624,7 @@ static bool initLua(tic_mem* tic, const char* code)
 
 	closeLua(tic);
 
-	lua_State* lua = machine->lua = luaL_newstate();
+	lua_State* lua = machine->lua = newLuaState(machine);
 	lua_open_builtins(lua);
 
 	initAPI(machine);
@@ -1227,7 +1634,7 @@ static bool initLua(tic_mem* tic, const char* code)
 
 		lua_settop(lua, 0);
 
-		if(luaL_loadstring(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
+		if(loadLuaCode(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
 		{
 			machine->data->error(machine->data->data, lua_tostring(lua, -1));
 			return false;
@@ -1420,7 +1827,7 @@ static void evalLua(tic_mem* tic, const char* code) {
 
 	lua_settop(lua, 0);
 
-	if(luaL_loadstring(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
+	if(loadLuaCode(lua, code) != LUA_OK || lua_pcall(lua, 0, LUA_MULTRET, 0) != LUA_OK)
 	{
 		machine->data->error(machine->data->data, lua_tostring(lua, -1));
 	}
@@ -1433,6 +1840,8 @@ static const tic_script_config LuaSyntaxConfig =
 	.tick 				= callLuaTick,
 	.scanline 			= callLuaScanline,
 	.overline 			= callLuaOverline,
+	.collect 			= collectLua,
+	.snapshot 			= LUA_SNAPSHOT,
 
 	.getOutline			= getLuaOutline,
 	.parse 				= parseCode,
@@ -1491,7 +1900,7 @@ static bool initMoonscript(tic_mem* tic, const char* code)
 	tic_machine* machine = (tic_machine*)tic;
 	closeLua(tic);
 
-	lua_State* lua = machine->lua = luaL_newstate();
+	lua_State* lua = machine->lua = newLuaState(machine);
 	lua_open_builtins(lua);
 
 	luaopen_lpeg(lua);
@@ -1602,6 +2011,8 @@ static const tic_script_config MoonSyntaxConfig =
 	.tick 				= callLuaTick,
 	.scanline 			= callLuaScanline,
 	.overline 			= callLuaOverline,
+	.collect 			= collectLua,
+	.snapshot 			= LUA_SNAPSHOT,
 
 	.getOutline			= getMoonOutline,
 	.parse 				= parseCode,
@@ -1644,7 +2055,7 @@ static bool initFennel(tic_mem* tic, const char* code)
 	tic_machine* machine = (tic_machine*)tic;
 	closeLua(tic);
 
-	lua_State* lua = machine->lua = luaL_newstate();
+	lua_State* lua = machine->lua = newLuaState(machine);
 	lua_open_builtins(lua);
 
 	initAPI(machine);
@@ -1778,6 +2189,8 @@ static const tic_script_config FennelSyntaxConfig =
 	.tick 				= callLuaTick,
 	.scanline 			= callLuaScanline,
 	.overline 			= callLuaOverline,
+	.collect 			= collectLua,
+	.snapshot 			= LUA_SNAPSHOT,
 
 	.getOutline			= getFennelOutline,
 	.parse 				= parseCode,
@@ -25,6 +25,7 @@
 #include "ticapi.h"
 #include "tools.h"
 #include "blip_buf.h"
+#include "heap.h"
 
 #define SFX_DEF_SPEED (1 << SFX_SPEED_BITS)
 
@@ -35,7 +36,7 @@
 #define API_KEYWORDS {TIC_FN, SCN_FN, OVR_FN, "print", "cls", "pix", "line", "rect", "rectb", \
 	"spr", "btn", "btnp", "sfx", "map", "mget", "mset", "peek", "poke", "peek4", "poke4", \
 	"memcpy", "memset", "trace", "pmem", "time", "exit", "font", "mouse", "circ", "circb", "tri", "textri", \
-	"clip", "music", "sync", "reset", "key", "keyp"}
+	"clip", "music", "sync", "reset", "key", "keyp", "raster", "mray", "msweep", "mfill", "mpath"}
 	
 typedef struct
 {
@@ -110,6 +111,38 @@ typedef struct
 	s32 row;
 } tic_jump_command;
 
+// palette bytes, border, offset.x and offset.y overridden per scanline
+#define TIC_RASTER_REGS (sizeof(tic_palette) + 3)
+#define TIC_RAM_VIEWS 3
+
+typedef struct
+{
+	u64 mask[TIC80_HEIGHT];
+	u8 data[TIC80_HEIGHT][TIC_RASTER_REGS];
+} tic_raster_data;
+
+// horizontal runs of lit pixels per glyph, built again after tic_font_touch
+typedef struct
+{
+	u8 x;
+	u8 y;
+	u8 width;
+} tic_glyph_span;
+
+typedef struct
+{
+	u8 start;
+	u8 end;
+	u8 count;
+	tic_glyph_span spans[TIC_FONT_HEIGHT * TIC_FONT_WIDTH / 2];
+} tic_glyph;
+
+typedef struct
+{
+	bool ready;
+	tic_glyph glyphs[2][TIC_FONT_CHARS];
+} tic_glyph_cache;
+
 typedef struct
 {
 
@@ -146,12 +179,18 @@ typedef struct
 	} music;
 
 	tic_tick tick;
+	tic_collect collect;
 	tic_scanline scanline;
+	tic_raster_data raster;
 
 	struct
 	{
 		tic_overline callback;
 		u32 palette[TIC_PALETTE_SIZE];
+
+		// 4bpp layer plus a bit per pixel telling which pixels OVR drew
+		u8 data[TIC80_WIDTH * TIC80_HEIGHT * TIC_PALETTE_BPP / BITS_IN_BYTE];
+		u8 mask[TIC80_WIDTH * TIC80_HEIGHT / BITS_IN_BYTE];
 	} ovr;
 
 	void (*setpix)(tic_mem* memory, s32 x, s32 y, u8 color);
@@ -163,6 +202,22 @@ typedef struct
 	bool initialized;
 } tic_machine_state_data;
 
+typedef struct tic_snapshot tic_snapshot;
+typedef struct tic_shared_cart tic_shared_cart;
+typedef struct tic_map_query tic_map_query;
+
+typedef struct
+{
+	tic_machine_state_data state;	
+	tic_ram ram;
+
+	struct
+	{
+		u64 start;
+		u64 paused;
+	} time;
+} tic_pause_data;
+
 typedef struct
 {
 	tic_mem memory; // it should be first
@@ -188,6 +243,34 @@ typedef struct
 
 	};
 
+	tic_heap heap;
+
+	struct
+	{
+		u64 start;		// when the tick started, in microseconds
+		u64 blit;		// how long the last blit took
+		u64 step;		// the recent longest collector step
+		u32 time;		// spent collecting garbage during the last frame
+		size_t live;	// heap left after the last full cycle
+		bool cycle;		// a cycle is in progress
+	} gc;
+
+	// the machine right after the script was initialized, used for instant resets,
+	// taken only once a running cart was reset, so carts that never restart don't pay for it
+	tic_snapshot* snapshot;
+	bool restarted;
+
+	// memory.cart points to one of them
+	tic_cartridge* own;
+	tic_shared_cart* shared;
+
+	// tiles, sprites and map sync()ed from a cart bank are read from it until ram is touched,
+	// NULL while the section lives in ram
+	const u8* views[TIC_RAM_VIEWS];
+
+	// scratch for mfill() and mpath(), allocated on the first call
+	tic_map_query* query;
+
 	struct
 	{
 		blip_buffer_t* left;
@@ -195,6 +278,8 @@ typedef struct
 	} blip;
 	
 	s32 samplerate;
+	// millionths more or fewer samples than samplerate, see tic_sound_rate
+	s32 correction;
 
 	struct
 	{
@@ -204,19 +289,12 @@ typedef struct
 
 	tic_tick_data* data;
 
-	tic_machine_state_data state;
+	tic_glyph_cache glyphs;
 
-	struct
-	{
-		tic_machine_state_data state;	
-		tic_ram ram;
+	tic_machine_state_data state;
 
-		struct
-		{
-			u64 start;
-			u64 paused;
-		} time;
-	} pause;
+	// allocated on the first pause
+	tic_pause_data* pause;
 
 } tic_machine;
 
@@ -224,7 +302,7 @@ typedef s32(DrawCharFunc)(tic_mem* memory, u8 symbol, s32 x, s32 y, s32 width, s
 s32 drawText(tic_mem* memory, const char* text, s32 x, s32 y, s32 width, s32 height, u8 color, s32 scale, DrawCharFunc* func, bool alt);
 s32 drawSpriteFont(tic_mem* memory, u8 symbol, s32 x, s32 y, s32 width, s32 height, u8 chromakey, s32 scale, bool alt);
 s32 drawFixedSpriteFont(tic_mem* memory, u8 index, s32 x, s32 y, s32 width, s32 height, u8 chromakey, s32 scale, bool alt);
-void parseCode(const tic_script_config* config, const char* start, u8* color, const tic_code_theme* theme);
+s32 parseCode(const tic_script_config* config, const char* start, u8* color, s32 state, const tic_code_theme* theme);
 
 #if defined(TIC_BUILD_WITH_SQUIRREL)
 const tic_script_config* getSquirrelScriptConfig();
@@ -1143,4 +1143,14 @@ void initMap(Map* map, tic_mem* tic, tic_map* src)
 	};
 
 	normalizeMap(&map->scroll.x, &map->scroll.y);
-}
\ No newline at end of file
+}
+
+void freeMap(Map* map)
+{
+	if(map)
+	{
+		history_delete(map->history);
+
+		free(map);
+	}
+}
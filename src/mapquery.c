@@ -0,0 +1,447 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "mapquery.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define CELL TIC_SPRITESIZE
+
+enum {Cells = TIC_MAP_WIDTH * TIC_MAP_HEIGHT, Closed = 0xffff};
+
+STATIC_ASSERT(map_cells, Cells < Closed);
+
+struct tic_map_query
+{
+	// a cell is seen in the current query when its stamp matches
+	u16 stamp[Cells];
+	u16 generation;
+
+	u32 cost[Cells];
+	u16 parent[Cells];
+
+	// open cells ordered by estimate for A*, a stack for the fill
+	u16 heap[Cells];
+	u16 slot[Cells];
+	s32 count;
+
+	u16 path[Cells];
+};
+
+tic_map_query* tic_map_query_create()
+{
+	return calloc(1, sizeof(tic_map_query));
+}
+
+void tic_map_query_delete(tic_map_query* query)
+{
+	free(query);
+}
+
+u32 tic_map_query_size()
+{
+	return sizeof(tic_map_query);
+}
+
+static inline s32 wrap(s32 value, s32 size)
+{
+	value %= size;
+	return value < 0 ? value + size : value;
+}
+
+static inline s32 cellIndex(s32 x, s32 y)
+{
+	return wrap(y, TIC_MAP_HEIGHT) * TIC_MAP_WIDTH + wrap(x, TIC_MAP_WIDTH);
+}
+
+static inline u8 cellFlags(const tic_map* map, const tic_flags* flags, s32 index)
+{
+	return flags->data[map->data[index]];
+}
+
+static inline bool solid(const tic_map* map, const tic_flags* flags, s32 x, s32 y, u8 mask)
+{
+	return cellFlags(map, flags, cellIndex(x, y)) & mask;
+}
+
+// keeps cell math in s32, also false for NaN
+static inline bool inRange(float value)
+{
+	return fabsf(value) < (float)(1 << 24);
+}
+
+static void setHit(tic_map_hit* hit, float x, float y, s32 cellx, s32 celly, s32 normalx, s32 normaly)
+{
+	*hit = (tic_map_hit)
+	{
+		.x = x, 
+		.y = y, 
+		.cellx = wrap(cellx, TIC_MAP_WIDTH), 
+		.celly = wrap(celly, TIC_MAP_HEIGHT),
+		.normalx = normalx, 
+		.normaly = normaly,
+	};
+}
+
+bool tic_map_ray(const tic_map* map, const tic_flags* flags, float x0, float y0, float x1, float y1, u8 mask, tic_map_hit* hit)
+{
+	if(!inRange(x0) || !inRange(y0) || !inRange(x1) || !inRange(y1))
+	{
+		setHit(hit, x0, y0, 0, 0, 0, 0);
+		return false;
+	}
+
+	const float dx = x1 - x0;
+	const float dy = y1 - y0;
+
+	s32 cx = (s32)floorf(x0 / CELL);
+	s32 cy = (s32)floorf(y0 / CELL);
+
+	const s32 stepx = dx > 0 ? 1 : dx < 0 ? -1 : 0;
+	const s32 stepy = dy > 0 ? 1 : dy < 0 ? -1 : 0;
+
+	// distances along the segment, 0 at the start and 1 at the end
+	const float deltax = stepx ? CELL / fabsf(dx) : INFINITY;
+	const float deltay = stepy ? CELL / fabsf(dy) : INFINITY;
+
+	float tx = stepx ? ((cx + (stepx > 0)) * CELL - x0) / dx : INFINITY;
+	float ty = stepy ? ((cy + (stepy > 0)) * CELL - y0) / dy : INFINITY;
+	float t = 0;
+
+	s32 nx = 0, ny = 0;
+
+	// a ray crossing more cells than the map has is given up on as a miss
+	for(s32 i = 0; i < Cells; i++)
+	{
+		if(solid(map, flags, cx, cy, mask))
+		{
+			setHit(hit, x0 + dx * t, y0 + dy * t, cx, cy, nx, ny);
+			return true;
+		}
+
+		if(tx > 1 && ty > 1)
+			break;
+
+		if(tx < ty)
+		{
+			t = tx;
+			tx += deltax;
+			cx += stepx;
+			nx = -stepx;
+			ny = 0;
+		}
+		else
+		{
+			t = ty;
+			ty += deltay;
+			cy += stepy;
+			nx = 0;
+			ny = -stepy;
+		}
+	}
+
+	setHit(hit, x1, y1, cx, cy, 0, 0);
+	return false;
+}
+
+// moves the edge of a rect along one axis, cells are (along, across) and swapped for y
+static float sweepAxis(const tic_map* map, const tic_flags* flags, u8 mask, bool vertical,
+	float pos, float size, float delta, float across, float acrossSize, s32* normal, s32* cell, s32* cellAcross)
+{
+	enum {Width = TIC_MAP_WIDTH, Height = TIC_MAP_HEIGHT};
+
+	const s32 alongCells = vertical ? Height : Width;
+	const s32 acrossCells = vertical ? Width : Height;
+
+	s32 first = (s32)floorf(across / CELL);
+	s32 last = MAX(first, (s32)ceilf((across + acrossSize) / CELL) - 1);
+	last = MIN(last, first + acrossCells - 1);
+
+	s32 from, to, step;
+
+	if(delta > 0)
+	{
+		float edge = pos + size;
+		from = (s32)ceilf(edge / CELL);
+		to = (s32)ceilf((edge + delta) / CELL) - 1;
+		step = 1;
+	}
+	else
+	{
+		from = (s32)floorf(pos / CELL) - 1;
+		to = (s32)floorf((pos + delta) / CELL);
+		step = -1;
+	}
+
+	// past a whole map every column repeats
+	s32 count = MIN((to - from) * step + 1, alongCells + 1);
+
+	for(s32 i = 0, c = from; i < count; i++, c += step)
+		for(s32 a = first; a <= last; a++)
+			if(vertical ? solid(map, flags, a, c, mask) : solid(map, flags, c, a, mask))
+			{
+				*normal = -step;
+				*cell = c;
+				*cellAcross = a;
+
+				return step > 0 ? c * CELL - (pos + size) : (c + 1) * CELL - pos;
+			}
+
+	return delta;
+}
+
+bool tic_map_sweep(const tic_map* map, const tic_flags* flags, float x, float y, float w, float h, float dx, float dy, u8 mask, tic_map_hit* hit)
+{
+	s32 nx = 0, ny = 0;
+	s32 cellx = 0, celly = 0;
+
+	if(!inRange(x) || !inRange(y) || !inRange(x + w) || !inRange(y + h) || w < 0 || h < 0)
+	{
+		setHit(hit, x, y, 0, 0, 0, 0);
+		return false;
+	}
+
+	if(dx != 0 && inRange(x + dx) && inRange(x + w + dx))
+		x += sweepAxis(map, flags, mask, false, x, w, dx, y, h, &nx, &cellx, &celly);
+
+	if(dy != 0 && inRange(y + dy) && inRange(y + h + dy))
+		y += sweepAxis(map, flags, mask, true, y, h, dy, x, w, &ny, &celly, &cellx);
+
+	setHit(hit, x, y, cellx, celly, nx, ny);
+
+	return nx || ny;
+}
+
+// stamps start from 1 so a fresh query sees every cell as new
+static void nextGeneration(tic_map_query* query)
+{
+	if(++query->generation == 0)
+	{
+		memset(query->stamp, 0, sizeof query->stamp);
+		query->generation = 1;
+	}
+
+	query->count = 0;
+}
+
+static inline bool seen(const tic_map_query* query, s32 index)
+{
+	return query->stamp[index] == query->generation;
+}
+
+static inline void neighbours(s32 index, s32 out[4])
+{
+	enum {Width = TIC_MAP_WIDTH, Size = TIC_MAP_WIDTH * TIC_MAP_HEIGHT};
+
+	s32 x = index % Width;
+
+	out[0] = x == Width - 1 ? index - x : index + 1;
+	out[1] = x == 0 ? index + Width - 1 : index - 1;
+	out[2] = index + Width >= Size ? index + Width - Size : index + Width;
+	out[3] = index < Width ? index - Width + Size : index - Width;
+}
+
+s32 tic_map_fill(tic_map_query* query, tic_map* map, const tic_flags* flags, s32 x, s32 y, u8 mask, s32 tile)
+{
+	nextGeneration(query);
+
+	s32 start = cellIndex(x, y);
+	u8 region = cellFlags(map, flags, start) & mask;
+	s32 filled = 0;
+
+	query->stamp[start] = query->generation;
+	query->heap[query->count++] = start;
+
+	while(query->count)
+	{
+		s32 index = query->heap[--query->count];
+		s32 next[4];
+
+		neighbours(index, next);
+
+		for(s32 i = 0; i < COUNT_OF(next); i++)
+			if(!seen(query, next[i]) && (cellFlags(map, flags, next[i]) & mask) == region)
+			{
+				query->stamp[next[i]] = query->generation;
+				query->heap[query->count++] = next[i];
+			}
+
+		if(tile >= 0)
+			map->data[index] = tile;
+
+		filled++;
+	}
+
+	return filled;
+}
+
+static inline u32 distance(s32 a, s32 b, s32 size)
+{
+	s32 d = abs(a - b);
+	return MIN(d, size - d);
+}
+
+static inline u32 estimate(const tic_map_query* query, s32 index, s32 goal)
+{
+	return query->cost[index]
+		+ distance(index % TIC_MAP_WIDTH, goal % TIC_MAP_WIDTH, TIC_MAP_WIDTH)
+		+ distance(index / TIC_MAP_WIDTH, goal / TIC_MAP_WIDTH, TIC_MAP_HEIGHT);
+}
+
+// the cheaper estimate first, the one further along on ties
+static inline bool before(const tic_map_query* query, s32 a, s32 b, s32 goal)
+{
+	u32 ea = estimate(query, a, goal);
+	u32 eb = estimate(query, b, goal);
+
+	return ea < eb || (ea == eb && query->cost[a] > query->cost[b]);
+}
+
+static void heapPlace(tic_map_query* query, s32 pos, s32 index)
+{
+	query->heap[pos] = index;
+	query->slot[index] = pos;
+}
+
+static void heapUp(tic_map_query* query, s32 pos, s32 goal)
+{
+	s32 index = query->heap[pos];
+
+	while(pos)
+	{
+		s32 parent = (pos - 1) / 2;
+
+		if(!before(query, index, query->heap[parent], goal))
+			break;
+
+		heapPlace(query, pos, query->heap[parent]);
+		pos = parent;
+	}
+
+	heapPlace(query, pos, index);
+}
+
+static s32 heapPop(tic_map_query* query, s32 goal)
+{
+	s32 top = query->heap[0];
+	s32 index = query->heap[--query->count];
+	s32 pos = 0;
+
+	while(true)
+	{
+		s32 child = pos * 2 + 1;
+
+		if(child >= query->count)
+			break;
+
+		if(child + 1 < query->count && before(query, query->heap[child + 1], query->heap[child], goal))
+			child++;
+
+		if(!before(query, query->heap[child], index, goal))
+			break;
+
+		heapPlace(query, pos, query->heap[child]);
+		pos = child;
+	}
+
+	if(query->count)
+		heapPlace(query, pos, index);
+
+	query->slot[top] = Closed;
+
+	return top;
+}
+
+s32 tic_map_path(tic_map_query* query, const tic_map* map, const tic_flags* flags, s32 x0, s32 y0, s32 x1, s32 y1, u8 mask, u8 cost, const u16** path)
+{
+	s32 start = cellIndex(x0, y0);
+	s32 goal = cellIndex(x1, y1);
+
+	*path = query->path;
+
+	if(start == goal)
+		return 0;
+
+	if(cellFlags(map, flags, goal) & mask)
+		return -1;
+
+	nextGeneration(query);
+
+	query->stamp[start] = query->generation;
+	query->cost[start] = 0;
+	heapPlace(query, query->count++, start);
+
+	while(query->count)
+	{
+		s32 index = heapPop(query, goal);
+
+		if(index == goal)
+		{
+			s32 steps = 0;
+
+			for(s32 i = goal; i != start; i = query->parent[i])
+				steps++;
+
+			for(s32 i = goal, n = steps; i != start; i = query->parent[i])
+				query->path[--n] = i;
+
+			return steps;
+		}
+
+		s32 next[4];
+		neighbours(index, next);
+
+		for(s32 i = 0; i < COUNT_OF(next); i++)
+		{
+			s32 n = next[i];
+			u8 f = cellFlags(map, flags, n);
+
+			if(f & mask)
+				continue;
+
+			// one for the step and one per cost flag
+			u32 c = query->cost[index] + 1;
+
+			for(u8 bits = f & cost; bits; bits &= bits - 1)
+				c++;
+
+			if(!seen(query, n))
+			{
+				query->stamp[n] = query->generation;
+				query->cost[n] = c;
+				query->parent[n] = index;
+				heapPlace(query, query->count++, n);
+				heapUp(query, query->count - 1, goal);
+			}
+			else if(query->slot[n] != Closed && c < query->cost[n])
+			{
+				query->cost[n] = c;
+				query->parent[n] = index;
+				heapUp(query, query->slot[n], goal);
+			}
+		}
+	}
+
+	return -1;
+}
@@ -0,0 +1,45 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// Collision and pathfinding queries over a map and the sprite flags, a cell is solid when
+// its tile has any of the mask flags. The map wraps around in both directions, as map() draws it.
+
+typedef struct tic_map_query tic_map_query;
+
+// scratch for fill and path, allocated once per machine
+tic_map_query* tic_map_query_create();
+void tic_map_query_delete(tic_map_query* query);
+u32 tic_map_query_size();
+
+// walks the cells a segment in pixels crosses until one is solid
+bool tic_map_ray(const tic_map* map, const tic_flags* flags, float x0, float y0, float x1, float y1, u8 mask, tic_map_hit* hit);
+// moves a rect in pixels along x then y, stopping it at the first solid cell on each axis
+bool tic_map_sweep(const tic_map* map, const tic_flags* flags, float x, float y, float w, float h, float dx, float dy, u8 mask, tic_map_hit* hit);
+// counts the 4-connected cells sharing the mask flags of the start cell, sets them to the tile if it isn't negative
+s32 tic_map_fill(tic_map_query* query, tic_map* map, const tic_flags* flags, s32 x, s32 y, u8 mask, s32 tile);
+// A* over 4-connected cells, a step costs 1 plus the number of cost flags on the cell it enters,
+// returns the steps to the goal, -1 if it can't be reached; the path holds them as cell indices
+s32 tic_map_path(tic_map_query* query, const tic_map* map, const tic_flags* flags, s32 x0, s32 y0, s32 x1, s32 y1, u8 mask, u8 cost, const u16** path);
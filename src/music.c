@@ -1728,3 +1728,13 @@ void initMusic(Music* music, tic_mem* tic, tic_music* src)
 
 	resetSelection(music);
 }
+
+void freeMusic(Music* music)
+{
+	if(music)
+	{
+		history_delete(music->history);
+
+		free(music);
+	}
+}
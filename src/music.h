@@ -74,4 +74,5 @@ struct Music
 	void(*event)(Music*, StudioEvent);
 };
 
-void initMusic(Music*, tic_mem*, tic_music* src);
\ No newline at end of file
+void initMusic(Music*, tic_mem*, tic_music* src);
+void freeMusic(Music*);
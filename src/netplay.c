@@ -0,0 +1,369 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "netplay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+	Window = TIC_NETPLAY_WINDOW,
+	CatchUp = 4,	// the most frames a spectator runs in one tick
+};
+
+typedef struct
+{
+	u32 ack;
+	u32 synced;
+	u32 hash;
+} Peer;
+
+struct tic_netplay
+{
+	tic80_netplay_config config;
+	tic80_netplay stats;
+
+	u32 frame;								// the next one to run
+	u32 received[TIC_NETPLAY_PLAYERS];		// inputs known in a row from frame 0
+	u32 confirmed;							// the least of them
+	s32 rollback;
+
+	bool mispredicted;
+	u32 rewind;								// the first frame run on a wrong prediction
+
+	u8 inputs[Window][TIC_NETPLAY_PLAYERS];
+	u8 used[Window][TIC_NETPLAY_PLAYERS];	// what the frame was run with, predictions included
+	u32 hashes[Window];
+
+	tic_checkpoint* checkpoints[TIC_NETPLAY_ROLLBACK];
+	Peer peers[TIC_NETPLAY_PEERS];
+
+	u8 packet[sizeof(tic_netplay_header) + TIC_NETPLAY_BURST];
+};
+
+static inline bool isPlayer(const tic_netplay* netplay)
+{
+	return netplay->config.local < netplay->config.players;
+}
+
+static inline s32 clamp(s32 value, s32 min, s32 max)
+{
+	return value < min ? min : value > max ? max : value;
+}
+
+tic_netplay* tic_netplay_create(const tic80_netplay_config* config)
+{
+	if(config->players < 2 || config->players > TIC_NETPLAY_PLAYERS
+		|| config->peers < config->players || config->peers > TIC_NETPLAY_PEERS
+		|| config->local < 0 || config->local >= config->peers)
+		return NULL;
+
+	tic_netplay* netplay = calloc(1, sizeof(tic_netplay));
+
+	if(netplay)
+	{
+		netplay->config = *config;
+		netplay->config.delay = clamp(config->delay, 1, TIC_NETPLAY_ROLLBACK);
+		netplay->rollback = isPlayer(netplay) ? clamp(config->rollback, 0, TIC_NETPLAY_ROLLBACK) : 0;
+		netplay->stats.desync = -1;
+
+		// nobody presses anything during the first frames
+		for(s32 i = 0; i < config->players; i++)
+			netplay->received[i] = netplay->config.delay;
+
+		netplay->confirmed = netplay->config.delay;
+
+		for(s32 i = 0; i < config->peers; i++)
+			netplay->peers[i].ack = netplay->config.delay;
+
+		memcpy(netplay->packet, TIC_NETPLAY_MAGIC, sizeof TIC_NETPLAY_MAGIC - 1);
+	}
+
+	return netplay;
+}
+
+void tic_netplay_close(tic_netplay* netplay, tic_mem* tic)
+{
+	if(netplay)
+	{
+		for(s32 i = 0; i < TIC_NETPLAY_ROLLBACK; i++)
+			tic_checkpoint_free(tic, netplay->checkpoints[i]);
+
+		free(netplay);
+	}
+}
+
+// FNV-1a over words, fast enough to run every frame
+static u32 hashRam(const tic_ram* ram)
+{
+	const u32* ptr = (const u32*)ram;
+	const u32* end = ptr + sizeof(tic_ram) / sizeof(u32);
+
+	u32 hash = 2166136261u;
+
+	while(ptr < end)
+		hash = (hash ^ *ptr++) * 16777619u;
+
+	return hash;
+}
+
+static void checkSync(tic_netplay* netplay)
+{
+	u32 synced = netplay->stats.synced;
+
+	for(s32 i = 0; i < netplay->config.peers && netplay->stats.desync < 0; i++)
+	{
+		const Peer* peer = &netplay->peers[i];
+
+		if(i != netplay->config.local && peer->synced && peer->synced <= synced && peer->synced + Window > synced
+			&& netplay->hashes[(peer->synced - 1) % Window] != peer->hash)
+			netplay->stats.desync = peer->synced - 1;
+	}
+}
+
+void tic_netplay_receive(tic_netplay* netplay, const void* packet, s32 size)
+{
+	const tic_netplay_header* header = packet;
+
+	if(size < (s32)sizeof(tic_netplay_header) 
+		|| memcmp(header->magic, TIC_NETPLAY_MAGIC, sizeof header->magic) != 0
+		|| header->players != netplay->config.players
+		|| header->from >= netplay->config.peers || header->from == netplay->config.local
+		|| size < (s32)sizeof(tic_netplay_header) + header->count)
+		return;
+
+	Peer* peer = &netplay->peers[header->from];
+
+	// packets can come out of order
+	if(header->ack > peer->ack)
+		peer->ack = header->ack;
+
+	if(header->synced > peer->synced)
+	{
+		peer->synced = header->synced;
+		peer->hash = header->hash;
+	}
+
+	if(header->from >= netplay->config.players)
+		return;
+
+	const u8* inputs = (const u8*)(header + 1);
+	u32* received = &netplay->received[header->from];
+
+	for(s32 i = 0; i < header->count; i++)
+	{
+		u32 frame = header->frame + i;
+
+		// the prediction still needs the input before the confirmed frame
+		if(frame == *received && frame + 1 < netplay->confirmed + Window)
+		{
+			u8 pad = inputs[i];
+
+			netplay->inputs[frame % Window][header->from] = pad;
+			(*received)++;
+
+			if(frame < netplay->frame && netplay->used[frame % Window][header->from] != pad
+				&& (!netplay->mispredicted || frame < netplay->rewind))
+			{
+				netplay->mispredicted = true;
+				netplay->rewind = frame;
+			}
+		}
+	}
+}
+
+static void run(tic_netplay* netplay, tic_mem* tic, tic_tick_data* data, bool quiet)
+{
+	u32 frame = netplay->frame;
+	u8* used = netplay->used[frame % Window];
+
+	if(frame >= netplay->confirmed)
+		tic_checkpoint_save(tic, netplay->checkpoints[frame % netplay->rollback]);
+
+	memset(&tic->ram.input, 0, sizeof(tic80_input));
+
+	for(s32 i = 0; i < netplay->config.players; i++)
+	{
+		u32 received = netplay->received[i];
+
+		used[i] = netplay->inputs[(frame < received ? frame : received - 1) % Window][i];
+		(&tic->ram.input.gamepads.first)[i].data = used[i];
+	}
+
+	// time() and the C library random numbers some VMs use only depend on the frame
+	data->start = data->counter() - (u64)frame * data->freq() / TIC80_FRAMERATE;
+	srand(frame);
+
+	tic->api.tick_start(tic, &tic->ram.sfx, &tic->ram.music);
+	tic->api.tick(tic, data);
+
+	if(quiet)
+		tic_tick_end_quiet(tic);
+	else tic->api.tick_end(tic);
+
+	// banks switched by sync() have to be in ram for the peers to hash the same bytes
+	tic_ram_touch(tic, 0, sizeof(tic_ram));
+	netplay->hashes[frame % Window] = hashRam(&tic->ram);
+	netplay->frame = frame + 1;
+}
+
+// every frame run ahead needs a checkpoint, VMs which can't have one wait for every input
+static bool canPredict(tic_netplay* netplay, tic_mem* tic)
+{
+	if(netplay->frame >= netplay->confirmed + netplay->rollback)
+		return false;
+
+	tic_checkpoint** checkpoint = &netplay->checkpoints[netplay->frame % netplay->rollback];
+
+	if(!*checkpoint && !(*checkpoint = tic_checkpoint_create(tic)))
+	{
+		// frames already run ahead still have theirs
+		if(netplay->frame == netplay->confirmed)
+			netplay->rollback = 0;
+
+		return false;
+	}
+
+	return true;
+}
+
+bool tic_netplay_tick(tic_netplay* netplay, tic_mem* tic, tic_tick_data* data, tic80_gamepad pad)
+{
+	s32 local = netplay->config.local;
+
+	if(isPlayer(netplay) && netplay->received[local] <= netplay->frame + netplay->config.delay)
+		netplay->inputs[netplay->received[local]++ % Window][local] = pad.data;
+
+	u32 confirmed = netplay->received[0];
+
+	for(s32 i = 1; i < netplay->config.players; i++)
+		if(netplay->received[i] < confirmed)
+			confirmed = netplay->received[i];
+
+	netplay->confirmed = confirmed;
+
+	if(netplay->mispredicted)
+	{
+		u32 end = netplay->frame;
+
+		netplay->mispredicted = false;
+
+		if(tic_checkpoint_load(tic, netplay->checkpoints[netplay->rewind % netplay->rollback]))
+		{
+			netplay->frame = netplay->rewind;
+			netplay->stats.rollbacks++;
+			netplay->stats.resimulated += end - netplay->rewind;
+
+			while(netplay->frame < end)
+				run(netplay, tic, data, true);
+		}
+		else if(netplay->stats.desync < 0)
+			netplay->stats.desync = netplay->rewind;
+	}
+
+	bool done = false;
+
+	if(isPlayer(netplay))
+	{
+		if(netplay->frame < confirmed || canPredict(netplay, tic))
+		{
+			run(netplay, tic, data, false);
+			done = true;
+		}
+	}
+	else
+	{
+		// spectators far behind catch up a few frames at a time
+		for(s32 i = 1; i < CatchUp && netplay->frame + TIC_NETPLAY_ROLLBACK < confirmed; i++)
+			run(netplay, tic, data, true);
+
+		if(netplay->frame < confirmed)
+		{
+			run(netplay, tic, data, false);
+			done = true;
+		}
+	}
+
+	if(!done)
+		netplay->stats.stalls++;
+
+	netplay->stats.frame = netplay->frame;
+	netplay->stats.confirmed = confirmed;
+	netplay->stats.synced = netplay->frame < confirmed ? netplay->frame : confirmed;
+
+	checkSync(netplay);
+
+	return done;
+}
+
+void tic_netplay_send(tic_netplay* netplay)
+{
+	const tic80_netplay_config* config = &netplay->config;
+
+	tic_netplay_header* header = (tic_netplay_header*)netplay->packet;
+	u8* inputs = (u8*)(header + 1);
+
+	s32 local = config->local;
+	u32 synced = netplay->stats.synced;
+
+	header->from = local;
+	header->players = config->players;
+	header->synced = synced;
+	header->hash = synced ? netplay->hashes[(synced - 1) % Window] : 0;
+
+	for(s32 i = 0; i < config->peers; i++)
+	{
+		// spectators only talk to players
+		if(i == local || (!isPlayer(netplay) && i >= config->players))
+			continue;
+
+		header->ack = i < config->players ? netplay->received[i] : 0;
+		header->frame = 0;
+		header->count = 0;
+
+		if(isPlayer(netplay))
+		{
+			u32 end = netplay->received[local];
+			u32 start = netplay->peers[i].ack;
+
+			// too far behind to ever catch up
+			if(start + Window < end)
+				start = end - Window;
+
+			u32 count = end - start < TIC_NETPLAY_BURST ? end - start : TIC_NETPLAY_BURST;
+
+			for(u32 f = 0; f < count; f++)
+				inputs[f] = netplay->inputs[(start + f) % Window][local];
+
+			header->frame = start;
+			header->count = count;
+		}
+
+		config->send(config->data, i, netplay->packet, sizeof(tic_netplay_header) + header->count);
+	}
+}
+
+tic80_netplay tic_netplay_stats(const tic_netplay* netplay)
+{
+	return netplay->stats;
+}
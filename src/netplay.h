@@ -0,0 +1,74 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// Rollback netplay for up to four players and any number of spectators, over whatever
+// transport the host has. Every peer runs the same cart on the same inputs: local input is
+// used a few frames late, input that hasn't arrived yet is predicted to be the last one seen,
+// and when it arrives different the machine goes back to the checkpoint taken before that
+// frame and runs up to the current one again, quietly. A packet repeats every input the
+// receiver hasn't acknowledged, so a lost one is covered by the next, and carries the RAM
+// hash of the last frame every input was known for to catch desyncs.
+// Spectators only run frames every input is known for.
+
+#define TIC_NETPLAY_MAGIC "TICN"
+#define TIC_NETPLAY_PORT 7790
+
+enum
+{
+	TIC_NETPLAY_PLAYERS = 4,
+	TIC_NETPLAY_PEERS = 8,
+	TIC_NETPLAY_ROLLBACK = 15,
+	TIC_NETPLAY_WINDOW = 256,	// frames of input kept for late peers
+	TIC_NETPLAY_BURST = 64,		// the most inputs one packet carries
+};
+
+typedef struct
+{
+	char magic[4];
+	u8 from;
+	u8 players;
+	u8 count;		// inputs of the sender that follow, starting at frame
+	u8 reserved;
+	u32 frame;
+	u32 ack;		// the first input of the receiver the sender doesn't have
+	u32 synced;		// frames the sender is sure of, and the RAM hash after the last one
+	u32 hash;
+} tic_netplay_header;
+
+typedef struct tic_netplay tic_netplay;
+
+tic_netplay* tic_netplay_create(const tic80_netplay_config* config);
+void tic_netplay_close(tic_netplay* netplay, tic_mem* tic);
+
+void tic_netplay_receive(tic_netplay* netplay, const void* packet, s32 size);
+
+// runs the next frame if it can, rolling back first if some input turned out different
+bool tic_netplay_tick(tic_netplay* netplay, tic_mem* tic, tic_tick_data* data, tic80_gamepad pad);
+
+// hands a packet for every other peer to the config send callback
+void tic_netplay_send(tic_netplay* netplay);
+
+tic80_netplay tic_netplay_stats(const tic_netplay* netplay);
@@ -0,0 +1,280 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "tools.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#define PACER_POSIX
+#include <time.h>
+#endif
+
+// vsync intervals are snapped to whole halves of the period up to this many frames
+#define VSYNC_SNAP 8
+// a wait this many periods late starts the schedule again instead of running frames to catch up
+#define MAX_LATE 4
+// a vsync interval under this part of the period means the display doesn't block on the swap
+#define VSYNC_MIN 8
+
+struct tic80_pacer
+{
+	tic80_pacer_config config;
+
+	u64 deadline;
+	u64 last;
+	u64 carry;
+
+	tic80_pacer_stats stats;
+
+	// frame times, the newest one at head - 1
+	u32 history[TIC80_PACER_HISTORY];
+	bool late[TIC80_PACER_HISTORY];
+	s32 head;
+	s32 count;
+};
+
+#if defined(_WIN32)
+
+// only as fine as the system timer, SDL sets it to 1ms while it runs
+static void sleepFor(u64 us)
+{
+	Sleep((DWORD)(us / 1000));
+}
+
+#elif defined(PACER_POSIX)
+
+static void sleepFor(u64 us)
+{
+	struct timespec delay = {us / 1000000, us % 1000000 * 1000};
+	nanosleep(&delay, NULL);
+}
+
+#else
+
+// nothing to sleep with, the whole wait spins
+static void sleepFor(u64 us) {}
+
+#endif
+
+tic80_pacer* tic80_pacer_create(const tic80_pacer_config* config)
+{
+	tic80_pacer* pacer = calloc(1, sizeof(tic80_pacer));
+
+	if(pacer)
+	{
+		pacer->config = *config;
+
+		if(!pacer->config.period)
+			pacer->config.period = 1000000 / TIC80_FRAMERATE;
+
+		pacer->last = pacer->deadline = tic_tool_get_microseconds();
+	}
+
+	return pacer;
+}
+
+void tic80_pacer_delete(tic80_pacer* pacer)
+{
+	free(pacer);
+}
+
+static void record(tic80_pacer* pacer, u64 now, bool late)
+{
+	tic80_pacer_stats* stats = &pacer->stats;
+
+	stats->frames++;
+	stats->frame = (u32)(now - pacer->last);
+	pacer->last = now;
+
+	pacer->history[pacer->head] = stats->frame;
+	pacer->late[pacer->head] = late;
+	pacer->head = (pacer->head + 1) % TIC80_PACER_HISTORY;
+
+	if(pacer->count < TIC80_PACER_HISTORY)
+		pacer->count++;
+
+	u64 sum = 0;
+	for(s32 i = 0; i < pacer->count; i++)
+		sum += pacer->history[i];
+
+	stats->average = (u32)(sum / pacer->count);
+
+	u64 deviation = 0;
+	for(s32 i = 0; i < pacer->count; i++)
+		deviation += abs((s32)pacer->history[i] - (s32)stats->average);
+
+	stats->jitter = (u32)(deviation / pacer->count);
+}
+
+// sleeps to spin before the deadline, then spins the rest, so the wake up is as late as the
+// sleep overshoots by at most the spin window
+static bool waitDeadline(tic80_pacer* pacer)
+{
+	const u32 period = pacer->config.period;
+	u64 now = tic_tool_get_microseconds();
+
+	pacer->deadline += period;
+
+	if(now >= pacer->deadline)
+	{
+		pacer->stats.missed++;
+
+		// a bit late is made up over the next frames, a stall starts over
+		if(now - pacer->deadline > period * MAX_LATE)
+			pacer->deadline = now;
+
+		return true;
+	}
+
+	u64 wake = pacer->deadline - pacer->config.spin;
+
+	if(now < wake)
+	{
+		sleepFor(wake - now);
+		now = tic_tool_get_microseconds();
+
+		pacer->stats.overshoot = now > wake ? (u32)(now - wake) : 0;
+
+		if(pacer->stats.overshoot > pacer->stats.worst)
+			pacer->stats.worst = pacer->stats.overshoot;
+	}
+
+	while(tic_tool_get_microseconds() < pacer->deadline);
+
+	return false;
+}
+
+// the display sets the pace, the time since the last call is turned into frames to run,
+// with intervals near a whole half period taken as exactly that to keep timer noise out
+static s32 countFrames(tic80_pacer* pacer, u64 now, bool* late)
+{
+	const u32 period = pacer->config.period;
+	u64 elapsed = now - pacer->last;
+
+	for(s32 i = 1; i <= VSYNC_SNAP * 2; i++)
+	{
+		u64 snap = (u64)period * i / 2;
+
+		if(elapsed + period / 16 > snap && elapsed < snap + period / 16)
+		{
+			elapsed = snap;
+			break;
+		}
+	}
+
+	pacer->carry += elapsed;
+
+	s32 frames = (s32)(pacer->carry / period);
+	pacer->carry -= (u64)frames * period;
+
+	*late = frames > 1;
+
+	if(frames > 1)
+		pacer->stats.missed += frames - 1;
+
+	if(frames > MAX_LATE)
+	{
+		frames = 1;
+		pacer->carry = 0;
+	}
+
+	return frames;
+}
+
+s32 tic80_pacer_wait(tic80_pacer* pacer)
+{
+	bool late = false;
+	s32 frames = 1;
+	u64 now = tic_tool_get_microseconds();
+
+	if(pacer->config.vsync && now - pacer->last >= pacer->config.period / VSYNC_MIN)
+		frames = countFrames(pacer, now, &late);
+	else
+	{
+		// vsync that doesn't wait falls back to a period after the last frame
+		if(pacer->config.vsync)
+			pacer->deadline = pacer->last;
+
+		late = waitDeadline(pacer);
+		now = tic_tool_get_microseconds();
+	}
+
+	record(pacer, now, late);
+
+	return frames;
+}
+
+tic80_pacer_stats tic80_pacer_report(const tic80_pacer* pacer)
+{
+	return pacer->stats;
+}
+
+static void putPixel(tic80_pixel_color_format format, void* pixels, s32 pitch, s32 x, s32 y, u32 color)
+{
+	u8* row = (u8*)pixels + y * pitch;
+
+	if(format == TIC80_PIXEL_COLOR_RGB565)
+		((u16*)row)[x] = (u16)color;
+	else
+		((u32*)row)[x] = color;
+}
+
+void tic80_pacer_graph(const tic80_pacer* pacer, tic80_pixel_color_format format, void* pixels, s32 pitch)
+{
+	enum {Width = TIC80_PACER_HISTORY, Height = TIC80_PACER_GRAPH_HEIGHT};
+
+	const u32 period = pacer->config.period;
+	const u32 back = tic_tool_pack_color(format, 0x1a, 0x1c, 0x2c);
+	const u32 good = tic_tool_pack_color(format, 0x38, 0xb7, 0x64);
+	const u32 uneven = tic_tool_pack_color(format, 0xff, 0xcd, 0x75);
+	const u32 late = tic_tool_pack_color(format, 0xb1, 0x3e, 0x53);
+	const u32 line = tic_tool_pack_color(format, 0xf4, 0xf4, 0xf4);
+
+	// the full height is two periods and the line marks one, bars off the average by a tenth
+	// of a period are uneven ones
+	for(s32 x = 0; x < Width; x++)
+	{
+		s32 age = Width - 1 - x;
+		s32 height = 0;
+		u32 color = good;
+
+		if(age < pacer->count)
+		{
+			s32 index = (pacer->head - 1 - age + TIC80_PACER_HISTORY) % TIC80_PACER_HISTORY;
+			u32 time = pacer->history[index];
+
+			height = (s32)MIN((u64)time * Height / (period * 2), Height);
+
+			if(pacer->late[index])
+				color = late;
+			else if(abs((s32)time - (s32)pacer->stats.average) > (s32)period / 10)
+				color = uneven;
+		}
+
+		for(s32 y = 0; y < Height; y++)
+			putPixel(format, pixels, pitch, x, Height - 1 - y, y == Height / 2 ? line : y < height ? color : back);
+	}
+}
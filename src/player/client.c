@@ -0,0 +1,248 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Reference thin client for player-server: sends the keyboard as the first gamepad,
+// rebuilds every frame from the delta stream with the core blit and plays its samples.
+// -headless skips the window and audio, for measuring over loopback.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL.h>
+
+#include "ticapi.h"
+#include "stream.h"
+#include "socket.h"
+
+#define DEFAULT_ADDRESS "7780"
+
+// don't let the audio queue grow behind the frames
+#define MAX_QUEUED_AUDIO (TIC80_SAMPLERATE * TIC_STEREO_CHANNELS * sizeof(s16) / 10)
+
+static struct
+{
+	bool quit;
+	bool headless;
+
+	struct
+	{
+		u32 frames;
+		u64 bytes;
+		u64 decode;
+		u32 maxDecode;
+	} stats;
+} state =
+{
+	.quit = false,
+	.headless = false,
+};
+
+static void readInput(tic80_input* input)
+{
+	static const SDL_Scancode Keys[] = 
+	{ 
+		SDL_SCANCODE_UP,
+		SDL_SCANCODE_DOWN,
+		SDL_SCANCODE_LEFT,
+		SDL_SCANCODE_RIGHT,
+
+		SDL_SCANCODE_Z,
+		SDL_SCANCODE_X,
+		SDL_SCANCODE_A,
+		SDL_SCANCODE_S,
+	};
+
+	memset(input, 0, sizeof(tic80_input));
+
+	if(state.headless)
+		return;
+
+	SDL_Event event;
+
+	while(SDL_PollEvent(&event))
+		if(event.type == SDL_QUIT)
+			state.quit = true;
+
+	const u8* keyboard = SDL_GetKeyboardState(NULL);
+
+	for(s32 i = 0; i < SDL_arraysize(Keys); i++)
+		if(keyboard[Keys[i]])
+			input->gamepads.first.data |= 1 << i;
+}
+
+static void reportFrame(u32 frame, s32 size, u32 decode)
+{
+	state.stats.frames++;
+	state.stats.bytes += size;
+	state.stats.decode += decode;
+
+	if(decode > state.stats.maxDecode)
+		state.stats.maxDecode = decode;
+
+	if(state.stats.frames == TIC80_FRAMERATE)
+	{
+		fprintf(stderr, "frame %u: %.1f KB/s, %llu bytes/frame, decode and blit %llu us avg %u us max\n",
+			frame,
+			state.stats.bytes / 1024.0,
+			(unsigned long long)(state.stats.bytes / state.stats.frames),
+			(unsigned long long)(state.stats.decode / state.stats.frames),
+			state.stats.maxDecode);
+
+		memset(&state.stats, 0, sizeof state.stats);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char* address = DEFAULT_ADDRESS;
+	s32 frames = -1;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(i + 1 < argc && strcmp(argv[i], "-a") == 0) address = argv[++i];
+		else if(i + 1 < argc && strcmp(argv[i], "-n") == 0) frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-headless") == 0) state.headless = true;
+		else
+		{
+			printf("usage: player-client [-a unix:/path | host:port | port] [-n frames] [-headless]\n");
+			return -1;
+		}
+	}
+
+	s32 server = socketConnect(address);
+
+	if(server < 0)
+	{
+		fprintf(stderr, "can't connect to %s\n", address);
+		return -1;
+	}
+
+	SDL_Window* window = NULL;
+	SDL_Renderer* renderer = NULL;
+	SDL_Texture* texture = NULL;
+	SDL_AudioDeviceID audioDevice = 0;
+
+	if(!state.headless)
+	{
+		SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
+
+		window = SDL_CreateWindow("TIC-80 client", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+		renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+		texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, TIC80_FULLWIDTH, TIC80_FULLHEIGHT);
+
+		SDL_AudioSpec want = 
+		{
+			.freq = TIC80_SAMPLERATE,
+			.format = AUDIO_S16,
+			.channels = TIC_STEREO_CHANNELS,
+		};
+
+		audioDevice = SDL_OpenAudioDevice(NULL, 0, &want, NULL, 0);
+		SDL_PauseAudioDevice(audioDevice, 0);
+	}
+
+	// only used to draw the decoded state
+	tic_mem* tic = tic_create(TIC80_SAMPLERATE);
+	tic_stream* stream = tic_stream_create();
+
+	u8* body = NULL;
+	u32 bodySize = 0;
+
+	while(!state.quit && frames != 0)
+	{
+		tic80_input input;
+		readInput(&input);
+
+		if(!socketSend(server, &input, sizeof input))
+			break;
+
+		tic_stream_header header;
+
+		if(!socketRecv(server, &header, sizeof header))
+			break;
+
+		if(header.size > bodySize)
+		{
+			u8* buffer = realloc(body, header.size);
+
+			if(!buffer)
+				break;
+
+			body = buffer;
+			bodySize = header.size;
+		}
+
+		if(!socketRecv(server, body, header.size))
+			break;
+
+		u64 start = SDL_GetPerformanceCounter();
+
+		if(!tic_stream_decode(stream, &header, body))
+		{
+			fprintf(stderr, "bad frame %u\n", header.frame);
+			break;
+		}
+
+		tic_stream_blit(stream, tic);
+
+		u32 decode = (u32)((SDL_GetPerformanceCounter() - start) * 1000000 / SDL_GetPerformanceFrequency());
+		reportFrame(header.frame, sizeof header + header.size, decode);
+
+		if(!state.headless)
+		{
+			s32 count = 0;
+			const s16* samples = tic_stream_samples(stream, &count);
+
+			if(audioDevice && SDL_GetQueuedAudioSize(audioDevice) < MAX_QUEUED_AUDIO)
+				SDL_QueueAudio(audioDevice, samples, count * sizeof(s16));
+
+			void* pixels = NULL;
+			s32 pitch = 0;
+			SDL_LockTexture(texture, NULL, &pixels, &pitch);
+			SDL_memcpy(pixels, tic->screen, pitch * TIC80_FULLHEIGHT);
+			SDL_UnlockTexture(texture);
+
+			SDL_RenderClear(renderer);
+			SDL_RenderCopy(renderer, texture, NULL, NULL);
+			SDL_RenderPresent(renderer);
+		}
+
+		if(frames > 0)
+			frames--;
+	}
+
+	free(body);
+	tic_stream_close(stream);
+	tic_close(tic);
+	socketClose(server);
+
+	if(!state.headless)
+	{
+		SDL_CloseAudioDevice(audioDevice);
+		SDL_DestroyTexture(texture);
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+	}
+
+	return 0;
+}
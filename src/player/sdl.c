@@ -21,6 +21,8 @@
 // SOFTWARE.
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <SDL.h>
 #include <tic80.h>
 
@@ -37,11 +39,46 @@ static void onExit()
 	state.quit = true;
 }
 
+// player-sdl [cart.tic] [--vsync] [--spin=us] [--stats]
+static void readOptions(s32 argc, char **argv, tic80_pacer_config* pacer, bool* stats)
+{
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "--vsync") == 0)
+			pacer->vsync = true;
+		else if(strncmp(argv[i], "--spin=", 7) == 0)
+			pacer->spin = atoi(argv[i] + 7);
+		else if(strcmp(argv[i], "--stats") == 0)
+			*stats = true;
+	}
+}
+
+static void showStats(SDL_Window* window, const tic80_pacer* pacer, const tic80_audio_sync* sync, s32 samplerate)
+{
+	tic80_pacer_stats stats = tic80_pacer_report(pacer);
+
+	if(stats.frames % TIC80_FRAMERATE == 0)
+	{
+		tic80_audio_sync_stats audio = sync ? tic80_audio_sync_report(sync) : (tic80_audio_sync_stats){0};
+
+		char title[256];
+		snprintf(title, sizeof title, "TIC-80 SDL demo - frame %.2fms jitter %.2fms missed %u overshoot %.2fms (worst %.2fms)"
+			" - audio %.1fms rate %+ippm underruns %u", 
+			stats.average / 1000.0, stats.jitter / 1000.0, stats.missed, stats.overshoot / 1000.0, stats.worst / 1000.0,
+			audio.average * 1000.0 / samplerate, audio.correction, audio.underruns);
+		SDL_SetWindowTitle(window, title);
+	}
+}
+
 int main(int argc, char **argv)
 {
-	char* cart = (argc > 1) ? argv[1] : "cart.tic";
+	char* cart = (argc > 1 && strncmp(argv[1], "--", 2) != 0) ? argv[1] : "cart.tic";
 	FILE* file = fopen(cart, "rb");
 
+	tic80_pacer_config pacerConfig = {.spin = 2000};
+	bool stats = false;
+	readOptions(argc, argv, &pacerConfig, &stats);
+
 	if(file)
 	{
 		fseek(file, 0, SEEK_END);
@@ -58,13 +95,12 @@ int main(int argc, char **argv)
 
 			{
 				SDL_Window* window = SDL_CreateWindow("TIC-80 SDL demo", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
-				SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+				SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | (pacerConfig.vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
 				SDL_Texture* texture = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ABGR8888, SDL_TEXTUREACCESS_STREAMING, TIC80_FULLWIDTH, TIC80_FULLHEIGHT);
 				
 				SDL_AudioDeviceID audioDevice = 0;
 				SDL_AudioSpec audioSpec;
 				SDL_AudioCVT cvt;
-				bool audioStarted = false;
 
 				{
 					SDL_AudioSpec want = 
@@ -81,8 +117,8 @@ int main(int argc, char **argv)
 
 					if (cvt.needed)
 					{
-						cvt.len = audioSpec.freq * sizeof(s16) / TIC80_FRAMERATE;
-						cvt.buf = SDL_malloc(cvt.len * cvt.len_mult);
+						// room for two frames of stereo samples, the rate control only adds a few
+						cvt.buf = SDL_malloc(audioSpec.freq * 2 * sizeof(s16) * 2 / TIC80_FRAMERATE * cvt.len_mult);
 					}
 				}
 
@@ -95,10 +131,26 @@ int main(int argc, char **argv)
 
 				tic80_load(tic, cart, size);
 				
-				if(tic)
+				tic80_pacer* pacer = tic80_pacer_create(&pacerConfig);
+
+				tic80_audio_sync* sync = NULL;
+				const s32 frameSize = audioSpec.channels * SDL_AUDIO_BITSIZE(audioSpec.format) / 8;
+
+				if(audioDevice)
 				{
-					u64 nextTick = SDL_GetPerformanceCounter();
-					const u64 Delta = SDL_GetPerformanceFrequency() / TIC80_FRAMERATE;
+					// holds a device buffer and two frames queued
+					const tic80_audio_sync_config syncConfig = 
+					{
+						.samplerate = audioSpec.freq,
+						.latency = (u32)((u64)audioSpec.samples * 1000000 / audioSpec.freq + 2 * 1000000 / TIC80_FRAMERATE),
+					};
+
+					sync = tic80_audio_sync_create(&syncConfig);
+				}
+
+				if(tic && pacer)
+				{
+					s32 frames = 1;
 
 					while(!state.quit)
 					{
@@ -140,27 +192,33 @@ int main(int argc, char **argv)
 							}
 						}
 
-						nextTick += Delta;
+						for(s32 i = 0; i < frames; i++)
+						{
+							tic80_tick(tic, input);
 
-						tic80_tick(tic, input);
+							if(sync)
+							{
+								// the correction is for the next tick, this one's samples are made
+								tic80_sound_rate(tic, tic80_audio_sync_update(sync, SDL_GetQueuedAudioSize(audioDevice) / frameSize));
+								SDL_PauseAudioDevice(audioDevice, tic80_audio_sync_report(sync).filling);
 
-						if (!audioStarted && audioDevice)
-						{
-							audioStarted = true;
-							SDL_PauseAudioDevice(audioDevice, 0);
+								s32 size = tic->sound.count * sizeof(tic->sound.samples[0]);
+
+								if (cvt.needed)
+								{
+									cvt.len = size;
+									SDL_memcpy(cvt.buf, tic->sound.samples, size);
+									SDL_ConvertAudio(&cvt);
+									SDL_QueueAudio(audioDevice, cvt.buf, cvt.len_cvt);
+								}
+								else SDL_QueueAudio(audioDevice, tic->sound.samples, size);
+							}
 						}
 
+						if(stats)
 						{
-							SDL_PauseAudioDevice(audioDevice, 0);
-							s32 size = tic->sound.count * sizeof(tic->sound.samples[0]);
-
-							if (cvt.needed)
-							{
-								SDL_memcpy(cvt.buf, tic->sound.samples, size);
-								SDL_ConvertAudio(&cvt);
-								SDL_QueueAudio(audioDevice, cvt.buf, cvt.len_cvt);
-							}
-							else SDL_QueueAudio(audioDevice, tic->sound.samples, size);
+							tic80_pacer_graph(pacer, TIC80_PIXEL_COLOR_ABGR8888, tic->screen, tic->pitch);
+							showStats(window, pacer, sync, audioSpec.freq);
 						}
 
 						SDL_RenderClear(renderer);
@@ -176,18 +234,15 @@ int main(int argc, char **argv)
 
 						SDL_RenderPresent(renderer);
 
-						{
-							s64 delay = nextTick - SDL_GetPerformanceCounter();
-
-							if (delay < 0) 
-								nextTick -= delay;
-							else SDL_Delay((u32)(delay * 1000 / SDL_GetPerformanceFrequency()));
-						}
-
+						frames = tic80_pacer_wait(pacer);
 					}
+				}
+
+				tic80_pacer_delete(pacer);
+				tic80_audio_sync_delete(sync);
 
+				if(tic)
 					tic80_delete(tic);
-				}
 
 				SDL_DestroyTexture(texture);
 				SDL_DestroyRenderer(renderer);
@@ -0,0 +1,223 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Headless frame server: runs a cart for one thin client at a time, reads its
+// tic80_input packets and answers every tick with a delta-encoded frame (see stream.h).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <tic80.h>
+
+#include "stream.h"
+#include "socket.h"
+
+#define DEFAULT_ADDRESS "7780"
+
+static struct
+{
+	bool quit;
+	bool verbose;
+
+	struct
+	{
+		u32 frames;
+		u64 bytes;
+		u64 encode;
+		u32 maxEncode;
+	} stats;
+} state =
+{
+	.quit = false,
+	.verbose = false,
+};
+
+static void onExit()
+{
+	state.quit = true;
+}
+
+static u64 getMicroseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static void sleepUntil(u64 time)
+{
+	u64 now = getMicroseconds();
+
+	if(time > now)
+	{
+		struct timespec delay = {(time - now) / 1000000, (time - now) % 1000000 * 1000};
+		nanosleep(&delay, NULL);
+	}
+}
+
+// keeps the last complete input, returns false once the client is gone
+static bool readInput(s32 client, tic80_input* input, u8* pending, s32* count)
+{
+	while(true)
+	{
+		s32 got = socketPoll(client, pending + *count, sizeof(tic80_input) - *count);
+
+		if(got < 0) return false;
+		if(got == 0) return true;
+
+		if((*count += got) == sizeof(tic80_input))
+		{
+			memcpy(input, pending, sizeof(tic80_input));
+			*count = 0;
+		}
+	}
+}
+
+static void reportFrame(u32 frame, s32 size, u32 encode)
+{
+	enum {ScreenSize = TIC80_FULLWIDTH * TIC80_FULLHEIGHT * sizeof(u32)};
+
+	state.stats.frames++;
+	state.stats.bytes += size;
+	state.stats.encode += encode;
+
+	if(encode > state.stats.maxEncode)
+		state.stats.maxEncode = encode;
+
+	if(state.verbose)
+		fprintf(stderr, "frame %u: %i bytes, encode %u us\n", frame, size, encode);
+
+	if(state.stats.frames == TIC80_FRAMERATE)
+	{
+		fprintf(stderr, "%u frames: %.1f KB/s, %llu bytes/frame (%.1f%% of RGBA), encode %llu us avg %u us max\n",
+			state.stats.frames, 
+			state.stats.bytes / 1024.0,
+			(unsigned long long)(state.stats.bytes / state.stats.frames),
+			state.stats.bytes * 100.0 / state.stats.frames / ScreenSize,
+			(unsigned long long)(state.stats.encode / state.stats.frames),
+			state.stats.maxEncode);
+
+		memset(&state.stats, 0, sizeof state.stats);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	const char* path = NULL;
+	const char* address = DEFAULT_ADDRESS;
+	s32 frames = -1;
+
+	for(s32 i = 1; i < argc; i++)
+	{
+		if(i + 1 < argc && strcmp(argv[i], "-a") == 0) address = argv[++i];
+		else if(i + 1 < argc && strcmp(argv[i], "-n") == 0) frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-v") == 0) state.verbose = true;
+		else if(!path && argv[i][0] != '-') path = argv[i];
+		else
+		{
+			path = NULL;
+			break;
+		}
+	}
+
+	if(!path)
+	{
+		printf("usage: player-server cart.tic [-a unix:/path | host:port | port] [-n frames] [-v]\n");
+		return -1;
+	}
+
+	tic80* tic = tic80_create(TIC80_SAMPLERATE);
+	tic->callback.exit = onExit;
+
+	if(!tic80_load_file(tic, path))
+	{
+		fprintf(stderr, "can't read %s\n", path);
+		tic80_delete(tic);
+		return -1;
+	}
+
+	s32 server = socketListen(address);
+
+	if(server < 0)
+	{
+		fprintf(stderr, "can't listen on %s\n", address);
+		tic80_delete(tic);
+		return -1;
+	}
+
+	// a client hanging up shows as a failed send
+	signal(SIGPIPE, SIG_IGN);
+
+	fprintf(stderr, "serving %s on %s\n", path, address);
+
+	while(!state.quit && frames != 0)
+	{
+		s32 client = socketAccept(server);
+
+		if(client < 0)
+			break;
+
+		fprintf(stderr, "client connected\n");
+
+		tic80_input input;
+		memset(&input, 0, sizeof input);
+
+		u8 pending[sizeof(tic80_input)];
+		s32 count = 0;
+
+		// the new client starts from a key frame
+		tic80_stream_start(tic);
+
+		u64 nextTick = getMicroseconds();
+
+		while(!state.quit && frames != 0 && readInput(client, &input, pending, &count))
+		{
+			tic80_tick(tic, input);
+
+			const void* packet = NULL;
+			u64 start = getMicroseconds();
+			s32 size = tic80_stream_frame(tic, &packet);
+			u32 encode = (u32)(getMicroseconds() - start);
+
+			if(!size || !socketSend(client, packet, size))
+				break;
+
+			reportFrame(((const tic_stream_header*)packet)->frame, size, encode);
+
+			if(frames > 0)
+				frames--;
+
+			nextTick += 1000000 / TIC80_FRAMERATE;
+			sleepUntil(nextTick);
+		}
+
+		fprintf(stderr, "client disconnected\n");
+		socketClose(client);
+	}
+
+	tic80_delete(tic);
+	socketClose(server);
+
+	return 0;
+}
@@ -0,0 +1,249 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "socket.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define UNIX_PREFIX "unix:"
+#define DEFAULT_HOST "127.0.0.1"
+
+bool socketAddress(const char* address, SocketAddress* out)
+{
+	memset(out, 0, sizeof(SocketAddress));
+
+	if(strncmp(address, UNIX_PREFIX, strlen(UNIX_PREFIX)) == 0)
+	{
+		struct sockaddr_un* addr = (struct sockaddr_un*)&out->data;
+		const char* path = address + strlen(UNIX_PREFIX);
+
+		if(strlen(path) >= sizeof addr->sun_path)
+			return false;
+
+		addr->sun_family = AF_UNIX;
+		strcpy(addr->sun_path, path);
+
+		out->size = sizeof(struct sockaddr_un);
+		out->family = AF_UNIX;
+
+		return true;
+	}
+
+	char host[256] = DEFAULT_HOST;
+	const char* port = strrchr(address, ':');
+
+	if(port)
+	{
+		snprintf(host, sizeof host, "%.*s", (s32)(port - address), address);
+		port++;
+	}
+	else port = address;
+
+	struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM};
+	struct addrinfo* info = NULL;
+
+	if(getaddrinfo(host, port, &hints, &info) != 0 || !info)
+		return false;
+
+	memcpy(&out->data, info->ai_addr, info->ai_addrlen);
+	out->size = info->ai_addrlen;
+	out->family = info->ai_family;
+
+	freeaddrinfo(info);
+
+	return true;
+}
+
+// frames are small and latency matters more than throughput
+static void setNoDelay(s32 fd, s32 family)
+{
+	if(family != AF_UNIX)
+	{
+		s32 on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof on);
+	}
+}
+
+s32 socketListen(const char* address)
+{
+	SocketAddress addr;
+
+	if(!socketAddress(address, &addr))
+		return -1;
+
+	s32 fd = socket(addr.family, SOCK_STREAM, 0);
+
+	if(fd >= 0)
+	{
+		if(addr.family == AF_UNIX)
+			unlink(((struct sockaddr_un*)&addr.data)->sun_path);
+		else
+		{
+			s32 on = 1;
+			setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+		}
+
+		if(bind(fd, (struct sockaddr*)&addr.data, addr.size) == 0 && listen(fd, 1) == 0)
+			return fd;
+
+		close(fd);
+	}
+
+	return -1;
+}
+
+s32 socketAccept(s32 server)
+{
+	struct sockaddr_storage addr;
+	socklen_t size = sizeof addr;
+
+	s32 fd = accept(server, (struct sockaddr*)&addr, &size);
+
+	if(fd >= 0)
+		setNoDelay(fd, addr.ss_family);
+
+	return fd;
+}
+
+s32 socketConnect(const char* address)
+{
+	SocketAddress addr;
+
+	if(!socketAddress(address, &addr))
+		return -1;
+
+	s32 fd = socket(addr.family, SOCK_STREAM, 0);
+
+	if(fd >= 0)
+	{
+		if(connect(fd, (struct sockaddr*)&addr.data, addr.size) == 0)
+		{
+			setNoDelay(fd, addr.family);
+			return fd;
+		}
+
+		close(fd);
+	}
+
+	return -1;
+}
+
+void socketClose(s32 socket)
+{
+	if(socket >= 0)
+		close(socket);
+}
+
+bool socketSend(s32 socket, const void* data, s32 size)
+{
+	const u8* ptr = data;
+
+	while(size > 0)
+	{
+		ssize_t sent = send(socket, ptr, size, 0);
+
+		if(sent < 0 && errno == EINTR) continue;
+		if(sent <= 0) return false;
+
+		ptr += sent;
+		size -= (s32)sent;
+	}
+
+	return true;
+}
+
+bool socketRecv(s32 socket, void* data, s32 size)
+{
+	u8* ptr = data;
+
+	while(size > 0)
+	{
+		ssize_t got = recv(socket, ptr, size, 0);
+
+		if(got < 0 && errno == EINTR) continue;
+		if(got <= 0) return false;
+
+		ptr += got;
+		size -= (s32)got;
+	}
+
+	return true;
+}
+
+s32 socketPoll(s32 socket, void* data, s32 size)
+{
+	ssize_t got = recv(socket, data, size, MSG_DONTWAIT);
+
+	if(got < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+
+	return got == 0 ? -1 : (s32)got;
+}
+
+s32 udpOpen(const char* address)
+{
+	SocketAddress addr;
+
+	if(!socketAddress(address, &addr))
+		return -1;
+
+	s32 fd = socket(addr.family, SOCK_DGRAM, 0);
+
+	if(fd >= 0)
+	{
+		if(addr.family == AF_UNIX)
+			unlink(((struct sockaddr_un*)&addr.data)->sun_path);
+
+		if(bind(fd, (struct sockaddr*)&addr.data, addr.size) == 0)
+			return fd;
+
+		close(fd);
+	}
+
+	return -1;
+}
+
+bool udpSend(s32 socket, const SocketAddress* to, const void* data, s32 size)
+{
+	// a full buffer is as good as a lost packet
+	return sendto(socket, data, size, MSG_DONTWAIT, (const struct sockaddr*)&to->data, to->size) == size;
+}
+
+s32 udpRecv(s32 socket, void* data, s32 size)
+{
+	ssize_t got = recv(socket, data, size, MSG_DONTWAIT);
+
+	if(got < 0)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ? 0 : -1;
+
+	return (s32)got;
+}
@@ -0,0 +1,56 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <tic80_types.h>
+
+#include <sys/socket.h>
+
+// Blocking stream sockets for the frame server and its client, and non-blocking
+// datagram ones for netplay.
+// An address is "unix:/path/to/socket", "host:port" or just "port" on localhost.
+
+typedef struct
+{
+	struct sockaddr_storage data;
+	socklen_t size;
+	s32 family;
+} SocketAddress;
+
+bool socketAddress(const char* address, SocketAddress* out);
+
+s32 socketListen(const char* address);
+s32 socketAccept(s32 server);
+s32 socketConnect(const char* address);
+void socketClose(s32 socket);
+
+bool socketSend(s32 socket, const void* data, s32 size);
+bool socketRecv(s32 socket, void* data, s32 size);
+
+// reads what already arrived without blocking, returns -1 once the peer is gone
+s32 socketPoll(s32 socket, void* data, s32 size);
+
+// binds to the address, receiving returns 0 when nothing arrived
+s32 udpOpen(const char* address);
+bool udpSend(s32 socket, const SocketAddress* to, const void* data, s32 size);
+s32 udpRecv(s32 socket, void* data, s32 size);
@@ -8,6 +8,7 @@
 #include <tic80.h>
 
 static tic80* tic = NULL;
+static tic80_pacer* pacer = NULL;
 
 static void app_init(void)
 {
@@ -41,23 +42,38 @@ static void app_init(void)
     }
 
     sokol_gfx_init(TIC80_FULLWIDTH, TIC80_FULLHEIGHT, 1, 1, false, false);
+
+    // sokol presents with vsync, so the display rate is turned into 60 ticks a second
+    tic80_pacer_config config = {.vsync = true};
+    pacer = tic80_pacer_create(&config);
 }
 
 static tic80_input tic_input;
 
 static void app_frame(void)
 {
-    if(tic)
+    if(!tic || !pacer) return;
+
+    for(s32 frames = tic80_pacer_wait(pacer); frames > 0; frames--)
+    {
         tic80_tick(tic, tic_input);
 
-    sokol_gfx_draw(tic->screen);
+        // the count follows the device rate and the rate correction, converted a frame's worth at a time
+        enum {Count = TIC80_SAMPLERATE / TIC80_FRAMERATE * 2};
+        static float floatSamples[Count];
 
-    static float floatSamples[TIC80_SAMPLERATE / TIC80_FRAMERATE * 2];
+        for(s32 start = 0; start < tic->sound.count; start += Count)
+        {
+            s32 count = tic->sound.count - start < Count ? tic->sound.count - start : Count;
 
-    for(s32 i = 0; i < tic->sound.count; i++)
-        floatSamples[i] = (float)tic->sound.samples[i] / SHRT_MAX;
+            for(s32 i = 0; i < count; i++)
+                floatSamples[i] = (float)tic->sound.samples[start + i] / SHRT_MAX;
 
-    saudio_push(floatSamples, tic->sound.count / 2);
+            saudio_push(floatSamples, count / 2);
+        }
+    }
+
+    sokol_gfx_draw(tic->screen);
 }
 
 static void app_input(const sapp_event* event)
@@ -100,6 +116,8 @@ static void app_cleanup(void)
 {
     if(tic)
         tic80_delete(tic);
+
+    tic80_pacer_delete(pacer);
     
     sg_shutdown();
 }
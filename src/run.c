@@ -79,7 +79,7 @@ static const char* data2md5(const void* data, s32 length)
 
 static void initPMemName(Run* run)
 {
-	const char* data = strlen(run->tic->saveid) ? run->tic->saveid : run->tic->cart.code.data;
+	const char* data = strlen(run->tic->saveid) ? run->tic->saveid : run->tic->cart->code.data;
 	const char* md5 = data2md5(data, strlen(data));
 	strcpy(run->saveid, TIC_LOCAL);
 	strcat(run->saveid, md5);
@@ -112,9 +112,9 @@ static void processDoFile(void* data, char* dst)
 	static const char DoFileTag[] = "dofile(";
 	enum {Size = sizeof DoFileTag - 1};
 
-	if (memcmp(tic->cart.code.data, DoFileTag, Size) == 0)
+	if (memcmp(tic->cart->code.data, DoFileTag, Size) == 0)
 	{
-		const char* start = tic->cart.code.data + Size;
+		const char* start = tic->cart->code.data + Size;
 		const char* end = strchr(start, ')');
 
 		if(end && *start == *(end-1) && (*start == '"' || *start == '\''))
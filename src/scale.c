@@ -0,0 +1,427 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "scale.h"
+#include "tools.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2, Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2};
+enum {Colors = TIC_PALETTE_SIZE * 2, Phases = 3, MaxFactor = 3};
+
+typedef struct
+{
+	// plain and scanline rows, then one per aperture grille column
+	u32 colors[2][Phases][Colors];
+	u32 palette[TIC_PALETTE_SIZE];
+	bool built;
+} Tables;
+
+static inline u8 darken(u8 value, u8 amount)
+{
+	return value * (255 - amount) / 255;
+}
+
+static void buildTables(Tables* tables, const u32* palette, const u32* ovr,
+	const tic80_scale* config, tic80_pixel_color_format format)
+{
+	const s32 lines = config->scanlines && config->scale > 1 ? 2 : 1;
+	const s32 phases = config->mask ? Phases : 1;
+
+	for(s32 i = 0; i < Colors; i++)
+	{
+		const u8* rgb = (const u8*)(i < TIC_PALETTE_SIZE ? &palette[i] : &ovr[i - TIC_PALETTE_SIZE]);
+
+		for(s32 l = 0; l < lines; l++)
+			for(s32 p = 0; p < phases; p++)
+			{
+				u8 c[3];
+
+				for(s32 ch = 0; ch < 3; ch++)
+				{
+					c[ch] = l ? darken(rgb[ch], config->scanlines) : rgb[ch];
+
+					if(config->mask && ch != p)
+						c[ch] = darken(c[ch], config->mask);
+				}
+
+				tables->colors[l][p][i] = tic_tool_pack_color(format, c[0], c[1], c[2]);
+			}
+	}
+
+	memcpy(tables->palette, palette, sizeof tables->palette);
+	tables->built = true;
+}
+
+// the frame row with one clamped pixel either side for the filters
+static void padRow(u8* dst, const tic_indexed_frame* frame, s32 y, s32 x, s32 width)
+{
+	const u8* src = frame->pixels[y < 0 ? 0 : y >= TIC80_FULLHEIGHT ? TIC80_FULLHEIGHT - 1 : y];
+
+	dst[0] = src[x > 0 ? x - 1 : 0];
+	memcpy(dst + 1, src + x, width);
+	dst[width + 1] = src[x + width < TIC80_FULLWIDTH ? x + width : TIC80_FULLWIDTH - 1];
+}
+
+#if defined(__SSE2__)
+static inline __m128i blend(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+// rows are padded, B above E, H below, D to the left, F to the right
+static void scale2x(u8* out0, u8* out1, const u8* up, const u8* mid, const u8* down, s32 width)
+{
+	s32 x = 0;
+
+#if defined(__SSE2__)
+	const __m128i ones = _mm_set1_epi8(-1);
+
+	for(; x + 16 <= width; x += 16)
+	{
+		__m128i B = _mm_loadu_si128((const __m128i*)(up + x + 1));
+		__m128i H = _mm_loadu_si128((const __m128i*)(down + x + 1));
+		__m128i D = _mm_loadu_si128((const __m128i*)(mid + x));
+		__m128i E = _mm_loadu_si128((const __m128i*)(mid + x + 1));
+		__m128i F = _mm_loadu_si128((const __m128i*)(mid + x + 2));
+
+		__m128i edge = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi8(B, H), _mm_cmpeq_epi8(D, F)), ones);
+
+		__m128i e0 = blend(_mm_and_si128(edge, _mm_cmpeq_epi8(D, B)), D, E);
+		__m128i e1 = blend(_mm_and_si128(edge, _mm_cmpeq_epi8(B, F)), F, E);
+		__m128i e2 = blend(_mm_and_si128(edge, _mm_cmpeq_epi8(D, H)), D, E);
+		__m128i e3 = blend(_mm_and_si128(edge, _mm_cmpeq_epi8(H, F)), F, E);
+
+		_mm_storeu_si128((__m128i*)(out0 + x * 2), _mm_unpacklo_epi8(e0, e1));
+		_mm_storeu_si128((__m128i*)(out0 + x * 2 + 16), _mm_unpackhi_epi8(e0, e1));
+		_mm_storeu_si128((__m128i*)(out1 + x * 2), _mm_unpacklo_epi8(e2, e3));
+		_mm_storeu_si128((__m128i*)(out1 + x * 2 + 16), _mm_unpackhi_epi8(e2, e3));
+	}
+#elif defined(__ARM_NEON)
+	for(; x + 16 <= width; x += 16)
+	{
+		uint8x16_t B = vld1q_u8(up + x + 1);
+		uint8x16_t H = vld1q_u8(down + x + 1);
+		uint8x16_t D = vld1q_u8(mid + x);
+		uint8x16_t E = vld1q_u8(mid + x + 1);
+		uint8x16_t F = vld1q_u8(mid + x + 2);
+
+		uint8x16_t edge = vmvnq_u8(vorrq_u8(vceqq_u8(B, H), vceqq_u8(D, F)));
+
+		uint8x16x2_t top, bottom;
+		top.val[0] = vbslq_u8(vandq_u8(edge, vceqq_u8(D, B)), D, E);
+		top.val[1] = vbslq_u8(vandq_u8(edge, vceqq_u8(B, F)), F, E);
+		bottom.val[0] = vbslq_u8(vandq_u8(edge, vceqq_u8(D, H)), D, E);
+		bottom.val[1] = vbslq_u8(vandq_u8(edge, vceqq_u8(H, F)), F, E);
+
+		vst2q_u8(out0 + x * 2, top);
+		vst2q_u8(out1 + x * 2, bottom);
+	}
+#endif
+
+	for(; x < width; x++)
+	{
+		u8 B = up[x + 1], H = down[x + 1], D = mid[x], E = mid[x + 1], F = mid[x + 2];
+		bool edge = B != H && D != F;
+
+		out0[x * 2]		= edge && D == B ? D : E;
+		out0[x * 2 + 1]	= edge && B == F ? F : E;
+		out1[x * 2]		= edge && D == H ? D : E;
+		out1[x * 2 + 1]	= edge && H == F ? F : E;
+	}
+}
+
+// A B C above, D E F, G H I below
+static void scale3x(u8* out0, u8* out1, u8* out2, const u8* up, const u8* mid, const u8* down, s32 width)
+{
+	for(s32 x = 0; x < width; x++, out0 += 3, out1 += 3, out2 += 3)
+	{
+		u8 A = up[x], B = up[x + 1], C = up[x + 2];
+		u8 D = mid[x], E = mid[x + 1], F = mid[x + 2];
+		u8 G = down[x], H = down[x + 1], I = down[x + 2];
+
+		if(B != H && D != F)
+		{
+			out0[0] = D == B ? D : E;
+			out0[1] = (D == B && E != C) || (B == F && E != A) ? B : E;
+			out0[2] = B == F ? F : E;
+			out1[0] = (D == B && E != G) || (D == H && E != A) ? D : E;
+			out1[1] = E;
+			out1[2] = (B == F && E != I) || (H == F && E != C) ? F : E;
+			out2[0] = D == H ? D : E;
+			out2[1] = (D == H && E != I) || (H == F && E != G) ? H : E;
+			out2[2] = H == F ? F : E;
+		}
+		else
+		{
+			memset(out0, E, 3);
+			memset(out1, E, 3);
+			memset(out2, E, 3);
+		}
+	}
+}
+
+static void replicate32(u32* dst, const u32* src, s32 count, s32 times)
+{
+	s32 i = 0;
+
+	switch(times)
+	{
+	case 1:
+		memcpy(dst, src, count * sizeof *dst);
+		return;
+#if defined(__SSE2__)
+	case 2:
+		for(; i + 4 <= count; i += 4, dst += 8)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(v, v));
+			_mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(v, v));
+		}
+		break;
+	case 3:
+		for(; i + 4 <= count; i += 4, dst += 12)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 0, 0)));
+			_mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 1, 1)));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 2)));
+		}
+		break;
+	case 4:
+		for(; i + 4 <= count; i += 4, dst += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi32(v, _MM_SHUFFLE(0, 0, 0, 0)));
+			_mm_storeu_si128((__m128i*)(dst + 4), _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 1, 1, 1)));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 2, 2)));
+			_mm_storeu_si128((__m128i*)(dst + 12), _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3)));
+		}
+		break;
+#elif defined(__ARM_NEON)
+	case 2:
+		for(; i + 4 <= count; i += 4, dst += 8)
+		{
+			uint32x4x2_t v;
+			v.val[0] = v.val[1] = vld1q_u32(src + i);
+			vst2q_u32(dst, v);
+		}
+		break;
+	case 3:
+		for(; i + 4 <= count; i += 4, dst += 12)
+		{
+			uint32x4x3_t v;
+			v.val[0] = v.val[1] = v.val[2] = vld1q_u32(src + i);
+			vst3q_u32(dst, v);
+		}
+		break;
+	case 4:
+		for(; i + 4 <= count; i += 4, dst += 16)
+		{
+			uint32x4x4_t v;
+			v.val[0] = v.val[1] = v.val[2] = v.val[3] = vld1q_u32(src + i);
+			vst4q_u32(dst, v);
+		}
+		break;
+#endif
+	}
+
+	for(; i < count; i++)
+		for(s32 t = 0; t < times; t++)
+			*dst++ = src[i];
+}
+
+static void replicate16(u16* dst, const u16* src, s32 count, s32 times)
+{
+	s32 i = 0;
+
+	switch(times)
+	{
+	case 1:
+		memcpy(dst, src, count * sizeof *dst);
+		return;
+#if defined(__SSE2__)
+	case 2:
+		for(; i + 8 <= count; i += 8, dst += 16)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi16(v, v));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_unpackhi_epi16(v, v));
+		}
+		break;
+	case 4:
+		for(; i + 8 <= count; i += 8, dst += 32)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+			__m128i lo = _mm_unpacklo_epi16(v, v), hi = _mm_unpackhi_epi16(v, v);
+			_mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(lo, lo));
+			_mm_storeu_si128((__m128i*)(dst + 8), _mm_unpackhi_epi32(lo, lo));
+			_mm_storeu_si128((__m128i*)(dst + 16), _mm_unpacklo_epi32(hi, hi));
+			_mm_storeu_si128((__m128i*)(dst + 24), _mm_unpackhi_epi32(hi, hi));
+		}
+		break;
+#elif defined(__ARM_NEON)
+	case 2:
+		for(; i + 8 <= count; i += 8, dst += 16)
+		{
+			uint16x8x2_t v;
+			v.val[0] = v.val[1] = vld1q_u16(src + i);
+			vst2q_u16(dst, v);
+		}
+		break;
+	case 3:
+		for(; i + 8 <= count; i += 8, dst += 24)
+		{
+			uint16x8x3_t v;
+			v.val[0] = v.val[1] = v.val[2] = vld1q_u16(src + i);
+			vst3q_u16(dst, v);
+		}
+		break;
+	case 4:
+		for(; i + 8 <= count; i += 8, dst += 32)
+		{
+			uint16x8x4_t v;
+			v.val[0] = v.val[1] = v.val[2] = v.val[3] = vld1q_u16(src + i);
+			vst4q_u16(dst, v);
+		}
+		break;
+#endif
+	}
+
+	for(; i < count; i++)
+		for(s32 t = 0; t < times; t++)
+			*dst++ = src[i];
+}
+
+// one output line, the aperture grille goes by output column so it can't be replicated
+static void drawLine(u8* dst, const u8* indices, s32 count, s32 times,
+	const u32 (*colors)[Colors], bool mask, s32 size)
+{
+	if(mask)
+	{
+		u32* dst32 = (u32*)dst;
+		u16* dst16 = (u16*)dst;
+
+		for(s32 i = 0, phase = 0; i < count; i++)
+			for(s32 t = 0; t < times; t++)
+			{
+				u32 color = colors[phase][indices[i]];
+
+				if(size == sizeof(u32)) *dst32++ = color;
+				else *dst16++ = (u16)color;
+
+				if(++phase == Phases) phase = 0;
+			}
+	}
+	else if(size == sizeof(u32))
+	{
+		u32 line[TIC80_FULLWIDTH * MaxFactor];
+
+		for(s32 i = 0; i < count; i++)
+			line[i] = colors[0][indices[i]];
+
+		replicate32((u32*)dst, line, count, times);
+	}
+	else
+	{
+		u16 line[TIC80_FULLWIDTH * MaxFactor];
+
+		for(s32 i = 0; i < count; i++)
+			line[i] = (u16)colors[0][indices[i]];
+
+		replicate16((u16*)dst, line, count, times);
+	}
+}
+
+static s32 filterFactor(tic80_scale_filter filter, s32 scale)
+{
+	switch(filter)
+	{
+	case TIC80_SCALE_2X: return scale % 2 == 0 ? 2 : 1;
+	case TIC80_SCALE_3X: return scale % 3 == 0 ? 3 : 1;
+	default: return 1;
+	}
+}
+
+void tic_scale(const tic_indexed_frame* frame, const tic80_scale* config,
+	tic80_pixel_color_format format, void* pixels, s32 pitch)
+{
+	if(config->scale < 1 || config->scale > TIC80_SCALE_MAX) return;
+
+	const s32 scale = config->scale;
+	const s32 factor = filterFactor(config->filter, scale);
+	const s32 times = scale / factor;
+	const s32 x0 = config->border ? 0 : Left, y0 = config->border ? 0 : Top;
+	const s32 width = config->border ? TIC80_FULLWIDTH : TIC80_WIDTH;
+	const s32 height = config->border ? TIC80_FULLHEIGHT : TIC80_HEIGHT;
+	const s32 size = format == TIC80_PIXEL_COLOR_RGB565 ? sizeof(u16) : sizeof(u32);
+	const s32 count = width * factor;
+	const s32 bytes = count * times * size;
+	const bool scanlines = config->scanlines && scale > 1;
+
+	Tables tables = {.built = false};
+	u8 rows[3][TIC80_FULLWIDTH + 2];
+	u8 expanded[MaxFactor][TIC80_FULLWIDTH * MaxFactor];
+	u8* out = pixels;
+
+	for(s32 y = y0; y < y0 + height; y++)
+	{
+		if(!tables.built || memcmp(tables.palette, frame->palettes[y], sizeof tables.palette))
+			buildTables(&tables, frame->palettes[y], frame->ovr, config, format);
+
+		if(factor > 1)
+		{
+			for(s32 r = 0; r < 3; r++)
+				padRow(rows[r], frame, y + r - 1, x0, width);
+
+			if(factor == 2)
+				scale2x(expanded[0], expanded[1], rows[0], rows[1], rows[2], width);
+			else
+				scale3x(expanded[0], expanded[1], expanded[2], rows[0], rows[1], rows[2], width);
+		}
+
+		for(s32 k = 0; k < factor; k++)
+		{
+			const u8* indices = factor > 1 ? expanded[k] : frame->pixels[y] + x0;
+			bool last = false;
+
+			for(s32 t = 0; t < times; t++, out += pitch)
+			{
+				bool dark = scanlines && k * times + t == scale - 1;
+
+				if(t && dark == last)
+					memcpy(out, out - pitch, bytes);
+				else
+					drawLine(out, indices, count, times, tables.colors[dark], config->mask, size);
+
+				last = dark;
+			}
+		}
+	}
+}
@@ -0,0 +1,52 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// Upscaling on the CPU for hosts without a GPU. Works on the palette indices the blit leaves
+// in a tic_indexed_frame: the filters compare indices, and every row is written through a
+// colour table built from that row's palette in the output format, so the CRT look costs a
+// table lookup. Replicating pixels and Scale2x use SSE2 or NEON where the compiler has them.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static inline s32 tic_scale_width(const tic80_scale* config)
+{
+	return (config->border ? TIC80_FULLWIDTH : TIC80_WIDTH) * config->scale;
+}
+
+static inline s32 tic_scale_height(const tic80_scale* config)
+{
+	return (config->border ? TIC80_FULLHEIGHT : TIC80_HEIGHT) * config->scale;
+}
+
+// pixels take tic_scale_width x tic_scale_height, rows pitch bytes apart
+void tic_scale(const tic_indexed_frame* frame, const tic80_scale* config,
+	tic80_pixel_color_format format, void* pixels, s32 pitch);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1067,4 +1067,14 @@ void initSfx(Sfx* sfx, tic_mem* tic, tic_sfx* src)
 		.history = history_create(src, sizeof(tic_sfx)),
 		.event = onStudioEvent,
 	};
-}
\ No newline at end of file
+}
+
+void freeSfx(Sfx* sfx)
+{
+	if(sfx)
+	{
+		history_delete(sfx->history);
+
+		free(sfx);
+	}
+}
@@ -65,4 +65,5 @@ struct Sfx
 	void(*event)(Sfx*, StudioEvent);
 };
 
-void initSfx(Sfx*, tic_mem*, tic_sfx* src);
\ No newline at end of file
+void initSfx(Sfx*, tic_mem*, tic_sfx* src);
+void freeSfx(Sfx*);
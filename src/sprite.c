@@ -1759,3 +1759,15 @@ void initSprite(Sprite* sprite, tic_mem* tic, tic_tiles* src)
 		.scanline = scanline,
 	};
 }
+
+void freeSprite(Sprite* sprite)
+{
+	if(sprite)
+	{
+		free(sprite->select.back);
+		free(sprite->select.front);
+		history_delete(sprite->history);
+
+		free(sprite);
+	}
+}
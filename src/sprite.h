@@ -67,4 +67,5 @@ struct Sprite
 	void (*overline)(tic_mem* tic, void* data);
 };
 
-void initSprite(Sprite*, tic_mem*, tic_tiles* src);
\ No newline at end of file
+void initSprite(Sprite*, tic_mem*, tic_tiles* src);
+void freeSprite(Sprite*);
@@ -53,6 +53,15 @@ static s32 getSquirrelNumber(HSQUIRRELVM vm, s32 index)
 	return 0;
 }
 
+static float getSquirrelFloat(HSQUIRRELVM vm, s32 index)
+{
+	SQFloat f;
+	if (SQ_SUCCEEDED(sq_getfloat(vm, index, &f)))
+		return (float)f;
+
+	return 0;
+}
+
 static void registerSquirrelFunction(tic_machine* machine, SQFUNCTION func, const char *name)
 {
 	sq_pushroottable(machine->squirrel);
@@ -128,6 +137,7 @@ static SQInteger squirrel_peek(HSQUIRRELVM vm)
 
 	if(address >=0 && address < sizeof(tic_ram))
 	{
+		tic_ram_touch(&machine->memory, address, 1);
 		sq_pushinteger(vm, *((u8*)&machine->memory.ram + address));
 		return 1;
 	}
@@ -146,6 +156,7 @@ static SQInteger squirrel_poke(HSQUIRRELVM vm)
 
 	if(address >=0 && address < sizeof(tic_ram))
 	{
+		tic_ram_touch(&machine->memory, address, 1);
 		*((u8*)&machine->memory.ram + address) = value;
 	}
 
@@ -162,6 +173,7 @@ static SQInteger squirrel_peek4(HSQUIRRELVM vm)
 
 		if(address >= 0 && address < sizeof(tic_ram)*2)
 		{
+			tic_ram_touch(&getSquirrelMachine(vm)->memory, address / 2, 1);
 			sq_pushinteger(vm, tic_tool_peek4((u8*)&getSquirrelMachine(vm)->memory.ram, address));
 			return 1;
 		}		
@@ -182,6 +194,7 @@ static SQInteger squirrel_poke4(HSQUIRRELVM vm)
 
 		if(address >= 0 && address < sizeof(tic_ram)*2)
 		{
+			tic_ram_touch(&getSquirrelMachine(vm)->memory, address / 2, 1);
 			tic_tool_poke4((u8*)&getSquirrelMachine(vm)->memory.ram, address, value);
 		}
 	}
@@ -589,6 +602,145 @@ static SQInteger squirrel_mget(HSQUIRRELVM vm)
 	return 0;
 }
 
+static SQInteger squirrel_mray(HSQUIRRELVM vm)
+{
+	SQInteger top = sq_gettop(vm);
+
+	if(top >= 5)
+	{
+		tic_mem* memory = (tic_mem*)getSquirrelMachine(vm);
+
+		float x0 = getSquirrelFloat(vm, 2);
+		float y0 = getSquirrelFloat(vm, 3);
+		float x1 = getSquirrelFloat(vm, 4);
+		float y1 = getSquirrelFloat(vm, 5);
+		u8 mask = top >= 6 ? getSquirrelNumber(vm, 6) : 0xff;
+
+		tic_map_hit hit;
+		bool done = memory->api.map_ray(memory, &memory->ram.map, x0, y0, x1, y1, mask, &hit);
+
+		sq_newarray(vm, 0);
+		sq_pushbool(vm, done ? SQTrue : SQFalse);
+		sq_arrayappend(vm, -2);
+		sq_pushfloat(vm, hit.x);
+		sq_arrayappend(vm, -2);
+		sq_pushfloat(vm, hit.y);
+		sq_arrayappend(vm, -2);
+		sq_pushinteger(vm, hit.cellx);
+		sq_arrayappend(vm, -2);
+		sq_pushinteger(vm, hit.celly);
+		sq_arrayappend(vm, -2);
+		sq_pushinteger(vm, hit.normalx);
+		sq_arrayappend(vm, -2);
+		sq_pushinteger(vm, hit.normaly);
+		sq_arrayappend(vm, -2);
+
+		return 1;
+	}
+	else return sq_throwerror(vm, "invalid params, mray(x0,y0,x1,y1,[mask=0xff])\n");
+
+	return 0;
+}
+
+static SQInteger squirrel_msweep(HSQUIRRELVM vm)
+{
+	SQInteger top = sq_gettop(vm);
+
+	if(top >= 7)
+	{
+		tic_mem* memory = (tic_mem*)getSquirrelMachine(vm);
+
+		float x = getSquirrelFloat(vm, 2);
+		float y = getSquirrelFloat(vm, 3);
+		float w = getSquirrelFloat(vm, 4);
+		float h = getSquirrelFloat(vm, 5);
+		float dx = getSquirrelFloat(vm, 6);
+		float dy = getSquirrelFloat(vm, 7);
+		u8 mask = top >= 8 ? getSquirrelNumber(vm, 8) : 0xff;
+
+		tic_map_hit hit;
+		memory->api.map_sweep(memory, &memory->ram.map, x, y, w, h, dx, dy, mask, &hit);
+
+		sq_newarray(vm, 0);
+		sq_pushfloat(vm, hit.x);
+		sq_arrayappend(vm, -2);
+		sq_pushfloat(vm, hit.y);
+		sq_arrayappend(vm, -2);
+		sq_pushinteger(vm, hit.normalx);
+		sq_arrayappend(vm, -2);
+		sq_pushinteger(vm, hit.normaly);
+		sq_arrayappend(vm, -2);
+
+		return 1;
+	}
+	else return sq_throwerror(vm, "invalid params, msweep(x,y,w,h,dx,dy,[mask=0xff])\n");
+
+	return 0;
+}
+
+static SQInteger squirrel_mfill(HSQUIRRELVM vm)
+{
+	SQInteger top = sq_gettop(vm);
+
+	if(top >= 3)
+	{
+		tic_mem* memory = (tic_mem*)getSquirrelMachine(vm);
+
+		s32 x = getSquirrelNumber(vm, 2);
+		s32 y = getSquirrelNumber(vm, 3);
+		u8 mask = top >= 4 ? getSquirrelNumber(vm, 4) : 0xff;
+		s32 tile = top >= 5 && sq_gettype(vm, 5) != OT_NULL ? (u8)getSquirrelNumber(vm, 5) : -1;
+
+		sq_pushinteger(vm, memory->api.map_fill(memory, &memory->ram.map, x, y, mask, tile));
+
+		return 1;
+	}
+	else return sq_throwerror(vm, "invalid params, mfill(x,y,[mask=0xff],[tile])\n");
+
+	return 0;
+}
+
+static SQInteger squirrel_mpath(HSQUIRRELVM vm)
+{
+	SQInteger top = sq_gettop(vm);
+
+	if(top >= 5)
+	{
+		tic_mem* memory = (tic_mem*)getSquirrelMachine(vm);
+
+		s32 x0 = getSquirrelNumber(vm, 2);
+		s32 y0 = getSquirrelNumber(vm, 3);
+		s32 x1 = getSquirrelNumber(vm, 4);
+		s32 y1 = getSquirrelNumber(vm, 5);
+		u8 mask = top >= 6 ? getSquirrelNumber(vm, 6) : 0xff;
+		u8 cost = top >= 7 ? getSquirrelNumber(vm, 7) : 0;
+
+		const u16* path = NULL;
+		s32 steps = memory->api.map_path(memory, &memory->ram.map, x0, y0, x1, y1, mask, cost, &path);
+
+		if(steps < 0)
+		{
+			sq_pushnull(vm);
+			return 1;
+		}
+
+		sq_newarray(vm, 0);
+
+		for(s32 i = 0; i < steps; i++)
+		{
+			sq_pushinteger(vm, path[i] % TIC_MAP_WIDTH);
+			sq_arrayappend(vm, -2);
+			sq_pushinteger(vm, path[i] / TIC_MAP_WIDTH);
+			sq_arrayappend(vm, -2);
+		}
+
+		return 1;
+	}
+	else return sq_throwerror(vm, "invalid params, mpath(x0,y0,x1,y1,[mask=0xff],[cost=0])\n");
+
+	return 0;
+}
+
 static SQInteger squirrel_mset(HSQUIRRELVM vm)
 {
 	SQInteger top = sq_gettop(vm);
@@ -877,6 +1029,64 @@ static SQInteger squirrel_sync(HSQUIRRELVM vm)
 	return 0;
 }
 
+// a null value clears the register, values go from -128 to 255
+static SQInteger squirrel_raster(HSQUIRRELVM vm)
+{
+	tic_mem* memory = (tic_mem*)getSquirrelMachine(vm);
+
+	SQInteger top = sq_gettop(vm);
+
+	s32 address = -1;
+	bool clear = true;
+	s32 value = 0;
+	s32 row = 0;
+	s32 count = TIC80_HEIGHT;
+
+	if(top >= 3 && sq_gettype(vm, 3) == OT_ARRAY)
+	{
+		address = getSquirrelNumber(vm, 2);
+		row = top >= 4 ? getSquirrelNumber(vm, 4) : 0;
+		count = MIN((s32)sq_getsize(vm, 3), TIC80_HEIGHT);
+
+		for(s32 i = 0; i < count; i++)
+		{
+			sq_pushinteger(vm, (SQInteger)i);
+			sq_rawget(vm, 3);
+			clear = sq_gettype(vm, -1) == OT_NULL;
+			value = clear ? 0 : getSquirrelNumber(vm, -1);
+			sq_poptop(vm);
+
+			if(!(clear 
+				? memory->api.raster_clear(memory, address, row + i, 1) 
+				: memory->api.raster(memory, address, value, row + i, 1)))
+				return sq_throwerror(vm, "raster() error, invalid address or value");
+		}
+
+		return 0;
+	}
+	else if(top >= 3)
+	{
+		address = getSquirrelNumber(vm, 2);
+		clear = sq_gettype(vm, 3) == OT_NULL;
+		value = clear ? 0 : getSquirrelNumber(vm, 3);
+
+		if(top >= 4)
+		{
+			row = getSquirrelNumber(vm, 4);
+			count = top >= 5 ? getSquirrelNumber(vm, 5) : TIC80_HEIGHT - row;
+		}
+	}
+	else if(top == 2)
+		return sq_throwerror(vm, "invalid params, raster [ addr val|null|[vals] [ row [ count ] ] ]\n");
+
+	if(!(clear 
+		? memory->api.raster_clear(memory, address, row, count) 
+		: memory->api.raster(memory, address, value, row, count)))
+		return sq_throwerror(vm, "raster() error, invalid address or value");
+
+	return 0;
+}
+
 static SQInteger squirrel_reset(HSQUIRRELVM vm)
 {
 	tic_machine* machine = getSquirrelMachine(vm);
@@ -972,6 +1182,8 @@ static SQInteger squirrel_memcpy(HSQUIRRELVM vm)
 		if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && src >= 0 && dest <= bound && src <= bound)
 		{
 			u8* base = (u8*)&getSquirrelMachine(vm)->memory;
+			tic_ram_touch(&getSquirrelMachine(vm)->memory, dest, size);
+			tic_ram_touch(&getSquirrelMachine(vm)->memory, src, size);
 			memcpy(base + dest, base + src, size);
 			return 0;
 		}
@@ -994,6 +1206,7 @@ static SQInteger squirrel_memset(HSQUIRRELVM vm)
 		if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && dest <= bound)
 		{
 			u8* base = (u8*)&getSquirrelMachine(vm)->memory;
+			tic_ram_touch(&getSquirrelMachine(vm)->memory, dest, size);
 			memset(base + dest, value, size);
 			return 0;
 		}
@@ -1272,7 +1485,7 @@ static const SQFUNCTION ApiFunc[] =
 	squirrel_mset, squirrel_peek, squirrel_poke, squirrel_peek4, squirrel_poke4, squirrel_memcpy, 
 	squirrel_memset, squirrel_trace, squirrel_pmem, squirrel_time, squirrel_exit, squirrel_font, squirrel_mouse, 
 	squirrel_circ, squirrel_circb, squirrel_tri, squirrel_textri, squirrel_clip, squirrel_music, squirrel_sync, squirrel_reset,
-	squirrel_key, squirrel_keyp
+	squirrel_key, squirrel_keyp, squirrel_raster, squirrel_mray, squirrel_msweep, squirrel_mfill, squirrel_mpath
 };
 
 STATIC_ASSERT(api_func, COUNT_OF(ApiKeywords) == COUNT_OF(ApiFunc));
@@ -22,9 +22,12 @@
 
 #include "start.h"
 
+#include <stddef.h>
+
 static void reset(Start* start)
 {
 	u8* tile = (u8*)start->tic->ram.tiles.data;
+	tic_ram_touch(start->tic, offsetof(tic_ram, tiles), sizeof(tic_tile));
 
 	start->tic->api.clear(start->tic, tic_color_0);
 
@@ -0,0 +1,323 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "stream.h"
+#include "machine.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#define SCREEN_ROW (TIC80_WIDTH * TIC_PALETTE_BPP / BITS_IN_BYTE)
+#define MASK_ROW (TIC80_WIDTH / BITS_IN_BYTE)
+#define OVR_ROW (SCREEN_ROW + MASK_ROW)
+#define REG_ROWS (TIC80_HEIGHT + 1)
+#define ROWS_MASK(ROWS) (((ROWS) + BITS_IN_BYTE - 1) / BITS_IN_BYTE)
+
+// a frame of stereo samples at up to 192kHz, with room for the rate correction
+#define MAX_SAMPLES_SIZE (192000 / TIC80_FRAMERATE * 2 * TIC_STEREO_CHANNELS * sizeof(s16))
+#define MAX_RAW_SIZE (sizeof(StreamFrame) + ROWS_MASK(TIC80_HEIGHT) * 2 + ROWS_MASK(REG_ROWS) + sizeof(u32) + MAX_SAMPLES_SIZE)
+
+enum {BorderReg = sizeof(tic_palette), OffsetXReg, OffsetYReg};
+
+typedef struct
+{
+	u8 screen[TIC80_HEIGHT][SCREEN_ROW];
+
+	// registers before SCN(0), then the ones every row is drawn with
+	u8 regs[REG_ROWS][TIC_RASTER_REGS];
+
+	// OVR nibbles followed by their mask
+	u8 ovr[TIC80_HEIGHT][OVR_ROW];
+} StreamFrame;
+
+STATIC_ASSERT(stream_header_size, sizeof(tic_stream_header) == 16);
+
+struct tic_stream
+{
+	StreamFrame frame;
+	StreamFrame sent;
+
+	bool key;
+	u32 count;
+
+	u8* raw;
+	u32 rawSize;
+
+	u8* packed;
+	u32 packedSize;
+
+	s16* samples;
+	u32 samplesSize;
+	s32 samplesCount;
+};
+
+static bool reserve(void* ptr, u32* capacity, u32 size)
+{
+	if(*capacity < size)
+	{
+		void** buffer = ptr;
+		void* data = realloc(*buffer, size);
+
+		if(!data)
+			return false;
+
+		*buffer = data;
+		*capacity = size;
+	}
+
+	return true;
+}
+
+static void readRegs(tic_mem* tic, s32 row, u8* regs)
+{
+	memcpy(regs, tic->ram.vram.palette.data, sizeof(tic_palette));
+	regs[BorderReg] = tic->ram.vram.vars.border;
+	regs[OffsetXReg] = tic->ram.vram.vars.offset.x;
+	regs[OffsetYReg] = tic->ram.vram.vars.offset.y;
+
+	if(row >= 0)
+	{
+		const tic_raster_data* raster = &((tic_machine*)tic)->state.raster;
+		u64 mask = raster->mask[row];
+
+		for(s32 i = 0; mask; i++, mask >>= 1)
+			if(mask & 1)
+				regs[i] = raster->data[row][i];
+	}
+}
+
+static void writeRegs(tic_mem* tic, const u8* regs)
+{
+	memcpy(tic->ram.vram.palette.data, regs, sizeof(tic_palette));
+	tic->ram.vram.vars.border = regs[BorderReg] & 0xf;
+	tic->ram.vram.vars.offset.x = regs[OffsetXReg];
+	tic->ram.vram.vars.offset.y = regs[OffsetYReg];
+}
+
+// a bit per row, then the rows which differ from the sent ones
+static u8* encodeRows(u8* out, const void* sent, const void* rows, s32 count, s32 size, bool key)
+{
+	const u8* prev = sent;
+	const u8* cur = rows;
+	u8* mask = out;
+
+	memset(mask, 0, ROWS_MASK(count));
+	out += ROWS_MASK(count);
+
+	for(s32 r = 0; r < count; r++, prev += size, cur += size)
+		if(key || memcmp(prev, cur, size))
+		{
+			mask[r / BITS_IN_BYTE] |= 1 << (r % BITS_IN_BYTE);
+			memcpy(out, cur, size);
+			out += size;
+		}
+
+	return out;
+}
+
+static const u8* decodeRows(const u8* in, const u8* end, void* rows, s32 count, s32 size)
+{
+	const u8* mask = in;
+	u8* dst = rows;
+
+	if(ROWS_MASK(count) > end - in)
+		return NULL;
+
+	in += ROWS_MASK(count);
+
+	for(s32 r = 0; r < count; r++, dst += size)
+		if(mask[r / BITS_IN_BYTE] & 1 << (r % BITS_IN_BYTE))
+		{
+			if(size > end - in)
+				return NULL;
+
+			memcpy(dst, in, size);
+			in += size;
+		}
+
+	return in;
+}
+
+tic_stream* tic_stream_create()
+{
+	tic_stream* stream = calloc(1, sizeof(tic_stream));
+
+	if(stream)
+		stream->key = true;
+
+	return stream;
+}
+
+void tic_stream_close(tic_stream* stream)
+{
+	if(stream)
+	{
+		free(stream->raw);
+		free(stream->packed);
+		free(stream->samples);
+		free(stream);
+	}
+}
+
+void tic_stream_key(tic_stream* stream)
+{
+	stream->key = true;
+}
+
+void tic_stream_begin(tic_stream* stream, tic_mem* tic)
+{
+	readRegs(tic, -1, stream->frame.regs[0]);
+}
+
+void tic_stream_scanline(tic_stream* stream, tic_mem* tic, s32 row)
+{
+	readRegs(tic, row, stream->frame.regs[row + 1]);
+}
+
+void tic_stream_overline(tic_stream* stream, tic_mem* tic)
+{
+	const tic_machine* machine = (tic_machine*)tic;
+
+	for(s32 r = 0; r < TIC80_HEIGHT; r++)
+	{
+		memcpy(stream->frame.ovr[r], machine->state.ovr.data + r * SCREEN_ROW, SCREEN_ROW);
+		memcpy(stream->frame.ovr[r] + SCREEN_ROW, machine->state.ovr.mask + r * MASK_ROW, MASK_ROW);
+	}
+}
+
+s32 tic_stream_encode(tic_stream* stream, tic_mem* tic, const void** packet)
+{
+	StreamFrame* frame = &stream->frame;
+	StreamFrame* sent = &stream->sent;
+
+	memcpy(frame->screen, tic->ram.vram.screen.data, sizeof frame->screen);
+
+	if(!reserve(&stream->raw, &stream->rawSize, MAX_RAW_SIZE)
+		|| !reserve(&stream->packed, &stream->packedSize, sizeof(tic_stream_header) + compressBound(MAX_RAW_SIZE)))
+		return 0;
+
+	u8* out = stream->raw;
+	out = encodeRows(out, sent->screen, frame->screen, TIC80_HEIGHT, SCREEN_ROW, stream->key);
+	out = encodeRows(out, sent->regs, frame->regs, REG_ROWS, TIC_RASTER_REGS, stream->key);
+	out = encodeRows(out, sent->ovr, frame->ovr, TIC80_HEIGHT, OVR_ROW, stream->key);
+
+	{
+		u32 size = MIN(tic->samples.size, (s32)MAX_SAMPLES_SIZE);
+		memcpy(out, &size, sizeof size);
+		memcpy(out + sizeof size, tic->samples.buffer, size);
+		out += sizeof size + size;
+	}
+
+	tic_stream_header header = {.frame = stream->count, .rawsize = (u32)(out - stream->raw)};
+	memcpy(header.magic, TIC_STREAM_MAGIC, sizeof header.magic);
+
+	uLongf packedSize = stream->packedSize - sizeof header;
+
+	if(compress2(stream->packed + sizeof header, &packedSize, stream->raw, header.rawsize, Z_BEST_SPEED) != Z_OK)
+		return 0;
+
+	header.size = (u32)packedSize;
+	memcpy(stream->packed, &header, sizeof header);
+
+	memcpy(sent, frame, sizeof(StreamFrame));
+	stream->key = false;
+	stream->count++;
+
+	*packet = stream->packed;
+
+	return sizeof header + header.size;
+}
+
+bool tic_stream_decode(tic_stream* stream, const tic_stream_header* header, const void* body)
+{
+	// nothing the encoder makes is bigger, a larger size is a broken or hostile packet
+	if(memcmp(header->magic, TIC_STREAM_MAGIC, sizeof header->magic) != 0 || header->rawsize > MAX_RAW_SIZE)
+		return false;
+
+	if(!reserve(&stream->raw, &stream->rawSize, header->rawsize))
+		return false;
+
+	uLongf rawsize = header->rawsize;
+
+	if(uncompress(stream->raw, &rawsize, body, header->size) != Z_OK || rawsize != header->rawsize)
+		return false;
+
+	StreamFrame* frame = &stream->frame;
+	const u8* in = stream->raw;
+	const u8* end = in + rawsize;
+
+	if(!(in = decodeRows(in, end, frame->screen, TIC80_HEIGHT, SCREEN_ROW))
+		|| !(in = decodeRows(in, end, frame->regs, REG_ROWS, TIC_RASTER_REGS))
+		|| !(in = decodeRows(in, end, frame->ovr, TIC80_HEIGHT, OVR_ROW)))
+		return false;
+
+	u32 size = 0;
+
+	if(sizeof size > (u32)(end - in))
+		return false;
+
+	memcpy(&size, in, sizeof size);
+	in += sizeof size;
+
+	if(size > (u32)(end - in) || !reserve(&stream->samples, &stream->samplesSize, size))
+		return false;
+
+	memcpy(stream->samples, in, size);
+	stream->samplesCount = size / sizeof(s16);
+	stream->count = header->frame;
+
+	return true;
+}
+
+static void blitScanline(tic_mem* tic, s32 row, void* data)
+{
+	tic_stream* stream = data;
+
+	writeRegs(tic, stream->frame.regs[row + 1]);
+}
+
+static void blitOverline(tic_mem* tic, void* data)
+{
+	tic_stream* stream = data;
+	tic_machine* machine = (tic_machine*)tic;
+
+	for(s32 r = 0; r < TIC80_HEIGHT; r++)
+	{
+		memcpy(machine->state.ovr.data + r * SCREEN_ROW, stream->frame.ovr[r], SCREEN_ROW);
+		memcpy(machine->state.ovr.mask + r * MASK_ROW, stream->frame.ovr[r] + SCREEN_ROW, MASK_ROW);
+	}
+}
+
+void tic_stream_blit(tic_stream* stream, tic_mem* tic)
+{
+	memcpy(tic->ram.vram.screen.data, stream->frame.screen, sizeof stream->frame.screen);
+	writeRegs(tic, stream->frame.regs[0]);
+
+	tic->api.blit(tic, blitScanline, blitOverline, stream);
+}
+
+const s16* tic_stream_samples(tic_stream* stream, s32* count)
+{
+	*count = stream->samplesCount;
+	return stream->samples;
+}
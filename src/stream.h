@@ -0,0 +1,60 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "ticapi.h"
+
+// Delta-encoded machine output for thin clients.
+// A frame packet carries only what changed since the previous one: 4bpp VRAM rows,
+// the registers every row was drawn with (palette, border and offsets as SCN and the
+// raster table left them) and OVR rows, plus the PCM samples, zlib-compressed as a whole.
+// The decoding side keeps the same state and draws it with the regular blit.
+// Clients send raw tic80_input structs back, the server applies the last one.
+
+#define TIC_STREAM_MAGIC "TICS"
+#define TIC_STREAM_PORT 7780
+
+typedef struct
+{
+	char magic[4];
+	u32 frame;
+	u32 size;		// packed body that follows
+	u32 rawsize;
+} tic_stream_header;
+
+typedef struct tic_stream tic_stream;
+
+tic_stream* tic_stream_create();
+void tic_stream_close(tic_stream* stream);
+
+// encoding, called around the blit, the next packet after tic_stream_key() has everything
+void tic_stream_key(tic_stream* stream);
+void tic_stream_begin(tic_stream* stream, tic_mem* tic);
+void tic_stream_scanline(tic_stream* stream, tic_mem* tic, s32 row);
+void tic_stream_overline(tic_stream* stream, tic_mem* tic);
+s32 tic_stream_encode(tic_stream* stream, tic_mem* tic, const void** packet);
+
+// decoding, takes a header and its body
+bool tic_stream_decode(tic_stream* stream, const tic_stream_header* header, const void* body);
+void tic_stream_blit(tic_stream* stream, tic_mem* tic);
+const s16* tic_stream_samples(tic_stream* stream, s32* count);
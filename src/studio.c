@@ -38,6 +38,8 @@
 #include "surf.h"
 
 #include "fs.h"
+#include "watch.h"
+#include "capture.h"
 
 #include "ext/gif.h"
 #include "ext/md5.h"
@@ -58,11 +60,44 @@
 #define TIC_EDITOR_BANKS 1
 #endif
 
+enum
+{
+	WatchCart,
+	WatchCode,
+	WatchSprites,
+	WatchMap,
+	WatchConfig,
+};
+
 typedef struct
 {
 	u8 data[16];
 } CartHash;
 
+// the cart is hashed by sections, and a section is hashed again only
+// after one of the counters which track the writes to it has moved
+enum
+{
+	SectionTiles,
+	SectionMap,
+	SectionSfx,
+	SectionMusic,
+	SectionPalette,
+	SectionFlags,
+	BankSections,
+
+	SectionCode = BankSections * TIC_BANKS,
+	SectionCover,
+	CartSections,
+};
+
+typedef struct
+{
+	u32 stamp;		// sum of the counters when the hash was taken
+	CartHash hash;	// the section as it is now
+	CartHash saved;	// the section as it was loaded or saved
+} CartSection;
+
 typedef struct
 {
 	bool down;
@@ -91,7 +126,8 @@ static struct
 
 	struct
 	{
-		CartHash hash;
+		CartSection sections[CartSections];
+		u32 edits;
 		u64 mdate;
 	}cart;
 
@@ -148,6 +184,8 @@ static struct
 
 	} video;
 
+	tic_capture* capture;
+
 	struct
 	{
 		Code* 	code;
@@ -171,6 +209,9 @@ static struct
 
 	FileSystem* fs;
 
+	// reports files edited outside, NULL where they have to be checked on focus
+	Watcher* watcher;
+
 	bool missedFrame;
 
 	s32 argc;
@@ -226,6 +267,8 @@ static struct
 		.frames = 0,
 	},
 
+	.capture = NULL,
+
 	.missedFrame = false,
 	.argc = 0,
 	.argv = NULL,
@@ -284,22 +327,22 @@ bool anyKeyWasPressed()
 
 tic_tiles* getBankTiles()
 {
-	return &impl.studio.tic->cart.banks[impl.bank.index.sprites].tiles;
+	return &tic_load_bank(impl.studio.tic, impl.bank.index.sprites)->tiles;
 }
 
 tic_map* getBankMap()
 {
-	return &impl.studio.tic->cart.banks[impl.bank.index.map].map;
+	return &tic_load_bank(impl.studio.tic, impl.bank.index.map)->map;
 }
 
 tic_palette* getBankPalette()
 {
-	return &impl.studio.tic->cart.banks[impl.bank.index.sprites].palette;
+	return &tic_load_bank(impl.studio.tic, impl.bank.index.sprites)->palette;
 }
 
 tic_flags* getBankFlags()
 {
-	return &impl.studio.tic->cart.banks[impl.bank.index.sprites].flags;
+	return &tic_load_bank(impl.studio.tic, impl.bank.index.sprites)->flags;
 }
 
 void playSystemSfx(s32 id)
@@ -790,37 +833,117 @@ void drawToolbar(tic_mem* tic, bool bg)
 	}
 }
 
+// editors and their history are created on the first use and dropped with the cart
+static Code* getCodeEditor(s32 bank)
+{
+	Code** code = &impl.editor[bank].code;
+
+	if(!*code)
+	{
+		*code = calloc(1, sizeof(Code));
+		initCode(*code, impl.studio.tic, &impl.studio.tic->cart->code);
+	}
+
+	return *code;
+}
+
+static Sprite* getSpriteEditor(s32 bank)
+{
+	Sprite** sprite = &impl.editor[bank].sprite;
+
+	if(!*sprite)
+	{
+		*sprite = calloc(1, sizeof(Sprite));
+		initSprite(*sprite, impl.studio.tic, &tic_load_bank(impl.studio.tic, bank)->tiles);
+	}
+
+	return *sprite;
+}
+
+static Map* getMapEditor(s32 bank)
+{
+	Map** map = &impl.editor[bank].map;
+
+	if(!*map)
+	{
+		*map = calloc(1, sizeof(Map));
+		initMap(*map, impl.studio.tic, &tic_load_bank(impl.studio.tic, bank)->map);
+	}
+
+	return *map;
+}
+
+static Sfx* getSfxEditor(s32 bank)
+{
+	Sfx** sfx = &impl.editor[bank].sfx;
+
+	if(!*sfx)
+	{
+		*sfx = calloc(1, sizeof(Sfx));
+		initSfx(*sfx, impl.studio.tic, &tic_load_bank(impl.studio.tic, bank)->sfx);
+	}
+
+	return *sfx;
+}
+
+static Music* getMusicEditor(s32 bank)
+{
+	Music** music = &impl.editor[bank].music;
+
+	if(!*music)
+	{
+		*music = calloc(1, sizeof(Music));
+		initMusic(*music, impl.studio.tic, &tic_load_bank(impl.studio.tic, bank)->music);
+	}
+
+	return *music;
+}
+
+static void freeEditors()
+{
+	for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
+	{
+		freeCode(impl.editor[i].code);
+		freeSprite(impl.editor[i].sprite);
+		freeMap(impl.editor[i].map);
+		freeSfx(impl.editor[i].sfx);
+		freeMusic(impl.editor[i].music);
+	}
+
+	memset(impl.editor, 0, sizeof impl.editor);
+}
+
 void setStudioEvent(StudioEvent event)
 {
 	switch(impl.mode)
 	{
 	case TIC_CODE_MODE: 	
 		{
-			Code* code = impl.editor[impl.bank.index.code].code;
+			Code* code = getCodeEditor(impl.bank.index.code);
 			code->event(code, event); 			
 		}
 		break;
 	case TIC_SPRITE_MODE:	
 		{
-			Sprite* sprite = impl.editor[impl.bank.index.sprites].sprite;
+			Sprite* sprite = getSpriteEditor(impl.bank.index.sprites);
 			sprite->event(sprite, event); 
 		}
 	break;
 	case TIC_MAP_MODE:
 		{
-			Map* map = impl.editor[impl.bank.index.map].map;
+			Map* map = getMapEditor(impl.bank.index.map);
 			map->event(map, event);
 		}
 		break;
 	case TIC_SFX_MODE:
 		{
-			Sfx* sfx = impl.editor[impl.bank.index.sfx].sfx;
+			Sfx* sfx = getSfxEditor(impl.bank.index.sfx);
 			sfx->event(sfx, event);
 		}
 		break;
 	case TIC_MUSIC_MODE:
 		{
-			Music* music = impl.editor[impl.bank.index.music].music;
+			Music* music = getMusicEditor(impl.bank.index.music);
 			music->event(music, event);
 		}
 		break;
@@ -889,7 +1012,7 @@ void drawBitIcon(s32 x, s32 y, const u8* ptr, u8 color)
 
 static void initWorldMap()
 {
-	initWorld(impl.world, impl.studio.tic, impl.editor[impl.bank.index.map].map);
+	initWorld(impl.world, impl.studio.tic, getMapEditor(impl.bank.index.map));
 }
 
 static void initRunMode()
@@ -1097,25 +1220,105 @@ static void resetBanks()
 
 static void initModules()
 {
-	tic_mem* tic = impl.studio.tic;
-
 	resetBanks();
+	freeEditors();
 
-	for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
+	if(impl.mode == TIC_WORLD_MODE)
+		initWorldMap();
+}
+
+static void* getSection(s32 index, u32* size)
+{
+	tic_cartridge* cart = impl.studio.tic->cart;
+
+	if(index == SectionCode)
+	{
+		*size = sizeof(tic_code);
+		return &cart->code;
+	}
+
+	if(index == SectionCover)
+	{
+		*size = sizeof(tic_cover_image);
+		return &cart->cover;
+	}
+
+	tic_bank* bank = &cart->banks[index / BankSections];
+
+	switch(index % BankSections)
+	{
+	case SectionTiles: 		*size = sizeof(tic_tiles) * 2; 	return &bank->tiles;
+	case SectionMap: 		*size = sizeof(tic_map); 		return &bank->map;
+	case SectionSfx: 		*size = sizeof(tic_sfx); 		return &bank->sfx;
+	case SectionMusic: 		*size = sizeof(tic_music); 		return &bank->music;
+	case SectionPalette: 	*size = sizeof(tic_palette); 	return &bank->palette;
+	default: 				*size = sizeof(tic_flags); 		return &bank->flags;
+	}
+}
+
+// editors not opened yet have no history
+#define EDITOR_HISTORY(BANK, NAME) (impl.editor[BANK].NAME ? impl.editor[BANK].NAME->history : NULL)
+
+static u32 getSectionStamp(s32 index)
+{
+	u32 stamp = impl.cart.edits;
+
+	if(index == SectionCode)
+	{
+		for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
+			stamp += history_generation(EDITOR_HISTORY(i, code));
+	}
+	else if(index < SectionCode)
+	{
+		s32 bank = index / BankSections;
+
+		stamp += impl.studio.tic->cartSyncs[bank];
+
+		if(bank < TIC_EDITOR_BANKS)
+			switch(index % BankSections)
+			{
+			case SectionTiles: 	stamp += history_generation(EDITOR_HISTORY(bank, sprite)); break;
+			case SectionMap: 	stamp += history_generation(EDITOR_HISTORY(bank, map)); break;
+			case SectionSfx: 	stamp += history_generation(EDITOR_HISTORY(bank, sfx)); break;
+			case SectionMusic: 	stamp += history_generation(EDITOR_HISTORY(bank, music)); break;
+			}
+	}
+
+	return stamp;
+}
+
+#undef EDITOR_HISTORY
+
+static const CartHash* getSectionHash(s32 index)
+{
+	CartSection* section = &impl.cart.sections[index];
+	u32 stamp = getSectionStamp(index);
+
+	// palette and flags are edited without history, but are small enough to hash every time
+	bool untracked = index < SectionCode 
+		&& (index % BankSections == SectionPalette || index % BankSections == SectionFlags);
+
+	if(untracked || section->stamp != stamp)
 	{
-		initCode(impl.editor[i].code, impl.studio.tic, &tic->cart.code);
-		initSprite(impl.editor[i].sprite, impl.studio.tic, &tic->cart.banks[i].tiles);
-		initMap(impl.editor[i].map, impl.studio.tic, &tic->cart.banks[i].map);
-		initSfx(impl.editor[i].sfx, impl.studio.tic, &tic->cart.banks[i].sfx);
-		initMusic(impl.editor[i].music, impl.studio.tic, &tic->cart.banks[i].music);
+		u32 size = 0;
+		const void* data = getSection(index, &size);
+
+		md5(data, size, section->hash.data);
+		section->stamp = stamp;
 	}
 
-	initWorldMap();
+	return &section->hash;
 }
 
 static void updateHash()
 {
-	md5(&impl.studio.tic->cart, sizeof(tic_cartridge), impl.cart.hash.data);
+	for(s32 i = 0; i < CartSections; i++)
+		impl.cart.sections[i].saved = *getSectionHash(i);
+}
+
+void studioCartEdited()
+{
+	impl.cart.edits++;
 }
 
 static void updateMDate()
@@ -1123,6 +1326,15 @@ static void updateMDate()
 	impl.cart.mdate = fsMDate(impl.console->fs, impl.console->romName);
 }
 
+static void watchCart()
+{
+#if defined(TIC80_PRO)
+	if(strlen(impl.console->romName))
+		watchFile(impl.watcher, WatchCart, fsGetFilePath(impl.console->fs, impl.console->romName));
+	else unwatchFile(impl.watcher, WatchCart);
+#endif
+}
+
 static void updateTitle()
 {
 	char name[FILENAME_MAX] = TIC_TITLE;
@@ -1138,23 +1350,84 @@ void studioRomSaved()
 	updateTitle();
 	updateHash();
 	updateMDate();
+	watchCart();
 }
 
 void studioRomLoaded()
 {
 	initModules();
+	studioCartEdited();
 
 	updateTitle();
 	updateHash();
 	updateMDate();
+	watchCart();
+}
+
+static bool updateSection(void* dst, const void* src, size_t size)
+{
+	if(memcmp(dst, src, size) == 0)
+		return false;
+
+	memcpy(dst, src, size);
+
+	return true;
+}
+
+// takes only the sections which differ, so the editors of the others keep their state
+void studioRomUpdated(const tic_cartridge* cart)
+{
+	tic_mem* tic = impl.studio.tic;
+
+	if(updateSection(&tic->cart->code, &cart->code, sizeof(tic_code)))
+		for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
+			if(impl.editor[i].code)
+				impl.editor[i].code->update(impl.editor[i].code);
+
+	bool world = false;
+
+	for(s32 i = 0; i < TIC_BANKS; i++)
+	{
+		tic_bank* bank = &tic->cart->banks[i];
+		const tic_bank* src = &cart->banks[i];
+
+		bool tiles = updateSection(&bank->tiles, &src->tiles, sizeof(tic_tiles));
+		bool sprites = updateSection(&bank->sprites, &src->sprites, sizeof(tic_tiles));
+		bool map = updateSection(&bank->map, &src->map, sizeof(tic_map));
+		bool sfx = updateSection(&bank->sfx, &src->sfx, sizeof(tic_sfx));
+		bool music = updateSection(&bank->music, &src->music, sizeof(tic_music));
+
+		updateSection(&bank->palette, &src->palette, sizeof(tic_palette));
+		updateSection(&bank->flags, &src->flags, sizeof(tic_flags));
+
+		if(i < TIC_EDITOR_BANKS)
+		{
+			if((tiles || sprites) && impl.editor[i].sprite) initSprite(impl.editor[i].sprite, tic, &bank->tiles);
+			if(map && impl.editor[i].map) initMap(impl.editor[i].map, tic, &bank->map);
+			if(sfx && impl.editor[i].sfx) initSfx(impl.editor[i].sfx, tic, &bank->sfx);
+			if(music && impl.editor[i].music) initMusic(impl.editor[i].music, tic, &bank->music);
+		}
+
+		world |= map;
+	}
+
+	updateSection(&tic->cart->cover, &cart->cover, sizeof(tic_cover_image));
+
+	if(world && impl.mode == TIC_WORLD_MODE)
+		initWorldMap();
+
+	studioCartEdited();
+	updateHash();
+	updateMDate();
 }
 
 bool studioCartChanged()
 {
-	CartHash hash;
-	md5(&impl.studio.tic->cart, sizeof(tic_cartridge), hash.data);
+	for(s32 i = 0; i < CartSections; i++)
+		if(memcmp(getSectionHash(i), &impl.cart.sections[i].saved, sizeof(CartHash)) != 0)
+			return true;
 
-	return memcmp(hash.data, impl.cart.hash.data, sizeof(CartHash)) != 0;
+	return false;
 }
 
 tic_key* getKeymap()
@@ -1242,8 +1515,9 @@ static void setCoverImage()
 
 			screen2buffer(buffer, tic->screen, rect);
 
-			gif_write_animation(impl.studio.tic->cart.cover.data, &impl.studio.tic->cart.cover.size,
+			gif_write_animation(impl.studio.tic->cart->cover.data, &impl.studio.tic->cart->cover.size,
 				TIC80_WIDTH, TIC80_HEIGHT, (const u8*)buffer, 1, TIC80_FRAMERATE, 1);
+			studioCartEdited();
 
 			free(buffer);
 
@@ -1393,9 +1667,9 @@ static void processShortcuts()
 		else if(keyWasPressedOnce(tic_key_f11)) goFullscreen();
 		else if(keyWasPressedOnce(tic_key_escape))
 		{
-			Code* code = impl.editor[impl.bank.index.code].code;
+			Code* code = impl.mode == TIC_CODE_MODE ? getCodeEditor(impl.bank.index.code) : NULL;
 
-			if(impl.mode == TIC_CODE_MODE && code->mode != TEXT_EDIT_MODE)
+			if(code && code->mode != TEXT_EDIT_MODE)
 			{
 				code->escape(code);
 				return;
@@ -1420,45 +1694,96 @@ static void reloadConfirm(bool yes, void* data)
 		impl.console->updateProject(impl.console);
 }
 
+static void checkProjectChanged()
+{
+	Console* console = impl.console;
+
+	u64 mdate = fsMDate(console->fs, console->romName);
+
+	if(impl.cart.mdate && mdate > impl.cart.mdate)
+	{
+		if(studioCartChanged())
+		{
+			static const char* Rows[] =
+			{
+				"",
+				"CART HAS CHANGED!",
+				"",
+				"DO YOU WANT",
+				"TO RELOAD IT?"
+			};
+
+			showDialog(Rows, COUNT_OF(Rows), reloadConfirm, NULL);
+		}
+		else console->updateProject(console);						
+	}
+}
+
 #endif
 
+static void reloadCode()
+{
+	Code* code = impl.editor[impl.bank.index.code].code;
+	impl.console->codeLiveReload.reload(impl.console, impl.studio.tic->cart->code.data);
+	if(impl.console->codeLiveReload.active && code && code->update)
+		code->update(code);
+}
+
 static void updateStudioProject()
 {
+	// the watcher already brought in every change
+	if(impl.watcher) return;
+
 #if defined(TIC80_PRO)
 
 	if(impl.mode != TIC_START_MODE)
-	{
-		Console* console = impl.console;
+		checkProjectChanged();
 
-		u64 mdate = fsMDate(console->fs, console->romName);
+#endif
 
-		if(impl.cart.mdate && mdate > impl.cart.mdate)
-		{
-			if(studioCartChanged())
-			{
-				static const char* Rows[] =
-				{
-					"",
-					"CART HAS CHANGED!",
-					"",
-					"DO YOU WANT",
-					"TO RELOAD IT?"
-				};
-
-				showDialog(Rows, COUNT_OF(Rows), reloadConfirm, NULL);
-			}
-			else console->updateProject(console);						
-		}
-	}
+	reloadCode();
+}
+
+static void processWatcher()
+{
+	u32 changes = watcherChanges(impl.watcher);
+
+	if(!changes) return;
+
+#if defined(TIC80_PRO)
+
+	if(changes & (1 << WatchCart) && impl.mode != TIC_START_MODE)
+		checkProjectChanged();
 
 #endif
-	{
-		Code* code = impl.editor[impl.bank.index.code].code;
-		impl.console->codeLiveReload.reload(impl.console, code->src);
-		if(impl.console->codeLiveReload.active && code->update)
-			code->update(code);
-	}
 
+	if(changes & (1 << WatchCode))
+		reloadCode();
+
+	if(changes & (1 << WatchSprites))
+		impl.console->injectLiveReload.reloadSprites(impl.console);
+
+	if(changes & (1 << WatchMap))
+		impl.console->injectLiveReload.reloadMap(impl.console);
+
+	if(changes & (1 << WatchConfig))
+		impl.config->reload(impl.config);
+}
+
+static void initWatcher()
+{
+	Console* console = impl.console;
+
+	if(console->codeLiveReload.active)
+		watchFile(impl.watcher, WatchCode, console->codeLiveReload.fileName);
+
+	if(strlen(console->injectLiveReload.sprites))
+		watchFile(impl.watcher, WatchSprites, console->injectLiveReload.sprites);
+
+	if(strlen(console->injectLiveReload.map))
+		watchFile(impl.watcher, WatchMap, console->injectLiveReload.map);
+
+	watchFile(impl.watcher, WatchConfig, fsGetRootFilePath(impl.fs, CONFIG_TIC_PATH));
 }
 
 static void drawRecordLabel(u32* frame, s32 sx, s32 sy, const u32* color)
@@ -1536,6 +1861,12 @@ static void recordFrame(u32* pixels)
 	}
 }
 
+static void captureFrame()
+{
+	if(impl.capture)
+		tic_capture_frame(impl.capture, impl.studio.tic);
+}
+
 static void drawPopup()
 {
 	if(impl.popup.counter > 0)
@@ -1582,8 +1913,8 @@ static void renderStudio()
 			music = &impl.config->cart.bank0.music;
 			break;
 		default:
-			sfx = &impl.studio.tic->cart.banks[impl.bank.index.sfx].sfx;
-			music = &impl.studio.tic->cart.banks[impl.bank.index.music].music;
+			sfx = &tic_load_bank(impl.studio.tic, impl.bank.index.sfx)->sfx;
+			music = &tic_load_bank(impl.studio.tic, impl.bank.index.music)->music;
 		}
 
 		impl.studio.tic->api.tick_start(impl.studio.tic, sfx, music);
@@ -1596,31 +1927,31 @@ static void renderStudio()
 	case TIC_RUN_MODE: 		impl.run->tick(impl.run); break;
 	case TIC_CODE_MODE: 	
 		{
-			Code* code = impl.editor[impl.bank.index.code].code;
+			Code* code = getCodeEditor(impl.bank.index.code);
 			code->tick(code);
 		}
 		break;
 	case TIC_SPRITE_MODE:	
 		{
-			Sprite* sprite = impl.editor[impl.bank.index.sprites].sprite;
+			Sprite* sprite = getSpriteEditor(impl.bank.index.sprites);
 			sprite->tick(sprite);		
 		}
 		break;
 	case TIC_MAP_MODE:
 		{
-			Map* map = impl.editor[impl.bank.index.map].map;
+			Map* map = getMapEditor(impl.bank.index.map);
 			map->tick(map);
 		}
 		break;
 	case TIC_SFX_MODE:
 		{
-			Sfx* sfx = impl.editor[impl.bank.index.sfx].sfx;
+			Sfx* sfx = getSfxEditor(impl.bank.index.sfx);
 			sfx->tick(sfx);
 		}
 		break;
 	case TIC_MUSIC_MODE:
 		{
-			Music* music = impl.editor[impl.bank.index.music].music;
+			Music* music = getMusicEditor(impl.bank.index.music);
 			music->tick(music);
 		}
 		break;
@@ -1649,12 +1980,14 @@ static void updateSystemFont()
 			for(s32 x = 0; x < TIC_SPRITESIZE; x++)
 				if(tic_tool_peek4(&impl.config->cart.bank0.sprites.data[i], TIC_SPRITESIZE*(y+1) - x-1))
 					impl.studio.tic->font.data[i*BITS_IN_BYTE+y] |= 1 << x;
+
+	tic_font_touch(impl.studio.tic);
 }
 
 void studioConfigChanged()
 {
 	Code* code = impl.editor[impl.bank.index.code].code;
-	if(code->update)
+	if(code && code->update)
 		code->update(code);
 
 	updateSystemFont();
@@ -1738,6 +2071,7 @@ static void processMouseStates()
 
 static void studioTick()
 {
+	processWatcher();
 	processShortcuts();
 	processMouseStates();
 	processGamepadMapping();
@@ -1759,7 +2093,7 @@ static void studioTick()
 			break;
 		case TIC_SPRITE_MODE:
 			{
-				Sprite* sprite = impl.editor[impl.bank.index.sprites].sprite;
+				Sprite* sprite = getSpriteEditor(impl.bank.index.sprites);
 				overline = sprite->overline;
 				scanline = sprite->scanline;
 				data = sprite;
@@ -1768,7 +2102,7 @@ static void studioTick()
 			break;
 		case TIC_MAP_MODE:
 			{
-				Map* map = impl.editor[impl.bank.index.map].map;
+				Map* map = getMapEditor(impl.bank.index.map);
 				overline = map->overline;
 				scanline = map->scanline;
 				data = map;
@@ -1782,6 +2116,7 @@ static void studioTick()
 
 		tic->api.blit(tic, scanline, overline, data);
 
+		captureFrame();
 		recordFrame(tic->screen);
 		drawDesyncLabel(tic->screen);
 	
@@ -1792,16 +2127,12 @@ static void studioClose()
 {
 	free((void*)getConfig()->crtShader);
 
-	{
-		for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
-		{
-			free(impl.editor[i].code);
-			free(impl.editor[i].sprite);
-			free(impl.editor[i].map);
-			free(impl.editor[i].sfx);
-			free(impl.editor[i].music);
-		}
+	tic_capture_close(impl.capture);
+	closeWatcher(impl.watcher);
+
+	freeEditors();
 
+	{
 		free(impl.start);
 		free(impl.console);
 		free(impl.run);
@@ -1837,15 +2168,6 @@ Studio* studioInit(s32 argc, char **argv, s32 samplerate, const char* folder, Sy
 	impl.studio.tic = impl.tic80local->memory;
 
 	{
-		for(s32 i = 0; i < TIC_EDITOR_BANKS; i++)
-		{
-			impl.editor[i].code		= calloc(1, sizeof(Code));
-			impl.editor[i].sprite	= calloc(1, sizeof(Sprite));
-			impl.editor[i].map 		= calloc(1, sizeof(Map));
-			impl.editor[i].sfx 		= calloc(1, sizeof(Sfx));
-			impl.editor[i].music 	= calloc(1, sizeof(Music));
-		}
-
 		impl.start 		= calloc(1, sizeof(Start));
 		impl.console 	= calloc(1, sizeof(Console));
 		impl.run 		= calloc(1, sizeof(Run));
@@ -1858,6 +2180,8 @@ Studio* studioInit(s32 argc, char **argv, s32 samplerate, const char* folder, Sy
 
 	fsMakeDir(impl.fs, TIC_LOCAL);
 	fsMakeDir(impl.fs, TIC_LOCAL_VERSION);
+
+	impl.watcher = createWatcher();
 	
 	initConfig(impl.config, impl.studio.tic, impl.fs);
 
@@ -1870,6 +2194,7 @@ Studio* studioInit(s32 argc, char **argv, s32 samplerate, const char* folder, Sy
 	initRunMode();
 
 	initModules();
+	initWatcher();
 
 	if(impl.console->skipStart)
 	{
@@ -1881,6 +2206,14 @@ Studio* studioInit(s32 argc, char **argv, s32 samplerate, const char* folder, Sy
 		impl.config->data.crtMonitor = true;
 	}
 
+	if(strlen(impl.console->capturePath))
+	{
+		impl.capture = tic_capture_open(impl.console->capturePath, impl.samplerate, true);
+
+		if(!impl.capture)
+			impl.system->showMessageBox("Warning", "cannot open capture file");
+	}
+
 	impl.studio.tick = studioTick;
 	impl.studio.close = studioClose;
 	impl.studio.updateProject = updateStudioProject;
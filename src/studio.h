@@ -102,6 +102,7 @@ void drawBitIcon(s32 x, s32 y, const u8* ptr, u8 color);
 
 void studioRomLoaded();
 void studioRomSaved();
+void studioRomUpdated(const tic_cartridge* cart);
 void studioConfigChanged();
 
 void setStudioMode(EditorMode mode);
@@ -148,6 +149,9 @@ void hideDialog();
 void hideGameMenu();
 
 bool studioCartChanged();
+
+// for the writes to the cart which don't go through an editor's history or sync
+void studioCartEdited();
 void playSystemSfx(s32 id);
 
 void runGameFromSurf();
@@ -23,6 +23,7 @@
 #include "surf.h"
 #include "fs.h"
 #include "console.h"
+#include "cart.h"
 
 #include "ext/gif.h"
 
@@ -496,13 +497,27 @@ static void updateMenuItemCover(Surf* surf, const u8* cover, s32 size)
 		{
 			enum { Size = TIC80_WIDTH * TIC80_HEIGHT };
 
-			for (s32 i = 0; i < Size; i++)
+			tic_rgb* rgb = malloc(Size * sizeof(tic_rgb));
+			u8* colors = malloc(Size);
+			tic_quantizer* quantizer = tic_tool_quantizer_create(getConfig()->cart->bank0.palette.colors, false);
+
+			if(rgb && colors && quantizer)
 			{
-				const gif_color* c = &image->palette[image->buffer[i]];
-				tic_rgb rgb = { c->r, c->g, c->b };
-				u8 color = tic_tool_find_closest_color(getConfig()->cart->bank0.palette.colors, &rgb);
-				tic_tool_poke4(item->cover->data, i, color);
+				for (s32 i = 0; i < Size; i++)
+				{
+					const gif_color* c = &image->palette[image->buffer[i]];
+					rgb[i] = (tic_rgb){ c->r, c->g, c->b };
+				}
+
+				tic_tool_quantize(quantizer, rgb, colors, TIC80_WIDTH, TIC80_HEIGHT, tic_dither_none);
+
+				for (s32 i = 0; i < Size; i++)
+					tic_tool_poke4(item->cover->data, i, colors[i]);
 			}
+
+			tic_tool_quantizer_free(quantizer);
+			free(rgb);
+			free(colors);
 		}
 
 		gif_close(image);
@@ -511,8 +526,6 @@ static void updateMenuItemCover(Surf* surf, const u8* cover, s32 size)
 
 static void loadCover(Surf* surf)
 {
-	tic_mem* tic = surf->tic;
-	
 	MenuItem* item = &surf->menu.items[surf->menu.pos];
 	
 	if(item->coverLoaded)
@@ -529,23 +542,36 @@ static void loadCover(Surf* surf)
 
 		if(data)
 		{
-			tic_cartridge* cart = (tic_cartridge*)malloc(sizeof(tic_cartridge));
+#if defined(TIC80_PRO)
 
-			if(cart)
+			if(hasProjectExt(item->name))
 			{
-#if defined(TIC80_PRO)
+				tic_cartridge* cart = (tic_cartridge*)malloc(sizeof(tic_cartridge));
 
-				if(hasProjectExt(item->name))
+				if(cart)
+				{
 					surf->console->loadProject(surf->console, item->name, data, size, cart);
-				else
 
-#endif					
-					tic->api.load(cart, data, size);
+					if(cart->cover.size)
+						updateMenuItemCover(surf, cart->cover.data, cart->cover.size);
+
+					free(cart);
+				}
+			}
+			else
+
+#endif
+			{
+				// only the cover chunk is decoded
+				tic_cover_image* cover = (tic_cover_image*)malloc(sizeof(tic_cover_image));
 
-				if(cart->cover.size)
-					updateMenuItemCover(surf, cart->cover.data, cart->cover.size);
+				if(cover)
+				{
+					if(tic_cart_load_cover(cover, data, size))
+						updateMenuItemCover(surf, cover->data, cover->size);
 
-				free(cart);
+					free(cover);
+				}
 			}
 
 			free(data);
@@ -663,7 +689,7 @@ static void onPlayCart(Surf* surf)
 
 			surf->console->loadProject(surf->console, item->name, data, size, cart);
 
-			memcpy(&surf->tic->cart, cart, sizeof(tic_cartridge));
+			memcpy(surf->tic->cart, cart, sizeof(tic_cartridge));
 
 			studioRomLoaded();
 
@@ -78,6 +78,10 @@ typedef struct
 	bool showSync;
 	bool crtMonitor;
 
+	// frame pacing, the last frameSpin microseconds of a wait spin instead of sleeping
+	bool vsync;
+	s32 frameSpin;
+
 	const char* crtShader;
 	const tic_cartridge* cart;
 
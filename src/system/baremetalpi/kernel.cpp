@@ -31,6 +31,7 @@
 #include "utils.h"
 #include <limits.h>
 #include <studio.h>
+#include "scale.h"
 #include "keycodes.h"
 #include "gamepads.h"
 #include "syscore.h"
@@ -50,6 +51,9 @@ static unsigned mousebuttons;
 static unsigned mousebuttonsOld;
 static unsigned mouseTime = 600; // starts not visible
 
+// palette indices of the last frame, scaled straight into the screen
+static tic_indexed_frame frame;
+
 // gamepad status
 static struct TGamePadState gamepad;
 
@@ -175,35 +179,20 @@ static System systemInterface =
 	.updateConfig = updateConfig,
 };
 
-u32 rgbaToBgra(u32 u){
-	u8 r = u & 0xFF;
-	u8 g = (u >> 8) & 0xff;
-	u8 b = (u >> 16) & 0xff;
-	return (b & 0xFF)      
-					| ((g & 0xFF) << 8)
-					| ((r & 0xFF)   << 16)
-					| (0xFF << 24);
-}
-
-void screenCopy(CScreenDevice* screen, u32* ts)
+void screenCopy(CScreenDevice* screen)
 {
+	static const tic80_scale Scale = {SCREEN_SCALE, SCREEN_FILTER, SCREEN_SCANLINES, SCREEN_MASK, false};
+
 	u32 pitch = screen->GetPitch();
 	u32* buf = screen->GetBuffer();
-	for (int y = 0; y<136;y++)
-	for (int x = 0; x<240;x++)
-	{
-		u32 p = ts[(y+4)*(8+240+8)+(x+8)];
-		buf[pitch*y + x] = rgbaToBgra(p);
-	}
+	tic_scale(&frame, &Scale, TIC80_PIXEL_COLOR_XRGB8888, buf, pitch * sizeof(u32));
 
 	// single pixel mouse pointer, disappear after 10 seconds unmoved
 	if (mouseTime<600)
 	{
-		u32 midx =  pitch*(mousey)+mousex;
+		u32 midx =  pitch*(mousey*SCREEN_SCALE)+mousex*SCREEN_SCALE;
 		buf[midx]= 0xffffff;
 	}
-
-	// memcpy(screen->GetBuffer(), tic->screen, 240*136*4); would have been too good
 }
 
 
@@ -441,6 +430,8 @@ TShutdownMode Run(void)
 	tic80_input* tic_input = &tic->ram.input;
 	tic_input->keyboard.data = 0;
 
+	tic_output_indexed(tic, &frame);
+
 
 	// sound system
 	mSound->AllocateQueue(1000);
@@ -464,7 +455,7 @@ TShutdownMode Run(void)
 
 		mScreen.vsync();
 
-		screenCopy(&mScreen, platform.studio->tic->screen);
+		screenCopy(&mScreen);
 
 		mScheduler.Yield(); // for sound
 	}
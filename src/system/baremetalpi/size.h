@@ -4,5 +4,11 @@
 #define SCREEN_WIDTH 240
 #define SCREEN_HEIGHT 136
 
+// CPU scaler settings, see tic80_scale
+#define SCREEN_SCALE 1
+#define SCREEN_FILTER TIC80_SCALE_NEAREST
+#define SCREEN_SCANLINES 0
+#define SCREEN_MASK 0
+
 #endif
 
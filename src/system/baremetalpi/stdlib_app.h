@@ -94,7 +94,7 @@ class CStdlibAppScreen : public CStdlibApp
 public:
         CStdlibAppScreen(const char *kernel)
                 : CStdlibApp (kernel),
-                  mScreen (SCREEN_WIDTH, SCREEN_HEIGHT),
+                  mScreen (SCREEN_WIDTH*SCREEN_SCALE, SCREEN_HEIGHT*SCREEN_SCALE),
 //                  mScreen (240, 136),
 		mSerial(&mInterrupt),
                   mTimer (&mInterrupt),
@@ -45,7 +45,7 @@ static       CDeviceNameService mDeviceNameService;
 static        CNullDevice        mNullDevice;
 static        CExceptionHandler  mExceptionHandler;
 static        CInterruptSystem   mInterrupt;
-static	CScreenDevice      mScreen(SCREEN_WIDTH, SCREEN_HEIGHT);
+static	CScreenDevice      mScreen(SCREEN_WIDTH*SCREEN_SCALE, SCREEN_HEIGHT*SCREEN_SCALE);
 static        CSerialDevice      mSerial(&mInterrupt);
 static        CTimer             mTimer(&mInterrupt);
 static        CLogger		mLogger(LogWarning /*mOptions.GetLogLevel ()*/, &mTimer);
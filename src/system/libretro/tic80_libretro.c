@@ -20,7 +20,7 @@
 // How long to wait before hiding the mouse.
 #define TIC_LIBRETRO_MOUSE_HIDE_TIMER_START 300
 
-static uint32_t *frame_buf;
+static tic80_pixel_color_format pixel_format;
 static struct retro_log_callback logging;
 static retro_log_printf_t log_cb;
 static retro_video_refresh_t video_cb;
@@ -91,9 +91,6 @@ static void tic80_libretro_fallback_log(enum retro_log_level level, const char *
  */
 void retro_init(void)
 {
-	// Create the frame buffer.
-	frame_buf = calloc(TIC80_FULLWIDTH * TIC80_FULLHEIGHT, sizeof(uint32_t));
-
 	// Initialize the keyboard mappings.
 	state.keymap[RETROK_UNKNOWN] = tic_key_unknown;
 	state.keymap[RETROK_a] = tic_key_a;
@@ -195,9 +192,6 @@ void retro_init(void)
  */
 void retro_deinit(void)
 {
-	// Clear out the frame buffer.
-	free(frame_buf);
-	frame_buf = NULL;
 }
 
 /**
@@ -558,29 +552,6 @@ static void tic80_libretro_update(tic80* game)
 	tic80_tick(game, state.input);
 }
 
-/**
- * Convert between argb8888 and abgr8888.
- *
- * This was copied from libretro-common's scaler.c:
- * https://github.com/libretro/libretro-common/blob/master/gfx/scaler/scaler.c
- *
- * @see tic80_libretro_draw()
- */
-void tic80_libretro_conv_argb8888_abgr8888(uint32_t *output, uint32_t *input,
-	int width, int height,
-	int out_stride, int in_stride)
-{
-	int h, w;
-	for (h = 0; h < height; h++, output += out_stride >> 2, input += in_stride >> 2) {
-		for (w = 0; w < width; w++) {
-			uint32_t col = input[w];
-			output[w] = ((col << 16) & 0xff0000) | 
-				((col >> 16) & 0xff) |
-				(col & 0xff00ff00);
-		}
-	}
-}
-
 /**
  * Draw the screen.
  */
@@ -589,13 +560,8 @@ static void tic80_libretro_draw(tic80* game)
 	// Mouse Cursor
 	tic80_libretro_mousecursor((tic80_local*)game, &state.input.mouse, state.mouseCursor);
 
-	// TIC-80 uses ABGR8888, so we need to convert it.
-	tic80_libretro_conv_argb8888_abgr8888(frame_buf, game->screen,
-		TIC80_FULLWIDTH, TIC80_FULLHEIGHT,
-		TIC80_FULLWIDTH << 2, TIC80_FULLWIDTH << 2);
-
-	// Render to the screen.
-	video_cb(frame_buf, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, TIC80_FULLWIDTH << 2);
+	// The core blits in the frontend's pixel format, so no conversion is needed.
+	video_cb(game->screen, TIC80_FULLWIDTH, TIC80_FULLHEIGHT, game->pitch);
 }
 
 /**
@@ -688,11 +654,17 @@ bool retro_load_game(const struct retro_game_info *info)
 	// TODO: Warn that Audio Synchronization required to run at a proper speed.
 	// TODO: Warn that the core doesn't support Runahead.
 
-	// Pixel format.
+	// Pixel format, the core blits straight into either of them.
 	enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+	pixel_format = TIC80_PIXEL_COLOR_XRGB8888;
 	if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt)) {
-		log_cb(RETRO_LOG_INFO, "[TIC-80] RETRO_PIXEL_FORMAT_XRGB8888 is not supported.\n");
-		return false;
+		log_cb(RETRO_LOG_INFO, "[TIC-80] RETRO_PIXEL_FORMAT_XRGB8888 is not supported, trying RGB565.\n");
+		fmt = RETRO_PIXEL_FORMAT_RGB565;
+		pixel_format = TIC80_PIXEL_COLOR_RGB565;
+		if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt)) {
+			log_cb(RETRO_LOG_INFO, "[TIC-80] RETRO_PIXEL_FORMAT_RGB565 is not supported.\n");
+			return false;
+		}
 	}
 
 	// Update the input button descriptions.
@@ -714,7 +686,7 @@ bool retro_load_game(const struct retro_game_info *info)
 	retro_unload_game();
 
 	// Set up the TIC-80 environment.
-	tic = tic80_create(TIC80_SAMPLERATE);
+	tic = tic80_create_ex(TIC80_SAMPLERATE, pixel_format);
 	tic->callback.exit = tic80_libretro_exit;
 	tic->callback.error = tic80_libretro_error;
 	tic->callback.trace = tic80_libretro_trace;
@@ -25,6 +25,7 @@
 #include "tools.h"
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -112,6 +113,10 @@ static struct
 
 	Net* net;
 
+	tic80_pacer* pacer;
+	// studio ticks due this frame, more than one when late, none on displays faster than 60Hz with vsync
+	s32 frames;
+
 	bool missedFrame;
 	bool inBackground;
 
@@ -120,10 +125,12 @@ static struct
 		SDL_AudioSpec 		spec;
 		SDL_AudioDeviceID 	device;
 		SDL_AudioCVT 		cvt;
+		tic80_audio_sync*	sync;
 	} audio;
 } platform =
 {
 	.touch = { .counter = TOUCH_TIMEOUT },
+	.frames = 1,
 };
 
 static inline bool crtMonitorEnabled()
@@ -145,10 +152,20 @@ static void initSound()
 
 	SDL_BuildAudioCVT(&platform.audio.cvt, want.format, want.channels, platform.audio.spec.freq, platform.audio.spec.format, platform.audio.spec.channels, platform.audio.spec.freq);
 
+	// room for two frames of stereo samples, the rate control only adds a few
 	if(platform.audio.cvt.needed)
+		platform.audio.cvt.buf = SDL_malloc(platform.audio.spec.freq * TIC_STEREO_CHANNELS * sizeof(s16) * 2 / TIC80_FRAMERATE * platform.audio.cvt.len_mult);
+
+	if(platform.audio.device)
 	{
-		platform.audio.cvt.len = platform.audio.spec.freq * platform.audio.spec.channels * sizeof(s16) / TIC80_FRAMERATE;
-		platform.audio.cvt.buf = SDL_malloc(platform.audio.cvt.len * platform.audio.cvt.len_mult);
+		// holds a device buffer and two frames queued
+		const tic80_audio_sync_config sync = 
+		{
+			.samplerate = platform.audio.spec.freq,
+			.latency = (u32)((u64)platform.audio.spec.samples * 1000000 / platform.audio.spec.freq + 2 * 1000000 / TIC80_FRAMERATE),
+		};
+
+		platform.audio.sync = tic80_audio_sync_create(&sync);
 	}
 }
 
@@ -353,7 +370,7 @@ static void initGPU()
 
 		GPU_SetInitWindow(SDL_GetWindowID(platform.window));
 
-		platform.gpu.screen = GPU_Init(w, h, GPU_INIT_DISABLE_VSYNC);
+		platform.gpu.screen = GPU_Init(w, h, platform.studio->config()->vsync ? GPU_INIT_ENABLE_VSYNC : GPU_INIT_DISABLE_VSYNC);
 
 		GPU_SetWindowResolution(w, h);
 	}
@@ -979,11 +996,22 @@ static void blitGpuTexture(GPU_Target* screen, GPU_Image* texture)
 static void blitSound()
 {
 	tic_mem* tic = platform.studio->tic;
+	const SDL_AudioSpec* spec = &platform.audio.spec;
+
+	if(!platform.audio.sync)
+		return;
 
-	SDL_PauseAudioDevice(platform.audio.device, 0);
+	// the correction is for the next tick, this one's samples are made
+	{
+		s32 queued = SDL_GetQueuedAudioSize(platform.audio.device) / (spec->channels * SDL_AUDIO_BITSIZE(spec->format) / 8);
+
+		tic_sound_rate(tic, tic80_audio_sync_update(platform.audio.sync, queued));
+		SDL_PauseAudioDevice(platform.audio.device, tic80_audio_sync_report(platform.audio.sync).filling);
+	}
 	
 	if(platform.audio.cvt.needed)
 	{
+		platform.audio.cvt.len = tic->samples.size;
 		SDL_memcpy(platform.audio.cvt.buf, tic->samples.buffer, tic->samples.size);
 		SDL_ConvertAudio(&platform.audio.cvt);
 		SDL_QueueAudio(platform.audio.device, platform.audio.cvt.buf, platform.audio.cvt.len_cvt);
@@ -1168,6 +1196,7 @@ static void renderCursor()
 	else
 	{
 		SDL_ShowCursor(SDL_DISABLE);
+		tic_ram_touch(platform.studio->tic, offsetof(tic_ram, sprites), sizeof(tic_tiles));
 		blitCursor(platform.studio->tic->ram.sprites.data[platform.studio->tic->ram.vram.vars.cursor.sprite].data);
 	}
 
@@ -1442,7 +1471,14 @@ static void gpuTick()
 	GPU_Clear(platform.gpu.screen);
 
 	{
-		platform.studio->tick();
+		for(s32 i = 0; i < platform.frames; i++)
+		{
+			platform.studio->tick();
+			blitSound();
+		}
+
+		if(platform.pacer && platform.studio->config()->showSync)
+			tic80_pacer_graph(platform.pacer, TIC80_PIXEL_COLOR_ABGR8888, tic->screen, TIC80_FULLWIDTH * sizeof(u32));
 
 		GPU_UpdateImageBytes(platform.gpu.texture, NULL, (const u8*)tic->screen, TIC80_FULLWIDTH * sizeof(u32));
 
@@ -1491,8 +1527,6 @@ static void gpuTick()
 	}
 
 	GPU_Flip(platform.gpu.screen);
-
-	blitSound();
 }
 
 #if defined(__EMSCRIPTEN__)
@@ -1552,28 +1586,28 @@ static s32 start(s32 argc, char **argv, const char* folder)
 
 #else
 	{
-		u64 nextTick = SDL_GetPerformanceCounter();
-		const u64 Delta = SDL_GetPerformanceFrequency() / TIC80_FRAMERATE;
+		const StudioConfig* config = platform.studio->config();
 
-		while (!platform.studio->quit)
+		tic80_pacer_config pacer = 
 		{
-			platform.missedFrame = false;
+			.spin = config->frameSpin > 0 ? config->frameSpin : 0,
+			.vsync = config->vsync,
+		};
 
-			nextTick += Delta;
-			
-			gpuTick();
+		platform.pacer = tic80_pacer_create(&pacer);
 
-			{
-				s64 delay = nextTick - SDL_GetPerformanceCounter();
+		while (!platform.studio->quit && platform.pacer)
+		{
+			u32 missed = tic80_pacer_report(platform.pacer).missed;
 
-				if(delay < 0)
-				{
-					nextTick -= delay;
-					platform.missedFrame = true;
-				}
-				else SDL_Delay((u32)(delay * 1000 / SDL_GetPerformanceFrequency()));
-			}
+			gpuTick();
+
+			platform.frames = tic80_pacer_wait(platform.pacer);
+			platform.missedFrame = tic80_pacer_report(platform.pacer).missed != missed;
 		}
+
+		tic80_pacer_delete(platform.pacer);
+		platform.pacer = NULL;
 	}
 
 #endif
@@ -1585,6 +1619,8 @@ static s32 start(s32 argc, char **argv, const char* folder)
 	if(platform.audio.cvt.buf)
 		SDL_free(platform.audio.cvt.buf);
 
+	tic80_audio_sync_delete(platform.audio.sync);
+
 	destroyGPU();
 
 	if(platform.keyboard.texture.downPixels)
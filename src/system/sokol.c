@@ -48,6 +48,8 @@ static struct
 
     Net* net;
 
+	tic80_pacer* pacer;
+
 } platform;
 
 static void setClipboardText(const char* text)
@@ -158,7 +160,12 @@ static void app_init(void)
 {
 	sokol_gfx_init(TIC80_FULLWIDTH, TIC80_FULLHEIGHT, 1, 1, false, true);
 
-	platform.audio.samples = calloc(sizeof platform.audio.samples[0], saudio_sample_rate() / TIC80_FRAMERATE * TIC_STEREO_CHANNELS);
+	// room for two frames, the sample count isn't quite the same every frame
+	platform.audio.samples = calloc(sizeof platform.audio.samples[0], saudio_sample_rate() * 2 / TIC80_FRAMERATE * TIC_STEREO_CHANNELS);
+
+	// frames come at the display rate with vsync, the pacer turns them into 60 ticks a second
+	tic80_pacer_config pacer = {.vsync = true};
+	platform.pacer = tic80_pacer_create(&pacer);
 }
 
 static void handleKeyboard()
@@ -185,17 +192,24 @@ static void app_frame(void)
 
 	input->gamepads.data = 0;
 	handleKeyboard();
-	platform.studio->tick();
 
-	sokol_gfx_draw(platform.studio->tic->screen);
+	for(s32 frames = platform.pacer ? tic80_pacer_wait(platform.pacer) : 1; frames > 0; frames--)
+	{
+		platform.studio->tick();
+
+		s32 count = tic->samples.size / sizeof tic->samples.buffer[0];
+		for(s32 i = 0; i < count; i++)
+			platform.audio.samples[i] = (float)tic->samples.buffer[i] / SHRT_MAX;
 
-	s32 count = tic->samples.size / sizeof tic->samples.buffer[0];
-	for(s32 i = 0; i < count; i++)
-		platform.audio.samples[i] = (float)tic->samples.buffer[i] / SHRT_MAX;
+		saudio_push(platform.audio.samples, count / 2);
 
-	saudio_push(platform.audio.samples, count / 2);
-	
-	input->mouse.scrollx = input->mouse.scrolly = 0;
+		input->mouse.scrollx = input->mouse.scrolly = 0;
+	}
+
+	if(platform.pacer && platform.studio->config()->showSync)
+		tic80_pacer_graph(platform.pacer, TIC80_PIXEL_COLOR_ABGR8888, tic->screen, TIC80_FULLWIDTH * sizeof(u32));
+
+	sokol_gfx_draw(platform.studio->tic->screen);
 }
 
 static void handleKeydown(sapp_keycode keycode, bool down)
@@ -396,6 +410,7 @@ static void app_cleanup(void)
 	platform.studio->close();
 	closeNet(platform.net);
 	free(platform.audio.samples);
+	tic80_pacer_delete(platform.pacer);
 }
 
 sapp_desc sokol_main(s32 argc, char* argv[])
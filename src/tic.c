@@ -30,6 +30,8 @@
 #include "ticapi.h"
 #include "tools.h"
 #include "machine.h"
+#include "cart.h"
+#include "mapquery.h"
 #include "ext/gif.h"
 
 #define CLOCKRATE (255<<13)
@@ -41,36 +43,6 @@
 #define CLAMP(v,a,b) (MIN(MAX(v,a),b))
 #define PIANO_START 8
 
-typedef enum
-{
-	CHUNK_DUMMY, 	// 0
-	CHUNK_TILES, 	// 1
-	CHUNK_SPRITES, 	// 2
-	CHUNK_COVER, 	// 3
-	CHUNK_MAP, 		// 4
-	CHUNK_CODE, 	// 5
-	CHUNK_FLAGS,	// 6
-	CHUNK_TEMP2, 	// 7
-	CHUNK_TEMP3,	// 8
-	CHUNK_SAMPLES,	// 9
-	CHUNK_WAVEFORM,	// 10
-	CHUNK_TEMP4,	// 11
-	CHUNK_PALETTE, 	// 12
-	CHUNK_PATTERNS_DEP, // 13 - deprecated chunk
-	CHUNK_MUSIC,	// 14
-	CHUNK_PATTERNS, // 15
-} ChunkType;
-
-typedef struct
-{
-	ChunkType type:5;
-	u32 bank:TIC_BANK_BITS;
-	u32 size:16; // max chunk size is 64K
-	u32 temp:8;
-} Chunk;
-
-STATIC_ASSERT(tic_bank_bits, TIC_BANK_BITS == 3);
-STATIC_ASSERT(tic_chunk_size, sizeof(Chunk) == 4);
 STATIC_ASSERT(tic_map, sizeof(tic_map) < 1024*32);
 STATIC_ASSERT(tic_sample, sizeof(tic_sample) == 66);
 STATIC_ASSERT(tic_track_pattern, sizeof(tic_track_pattern) == 3*MUSIC_PATTERN_ROWS);
@@ -161,7 +133,7 @@ static void runNoise(blip_buffer_t* blip, tic_sound_register* reg, tic_sound_reg
 static void resetPalette(tic_mem* memory)
 {
 	static const u8 DefaultMapping[] = {16, 50, 84, 118, 152, 186, 220, 254};
-	memcpy(memory->ram.vram.palette.data, memory->cart.bank0.palette.data, sizeof(tic_palette));
+	memcpy(memory->ram.vram.palette.data, memory->cart->bank0.palette.data, sizeof(tic_palette));
 	memcpy(memory->ram.vram.mapping, DefaultMapping, sizeof DefaultMapping);
 }
 
@@ -175,33 +147,40 @@ static void setPixelDma(tic_mem* tic, s32 x, s32 y, u8 color)
 	tic_tool_poke4(tic->ram.vram.screen.data, y * TIC80_WIDTH + x, color);
 }
 
-static inline u32* getOvrAddr(tic_mem* tic, s32 x, s32 y)
+static inline void setOvrMask(u8* mask, s32 start, s32 end)
 {
-	enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2};
-	enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2};
+	for(; start < end && (start & 7); start++)
+		mask[start >> 3] |= 1 << (start & 7);
 
-	return tic->screen + x + (y << TIC80_FULLWIDTH_BITS) + (Left + Top * TIC80_FULLWIDTH);
+	for(; start + BITS_IN_BYTE <= end; start += BITS_IN_BYTE)
+		mask[start >> 3] = 0xff;
+
+	for(; start < end; start++)
+		mask[start >> 3] |= 1 << (start & 7);
 }
 
 static void setPixelOvr(tic_mem* tic, s32 x, s32 y, u8 color)
 {
 	tic_machine* machine = (tic_machine*)tic;
-	
-	*getOvrAddr(tic, x, y) = *(machine->state.ovr.palette + color);
+	s32 index = y * TIC80_WIDTH + x;
+
+	tic_tool_poke4(machine->state.ovr.data, index, color);
+	setOvrMask(machine->state.ovr.mask, index, index + 1);
 }
 
 static u8 getPixelOvr(tic_mem* tic, s32 x, s32 y)
 {
 	tic_machine* machine = (tic_machine*)tic;
-	
-	u32 color = *getOvrAddr(tic, x, y);
-	u32* pal = machine->state.ovr.palette;
+	s32 index = y * TIC80_WIDTH + x;
 
-	for(s32 i = 0; i < TIC_PALETTE_SIZE; i++, pal++)
-		if(*pal == color)
-			return i;
+	if(machine->state.ovr.mask[index >> 3] & 1 << (index & 7))
+		return tic_tool_peek4(machine->state.ovr.data, index);
 
-	return 0;
+	// what the blit put under the overlay
+	x = (x + tic->ram.vram.vars.offset.x + TIC80_WIDTH * 2) % TIC80_WIDTH;
+	y = (y + tic->ram.vram.vars.offset.y + TIC80_HEIGHT * 2) % TIC80_HEIGHT;
+
+	return tic_tool_peek4(tic->ram.vram.screen.data, y * TIC80_WIDTH + x);
 }
 
 static u8 getPixelDma(tic_mem* tic, s32 x, s32 y)
@@ -225,31 +204,36 @@ static u8 getPixel(tic_machine* machine, s32 x, s32 y)
 	return machine->state.getpix(&machine->memory, x, y);
 }
 
-static void drawHLineDma(tic_mem* memory, s32 xl, s32 xr, s32 y, u8 color)
+static void drawHLineBuffer(u8* buffer, s32 xl, s32 xr, s32 y, u8 color)
 {
 	color = color << 4 | color;
 	if (xl >= xr) return;
 	if (xl & 1) {
-		tic_tool_poke4(&memory->ram.vram.screen.data, y * TIC80_WIDTH + xl, color);
+		tic_tool_poke4(buffer, y * TIC80_WIDTH + xl, color);
 		xl++;
 	}
 	s32 count = (xr - xl) >> 1;
-	u8 *screen = memory->ram.vram.screen.data + ((y * TIC80_WIDTH + xl) >> 1);
+	u8 *screen = buffer + ((y * TIC80_WIDTH + xl) >> 1);
 	for(s32 i = 0; i < count; i++) *screen++ = color;
 	if (xr & 1) {
-		tic_tool_poke4(&memory->ram.vram.screen.data, y * TIC80_WIDTH + xr - 1, color);
+		tic_tool_poke4(buffer, y * TIC80_WIDTH + xr - 1, color);
 	}
 }
 
-static void drawHLineOvr(tic_mem* tic, s32 x1, s32 x2, s32 y, u8 color)
+static void drawHLineDma(tic_mem* memory, s32 xl, s32 xr, s32 y, u8 color)
 {
-	tic_machine* machine = (tic_machine*)tic;
-	u32 final_color = *(machine->state.ovr.palette + color);
-	for(s32 x = x1; x < x2; ++x) {
-		*getOvrAddr(tic, x, y) = final_color;
-	}
+	drawHLineBuffer(memory->ram.vram.screen.data, xl, xr, y, color);
 }
 
+static void drawHLineOvr(tic_mem* tic, s32 xl, s32 xr, s32 y, u8 color)
+{
+	tic_machine* machine = (tic_machine*)tic;
+
+	if (xl >= xr) return;
+
+	drawHLineBuffer(machine->state.ovr.data, xl, xr, y, color);
+	setOvrMask(machine->state.ovr.mask, y * TIC80_WIDTH + xl, y * TIC80_WIDTH + xr);
+}
 
 static void drawHLine(tic_machine* machine, s32 x, s32 y, s32 width, u8 color)
 {
@@ -542,9 +526,11 @@ static void api_reset(tic_mem* memory)
 	soundClear(memory);
 
 	tic_machine* machine = (tic_machine*)memory;
+	machine->restarted |= machine->state.initialized;
 	machine->state.initialized = false;
 	machine->state.scanline = NULL;
 	machine->state.ovr.callback = NULL;
+	memset(machine->state.raster.mask, 0, sizeof machine->state.raster.mask);
 
 	machine->state.setpix = setPixelDma;
 	machine->state.getpix = getPixelDma;
@@ -553,36 +539,280 @@ static void api_reset(tic_mem* memory)
 	updateSaveid(memory);
 }
 
+// the first TIC_RAM_VIEWS sections are switched by pointing at the bank, the rest are small enough to copy
+static const struct {s32 bank; s32 ram; s32 size;} SyncSections[] = 
+{
+	{offsetof(tic_bank, tiles), 	offsetof(tic_ram, tiles), 			sizeof(tic_tiles)	},
+	{offsetof(tic_bank, sprites),	offsetof(tic_ram, sprites), 		sizeof(tic_tiles)	},
+	{offsetof(tic_bank, map), 		offsetof(tic_ram, map), 			sizeof(tic_map)		},
+	{offsetof(tic_bank, sfx), 		offsetof(tic_ram, sfx), 			sizeof(tic_sfx)		},
+	{offsetof(tic_bank, music), 	offsetof(tic_ram, music), 			sizeof(tic_music)	},
+	{offsetof(tic_bank, palette), 	offsetof(tic_ram, vram.palette), 	sizeof(tic_palette)	},
+	{offsetof(tic_bank, flags), 	offsetof(tic_ram, flags), 			sizeof(tic_flags)	},
+};
+
+// fills in the ram of the switched sections overlapping the range
+void tic_ram_touch(tic_mem* memory, u32 address, s32 size)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	for(s32 i = 0; i < TIC_RAM_VIEWS; i++)
+	{
+		const u8* view = machine->views[i];
+
+		if(view && address < SyncSections[i].ram + SyncSections[i].size && address + size > SyncSections[i].ram)
+		{
+			memcpy((u8*)&memory->ram + SyncSections[i].ram, view, SyncSections[i].size);
+			machine->views[i] = NULL;
+		}
+	}
+}
+
+static void flushViews(tic_mem* memory)
+{
+	tic_ram_touch(memory, 0, sizeof(tic_ram));
+}
+
+static void dropViews(tic_machine* machine)
+{
+	memset(machine->views, 0, sizeof machine->views);
+}
+
+// where the renderer reads a section it was given from
+static const void* ramView(tic_mem* memory, const void* src)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	for(s32 i = 0; i < TIC_RAM_VIEWS; i++)
+		if(machine->views[i] && src == (u8*)&memory->ram + SyncSections[i].ram)
+			return machine->views[i];
+
+	return src;
+}
+
 static void api_pause(tic_mem* memory)
 {
 	tic_machine* machine = (tic_machine*)memory;
 
-	memcpy(&machine->pause.state, &machine->state, sizeof(tic_machine_state_data));
-	memcpy(&machine->pause.ram, &memory->ram, sizeof(tic_ram));
+	if(!machine->pause)
+		machine->pause = malloc(sizeof(tic_pause_data));
+
+	if(machine->pause)
+	{
+		flushViews(memory);
+
+		memcpy(&machine->pause->state, &machine->state, sizeof(tic_machine_state_data));
+		memcpy(&machine->pause->ram, &memory->ram, sizeof(tic_ram));
 
-	machine->pause.time.start = machine->data->start;
-	machine->pause.time.paused = machine->data->counter();
+		machine->pause->time.start = machine->data->start;
+		machine->pause->time.paused = machine->data->counter();
+	}
 }
 
 static void api_resume(tic_mem* memory)
 {
 	tic_machine* machine = (tic_machine*)memory;
 
-	if (machine->data)
+	if (machine->data && machine->pause)
 	{
-		memcpy(&machine->state, &machine->pause.state, sizeof(tic_machine_state_data));
-		memcpy(&memory->ram, &machine->pause.ram, sizeof(tic_ram));
+		dropViews(machine);
+
+		memcpy(&machine->state, &machine->pause->state, sizeof(tic_machine_state_data));
+		memcpy(&memory->ram, &machine->pause->ram, sizeof(tic_ram));
 
-		machine->data->start = machine->pause.time.start + machine->data->counter() - machine->pause.time.paused;
+		machine->data->start = machine->pause->time.start + machine->data->counter() - machine->pause->time.paused;
 	}
 }
 
-void tic_close(tic_mem* memory)
+struct tic_snapshot
+{
+	// a shared cart is compared by address, any other one is copied
+	const tic_shared_cart* shared;
+	tic_cartridge* cart;
+	tic_ram ram;
+	tic_machine_state_data state;
+	u8 input;
+	char* code;
+	u32 image;
+};
+
+static void dropSnapshot(tic_machine* machine)
+{
+	if(machine->snapshot)
+	{
+		tic_heap_drop(&machine->heap, machine->snapshot->image);
+		free(machine->snapshot->cart);
+		free(machine->snapshot->code);
+		free(machine->snapshot);
+		machine->snapshot = NULL;
+	}
+}
+
+// carts loaded from the same bytes are parsed once and shared by every machine running them,
+// nothing here is locked, include/tic80.h asks for every instance to stay on one thread
+struct tic_shared_cart
+{
+	tic_cartridge cart;
+	s32 refs;
+	u32 hash;
+
+	// kept packed, banks are decoded on the first sync
+	u8* data;
+	s32 size;
+	u8 pending;
+
+	tic_shared_cart* next;
+};
+
+static tic_shared_cart* SharedCarts = NULL;
+
+static tic_shared_cart* acquireSharedCart(const u8* buffer, s32 size)
+{
+	u32 hash = tic_cart_hash(buffer, size);
+
+	// the bytes are only compared when the hash matches
+	for(tic_shared_cart* shared = SharedCarts; shared; shared = shared->next)
+		if(shared->hash == hash && shared->size == size && memcmp(shared->data, buffer, size) == 0)
+		{
+			shared->refs++;
+			return shared;
+		}
+
+	// calloc'd, so the banks not decoded yet cost nothing
+	tic_shared_cart* shared = calloc(1, sizeof(tic_shared_cart));
+
+	if(shared)
+	{
+		shared->data = malloc(size);
+
+		if(shared->data)
+		{
+			memcpy(shared->data, buffer, size);
+
+			shared->size = size;
+			shared->hash = hash;
+			shared->refs = 1;
+			shared->next = SharedCarts;
+			SharedCarts = shared;
+
+			tic_cart_load_bank(&shared->cart, shared->data, size, 0);
+			shared->pending = ((1 << TIC_BANKS) - 1) & ~1;
+
+			return shared;
+		}
+
+		free(shared);
+	}
+
+	return NULL;
+}
+
+static void releaseSharedCart(tic_shared_cart* shared)
+{
+	if(shared && --shared->refs == 0)
+	{
+		for(tic_shared_cart** link = &SharedCarts; *link; link = &(*link)->next)
+			if(*link == shared)
+			{
+				*link = shared->next;
+				break;
+			}
+
+		free(shared->data);
+		free(shared);
+	}
+}
+
+static void decodeBank(tic_shared_cart* shared, s32 bank)
+{
+	if(shared && (shared->pending & (1 << bank)))
+	{
+		tic_cart_load_bank(&shared->cart, shared->data, shared->size, bank);
+		shared->pending &= ~(1 << bank);
+	}
+}
+
+// gives the machine its own copy of the cart before it's written to
+static bool ownCart(tic_machine* machine)
+{
+	if(machine->shared)
+	{
+		if(!machine->own)
+			machine->own = malloc(sizeof(tic_cartridge));
+
+		if(!machine->own) return false;
+
+		for(s32 i = 0; i < TIC_BANKS; i++)
+			decodeBank(machine->shared, i);
+
+		memcpy(machine->own, &machine->shared->cart, sizeof(tic_cartridge));
+
+		for(s32 i = 0; i < TIC_RAM_VIEWS; i++)
+			if(machine->views[i])
+				machine->views[i] = (u8*)machine->own + (machine->views[i] - (u8*)&machine->shared->cart);
+
+		releaseSharedCart(machine->shared);
+		dropSnapshot(machine);
+
+		machine->shared = NULL;
+		machine->memory.cart = machine->own;
+	}
+
+	return true;
+}
+
+static void useSharedCart(tic_machine* machine, tic_shared_cart* shared)
+{
+	if(shared != machine->shared)
+		dropSnapshot(machine);
+
+	releaseSharedCart(machine->shared);
+	free(machine->own);
+
+	machine->shared = shared;
+	machine->own = NULL;
+	machine->memory.cart = &shared->cart;
+}
+
+void tic_load_shared(tic_mem* memory, const void* buffer, s32 size)
 {
 	tic_machine* machine = (tic_machine*)memory;
 
-	machine->state.initialized = false;
+	flushViews(memory);
+	tic_shared_cart* shared = acquireSharedCart(buffer, size);
+
+	if(shared)
+		useSharedCart(machine, shared);
+	else if(ownCart(machine))
+		tic_cart_load(memory->cart, buffer, size);
+}
+
+// the shared cart keeps a copy, a mapping kept open would fault on access once the file is truncated
+bool tic_load_file(tic_mem* memory, const char* path)
+{
+	s32 size = 0;
+	void* data = tic_cart_map(path, &size);
+
+	if(!data)
+		return false;
+
+	tic_load_shared(memory, data, size);
+	tic_cart_unmap(data, size);
+
+	return true;
+}
+
+tic_bank* tic_load_bank(tic_mem* memory, s32 bank)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	decodeBank(machine->shared, bank);
+
+	return &memory->cart->banks[bank];
+}
 
+static void closeScripts(tic_mem* memory)
+{
 #if defined(TIC_BUILD_WITH_SQUIRREL)
 	getSquirrelScriptConfig()->close(memory);
 #endif
@@ -608,11 +838,30 @@ void tic_close(tic_mem* memory)
 #if defined(TIC_BUILD_WITH_WREN)
 	getWrenScriptConfig()->close(memory);
 #endif
+}
+
+void tic_close(tic_mem* memory)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	machine->state.initialized = false;
+
+	closeScripts(memory);
+	dropSnapshot(machine);
+
+	releaseSharedCart(machine->shared);
+	free(machine->own);
+	free(machine->pause);
+	tic_map_query_delete(machine->query);
 
 	blip_delete(machine->blip.left);
 	blip_delete(machine->blip.right);
 
 	free(memory->samples.buffer);
+
+	if(!memory->output.external)
+		free(memory->screen);
+
 	free(machine);
 }
 
@@ -644,21 +893,117 @@ static void api_clear(tic_mem* memory, u8 color)
 	}
 }
 
+static void buildGlyph(const u8* ptr, s32 width, tic_glyph* glyph)
+{
+	s32 start = 0;
+	s32 end = width;
+	s32 i = 0;
+
+	for(s32 col = 0; col < width; col++)
+	{
+		for(i = 0; i < TIC_FONT_HEIGHT; i++)
+			if(*(ptr + i) & 0b10000000 >> col) break;
+
+		if(i < TIC_FONT_HEIGHT)	break; else start++;
+	}
+
+	for(s32 col = width - 1; col >= start; col--)
+	{
+		for(i = 0; i < TIC_FONT_HEIGHT; i++)
+			if(*(ptr + i) & 0b10000000 >> col) break;
+
+		if(i < TIC_FONT_HEIGHT)	break; else end--;
+	}
+
+	glyph->start = start;
+	glyph->end = end;
+	glyph->count = 0;
+
+	for(s32 row = 0; row < TIC_FONT_HEIGHT; row++, ptr++)
+		for(s32 col = 0; col < width; col++)
+			if(*ptr & 0b10000000 >> col)
+			{
+				tic_glyph_span* span = &glyph->spans[glyph->count++];
+				span->x = col;
+				span->y = row;
+
+				while(col < width && *ptr & 0b10000000 >> col) col++;
+
+				span->width = col - span->x;
+			}
+}
+
+void tic_font_touch(tic_mem* memory)
+{
+	((tic_machine*)memory)->glyphs.ready = false;
+}
+
+static void updateGlyphs(tic_mem* memory)
+{
+	tic_glyph_cache* cache = &((tic_machine*)memory)->glyphs;
+
+	if(cache->ready)
+		return;
+
+	for(s32 i = 0; i < TIC_FONT_CHARS; i++)
+		buildGlyph(memory->font.data + i*BITS_IN_BYTE, TIC_FONT_WIDTH, &cache->glyphs[false][i]);
+
+	for(s32 i = 0; i < TIC_FONT_CHARS / 2; i++)
+		buildGlyph(memory->font.data + (i + TIC_FONT_CHARS / 2)*BITS_IN_BYTE, TIC_ALTFONT_WIDTH, &cache->glyphs[true][i]);
+
+	cache->ready = true;
+}
+
+static const tic_glyph* getGlyph(tic_mem* memory, u8 symbol, bool alt, tic_glyph* temp)
+{
+	// alt symbols above 127 run past the font and can't be cached
+	if(alt && symbol >= TIC_FONT_CHARS / 2)
+	{
+		buildGlyph(memory->font.data + (symbol + TIC_FONT_CHARS / 2)*BITS_IN_BYTE, TIC_ALTFONT_WIDTH, temp);
+		return temp;
+	}
+
+	return &((tic_machine*)memory)->glyphs.glyphs[alt][symbol];
+}
+
+static void drawGlyph(tic_machine* machine, const tic_glyph* glyph, s32 x, s32 y, u8 color, s32 scale)
+{
+	const tic_clip_data* clip = &machine->state.clip;
+	color = mapColor(&machine->memory, color);
+
+	for(const tic_glyph_span* span = glyph->spans, *end = span + glyph->count; span < end; span++)
+	{
+		s32 xl = x + span->x * scale;
+		s32 xr = MIN(xl + span->width * scale, clip->r);
+		xl = MAX(xl, clip->l);
+
+		if(xl >= xr) continue;
+
+		s32 yt = y + span->y * scale;
+		s32 yb = MIN(yt + scale, clip->b);
+
+		for(s32 ys = MAX(yt, clip->t); ys < yb; ys++)
+			machine->state.drawhline(&machine->memory, xl, xr, ys, color);
+	}
+}
+
 static s32 drawChar(tic_mem* memory, u8 symbol, s32 x, s32 y, s32 width, s32 height, u8 color, s32 scale, bool alt)
 {
-	const u8* ptr = memory->font.data + (symbol + (alt ? TIC_FONT_CHARS / 2 : 0))*BITS_IN_BYTE;
-	x += (BITS_IN_BYTE - 1)*scale;
+	const s32 FontWidth = alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH;
 
-	for(s32 i = 0, ys = y; i < TIC_FONT_HEIGHT; i++, ptr++, ys += scale)
-		for(s32 col = BITS_IN_BYTE - (alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH), xs = x - col; col < BITS_IN_BYTE; col++, xs -= scale)
-			if(*ptr & 1 << col)
-				api_rect(memory, xs, ys, scale, scale, color);
+	// scaled fixed glyphs have always been shifted right by the unused columns
+	x += (BITS_IN_BYTE - FontWidth) * (scale - 1);
 
-	return (alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH)*scale;
+	tic_glyph temp;
+	drawGlyph((tic_machine*)memory, getGlyph(memory, symbol, alt, &temp), x, y, color, scale);
+
+	return FontWidth*scale;
 }
 
 static s32 api_draw_char(tic_mem* memory, u8 symbol, s32 x, s32 y, u8 color, bool alt)
 {
+	updateGlyphs(memory);
+
 	return drawChar(memory, symbol, x, y, alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH, TIC_FONT_HEIGHT, color, 1, alt);
 }
 
@@ -686,53 +1031,33 @@ s32 drawText(tic_mem* memory, const char* text, s32 x, s32 y, s32 width, s32 hei
 
 static s32 api_fixed_text(tic_mem* memory, const char* text, s32 x, s32 y, u8 color, bool alt)
 {
+	updateGlyphs(memory);
+
 	return drawText(memory, text, x, y, alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH, TIC_FONT_HEIGHT, color, 1, drawChar, alt);
 }
 
 static s32 drawNonFixedChar(tic_mem* memory, u8 symbol, s32 x, s32 y, s32 width, s32 height, u8 color, s32 scale, bool alt)
 {
-	const u8* ptr = memory->font.data + (symbol + (alt ? TIC_FONT_CHARS / 2 : 0))*BITS_IN_BYTE;
-
-	const s32 FontWidth = alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH;
-
-	s32 start = 0;
-	s32 end = FontWidth;
-	s32 i = 0;
-
-	for(s32 col = 0; col < FontWidth; col++)
-	{
-		for(i = 0; i < TIC_FONT_HEIGHT; i++)
-			if(*(ptr + i) & 0b10000000 >> col) break;
-
-		if(i < TIC_FONT_HEIGHT)	break; else start++;
-	}
-
-	x -= start * scale;
-	
-	for(s32 col = FontWidth - 1; col >= start; col--)
-	{
-		for(i = 0; i < TIC_FONT_HEIGHT; i++)
-			if(*(ptr + i) & 0b10000000 >> col) break;
-
-		if(i < TIC_FONT_HEIGHT)	break; else end--;
-	}
+	tic_glyph temp;
+	const tic_glyph* glyph = getGlyph(memory, symbol, alt, &temp);
 
-	for(s32 ys = y, i = 0; i < TIC_FONT_HEIGHT; i++, ptr++, ys += scale)
-		for(s32 col = start, xs = x + start*scale; col < end; col++, xs += scale)
-			if(*ptr & 0b10000000 >> col)
-				api_rect(memory, xs, ys, scale, scale, color);
+	drawGlyph((tic_machine*)memory, glyph, x - glyph->start * scale, y, color, scale);
 
-	s32 size = end - start;
-	return (size ? size + 1 : FontWidth - 2) * scale;
+	s32 size = glyph->end - glyph->start;
+	return (size ? size + 1 : (alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH) - 2) * scale;
 }
 
 static s32 api_text(tic_mem* memory, const char* text, s32 x, s32 y, u8 color, bool alt)
 {
+	updateGlyphs(memory);
+
 	return drawText(memory, text, x, y, alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH, TIC_FONT_HEIGHT, color, 1, drawNonFixedChar, alt);
 }
 
 static s32 api_text_ex(tic_mem* memory, const char* text, s32 x, s32 y, u8 color, bool fixed, s32 scale, bool alt)
 {
+	updateGlyphs(memory);
+
 	return drawText(memory, text, x, y, alt ? TIC_ALTFONT_WIDTH : TIC_FONT_WIDTH, TIC_FONT_HEIGHT, color, scale, fixed ? drawChar : drawNonFixedChar, alt);
 }
 
@@ -744,6 +1069,8 @@ static void drawSprite(tic_mem* memory, const tic_tiles* src, s32 index, s32 x,
 
 static void api_sprite_ex(tic_mem* memory, const tic_tiles* src, s32 index, s32 x, s32 y, s32 w, s32 h, u8* colors, s32 count, s32 scale, tic_flip flip, tic_rotate rotate)
 {
+	src = ramView(memory, src);
+
 	s32 step = TIC_SPRITESIZE * scale;
 
 	const tic_flip vert_horz_flip = tic_horz_flip | tic_vert_flip;
@@ -815,7 +1142,8 @@ s32 drawSpriteFont(tic_mem* memory, u8 symbol, s32 x, s32 y, s32 width, s32 heig
 
 s32 drawFixedSpriteFont(tic_mem* memory, u8 index, s32 x, s32 y, s32 width, s32 height, u8 chromakey, s32 scale, bool alt)
 {
-	const u8* ptr = memory->ram.sprites.data[index].data;
+	const tic_tiles* sprites = ramView(memory, &memory->ram.sprites);
+	const u8* ptr = sprites->data[index].data;
 
 	enum {Size = TIC_SPRITESIZE};
 
@@ -1069,8 +1397,8 @@ static void api_textri(tic_mem* memory, float x1, float y1, float x2, float y2,
 {
 	tic_machine* machine = (tic_machine*)memory;
 	TexVert V0, V1, V2;
-	const u8* ptr = memory->ram.tiles.data[0].data;
-	const u8* map = memory->ram.map.data;
+	const u8* ptr = ((const tic_tiles*)ramView(memory, &memory->ram.tiles))->data[0].data;
+	const u8* map = ((const tic_map*)ramView(memory, &memory->ram.map))->data;
 
 	V0.x = x1; 	V0.y = y1; 	V0.u = u1; 	V0.v = v1;
 	V1.x = x2; 	V1.y = y2; 	V1.u = u2; 	V1.v = v2;
@@ -1165,16 +1493,20 @@ static void api_textri(tic_mem* memory, float x1, float y1, float x2, float y2,
 
 static void api_sprite(tic_mem* memory, const tic_tiles* src, s32 index, s32 x, s32 y, u8* colors, s32 count)
 {
-	drawSprite(memory, src, index, x, y, colors, count, 1, tic_no_flip, tic_no_rotate);
+	drawSprite(memory, ramView(memory, src), index, x, y, colors, count, 1, tic_no_flip, tic_no_rotate);
 }
 
 static void api_map(tic_mem* memory, const tic_map* src, const tic_tiles* tiles, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8 chromakey, s32 scale)
 {
-	drawMap((tic_machine*)memory, src, tiles, x, y, width, height, sx, sy, chromakey, scale, NULL, NULL);
+	drawMap((tic_machine*)memory, ramView(memory, src), ramView(memory, tiles), x, y, width, height, sx, sy, chromakey, scale, NULL, NULL);
 }
 
 static void api_remap(tic_mem* memory, const tic_map* src, const tic_tiles* tiles, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8 chromakey, s32 scale, RemapFunc remap, void* data)
 {
+	// the callback may write the map or the tiles while they're drawn, so they have to be in ram
+	if(src == &memory->ram.map) tic_ram_touch(memory, offsetof(tic_ram, map), sizeof(tic_map));
+	if(tiles == &memory->ram.tiles) tic_ram_touch(memory, offsetof(tic_ram, tiles), sizeof(tic_tiles));
+
 	drawMap((tic_machine*)memory, src, tiles, x, y, width, height, sx, sy, chromakey, scale, remap, data);
 }
 
@@ -1182,6 +1514,9 @@ static void api_map_set(tic_mem* memory, tic_map* src, s32 x, s32 y, u8 value)
 {
 	if(x < 0 || x >= TIC_MAP_WIDTH || y < 0 || y >= TIC_MAP_HEIGHT) return;
 
+	if(src == &memory->ram.map)
+		tic_ram_touch(memory, offsetof(tic_ram, map), sizeof(tic_map));
+
 	*(src->data + y * TIC_MAP_WIDTH + x) = value;
 }
 
@@ -1189,9 +1524,52 @@ static u8 api_map_get(tic_mem* memory, const tic_map* src, s32 x, s32 y)
 {
 	if(x < 0 || x >= TIC_MAP_WIDTH || y < 0 || y >= TIC_MAP_HEIGHT) return 0;
 	
+	src = ramView(memory, src);
+
 	return *(src->data + y * TIC_MAP_WIDTH + x);
 }
 
+static bool api_map_ray(tic_mem* memory, const tic_map* src, float x0, float y0, float x1, float y1, u8 mask, tic_map_hit* hit)
+{
+	return tic_map_ray(ramView(memory, src), &memory->ram.flags, x0, y0, x1, y1, mask, hit);
+}
+
+static bool api_map_sweep(tic_mem* memory, const tic_map* src, float x, float y, float w, float h, float dx, float dy, u8 mask, tic_map_hit* hit)
+{
+	return tic_map_sweep(ramView(memory, src), &memory->ram.flags, x, y, w, h, dx, dy, mask, hit);
+}
+
+static tic_map_query* getMapQuery(tic_machine* machine)
+{
+	if(!machine->query)
+		machine->query = tic_map_query_create();
+
+	return machine->query;
+}
+
+static s32 api_map_fill(tic_mem* memory, tic_map* src, s32 x, s32 y, u8 mask, s32 tile)
+{
+	tic_map_query* query = getMapQuery((tic_machine*)memory);
+
+	if(!query) return 0;
+
+	if(tile < 0)
+		src = (tic_map*)ramView(memory, src);
+	else if(src == &memory->ram.map)
+		tic_ram_touch(memory, offsetof(tic_ram, map), sizeof(tic_map));
+
+	return tic_map_fill(query, src, &memory->ram.flags, x, y, mask, tile);
+}
+
+static s32 api_map_path(tic_mem* memory, const tic_map* src, s32 x0, s32 y0, s32 x1, s32 y1, u8 mask, u8 cost, const u16** path)
+{
+	tic_map_query* query = getMapQuery((tic_machine*)memory);
+
+	if(!query) return -1;
+
+	return tic_map_path(query, ramView(memory, src), &memory->ram.flags, x0, y0, x1, y1, mask, cost, path);
+}
+
 static void api_line(tic_mem* memory, s32 x0, s32 y0, s32 x1, s32 y1, u8 color)
 {
 	ticLine(memory, x0, y0, x1, y1, color, api_pixel);
@@ -1493,6 +1871,8 @@ static void api_tick_start(tic_mem* memory, const tic_sfx* sfxsrc, const tic_mus
 
 	machine->sound.sfx = sfxsrc;
 	machine->sound.music = music;
+	machine->heap.frameAllocs = 0;
+	machine->gc.start = tic_tool_get_microseconds();
 
 	for (s32 i = 0; i < TIC_SOUND_CHANNELS; ++i )
 		memset(&memory->ram.registers[i], 0, sizeof(tic_sound_register));
@@ -1559,22 +1939,95 @@ static void stereo_tick_end(tic_mem* memory, tic_sound_register_data* registers,
 	blip_end_frame(blip, EndTime);
 }
 
-static void api_tick_end(tic_mem* memory)
+// spends the part of the frame left by the cart and the last blit on garbage collection,
+// so the VM rarely has to collect in the middle of TIC()
+static void collectGarbage(tic_machine* machine)
 {
-	tic_machine* machine = (tic_machine*)memory;
+	enum {FrameTime = 1000000 / TIC80_FRAMERATE, Reserve = FrameTime / 4};
 
-	machine->state.gamepads.previous.data = machine->memory.ram.input.gamepads.data;
-	machine->state.keyboard.previous.data = machine->memory.ram.input.keyboard.data;
+	machine->gc.time = 0;
 
-	stereo_tick_end(memory, machine->state.registers.left, machine->blip.left, 0);
-	stereo_tick_end(memory, machine->state.registers.right, machine->blip.right, 1);
+	if(!machine->state.initialized || !machine->state.collect) return;
 
-	blip_read_samples(machine->blip.left, machine->memory.samples.buffer, machine->samplerate / TIC80_FRAMERATE, TIC_STEREO_CHANNELS);
-	blip_read_samples(machine->blip.right, machine->memory.samples.buffer + 1, machine->samplerate / TIC80_FRAMERATE, TIC_STEREO_CHANNELS);
+	// a new cycle waits until the heap grew by half since the last one
+	if(!machine->gc.cycle && machine->heap.used < machine->gc.live + machine->gc.live / 2)
+		return;
 
-	machine->state.setpix = setPixelOvr;
-	machine->state.getpix = getPixelOvr;
+	u64 start = tic_tool_get_microseconds();
+	u64 busy = start - machine->gc.start + machine->gc.blit + Reserve;
+
+	if(busy >= FrameTime) return;
+
+	u64 deadline = start + FrameTime - busy;
+
+	machine->gc.cycle = true;
+
+	for(u64 now = start; now + machine->gc.step < deadline;)
+	{
+		bool done = machine->state.collect(&machine->memory);
+
+		u64 next = tic_tool_get_microseconds();
+		u64 step = next - now;
+
+		// the estimate grows at once and decays slowly
+		machine->gc.step = step > machine->gc.step ? step : (machine->gc.step + step) / 2;
+		now = next;
+
+		if(done)
+		{
+			machine->gc.cycle = false;
+			machine->gc.live = machine->heap.used;
+			break;
+		}
+	}
+
+	machine->gc.time = (u32)(tic_tool_get_microseconds() - start);
+}
+
+// sample frames one tick can make at the fastest rate correction
+static s32 maxSamples(s32 samplerate)
+{
+	return (s32)((s64)samplerate * (1000000 + TIC80_SOUND_RATE_MAX) / 1000000 / TIC80_FRAMERATE) + 1;
+}
+
+static void endTick(tic_machine* machine, bool quiet)
+{
+	tic_mem* memory = &machine->memory;
+
+	machine->state.gamepads.previous.data = machine->memory.ram.input.gamepads.data;
+	machine->state.keyboard.previous.data = machine->memory.ram.input.keyboard.data;
+
+	if(!quiet)
+	{
+		stereo_tick_end(memory, machine->state.registers.left, machine->blip.left, 0);
+		stereo_tick_end(memory, machine->state.registers.right, machine->blip.right, 1);
+
+		// whatever the frame made, rates that don't divide by the frame rate and the
+		// rate correction leave it a sample more or less than samplerate / TIC80_FRAMERATE
+		s32 count = MIN(blip_samples_avail(machine->blip.left), maxSamples(machine->samplerate));
+
+		blip_read_samples(machine->blip.left, machine->memory.samples.buffer, count, TIC_STEREO_CHANNELS);
+		blip_read_samples(machine->blip.right, machine->memory.samples.buffer + 1, count, TIC_STEREO_CHANNELS);
+
+		memory->samples.size = count * TIC_STEREO_CHANNELS * sizeof(s16);
+	}
+
+	machine->state.setpix = setPixelOvr;
+	machine->state.getpix = getPixelOvr;
 	machine->state.drawhline = drawHLineOvr;
+
+	if(!quiet)
+		collectGarbage(machine);
+}
+
+static void api_tick_end(tic_mem* memory)
+{
+	endTick((tic_machine*)memory, false);
+}
+
+void tic_tick_end_quiet(tic_mem* memory)
+{
+	endTick((tic_machine*)memory, true);
 }
 
 
@@ -1615,7 +2068,7 @@ static void api_music_frame(tic_mem* memory, s32 index, s32 frame, s32 row, bool
 
 static void initCover(tic_mem* tic)
 {
-	const tic_cover_image* cover = &tic->cart.cover;
+	const tic_cover_image* cover = &tic->cart->cover;
 
 	if(cover->size)
 	{
@@ -1627,13 +2080,27 @@ static void initCover(tic_mem* tic)
 			{
 				enum { Size = TIC80_WIDTH * TIC80_HEIGHT };
 
-				for (s32 i = 0; i < Size; i++)
+				tic_rgb* rgb = malloc(Size * sizeof(tic_rgb));
+				u8* colors = malloc(Size);
+				tic_quantizer* quantizer = tic_tool_quantizer_create(tic->cart->bank0.palette.colors, false);
+
+				if(rgb && colors && quantizer)
 				{
-					const gif_color* c = &image->palette[image->buffer[i]];
-					tic_rgb rgb = { c->r, c->g, c->b };
-					u8 color = tic_tool_find_closest_color(tic->cart.bank0.palette.colors, &rgb);
-					tic_tool_poke4(tic->ram.vram.screen.data, i, color);
+					for (s32 i = 0; i < Size; i++)
+					{
+						const gif_color* c = &image->palette[image->buffer[i]];
+						rgb[i] = (tic_rgb){ c->r, c->g, c->b };
+					}
+
+					tic_tool_quantize(quantizer, rgb, colors, TIC80_WIDTH, TIC80_HEIGHT, tic_dither_none);
+
+					for (s32 i = 0; i < Size; i++)
+						tic_tool_poke4(tic->ram.vram.screen.data, i, colors[i]);
 				}
+
+				tic_tool_quantizer_free(quantizer);
+				free(rgb);
+				free(colors);
 			}
 
 			gif_close(image);
@@ -1645,18 +2112,7 @@ static void api_sync(tic_mem* tic, u32 mask, s32 bank, bool toCart)
 {
 	tic_machine* machine = (tic_machine*)tic;
 
-	static const struct {s32 bank; s32 ram; s32 size;} Sections[] = 
-	{
-		{offsetof(tic_bank, tiles), 	offsetof(tic_ram, tiles), 			sizeof(tic_tiles)	},
-		{offsetof(tic_bank, sprites),	offsetof(tic_ram, sprites), 		sizeof(tic_tiles)	},
-		{offsetof(tic_bank, map), 		offsetof(tic_ram, map), 			sizeof(tic_map)		},
-		{offsetof(tic_bank, sfx), 		offsetof(tic_ram, sfx), 			sizeof(tic_sfx)		},
-		{offsetof(tic_bank, music), 	offsetof(tic_ram, music), 			sizeof(tic_music)	},
-		{offsetof(tic_bank, palette), 	offsetof(tic_ram, vram.palette), 	sizeof(tic_palette)	},
-		{offsetof(tic_bank, flags), 	offsetof(tic_ram, flags), 			sizeof(tic_flags)	},
-	};
-
-	enum{Count = COUNT_OF(Sections), Mask = (1 << Count) - 1};
+	enum{Count = COUNT_OF(SyncSections), Mask = (1 << Count) - 1};
 
 	if(mask == 0) mask = Mask;
 	
@@ -1664,14 +2120,34 @@ static void api_sync(tic_mem* tic, u32 mask, s32 bank, bool toCart)
 
 	assert(bank >= 0 && bank < TIC_BANKS);
 
+	if(toCart && !ownCart(machine))
+		return;
+
+	decodeBank(machine->shared, bank);
+
 	for(s32 i = 0; i < Count; i++)
 	{
 		if(mask & (1 << i))
-			toCart
-				? memcpy((u8*)&tic->cart.banks[bank] + Sections[i].bank, (u8*)&tic->ram + Sections[i].ram, Sections[i].size)
-				: memcpy((u8*)&tic->ram + Sections[i].ram, (u8*)&tic->cart.banks[bank] + Sections[i].bank, Sections[i].size);
+		{
+			u8* cart = (u8*)&tic->cart->banks[bank] + SyncSections[i].bank;
+			u8* ram = (u8*)&tic->ram + SyncSections[i].ram;
+			const u8* view = i < TIC_RAM_VIEWS ? machine->views[i] : NULL;
+
+			if(toCart)
+			{
+				if(view != cart)
+					memcpy(cart, view ? view : ram, SyncSections[i].size);
+			}
+			else if(i < TIC_RAM_VIEWS)
+				machine->views[i] = cart;
+			else
+				memcpy(ram, cart, SyncSections[i].size);
+		}
 	}
 
+	if(toCart && mask)
+		tic->cartSyncs[bank]++;
+
 	machine->state.synced |= mask;
 }
 
@@ -1783,13 +2259,13 @@ static const tic_script_config* getScriptConfig(const char* code)
 
 static const tic_script_config* api_get_script_config(tic_mem* memory)
 {
-	return getScriptConfig(memory->cart.code.data);
+	return getScriptConfig(memory->cart->code.data);
 }
 
 static void updateSaveid(tic_mem* memory)
 {
 	memset(memory->saveid, 0, sizeof memory->saveid);
-	const char* saveid = readMetatag(memory->cart.code.data, "saveid", api_get_script_config(memory)->singleComment);
+	const char* saveid = readMetatag(memory->cart->code.data, "saveid", api_get_script_config(memory)->singleComment);
 	if(saveid)
 	{
 		strncpy(memory->saveid, saveid, TIC_SAVEID_SIZE-1);
@@ -1797,6 +2273,151 @@ static void updateSaveid(tic_mem* memory)
 	}
 }
 
+static void saveSnapshot(tic_machine* machine, const tic_script_config* config, const char* code)
+{
+	tic_mem* tic = &machine->memory;
+
+	if(machine->snapshot)
+	{
+		tic_heap_drop(&machine->heap, machine->snapshot->image);
+		machine->snapshot->image = 0;
+	}
+
+	u32 image = config->snapshot && machine->heap.used ? tic_heap_save(&machine->heap) : 0;
+
+	if(image)
+	{
+		if(!machine->snapshot)
+			machine->snapshot = calloc(1, sizeof(tic_snapshot));
+
+		tic_snapshot* snapshot = machine->snapshot;
+
+		if(snapshot)
+		{
+			snapshot->image = image;
+
+			free(snapshot->code);
+			snapshot->code = malloc(strlen(code) + 1);
+
+			snapshot->shared = machine->shared;
+
+			if(snapshot->shared)
+			{
+				free(snapshot->cart);
+				snapshot->cart = NULL;
+			}
+			else if(!snapshot->cart)
+				snapshot->cart = malloc(sizeof(tic_cartridge));
+
+			if(snapshot->code && (snapshot->shared || snapshot->cart))
+			{
+				strcpy(snapshot->code, code);
+
+				if(snapshot->cart)
+					memcpy(snapshot->cart, tic->cart, sizeof(tic_cartridge));
+
+				flushViews(tic);
+				memcpy(&snapshot->ram, &tic->ram, sizeof(tic_ram));
+				memcpy(&snapshot->state, &machine->state, sizeof(tic_machine_state_data));
+				snapshot->input = tic->input.data;
+			}
+			else dropSnapshot(machine);
+		}
+		else tic_heap_drop(&machine->heap, image);
+	}
+	else dropSnapshot(machine);
+}
+
+// skips the script init if neither the cart nor the code changed since the snapshot
+static bool restoreSnapshot(tic_machine* machine, const char* code)
+{
+	tic_mem* tic = &machine->memory;
+	tic_snapshot* snapshot = machine->snapshot;
+
+	if(!snapshot || strcmp(snapshot->code, code) != 0
+		|| snapshot->shared != machine->shared
+		|| (snapshot->cart && memcmp(snapshot->cart, tic->cart, sizeof(tic_cartridge)) != 0))
+		return false;
+
+	if(!tic_heap_restore(&machine->heap, snapshot->image))
+	{
+		dropSnapshot(machine);
+		return false;
+	}
+
+	tic_persistent persistent = tic->ram.persistent;
+	tic80_input input = tic->ram.input;
+
+	dropViews(machine);
+	memcpy(&tic->ram, &snapshot->ram, sizeof(tic_ram));
+	memcpy(&machine->state, &snapshot->state, sizeof(tic_machine_state_data));
+
+	tic->ram.persistent = persistent;
+	tic->ram.input = input;
+	tic->input.data = snapshot->input;
+
+	memset(&machine->gc, 0, sizeof machine->gc);
+	machine->data->start = machine->data->counter();
+
+	return true;
+}
+
+struct tic_checkpoint
+{
+	tic_ram ram;
+	tic_machine_state_data state;
+	u8 input;
+	u32 image;
+};
+
+tic_checkpoint* tic_checkpoint_create(tic_mem* memory)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	return machine->state.initialized && api_get_script_config(memory)->snapshot 
+		? calloc(1, sizeof(tic_checkpoint)) 
+		: NULL;
+}
+
+bool tic_checkpoint_save(tic_mem* memory, tic_checkpoint* checkpoint)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	tic_heap_drop(&machine->heap, checkpoint->image);
+	checkpoint->image = tic_heap_save(&machine->heap);
+
+	flushViews(memory);
+	memcpy(&checkpoint->ram, &memory->ram, sizeof(tic_ram));
+	memcpy(&checkpoint->state, &machine->state, sizeof(tic_machine_state_data));
+	checkpoint->input = memory->input.data;
+
+	return checkpoint->image != 0;
+}
+
+bool tic_checkpoint_load(tic_mem* memory, const tic_checkpoint* checkpoint)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	if(!tic_heap_restore(&machine->heap, checkpoint->image))
+		return false;
+
+	dropViews(machine);
+	memcpy(&memory->ram, &checkpoint->ram, sizeof(tic_ram));
+	memcpy(&machine->state, &checkpoint->state, sizeof(tic_machine_state_data));
+	memory->input.data = checkpoint->input;
+
+	return true;
+}
+
+void tic_checkpoint_free(tic_mem* memory, tic_checkpoint* checkpoint)
+{
+	if(checkpoint)
+	{
+		tic_heap_drop(&((tic_machine*)memory)->heap, checkpoint->image);
+		free(checkpoint);
+	}
+}
+
 static void api_tick(tic_mem* tic, tic_tick_data* data)
 {
 	tic_machine* machine = (tic_machine*)tic;
@@ -1811,7 +2432,7 @@ static void api_tick(tic_mem* tic, tic_tick_data* data)
 		if(code)
 		{
 			memset(code, 0, CodeSize);
-			strcpy(code, tic->cart.code.data);
+			strcpy(code, tic->cart->code.data);
 
 			if(data->preprocessor)
 				data->preprocessor(data->data, code);
@@ -1819,6 +2440,13 @@ static void api_tick(tic_mem* tic, tic_tick_data* data)
 			bool done = false;
 			const tic_script_config* config = NULL;
 
+			if(restoreSnapshot(machine, code))
+			{
+				free(code);
+				machine->state.tick(tic);
+				return;
+			}
+
 			if(strlen(code))
 			{
 				config = getScriptConfig(code);
@@ -1836,6 +2464,10 @@ static void api_tick(tic_mem* tic, tic_tick_data* data)
 				else tic->input.data = -1;  // default is all enabled
 
 				data->start = data->counter();
+
+				// all the VMs share the machine heap, so only one lives at a time
+				closeScripts(tic);
+				memset(&machine->gc, 0, sizeof machine->gc);
 				
 				done = config->init(tic, code);
 			}
@@ -1844,17 +2476,25 @@ static void api_tick(tic_mem* tic, tic_tick_data* data)
 				machine->data->error(machine->data->data, "the code is empty");
 			}
 
-			free(code);
-
 			if(done)
 			{
 				machine->state.tick = config->tick;
+				machine->state.collect = config->collect;
 				machine->state.scanline = config->scanline;
 				machine->state.ovr.callback = config->overline;
 
 				machine->state.initialized = true;
+
+				if(machine->restarted)
+					saveSnapshot(machine, config, code);
+				else dropSnapshot(machine);
+
+				machine->restarted = false;
 			}
-			else return;
+
+			free(code);
+
+			if(!done) return;
 		}
 	}
 
@@ -1877,6 +2517,63 @@ static void api_overline(tic_mem* memory, void* data)
 		machine->state.ovr.callback(memory, data);
 }
 
+static s32 getRasterRegister(s32 address)
+{
+	enum
+	{
+		Palette = offsetof(tic_ram, vram.palette), 
+		Vars = offsetof(tic_ram, vram.vars),
+		Count = TIC_RASTER_REGS - sizeof(tic_palette),
+	};
+
+	if(address >= Palette && address < Palette + sizeof(tic_palette))
+		return address - Palette;
+
+	if(address >= Vars && address < Vars + Count)
+		return sizeof(tic_palette) + address - Vars;
+
+	return -1;
+}
+
+// values from -128 to 255 are stored as bytes
+static bool api_raster(tic_mem* memory, s32 address, s32 value, s32 row, s32 count)
+{
+	tic_raster_data* raster = &((tic_machine*)memory)->state.raster;
+
+	s32 reg = getRasterRegister(address);
+
+	if(reg < 0 || value < INT8_MIN || value > UINT8_MAX)
+		return false;
+
+	s32 end = MIN(row + count, TIC80_HEIGHT);
+
+	for(s32 r = MAX(row, 0); r < end; r++)
+	{
+		raster->mask[r] |= 1ULL << reg;
+		raster->data[r][reg] = value & 0xff;
+	}
+
+	return true;
+}
+
+// a negative address clears every register on the rows
+static bool api_raster_clear(tic_mem* memory, s32 address, s32 row, s32 count)
+{
+	tic_raster_data* raster = &((tic_machine*)memory)->state.raster;
+
+	s32 reg = address < 0 ? -1 : getRasterRegister(address);
+
+	if(address >= 0 && reg < 0)
+		return false;
+
+	s32 end = MIN(row + count, TIC80_HEIGHT);
+
+	for(s32 r = MAX(row, 0); r < end; r++)
+		raster->mask[r] &= reg < 0 ? 0 : ~(1ULL << reg);
+
+	return true;
+}
+
 static double api_time(tic_mem* memory)
 {
 	tic_machine* machine = (tic_machine*)memory;
@@ -1956,223 +2653,349 @@ static bool api_keyp(tic_mem* tic, tic_key key, s32 hold, s32 period)
 
 static void api_load(tic_cartridge* cart, const u8* buffer, s32 size)
 {
-	const u8* end = buffer + size;
-	memset(cart, 0, sizeof(tic_cartridge));
-
-	#define LOAD_CHUNK(to) memcpy(&to, buffer, MIN(sizeof(to), chunk.size))
+	tic_cart_load(cart, buffer, size);
+}
 
-	bool paletteExists = false;
+static s32 api_save(const tic_cartridge* cart, u8* buffer)
+{
+	return tic_cart_save(cart, buffer);
+}
 
-	while(buffer < end)
+// copied from SDL2
+static inline void memset4(void *dst, u32 val, u32 dwords)
+{
+#if defined(__GNUC__) && defined(i386)
+	s32 u0, u1, u2;
+	__asm__ __volatile__ (
+		"cld \n\t"
+		"rep ; stosl \n\t"
+		: "=&D" (u0), "=&a" (u1), "=&c" (u2)
+		: "0" (dst), "1" (val), "2" (dwords)
+		: "memory"
+	);
+#else
+	u32 _n = (dwords + 3) / 4;
+	u32 *_p = (u32*)dst;
+	u32 _val = (val);
+	if (dwords == 0)
+		return;
+	switch (dwords % 4)
 	{
-		Chunk chunk;
-		memcpy(&chunk, buffer, sizeof(Chunk));
-		buffer += sizeof(Chunk);
-
-		switch(chunk.type)
-		{
-		case CHUNK_TILES: 		LOAD_CHUNK(cart->banks[chunk.bank].tiles); 			break;
-		case CHUNK_SPRITES: 	LOAD_CHUNK(cart->banks[chunk.bank].sprites); 		break;
-		case CHUNK_MAP: 		LOAD_CHUNK(cart->banks[chunk.bank].map); 			break;
-		case CHUNK_SAMPLES: 	LOAD_CHUNK(cart->banks[chunk.bank].sfx.samples); 	break;
-		case CHUNK_WAVEFORM:	LOAD_CHUNK(cart->banks[chunk.bank].sfx.waveform); 	break;
-		case CHUNK_MUSIC:		LOAD_CHUNK(cart->banks[chunk.bank].music.tracks); 	break;
-		case CHUNK_PATTERNS:	LOAD_CHUNK(cart->banks[chunk.bank].music.patterns);	break;
-		case CHUNK_PALETTE:		LOAD_CHUNK(cart->banks[chunk.bank].palette);		break;
-		case CHUNK_FLAGS:		LOAD_CHUNK(cart->banks[chunk.bank].flags);			break;
-		case CHUNK_CODE: 		
-			if(chunk.bank == 0)
-				LOAD_CHUNK(cart->code);
-			break;
-		case CHUNK_COVER:
-			LOAD_CHUNK(cart->cover.data);
-			cart->cover.size = chunk.size;
-			break;
-		case CHUNK_PATTERNS_DEP: 
-			{
-				// workaround to load deprecated music patterns section
-				// and automatically convert volume value to a command
-				tic_patterns* ptrns = &cart->banks[chunk.bank].music.patterns;
-				LOAD_CHUNK(*ptrns);
-				for(s32 i = 0; i < MUSIC_PATTERNS; i++)
-					for(s32 r = 0; r < MUSIC_PATTERN_ROWS; r++)
-					{
-						tic_track_row* row = &ptrns->data[i].rows[r];
-						if(row->note >= NoteStart && row->command == tic_music_cmd_empty)
-						{
-							row->command = tic_music_cmd_volume;
-							row->param2 = row->param1 = MAX_VOLUME - row->param1;
-						}
-					}
-			}
-			break;
-		default: break;
-		}
-
-		buffer += chunk.size;
-
-		if(chunk.bank == 0 && chunk.type == CHUNK_PALETTE)
-			paletteExists = true;
+		case 0: do {    *_p++ = _val;
+		case 3:         *_p++ = _val;
+		case 2:         *_p++ = _val;
+		case 1:         *_p++ = _val;
+		} while ( --_n );
 	}
+#endif
+}
 
-	#undef LOAD_CHUNK
+static inline s32 pixelSize(tic80_pixel_color_format format)
+{
+	return format == TIC80_PIXEL_COLOR_RGB565 ? sizeof(u16) : sizeof(u32);
+}
 
-	// workaround to support ancient carts without palette
-	// load DB16 palette if it not exists
-	if(!paletteExists)
+// blit palette keeps RGBA bytes, returns it in the output format
+static const u32* convertPalette(tic80_pixel_color_format format, const u32* src, u32* dst)
+{
+	switch(format)
 	{
-		static const u8 DB16[] = {0x14, 0x0c, 0x1c, 0x44, 0x24, 0x34, 0x30, 0x34, 0x6d, 0x4e, 0x4a, 0x4e, 0x85, 0x4c, 0x30, 0x34, 0x65, 0x24, 0xd0, 0x46, 0x48, 0x75, 0x71, 0x61, 0x59, 0x7d, 0xce, 0xd2, 0x7d, 0x2c, 0x85, 0x95, 0xa1, 0x6d, 0xaa, 0x2c, 0xd2, 0xaa, 0x99, 0x6d, 0xc2, 0xca, 0xda, 0xd4, 0x5e, 0xde, 0xee, 0xd6};
-		memcpy(cart->bank0.palette.data, DB16, sizeof(tic_palette));
+	case TIC80_PIXEL_COLOR_XRGB8888:
+		for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+		{
+			const u8* c = (const u8*)&src[i];
+			dst[i] = 0xff000000 | c[0] << 16 | c[1] << 8 | c[2];
+		}
+		return dst;
+	case TIC80_PIXEL_COLOR_RGB565:
+		for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+		{
+			const u8* c = (const u8*)&src[i];
+			dst[i] = (c[0] >> 3) << 11 | (c[1] >> 2) << 5 | c[2] >> 3;
+		}
+		return dst;
+	default:
+		return src;
 	}
 }
 
+static inline void fillPixels(u8* dst, u32 color, s32 count, s32 size)
+{
+	if(size == sizeof(u32))
+		memset4(dst, color, count);
+	else
+		for(u16 *ptr = (u16*)dst, *end = ptr + count; ptr < end;)
+			*ptr++ = (u16)color;
+}
+
+typedef struct
+{
+	const u32* pal;
+	const u32* rgba;
+	u8 border;
+	s8 x;
+	s8 y;
+} RasterRow;
 
-static s32 calcBufferSize(const void* buffer, s32 size)
+// buffer takes the RGBA palette and the converted one after it
+static RasterRow getRasterRow(tic_mem* tic, s32 row, const u32* rgba, const u32* pal, u32* buffer)
 {
-	const u8* ptr = (u8*)buffer + size - 1;
-	const u8* end = (u8*)buffer;
+	RasterRow out = {pal, rgba, tic->ram.vram.vars.border, tic->ram.vram.vars.offset.x, tic->ram.vram.vars.offset.y};
+
+	const tic_raster_data* raster = &((tic_machine*)tic)->state.raster;
+	u64 mask = raster->mask[row];
 
-	while(ptr >= end)
+	if(mask)
 	{
-		if(*ptr) break;
+		const u8* data = raster->data[row];
 
-		ptr--;
-		size--;
-	}
+		enum {PaletteRegs = sizeof(tic_palette), PaletteMask = (1ULL << PaletteRegs) - 1};
 
-	return size;
-}
+		if(mask & PaletteMask)
+		{
+			memcpy(buffer, rgba, sizeof(u32) * TIC_PALETTE_SIZE);
 
-static u8* saveFixedChunk(u8* buffer, ChunkType type, const void* from, s32 size, s32 bank)
-{
-	if(size)
-	{
-		Chunk chunk = {.type = type, .bank = bank, .size = size, .temp = 0};
-		memcpy(buffer, &chunk, sizeof(Chunk));
-		buffer += sizeof(Chunk);
-		memcpy(buffer, from, size);
-		buffer += size;
-	}
+			for(s32 i = 0; i < PaletteRegs; i++)
+				if(mask & (1ULL << i))
+					((u8*)buffer)[i / 3 * sizeof(u32) + i % 3] = data[i];
 
-	return buffer;
-}
+			out.rgba = buffer;
+			out.pal = convertPalette(tic->output.format, buffer, buffer + TIC_PALETTE_SIZE);
+		}
 
-static u8* saveChunk(u8* buffer, ChunkType type, const void* from, s32 size, s32 bank)
+		if(mask & (1ULL << PaletteRegs)) out.border = data[PaletteRegs] & 0xf;
+		if(mask & (1ULL << (PaletteRegs + 1))) out.x = data[PaletteRegs + 1];
+		if(mask & (1ULL << (PaletteRegs + 2))) out.y = data[PaletteRegs + 2];
+	}
+
+	return out;
+}
+
+// both colours of a packed byte at once, 8 pixels per mask byte
+#define BLIT_OVERLAY(TYPE)															\
+	{																				\
+		TYPE pairs[256][2];															\
+		for(s32 i = 0; i < 256; i++)												\
+		{																			\
+			pairs[i][0] = (TYPE)pal[i & 0xf];										\
+			pairs[i][1] = (TYPE)pal[i >> 4];										\
+		}																			\
+		for(s32 r = 0; r < TIC80_HEIGHT; r++, rowPtr += tic->output.pitch)			\
+		{																			\
+			TYPE* dst = (TYPE*)rowPtr + Left;										\
+			for(s32 c = 0; c < TIC80_WIDTH / BITS_IN_BYTE; c++, mask++, src += 4, dst += BITS_IN_BYTE) \
+			{																		\
+				u8 bits = *mask;													\
+				if(bits == 0xff)													\
+				{																	\
+					for(s32 i = 0; i < 4; i++)										\
+						memcpy(dst + i*2, pairs[src[i]], sizeof pairs[0]);			\
+				}																	\
+				else if(bits)														\
+				{																	\
+					for(s32 i = 0; i < BITS_IN_BYTE; i++)							\
+						if(bits & 1 << i)											\
+							dst[i] = pairs[src[i >> 1]][i & 1];						\
+				}																	\
+			}																		\
+		}																			\
+	}
+
+static void blitOverlay(tic_mem* tic)
 {
-	s32 chunkSize = calcBufferSize(from, size);
+	enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2};
+	enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2};
 
-	return saveFixedChunk(buffer, type, from, chunkSize, bank);
+	tic_machine* machine = (tic_machine*)tic;
+	const u32* pal = machine->state.ovr.palette;
+	const u8* mask = machine->state.ovr.mask;
+	const u8* src = machine->state.ovr.data;
+
+	u8* rowPtr = (u8*)tic->screen + Top * tic->output.pitch;
+
+	if(pixelSize(tic->output.format) == sizeof(u32))
+		BLIT_OVERLAY(u32)
+	else
+		BLIT_OVERLAY(u16)
 }
 
-static s32 api_save(const tic_cartridge* cart, u8* buffer)
+#undef BLIT_OVERLAY
+
+static void indexRow(tic_indexed_frame* frame, s32 y, const RasterRow* row, const u8* src)
 {
-	u8* start = buffer;
+	enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2, Right = Left};
 
-	#define SAVE_CHUNK(ID, FROM, BANK) saveChunk(buffer, ID, &FROM, sizeof(FROM), BANK)
+	u8* dst = frame->pixels[y];
+	memcpy(frame->palettes[y], row->rgba, sizeof frame->palettes[y]);
 
-	for(s32 i = 0; i < TIC_BANKS; i++)
+	if(!src)
 	{
-		buffer = SAVE_CHUNK(CHUNK_TILES, 	cart->banks[i].tiles, 			i);
-		buffer = SAVE_CHUNK(CHUNK_SPRITES, 	cart->banks[i].sprites, 		i);
-		buffer = SAVE_CHUNK(CHUNK_MAP, 		cart->banks[i].map, 			i);
-		buffer = SAVE_CHUNK(CHUNK_SAMPLES, 	cart->banks[i].sfx.samples, 	i);
-		buffer = SAVE_CHUNK(CHUNK_WAVEFORM, cart->banks[i].sfx.waveform, 	i);
-		buffer = SAVE_CHUNK(CHUNK_PATTERNS, cart->banks[i].music.patterns, 	i);
-		buffer = SAVE_CHUNK(CHUNK_MUSIC, 	cart->banks[i].music.tracks, 	i);
-		buffer = SAVE_CHUNK(CHUNK_PALETTE, 	cart->banks[i].palette, 		i);
-		buffer = SAVE_CHUNK(CHUNK_FLAGS, 	cart->banks[i].flags, 			i);
+		memset(dst, row->border, TIC80_FULLWIDTH);
+		return;
 	}
 
-	buffer = SAVE_CHUNK(CHUNK_CODE, cart->code, 0);
-	buffer = saveFixedChunk(buffer, CHUNK_COVER, cart->cover.data, cart->cover.size, 0);
+	memset(dst, row->border, Left);
+	memset(dst + TIC80_FULLWIDTH - Right, row->border, Right);
 
-	#undef SAVE_CHUNK
-
-	return (s32)(buffer - start);
+	dst += Left;
+	u32 x = (-row->x + TIC80_WIDTH) % TIC80_WIDTH;
+	for(s32 c = 0; c < TIC80_WIDTH / 2; c++)
+	{
+		u8 val = src[c];
+		dst[x++ % TIC80_WIDTH] = val & 0xf;
+		dst[x++ % TIC80_WIDTH] = val >> 4;
+	}
 }
 
-// copied from SDL2
-static inline void memset4(void *dst, u32 val, u32 dwords)
+static void indexOverlay(tic_mem* tic, tic_indexed_frame* frame)
 {
-#if defined(__GNUC__) && defined(i386)
-	s32 u0, u1, u2;
-	__asm__ __volatile__ (
-		"cld \n\t"
-		"rep ; stosl \n\t"
-		: "=&D" (u0), "=&a" (u1), "=&c" (u2)
-		: "0" (dst), "1" (val), "2" (dwords)
-		: "memory"
-	);
-#else
-	u32 _n = (dwords + 3) / 4;
-	u32 *_p = (u32*)dst;
-	u32 _val = (val);
-	if (dwords == 0)
-		return;
-	switch (dwords % 4)
+	enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2};
+	enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2};
+
+	tic_machine* machine = (tic_machine*)tic;
+	const u8* mask = machine->state.ovr.mask;
+	const u8* src = machine->state.ovr.data;
+
+	for(s32 r = 0, i = 0; r < TIC80_HEIGHT; r++)
 	{
-		case 0: do {    *_p++ = _val;
-		case 3:         *_p++ = _val;
-		case 2:         *_p++ = _val;
-		case 1:         *_p++ = _val;
-		} while ( --_n );
+		u8* dst = frame->pixels[Top + r] + Left;
+
+		for(s32 c = 0; c < TIC80_WIDTH; c += BITS_IN_BYTE, i += BITS_IN_BYTE)
+		{
+			u8 bits = mask[i / BITS_IN_BYTE];
+
+			if(bits)
+				for(s32 b = 0; b < BITS_IN_BYTE; b++)
+					if(bits & 1 << b)
+						dst[c + b] = TIC_PALETTE_SIZE + tic_tool_peek4(src, i + b);
+		}
 	}
-#endif
 }
 
+#define BLIT_ROW(TYPE)													\
+	{																	\
+		TYPE* colPtr = (TYPE*)rowPtr + Left;							\
+		u32 x = (-row.x + TIC80_WIDTH) % TIC80_WIDTH;					\
+		for(s32 c = 0; c < TIC80_WIDTH / 2; c++)						\
+		{																\
+			u8 val = src[c];											\
+			*(colPtr + (x++ % TIC80_WIDTH)) = (TYPE)rowPal[val & 0xf];	\
+			*(colPtr + (x++ % TIC80_WIDTH)) = (TYPE)rowPal[val >> 4];	\
+		}																\
+	}
+
 static void api_blit(tic_mem* tic, tic_scanline scanline, tic_overline overline, void* data)
 {
-	const u32* pal = tic_palette_blit(&tic->ram.vram.palette);
+	const s32 size = pixelSize(tic->output.format);
+
+	if(!tic->screen)
+		tic->screen = malloc(TIC80_FULLWIDTH * TIC80_FULLHEIGHT * size);
+
+	if(!tic->screen) return;
+
+	u64 start = tic_tool_get_microseconds();
+	const u32* rgba = tic_palette_blit(&tic->ram.vram.palette);
+
+	u32 palette[TIC_PALETTE_SIZE];
+	const u32* pal = convertPalette(tic->output.format, rgba, palette);
+
+	tic_indexed_frame* indexed = tic->output.indexed;
+	const bool colors = !tic->output.indexedOnly;
 
 	{
 		tic_machine* machine = (tic_machine*)tic;
 		memcpy(machine->state.ovr.palette, pal, sizeof machine->state.ovr.palette);
+
+		if(indexed)
+			memcpy(indexed->ovr, rgba, sizeof indexed->ovr);
 	}
 
 	if(scanline)
 	{
 		scanline(tic, 0, data);
-		pal = tic_palette_blit(&tic->ram.vram.palette);
+		rgba = tic_palette_blit(&tic->ram.vram.palette);
+		pal = convertPalette(tic->output.format, rgba, palette);
 	}
 
 	enum {Top = (TIC80_FULLHEIGHT-TIC80_HEIGHT)/2, Bottom = Top};
 	enum {Left = (TIC80_FULLWIDTH-TIC80_WIDTH)/2, Right = Left};
 
-	u32* out = tic->screen;
+	const s32 pitch = tic->output.pitch;
+	u8* out = (u8*)tic->screen;
+
+	u32 rasterPalette[TIC_PALETTE_SIZE * 2];
+	RasterRow row = getRasterRow(tic, 0, rgba, pal, rasterPalette);
+
+	for(s32 r = 0; r < Top; r++)
+	{
+		if(colors)
+			fillPixels(out + r * pitch, row.pal[row.border], TIC80_FULLWIDTH, size);
 
-	memset4(&out[0 * TIC80_FULLWIDTH], pal[tic->ram.vram.vars.border], TIC80_FULLWIDTH*Top);
+		if(indexed)
+			indexRow(indexed, r, &row, NULL);
+	}
 
-	u32* rowPtr = out + (Top*TIC80_FULLWIDTH);
-	for(s32 r = 0; r < TIC80_HEIGHT; r++, rowPtr += TIC80_FULLWIDTH)
+	u8* rowPtr = out + Top * pitch;
+	for(s32 r = 0; r < TIC80_HEIGHT; r++, rowPtr += pitch)
 	{
-		u32 *colPtr = rowPtr + Left;
-		memset4(rowPtr, pal[tic->ram.vram.vars.border], Left);
+		if(r) row = getRasterRow(tic, r, rgba, pal, rasterPalette);
+
+		const u32* rowPal = row.pal;
 
-		s32 pos = (r + tic->ram.vram.vars.offset.y + TIC80_HEIGHT) % TIC80_HEIGHT * TIC80_WIDTH >> 1;
+		const u8* src = (u8*)tic->ram.vram.screen.data 
+			+ ((r + row.y + TIC80_HEIGHT) % TIC80_HEIGHT * TIC80_WIDTH >> 1);
 
-		u32 x = (-tic->ram.vram.vars.offset.x + TIC80_WIDTH) % TIC80_WIDTH;
-		for(s32 c = 0; c < TIC80_WIDTH / 2; c++)
+		if(colors)
 		{
-			u8 val = ((u8*)tic->ram.vram.screen.data)[pos + c];
-			*(colPtr + (x++ % TIC80_WIDTH)) = pal[val & 0xf];
-			*(colPtr + (x++ % TIC80_WIDTH)) = pal[val >> 4];
+			fillPixels(rowPtr, rowPal[row.border], Left, size);
+
+			if(size == sizeof(u32))
+				BLIT_ROW(u32)
+			else
+				BLIT_ROW(u16)
+
+			fillPixels(rowPtr + (TIC80_FULLWIDTH-Right) * size, rowPal[row.border], Right, size);
 		}
 
-		memset4(rowPtr + (TIC80_FULLWIDTH-Right), pal[tic->ram.vram.vars.border], Right);
+		if(indexed)
+			indexRow(indexed, Top + r, &row, src);
 			
 		if(scanline && (r < TIC80_HEIGHT-1))
 		{
 			scanline(tic, r+1, data);
-			pal = tic_palette_blit(&tic->ram.vram.palette);
+			rgba = tic_palette_blit(&tic->ram.vram.palette);
+			pal = convertPalette(tic->output.format, rgba, palette);
 		}
 	}
 
-	memset4(&out[(TIC80_FULLHEIGHT-Bottom) * TIC80_FULLWIDTH], pal[tic->ram.vram.vars.border], TIC80_FULLWIDTH*Bottom);
+	for(s32 r = TIC80_FULLHEIGHT-Bottom; r < TIC80_FULLHEIGHT; r++)
+	{
+		if(colors)
+			fillPixels(out + r * pitch, row.pal[row.border], TIC80_FULLWIDTH, size);
+
+		if(indexed)
+			indexRow(indexed, r, &row, NULL);
+	}
 
 	if(overline)
+	{
+		tic_machine* machine = (tic_machine*)tic;
+
+		memset(machine->state.ovr.mask, 0, sizeof machine->state.ovr.mask);
 		overline(tic, data);
+
+		if(colors)
+			blitOverlay(tic);
+
+		if(indexed)
+			indexOverlay(tic, indexed);
+	}
+
+	((tic_machine*)tic)->gc.blit = tic_tool_get_microseconds() - start;
 }
 
+#undef BLIT_ROW
+
 static void initApi(tic_api* api)
 {
 #define INIT_API(func) api->func = api_##func
@@ -2195,6 +3018,10 @@ static void initApi(tic_api* api)
 	INIT_API(remap);
 	INIT_API(map_set);
 	INIT_API(map_get);
+	INIT_API(map_ray);
+	INIT_API(map_sweep);
+	INIT_API(map_fill);
+	INIT_API(map_path);
 	INIT_API(circle);
 	INIT_API(circle_border);
 	INIT_API(tri);
@@ -2210,6 +3037,8 @@ static void initApi(tic_api* api)
 	INIT_API(tick);
 	INIT_API(scanline);
 	INIT_API(overline);
+	INIT_API(raster);
+	INIT_API(raster_clear);
 	INIT_API(reset);
 	INIT_API(pause);
 	INIT_API(resume);
@@ -2236,6 +3065,19 @@ tic_mem* tic_create(s32 samplerate)
 	if(machine != (tic_machine*)&machine->memory)
 		return NULL;
 
+	machine->own = calloc(1, sizeof(tic_cartridge));
+
+	if(!machine->own)
+	{
+		free(machine);
+		return NULL;
+	}
+
+	machine->memory.cart = machine->own;
+
+	machine->memory.output.format = TIC80_PIXEL_COLOR_ABGR8888;
+	machine->memory.output.pitch = TIC80_FULLWIDTH * sizeof(u32);
+
 	machine->sound.sfx = &machine->memory.ram.sfx;
 	machine->sound.music = &machine->memory.ram.music;
 
@@ -2243,7 +3085,7 @@ tic_mem* tic_create(s32 samplerate)
 
 	machine->samplerate = samplerate;
 	machine->memory.samples.size = samplerate * TIC_STEREO_CHANNELS / TIC80_FRAMERATE * sizeof(s16);
-	machine->memory.samples.buffer = malloc(machine->memory.samples.size);
+	machine->memory.samples.buffer = malloc(maxSamples(samplerate) * TIC_STEREO_CHANNELS * sizeof(s16));
 
 	machine->blip.left = blip_new(samplerate / 10);
 	machine->blip.right = blip_new(samplerate / 10);
@@ -2256,17 +3098,114 @@ tic_mem* tic_create(s32 samplerate)
 	return &machine->memory;
 }
 
+tic80_memory tic_memory_report(tic_mem* memory)
+{
+	const tic_machine* machine = (tic_machine*)memory;
+	const tic_snapshot* snapshot = machine->snapshot;
+	const tic_shared_cart* shared = machine->shared;
+
+	tic80_memory report =
+	{
+		.machine = sizeof(tic_machine),
+		.cart = machine->own ? sizeof(tic_cartridge) : 0,
+		.shared = shared ? (sizeof(tic_shared_cart) + shared->size) / shared->refs : 0,
+		.screen = memory->screen && !memory->output.external 
+			? TIC80_FULLWIDTH * TIC80_FULLHEIGHT * pixelSize(memory->output.format) : 0,
+		.pause = machine->pause ? sizeof(tic_pause_data) : 0,
+		.snapshot = snapshot 
+			? sizeof(tic_snapshot) + strlen(snapshot->code) + 1 
+				+ (snapshot->cart ? sizeof(tic_cartridge) : 0) 
+				+ tic_heap_image_size(&machine->heap)
+			: 0,
+		.heap = tic_heap_footprint(&machine->heap),
+		.samples = maxSamples(machine->samplerate) * TIC_STEREO_CHANNELS * sizeof(s16),
+		.query = machine->query ? tic_map_query_size() : 0,
+	};
+
+	report.total = report.machine + report.cart + report.shared + report.screen 
+		+ report.pause + report.snapshot + report.heap + report.samples + report.query;
+
+	return report;
+}
+
+void tic_sound_rate(tic_mem* memory, s32 correction)
+{
+	tic_machine* machine = (tic_machine*)memory;
+
+	correction = MIN(MAX(correction, -TIC80_SOUND_RATE_MAX), TIC80_SOUND_RATE_MAX);
+
+	if(correction != machine->correction)
+	{
+		double rate = machine->samplerate * (1.0 + correction / 1000000.0);
+
+		blip_set_rates(machine->blip.left, CLOCKRATE, rate);
+		blip_set_rates(machine->blip.right, CLOCKRATE, rate);
+
+		machine->correction = correction;
+	}
+}
+
+void tic_output(tic_mem* memory, tic80_pixel_color_format format, void* pixels, s32 pitch)
+{
+	if(!memory->output.external)
+		free(memory->screen);
+
+	memory->screen = pixels;
+	memory->output.external = pixels != NULL;
+	memory->output.format = format;
+	memory->output.pitch = pixels ? pitch : TIC80_FULLWIDTH * pixelSize(format);
+}
+
+void tic_output_indexed(tic_mem* memory, tic_indexed_frame* frame, bool only)
+{
+	memory->output.indexed = frame;
+	memory->output.indexedOnly = frame && only;
+}
+
 static inline bool islineend(char c) {return c == '\n' || c == '\0';}
 static inline bool isalpha_(char c) {return isalpha(c) || c == '_';}
 static inline bool isalnum_(char c) {return isalnum(c) || c == '_';}
 
-void parseCode(const tic_script_config* config, const char* start, u8* color, const tic_code_theme* theme)
+enum
+{
+	CodeStateNone,
+	CodeStateBlockComment,
+	CodeStateBlockString,
+	CodeStateDoubleQuote,
+	CodeStateSingleQuote,
+};
+
+static const char* findInLine(const char* ptr, const char* str)
+{
+	size_t len = strlen(str);
+
+	for(; !islineend(*ptr); ptr++)
+		if(strncmp(ptr, str, len) == 0)
+			return ptr + len;
+
+	return NULL;
+}
+
+static const char* findQuoteInLine(const char* ptr, char quote)
+{
+	for(; !islineend(*ptr); ptr++)
+	{
+		if(*ptr == '\\')
+		{
+			if(islineend(ptr[1])) break;
+			ptr++;
+		}
+		else if(*ptr == quote) return ptr + 1;
+	}
+
+	return NULL;
+}
+
+s32 parseCode(const tic_script_config* config, const char* start, u8* color, s32 state, const tic_code_theme* theme)
 {
 	const char* ptr = start;
 
-	const char* blockCommentStart = NULL;
-	const char* blockStringStart = NULL;
-	const char* blockStdStringStart = NULL;
+	const char* blockStart = start;
 	const char* singleCommentStart = NULL;
 	const char* wordStart = NULL;
 	const char* numberStart = NULL;
@@ -2275,51 +3214,33 @@ void parseCode(const tic_script_config* config, const char* start, u8* color, co
 	{
 		char c = ptr[0];
 
-		if(blockCommentStart)
+		if(state != CodeStateNone)
 		{
-			const char* end = strstr(ptr, config->blockCommentEnd);
+			const char* end = NULL;
 
-			ptr = end ? end + strlen(config->blockCommentEnd) : blockCommentStart + strlen(blockCommentStart);
-			memset(color + (blockCommentStart - start), theme->comment, ptr - blockCommentStart);
-			blockCommentStart = NULL;
-			continue;
-		}
-		else if(blockStringStart)
-		{
-			const char* end = strstr(ptr, config->blockStringEnd);
+			switch(state)
+			{
+			case CodeStateBlockComment: end = findInLine(ptr, config->blockCommentEnd); break;
+			case CodeStateBlockString: end = findInLine(ptr, config->blockStringEnd); break;
+			case CodeStateDoubleQuote: end = findQuoteInLine(ptr, '"'); break;
+			case CodeStateSingleQuote: end = findQuoteInLine(ptr, '\''); break;
+			}
 
-			ptr = end ? end + strlen(config->blockStringEnd) : blockStringStart + strlen(blockStringStart);
-			memset(color + (blockStringStart - start), theme->string, ptr - blockStringStart);
-			blockStringStart = NULL;
-			continue;
-		}
-		else if(blockStdStringStart)
-		{
-			const char* blockStart = blockStdStringStart+1;
+			u8 value = state == CodeStateBlockComment ? theme->comment : theme->string;
 
-			while(true)
+			if(end)
 			{
-				const char* pos = strchr(blockStart, *blockStdStringStart);
-				
-				if(pos)
-				{
-					if(*(pos-1) == '\\' && *(pos-2) != '\\') blockStart = pos + 1;
-					else
-					{
-						ptr = pos + 1;
-						break;
-					}
-				}
-				else
-				{
-					ptr = blockStdStringStart + strlen(blockStdStringStart);
-					break;
-				}
+				memset(color + (blockStart - start), value, end - blockStart);
+				state = CodeStateNone;
+				ptr = end;
+				continue;
 			}
 
-			memset(color + (blockStdStringStart - start), theme->string, ptr - blockStdStringStart);
-			blockStdStringStart = NULL;
-			continue;
+			// token continues on the next line
+			while(!islineend(*ptr)) ptr++;
+
+			memset(color + (blockStart - start), value, ptr - blockStart + (*ptr == '\n'));
+			return *ptr ? state : CodeStateNone;
 		}
 		else if(singleCommentStart)
 		{
@@ -2386,25 +3307,28 @@ void parseCode(const tic_script_config* config, const char* start, u8* color, co
 		}
 		else
 		{
-			if(config->blockCommentStart && memcmp(ptr, config->blockCommentStart, strlen(config->blockCommentStart)) == 0)
+			if(config->blockCommentStart && strncmp(ptr, config->blockCommentStart, strlen(config->blockCommentStart)) == 0)
 			{
-				blockCommentStart = ptr;
+				state = CodeStateBlockComment;
+				blockStart = ptr;
 				ptr += strlen(config->blockCommentStart);
 				continue;
 			}
-			if(config->blockStringStart && memcmp(ptr, config->blockStringStart, strlen(config->blockStringStart)) == 0)
+			if(config->blockStringStart && strncmp(ptr, config->blockStringStart, strlen(config->blockStringStart)) == 0)
 			{
-				blockStringStart = ptr;
+				state = CodeStateBlockString;
+				blockStart = ptr;
 				ptr += strlen(config->blockStringStart);
 				continue;
 			}
 			else if(c == '"' || c == '\'')
 			{
-				blockStdStringStart = ptr;
+				state = c == '"' ? CodeStateDoubleQuote : CodeStateSingleQuote;
+				blockStart = ptr;
 				ptr++;
 				continue;
 			}
-			else if(config->singleComment && memcmp(ptr, config->singleComment, strlen(config->singleComment)) == 0)
+			else if(config->singleComment && strncmp(ptr, config->singleComment, strlen(config->singleComment)) == 0)
 			{
 				singleCommentStart = ptr;
 				ptr += strlen(config->singleComment);
@@ -2426,8 +3350,10 @@ void parseCode(const tic_script_config* config, const char* start, u8* color, co
 			else if(iscntrl(c)) color[ptr - start] = theme->other;
 		}
 
-		if(!c) break;
+		if(islineend(c)) break;
 
 		ptr++;
 	}
+
+	return CodeStateNone;
 }
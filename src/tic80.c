@@ -20,12 +20,18 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include <tic80.h>
 #include "ticapi.h"
 #include "tools.h"
+#include "machine.h"
+#include "capture.h"
+#include "stream.h"
+#include "netplay.h"
+#include "scale.h"
 
 #include "ext/gif.h"
 
@@ -60,12 +66,24 @@ static u64 getFreq()
 
 static u64 TickCounter = 0;
 
+// the capture encodes packed ABGR frames
+static bool canCapture(const tic_mem* memory)
+{
+	return memory->output.format == TIC80_PIXEL_COLOR_ABGR8888
+		&& memory->output.pitch == TIC80_FULLWIDTH * sizeof(u32);
+}
+
 static u64 getCounter()
 {
 	return TickCounter;
 }
 
 tic80* tic80_create(s32 samplerate)
+{
+	return tic80_create_ex(samplerate, TIC80_PIXEL_COLOR_ABGR8888);
+}
+
+tic80* tic80_create_ex(s32 samplerate, tic80_pixel_color_format format)
 {
 	tic80_local* tic80 = malloc(sizeof(tic80_local));
 
@@ -74,10 +92,13 @@ tic80* tic80_create(s32 samplerate)
 		memset(tic80, 0, sizeof(tic80_local));
 
 		tic80->memory = tic_create(samplerate);
+		tic_output(tic80->memory, format, NULL, 0);
+		tic80->tic.pitch = tic80->memory->output.pitch;
 
 		{
 			static const u8 Font[] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x30, 0x30, 0x30, 0x00, 0x30, 0x00, 0x00, 0x00, 0x50, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x50, 0xf8, 0x50, 0xf8, 0x50, 0x00, 0x00, 0x00, 0x78, 0xa0, 0x70, 0x28, 0xf0, 0x00, 0x00, 0x00, 0x88, 0x10, 0x20, 0x40, 0x88, 0x00, 0x00, 0x00, 0x40, 0xa0, 0x68, 0x90, 0x68, 0x00, 0x00, 0x00, 0x20, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10, 0x20, 0x20, 0x20, 0x10, 0x00, 0x00, 0x00, 0x40, 0x20, 0x20, 0x20, 0x40, 0x00, 0x00, 0x00, 0x20, 0xa8, 0x70, 0xa8, 0x20, 0x00, 0x00, 0x00, 0x00, 0x20, 0x70, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x20, 0x40, 0x00, 0x00, 0x00, 0x00, 0x70, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x08, 0x10, 0x20, 0x40, 0x80, 0x00, 0x00, 0x00, 0x70, 0xd8, 0xe8, 0xc8, 0x70, 0x00, 0x00, 0x00, 0x30, 0x70, 0x30, 0x30, 0x78, 0x00, 0x00, 0x00, 0xf0, 0x18, 0x70, 0xc0, 0xf8, 0x00, 0x00, 0x00, 0xf8, 0x18, 0x30, 0x98, 0x70, 0x00, 0x00, 0x00, 0x30, 0x70, 0xd0, 0xf8, 0x10, 0x00, 0x00, 0x00, 0xf8, 0xc0, 0xf0, 0x18, 0xf0, 0x00, 0x00, 0x00, 0x70, 0xc0, 0xf0, 0xc8, 0x70, 0x00, 0x00, 0x00, 0xf8, 0x18, 0x30, 0x60, 0xc0, 0x00, 0x00, 0x00, 0x70, 0xc8, 0x70, 0xc8, 0x70, 0x00, 0x00, 0x00, 0x70, 0xc8, 0x78, 0x08, 0x70, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00, 0x60, 0x60, 0x00, 0x00, 0x00, 0x60, 0x60, 0x00, 0x60, 0x20, 0x40, 0x00, 0x00, 0x10, 0x20, 0x40, 0x20, 0x10, 0x00, 0x00, 0x00, 0x00, 0x70, 0x00, 0x70, 0x00, 0x00, 0x00, 0x00, 0x40, 0x20, 0x10, 0x20, 0x40, 0x00, 0x00, 0x00, 0x78, 0x18, 0x30, 0x00, 0x30, 0x00, 0x00, 0x00, 0x70, 0xa8, 0xb8, 0x80, 0x70, 0x00, 0x00, 0x00, 0x70, 0xc8, 0xc8, 0xf8, 0xc8, 0x00, 0x00, 0x00, 0xf0, 0xc8, 0xf0, 0xc8, 0xf0, 0x00, 0x00, 0x00, 0x70, 0xc8, 0xc0, 0xc8, 0x70, 0x00, 0x00, 0x00, 0xf0, 0xc8, 0xc8, 0xc8, 0xf0, 0x00, 0x00, 0x00, 0xf8, 0xc0, 0xf0, 0xc0, 0xf8, 0x00, 0x00, 0x00, 0xf8, 0xc0, 0xf0, 0xc0, 0xc0, 0x00, 0x00, 0x00, 0x78, 0xc0, 0xd8, 0xc8, 0x78, 0x00, 0x00, 0x00, 0xc8, 0xc8, 0xf8, 0xc8, 0xc8, 0x00, 0x00, 0x00, 0x78, 0x30, 0x30, 0x30, 0x78, 0x00, 0x00, 0x00, 0xf8, 0x18, 0x18, 0xd8, 0x70, 0x00, 0x00, 0x00, 0xc8, 0xd0, 0xe0, 0xd0, 0xc8, 0x00, 0x00, 0x00, 0xc0, 0xc0, 0xc0, 0xc0, 0xf8, 0x00, 0x00, 0x00, 0xd8, 0xf8, 0xf8, 0xa8, 0x88, 0x00, 0x00, 0x00, 0xc8, 0xe8, 0xf8, 0xd8, 0xc8, 0x00, 0x00, 0x00, 0x70, 0xc8, 0xc8, 0xc8, 0x70, 0x00, 0x00, 0x00, 0xf0, 0xc8, 0xc8, 0xf0, 0xc0, 0x00, 0x00, 0x00, 0x70, 0xc8, 0xc8, 0xc8, 0x70, 0x08, 0x00, 0x00, 0xf0, 0xc8, 0xc8, 0xf0, 0xc8, 0x00, 0x00, 0x00, 0x78, 0xe0, 0x70, 0x38, 0xf0, 0x00, 0x00, 0x00, 0x78, 0x30, 0x30, 0x30, 0x30, 0x00, 0x00, 0x00, 0xc8, 0xc8, 0xc8, 0xc8, 0x70, 0x00, 0x00, 0x00, 0xc8, 0xc8, 0xc8, 0x70, 0x20, 0x00, 0x00, 0x00, 0x88, 0xa8, 0xf8, 0xf8, 0xd8, 0x00, 0x00, 0x00, 0xc8, 0xc8, 0x70, 0xc8, 0xc8, 0x00, 0x00, 0x00, 0x68, 0x68, 0x78, 0x30, 0x30, 0x00, 0x00, 0x00, 0xf8, 0x30, 0x60, 0xc0, 0xf8, 0x00, 0x00, 0x00, 0x30, 0x20, 0x20, 0x20, 0x30, 0x00, 0x00, 0x00, 0x80, 0x40, 0x20, 0x10, 0x08, 0x00, 0x00, 0x00, 0x60, 0x20, 0x20, 0x20, 0x60, 0x00, 0x00, 0x00, 0x20, 0x50, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0x00, 0x00, 0x00, 0x40, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x78, 0x98, 0x98, 0x78, 0x00, 0x00, 0x00, 0xc0, 0xf0, 0xc8, 0xc8, 0xf0, 0x00, 0x00, 0x00, 0x00, 0x78, 0xe0, 0xe0, 0x78, 0x00, 0x00, 0x00, 0x18, 0x78, 0x98, 0x98, 0x78, 0x00, 0x00, 0x00, 0x00, 0x70, 0xd8, 0xe0, 0x70, 0x00, 0x00, 0x00, 0x38, 0x60, 0xf8, 0x60, 0x60, 0x00, 0x00, 0x00, 0x00, 0x70, 0x98, 0xf8, 0x18, 0x70, 0x00, 0x00, 0xc0, 0xf0, 0xc8, 0xc8, 0xc8, 0x00, 0x00, 0x00, 0x30, 0x00, 0x30, 0x30, 0x30, 0x00, 0x00, 0x00, 0x18, 0x00, 0x18, 0x18, 0x98, 0x70, 0x00, 0x00, 0xc0, 0xc8, 0xf0, 0xc8, 0xc8, 0x00, 0x00, 0x00, 0x60, 0x60, 0x60, 0x60, 0x38, 0x00, 0x00, 0x00, 0x00, 0xd0, 0xf8, 0xa8, 0xa8, 0x00, 0x00, 0x00, 0x00, 0xf0, 0xc8, 0xc8, 0xc8, 0x00, 0x00, 0x00, 0x00, 0x70, 0xc8, 0xc8, 0x70, 0x00, 0x00, 0x00, 0x00, 0xf0, 0xc8, 0xc8, 0xf0, 0xc0, 0x00, 0x00, 0x00, 0x78, 0x98, 0x98, 0x78, 0x18, 0x00, 0x00, 0x00, 0xf0, 0xc8, 0xc0, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x78, 0xe0, 0x38, 0xf0, 0x00, 0x00, 0x00, 0x60, 0xf8, 0x60, 0x60, 0x38, 0x00, 0x00, 0x00, 0x00, 0xc8, 0xc8, 0xc8, 0x70, 0x00, 0x00, 0x00, 0x00, 0xc8, 0xc8, 0x70, 0x20, 0x00, 0x00, 0x00, 0x00, 0x88, 0xa8, 0xf8, 0xd8, 0x00, 0x00, 0x00, 0x00, 0xd8, 0x70, 0x70, 0xd8, 0x00, 0x00, 0x00, 0x00, 0x98, 0x98, 0x78, 0x18, 0x70, 0x00, 0x00, 0x00, 0xf8, 0x30, 0x60, 0xf8, 0x00, 0x00, 0x00, 0x30, 0x20, 0x60, 0x20, 0x30, 0x00, 0x00, 0x00, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x60, 0x20, 0x30, 0x20, 0x60, 0x00, 0x00, 0x00, 0x00, 0x28, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x40, 0x40, 0x00, 0x40, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa0, 0xe0, 0xa0, 0xe0, 0xa0, 0x00, 0x00, 0x00, 0x60, 0xc0, 0x60, 0xc0, 0x40, 0x00, 0x00, 0x00, 0x80, 0x20, 0x40, 0x80, 0x20, 0x00, 0x00, 0x00, 0xc0, 0xc0, 0xe0, 0xa0, 0x60, 0x00, 0x00, 0x00, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x40, 0x40, 0x40, 0x20, 0x00, 0x00, 0x00, 0x80, 0x40, 0x40, 0x40, 0x80, 0x00, 0x00, 0x00, 0x00, 0xa0, 0x40, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0xe0, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x80, 0x00, 0x00, 0x00, 0x00, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x20, 0x40, 0x80, 0x00, 0x00, 0x00, 0x00, 0x60, 0xa0, 0xa0, 0xa0, 0xc0, 0x00, 0x00, 0x00, 0x40, 0xc0, 0x40, 0x40, 0xe0, 0x00, 0x00, 0x00, 0xc0, 0x20, 0x40, 0x80, 0xe0, 0x00, 0x00, 0x00, 0xc0, 0x20, 0x40, 0x20, 0xc0, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xe0, 0x20, 0x20, 0x00, 0x00, 0x00, 0xe0, 0x80, 0xc0, 0x20, 0xc0, 0x00, 0x00, 0x00, 0x60, 0x80, 0xe0, 0xa0, 0xe0, 0x00, 0x00, 0x00, 0xe0, 0x20, 0x40, 0x80, 0x80, 0x00, 0x00, 0x00, 0xe0, 0xa0, 0xe0, 0xa0, 0xe0, 0x00, 0x00, 0x00, 0xe0, 0xa0, 0xe0, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00, 0x40, 0x00, 0x40, 0x80, 0x00, 0x00, 0x00, 0x20, 0x40, 0x80, 0x40, 0x20, 0x00, 0x00, 0x00, 0x00, 0xe0, 0x00, 0xe0, 0x00, 0x00, 0x00, 0x00, 0x80, 0x40, 0x20, 0x40, 0x80, 0x00, 0x00, 0x00, 0xe0, 0x20, 0x40, 0x00, 0x40, 0x00, 0x00, 0x00, 0x60, 0xa0, 0xe0, 0x80, 0x60, 0x00, 0x00, 0x00, 0x40, 0xa0, 0xe0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xc0, 0xa0, 0xc0, 0x00, 0x00, 0x00, 0x60, 0x80, 0x80, 0x80, 0x60, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xa0, 0xa0, 0xc0, 0x00, 0x00, 0x00, 0xe0, 0x80, 0xc0, 0x80, 0xe0, 0x00, 0x00, 0x00, 0xe0, 0x80, 0xc0, 0x80, 0x80, 0x00, 0x00, 0x00, 0x60, 0x80, 0xe0, 0xa0, 0x60, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xe0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0xe0, 0x40, 0x40, 0x40, 0xe0, 0x00, 0x00, 0x00, 0x20, 0x20, 0x20, 0xa0, 0x40, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xc0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x80, 0x80, 0x80, 0x80, 0xe0, 0x00, 0x00, 0x00, 0xe0, 0xe0, 0xa0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xa0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x40, 0xa0, 0xa0, 0xa0, 0x40, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xc0, 0x80, 0x80, 0x00, 0x00, 0x00, 0x40, 0xa0, 0xa0, 0xe0, 0x60, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xe0, 0xc0, 0xa0, 0x00, 0x00, 0x00, 0x60, 0x80, 0x40, 0x20, 0xc0, 0x00, 0x00, 0x00, 0xe0, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xa0, 0xa0, 0x60, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xa0, 0x40, 0x40, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xa0, 0xe0, 0xe0, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0x40, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0xe0, 0x20, 0x40, 0x80, 0xe0, 0x00, 0x00, 0x00, 0x60, 0x40, 0x40, 0x40, 0x60, 0x00, 0x00, 0x00, 0x00, 0x80, 0x40, 0x20, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x40, 0x40, 0x40, 0xc0, 0x00, 0x00, 0x00, 0x40, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xe0, 0x00, 0x00, 0x00, 0x40, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc0, 0x60, 0xa0, 0xe0, 0x00, 0x00, 0x00, 0x80, 0xc0, 0xa0, 0xa0, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x60, 0x80, 0x80, 0x60, 0x00, 0x00, 0x00, 0x20, 0x60, 0xa0, 0xa0, 0x60, 0x00, 0x00, 0x00, 0x00, 0x60, 0xa0, 0xc0, 0x60, 0x00, 0x00, 0x00, 0x20, 0x40, 0xe0, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x60, 0xa0, 0xe0, 0x20, 0x40, 0x00, 0x00, 0x80, 0xc0, 0xa0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x40, 0x00, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x20, 0x00, 0x20, 0x20, 0xa0, 0x40, 0x00, 0x00, 0x80, 0xa0, 0xc0, 0xc0, 0xa0, 0x00, 0x00, 0x00, 0xc0, 0x40, 0x40, 0x40, 0xe0, 0x00, 0x00, 0x00, 0x00, 0xe0, 0xe0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xa0, 0xa0, 0x00, 0x00, 0x00, 0x00, 0x40, 0xa0, 0xa0, 0x40, 0x00, 0x00, 0x00, 0x00, 0xc0, 0xa0, 0xa0, 0xc0, 0x80, 0x00, 0x00, 0x00, 0x60, 0xa0, 0xa0, 0x60, 0x20, 0x00, 0x00, 0x00, 0xa0, 0xc0, 0x80, 0x80, 0x00, 0x00, 0x00, 0x00, 0x60, 0x80, 0x20, 0xc0, 0x00, 0x00, 0x00, 0x40, 0xe0, 0x40, 0x40, 0x20, 0x00, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xa0, 0x60, 0x00, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xe0, 0x40, 0x00, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0xe0, 0xe0, 0x00, 0x00, 0x00, 0x00, 0xa0, 0x40, 0x40, 0xa0, 0x00, 0x00, 0x00, 0x00, 0xa0, 0xa0, 0x60, 0x20, 0x40, 0x00, 0x00, 0x00, 0xe0, 0x20, 0x80, 0xe0, 0x00, 0x00, 0x00, 0x60, 0x40, 0xc0, 0x40, 0x60, 0x00, 0x00, 0x00, 0x40, 0x40, 0x00, 0x40, 0x40, 0x00, 0x00, 0x00, 0xc0, 0x40, 0x60, 0x40, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x60, 0xc0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 			memcpy(tic80->memory->font.data, Font, sizeof Font);
+			tic_font_touch(tic80->memory);
 		}
 
 		return &tic80->tic;
@@ -86,10 +107,8 @@ tic80* tic80_create(s32 samplerate)
 	return NULL;
 }
 
-TIC80_API void tic80_load(tic80* tic, void* cart, s32 size)
+static void initTick(tic80_local* tic80)
 {
-	tic80_local* tic80 = (tic80_local*)tic;
-
 	tic80->tic.sound.count = tic80->memory->samples.size/sizeof(s16);
 	tic80->tic.sound.samples = tic80->memory->samples.buffer;
 
@@ -107,13 +126,101 @@ TIC80_API void tic80_load(tic80* tic, void* cart, s32 size)
 		tic80->tickData.syncPMEM = false;
 		TickCounter = 0;
 	}
+}
+
+TIC80_API void tic80_load(tic80* tic, void* cart, s32 size)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	initTick(tic80);
 
 	{
-		tic80->memory->api.load(&tic80->memory->cart, cart, size);
+		tic_load_shared(tic80->memory, cart, size);
 		tic80->memory->api.reset(tic80->memory);
 	}
 }
 
+TIC80_API bool tic80_load_file(tic80* tic, const char* path)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	if(!tic_load_file(tic80->memory, path))
+		return false;
+
+	initTick(tic80);
+	tic80->memory->api.reset(tic80->memory);
+
+	return true;
+}
+
+// records the registers every row is drawn with for the stream
+static void streamScanline(tic_mem* memory, s32 row, void* data)
+{
+	tic80_local* tic80 = data;
+
+	memory->api.scanline(memory, row, NULL);
+	tic_stream_scanline(tic80->stream, memory, row);
+}
+
+static void streamOverline(tic_mem* memory, void* data)
+{
+	tic80_local* tic80 = data;
+
+	memory->api.overline(memory, NULL);
+	tic_stream_overline(tic80->stream, memory);
+}
+
+struct tic_scaler
+{
+	tic_indexed_frame frame;
+	tic80_scale config;
+	void* pixels;
+	s32 pitch;
+	bool external;
+};
+
+// the scaled frame when there is one
+static void setScreen(tic80_local* tic80)
+{
+	tic80->tic.screen = tic80->scaler ? tic80->scaler->pixels : tic80->memory->screen;
+	tic80->tic.pitch = tic80->scaler ? tic80->scaler->pitch : tic80->memory->output.pitch;
+}
+
+static void present(tic80_local* tic80)
+{
+	// the host only sees the scaled frame, the full colour one is drawn just for the capture
+	if(tic80->scaler)
+		tic_output_indexed(tic80->memory, &tic80->scaler->frame, !tic80->capture);
+
+	if(tic80->stream)
+	{
+		tic_stream_begin(tic80->stream, tic80->memory);
+		tic80->memory->api.blit(tic80->memory, streamScanline, streamOverline, tic80);
+	}
+	else tic80->memory->api.blit(tic80->memory, tic80->memory->api.scanline, tic80->memory->api.overline, NULL);
+
+	if(tic80->scaler)
+	{
+		struct tic_scaler* scaler = tic80->scaler;
+		tic_scale(&scaler->frame, &scaler->config, tic80->memory->output.format, scaler->pixels, scaler->pitch);
+	}
+
+	setScreen(tic80);
+	tic80->tic.sound.count = tic80->memory->samples.size/sizeof(s16);
+
+	if(tic80->capture)
+	{
+		if(canCapture(tic80->memory))
+			tic_capture_frame(tic80->capture, tic80->memory);
+		else
+		{
+			// the frames can't be encoded any more, end the recording instead of leaving gaps in it
+			fprintf(stderr, "capture: stopped, the output is no longer packed ABGR\n");
+			tic80_capture_stop(&tic80->tic);
+		}
+	}
+}
+
 TIC80_API void tic80_tick(tic80* tic, tic80_input input)
 {
 	tic80_local* tic80 = (tic80_local*)tic;
@@ -124,15 +231,220 @@ TIC80_API void tic80_tick(tic80* tic, tic80_input input)
 	tic80->memory->api.tick(tic80->memory, &tic80->tickData);
 	tic80->memory->api.tick_end(tic80->memory);
 
-	tic80->memory->api.blit(tic80->memory, tic80->memory->api.scanline, tic80->memory->api.overline, NULL);
+	present(tic80);
+
+	TickCounter++;
+}
+
+TIC80_API bool tic80_capture_start(tic80* tic, const char* path, bool compress)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic80_capture_stop(tic);
+
+	if(!canCapture(tic80->memory))
+		return false;
+
+	tic80->capture = tic_capture_open(path, ((tic_machine*)tic80->memory)->samplerate, compress);
+
+	return tic80->capture != NULL;
+}
+
+TIC80_API void tic80_capture_stop(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic_capture_close(tic80->capture);
+	tic80->capture = NULL;
+}
+
+TIC80_API bool tic80_stream_start(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	if(!tic80->stream)
+		tic80->stream = tic_stream_create();
+	else tic_stream_key(tic80->stream);
+
+	return tic80->stream != NULL;
+}
+
+TIC80_API s32 tic80_stream_frame(tic80* tic, const void** packet)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	return tic80->stream ? tic_stream_encode(tic80->stream, tic80->memory, packet) : 0;
+}
+
+TIC80_API void tic80_stream_stop(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic_stream_close(tic80->stream);
+	tic80->stream = NULL;
+}
+
+TIC80_API bool tic80_netplay_start(tic80* tic, const tic80_netplay_config* config)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic80_netplay_stop(tic);
+	tic80->netplay = tic_netplay_create(config);
+
+	return tic80->netplay != NULL;
+}
+
+TIC80_API void tic80_netplay_receive(tic80* tic, const void* packet, s32 size)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	if(tic80->netplay)
+		tic_netplay_receive(tic80->netplay, packet, size);
+}
+
+TIC80_API bool tic80_netplay_tick(tic80* tic, tic80_gamepad pad)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	if(!tic80->netplay) return false;
+
+	bool done = tic_netplay_tick(tic80->netplay, tic80->memory, &tic80->tickData, pad);
+
+	if(done)
+		present(tic80);
+
+	tic_netplay_send(tic80->netplay);
 
 	TickCounter++;
+
+	return done;
+}
+
+TIC80_API tic80_netplay tic80_netplay_stats(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	return tic80->netplay ? tic_netplay_stats(tic80->netplay) : (tic80_netplay){.desync = -1};
+}
+
+TIC80_API void tic80_netplay_stop(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic_netplay_close(tic80->netplay, tic80->memory);
+	tic80->netplay = NULL;
+}
+
+TIC80_API void tic80_heap_limit(tic80* tic, u32 bytes)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	((tic_machine*)tic80->memory)->heap.limit = bytes;
+}
+
+TIC80_API tic80_heap tic80_heap_stats(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+	const tic_machine* machine = (tic_machine*)tic80->memory;
+	const tic_heap* heap = &machine->heap;
+
+	return (tic80_heap)
+	{
+		.limit = (u32)heap->limit,
+		.used = (u32)heap->used,
+		.peak = (u32)heap->peak,
+		.allocs = heap->frameAllocs,
+		.gc = machine->gc.time,
+	};
+}
+
+TIC80_API tic80_memory tic80_memory_report(tic80* tic)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic80_memory report = tic_memory_report(tic80->memory);
+
+	report.machine += sizeof(tic80_local);
+	report.total += sizeof(tic80_local);
+
+	if(tic80->scaler)
+	{
+		const tic80_scale* config = &tic80->scaler->config;
+		u32 size = sizeof(struct tic_scaler)
+			+ (tic80->scaler->external ? 0 : tic80->scaler->pitch * tic_scale_height(config));
+
+		report.screen += size;
+		report.total += size;
+	}
+
+	return report;
+}
+
+TIC80_API void tic80_sound_rate(tic80* tic, s32 correction)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic_sound_rate(tic80->memory, correction);
+}
+
+TIC80_API void tic80_framebuffer(tic80* tic, void* pixels, s32 pitch)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+
+	tic_output(tic80->memory, tic80->memory->output.format, pixels, pitch);
+
+	setScreen(tic80);
+}
+
+TIC80_API void tic80_scaler(tic80* tic, const tic80_scale* config, void* pixels, s32 pitch)
+{
+	tic80_local* tic80 = (tic80_local*)tic;
+	struct tic_scaler* scaler = tic80->scaler;
+
+	if(scaler)
+	{
+		tic_output_indexed(tic80->memory, NULL, false);
+
+		if(!scaler->external)
+			free(scaler->pixels);
+
+		free(scaler);
+		tic80->scaler = NULL;
+	}
+
+	if(config && config->scale >= 1 && config->scale <= TIC80_SCALE_MAX)
+	{
+		scaler = calloc(1, sizeof(struct tic_scaler));
+
+		if(scaler)
+		{
+			s32 size = tic80->memory->output.format == TIC80_PIXEL_COLOR_RGB565 ? sizeof(u16) : sizeof(u32);
+
+			scaler->config = *config;
+			scaler->external = pixels != NULL;
+			scaler->pitch = pixels ? pitch : tic_scale_width(config) * size;
+			scaler->pixels = pixels ? pixels : calloc(tic_scale_height(config), scaler->pitch);
+
+			if(scaler->pixels)
+			{
+				tic80->scaler = scaler;
+				tic_output_indexed(tic80->memory, &scaler->frame, true);
+			}
+			else free(scaler);
+		}
+	}
+
+	setScreen(tic80);
 }
 
 TIC80_API void tic80_delete(tic80* tic)
 {
 	tic80_local* tic80 = (tic80_local*)tic;
 
+	tic80_capture_stop(tic);
+	tic80_stream_stop(tic);
+	tic80_netplay_stop(tic);
+	tic80_scaler(tic, NULL, NULL, 0);
 	tic_close(tic80->memory);
 
 	free(tic80);
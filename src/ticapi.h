@@ -70,6 +70,8 @@ typedef struct tic_mem tic_mem;
 typedef void(*tic_tick)(tic_mem* memory);
 typedef void(*tic_scanline)(tic_mem* memory, s32 row, void* data);
 typedef void(*tic_overline)(tic_mem* memory, void* data);
+// does one incremental garbage collector step, returns true when a full cycle is done
+typedef bool(*tic_collect)(tic_mem* memory);
 
 typedef struct
 {
@@ -101,10 +103,16 @@ struct tic_script_config
 		tic_tick tick;
 		tic_scanline scanline;
 		tic_overline overline;		
+		tic_collect collect;
+
+		// the VM lives in the machine heap only and can be rolled back with it
+		bool snapshot;
 	};
 
 	const tic_outline_item* (*getOutline)(const char* code, s32* size);
-	void (*parse)(const tic_script_config* config, const char* start, u8* color, const tic_code_theme* theme);
+	// colors a single line entered in the given lexer state (0 at the top of the code)
+	// and returns the state the next line starts in
+	s32 (*parse)(const tic_script_config* config, const char* start, u8* color, s32 state, const tic_code_theme* theme);
 	void (*eval)(tic_mem* tic, const char* code);
 
 	const char* blockCommentStart;
@@ -120,6 +128,18 @@ struct tic_script_config
 	s32 apiCount;
 };
 
+// where a map query stopped, the normal points away from the solid cell it touched
+// and is zero on axes it didn't touch or when the query started inside the cell
+typedef struct
+{
+	float x;
+	float y;
+	s32 cellx;
+	s32 celly;
+	s32 normalx;
+	s32 normaly;
+} tic_map_hit;
+
 typedef struct
 {
 	s32  (*draw_char)			(tic_mem* memory, u8 symbol, s32 x, s32 y, u8 color, bool alt);
@@ -140,6 +160,10 @@ typedef struct
 	void (*remap)				(tic_mem* memory, const tic_map* src, const tic_tiles* tiles, s32 x, s32 y, s32 width, s32 height, s32 sx, s32 sy, u8 chromakey, s32 scale, RemapFunc remap, void* data);
 	void (*map_set)				(tic_mem* memory, tic_map* src, s32 x, s32 y, u8 value);
 	u8   (*map_get)				(tic_mem* memory, const tic_map* src, s32 x, s32 y);
+	bool (*map_ray)				(tic_mem* memory, const tic_map* src, float x0, float y0, float x1, float y1, u8 mask, tic_map_hit* hit);
+	bool (*map_sweep)			(tic_mem* memory, const tic_map* src, float x, float y, float w, float h, float dx, float dy, u8 mask, tic_map_hit* hit);
+	s32  (*map_fill)			(tic_mem* memory, tic_map* src, s32 x, s32 y, u8 mask, s32 tile);
+	s32  (*map_path)			(tic_mem* memory, const tic_map* src, s32 x0, s32 y0, s32 x1, s32 y1, u8 mask, u8 cost, const u16** path);
 	void (*circle)				(tic_mem* memory, s32 x, s32 y, s32 radius, u8 color);
 	void (*circle_border)		(tic_mem* memory, s32 x, s32 y, s32 radius, u8 color);
 	void (*tri)					(tic_mem* memory, s32 x1, s32 y1, s32 x2, s32 y2, s32 x3, s32 y3, u8 color);
@@ -155,6 +179,8 @@ typedef struct
 	void (*tick)				(tic_mem* memory, tic_tick_data* data);
 	void (*scanline)			(tic_mem* memory, s32 row, void* data);
 	void (*overline)				(tic_mem* memory, void* data);
+	bool (*raster)				(tic_mem* memory, s32 address, s32 value, s32 row, s32 count);
+	bool (*raster_clear)		(tic_mem* memory, s32 address, s32 row, s32 count);
 	void (*reset)				(tic_mem* memory);
 	void (*pause)				(tic_mem* memory);
 	void (*resume)				(tic_mem* memory);
@@ -173,10 +199,19 @@ typedef struct
 	const tic_script_config* (*get_script_config)(tic_mem* memory);
 } tic_api;
 
+// the blit as palette indices for the CPU scaler, 16 and up pick from the OVR palette
+typedef struct
+{
+	u8 pixels[TIC80_FULLHEIGHT][TIC80_FULLWIDTH];
+	u32 palettes[TIC80_FULLHEIGHT][TIC_PALETTE_SIZE];	// RGBA bytes every row was drawn with
+	u32 ovr[TIC_PALETTE_SIZE];
+} tic_indexed_frame;
+
 struct tic_mem
 {
 	tic_ram 			ram;
-	tic_cartridge 		cart;
+	tic_cartridge* 		cart;
+	u32 				cartSyncs[TIC_BANKS]; // bumped when sync writes to a bank of the cart
 	tic_font 			font;
 	tic_api 			api;
 
@@ -200,15 +235,63 @@ struct tic_mem
 		s32 size;
 	} samples;
 
-	u32 screen[TIC80_FULLWIDTH * TIC80_FULLHEIGHT];
+	struct
+	{
+		tic80_pixel_color_format format;
+		s32 pitch;		// bytes between screen rows
+		bool external;	// the screen belongs to the host
+		tic_indexed_frame* indexed;
+		bool indexedOnly;	// the blit leaves the screen alone
+	} output;
+
+	// allocated on the first blit unless the host gave its own buffer
+	u32* screen;
 };
 
 tic_mem* tic_create(s32 samplerate);
 void tic_close(tic_mem* memory);
 
+// loads the cart shared with other machines running the same one, copied on the first write
+void tic_load_shared(tic_mem* memory, const void* buffer, s32 size);
+// same, reading the file, false if it can't be read
+bool tic_load_file(tic_mem* memory, const char* path);
+// the cart bank, decoded first if the shared cart hasn't needed it yet
+tic_bank* tic_load_bank(tic_mem* memory, s32 bank);
+// sync() switches tiles, sprites and map by pointing at the cart bank, code reading or writing
+// those parts of ram directly calls this first to have them copied in
+void tic_ram_touch(tic_mem* memory, u32 address, s32 size);
+// the font lives outside ram, whoever changes it calls this to have the glyphs built again
+void tic_font_touch(tic_mem* memory);
+tic80_memory tic_memory_report(tic_mem* memory);
+
+// the sound is made this many millionths faster or slower from the next tick,
+// samples.size changes with it
+void tic_sound_rate(tic_mem* memory, s32 correction);
+
+// blit pixel format, draws straight into pixels if they are given
+void tic_output(tic_mem* memory, tic80_pixel_color_format format, void* pixels, s32 pitch);
+// the blit also fills the frame while it's set, NULL stops it,
+// with 'only' it fills just the frame and skips the full colour screen
+void tic_output_indexed(tic_mem* memory, tic_indexed_frame* frame, bool only);
+
+// rollback points with the RAM, the machine state and the script heap,
+// NULL until the script is running or if its VM can't be snapshotted
+typedef struct tic_checkpoint tic_checkpoint;
+tic_checkpoint* tic_checkpoint_create(tic_mem* memory);
+bool tic_checkpoint_save(tic_mem* memory, tic_checkpoint* checkpoint);
+bool tic_checkpoint_load(tic_mem* memory, const tic_checkpoint* checkpoint);
+void tic_checkpoint_free(tic_mem* memory, tic_checkpoint* checkpoint);
+
+// ends a re-simulated tick without mixing sound or collecting garbage
+void tic_tick_end_quiet(tic_mem* memory);
+
 typedef struct
 {
 	tic80 tic;
 	tic_mem* memory;
 	tic_tick_data tickData;
+	struct tic_capture* capture;
+	struct tic_stream* stream;
+	struct tic_netplay* netplay;
+	struct tic_scaler* scaler;
 } tic80_local;
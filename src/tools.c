@@ -24,6 +24,14 @@
 #include "ext/gif.h"
 
 #include <string.h>
+#include <stdlib.h>
+#include <math.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 extern void tic_tool_poke4(void* addr, u32 index, u8 value);
 extern u8 tic_tool_peek4(const void* addr, u32 index);
@@ -86,6 +94,335 @@ u32 tic_tool_find_closest_color(const tic_rgb* palette, const tic_rgb* color)
 	return closetColor;
 }
 
+typedef struct
+{
+	float l;
+	float a;
+	float b;
+} OkLab;
+
+static float srgbToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : powf((value + 0.055f) / 1.055f, 2.4f);
+}
+
+// cube roots of the LMS cone responses, OKLab is linear in them
+static void rgbToLms(u8 r, u8 g, u8 b, float* lms)
+{
+	float lr = srgbToLinear(r / 255.0f);
+	float lg = srgbToLinear(g / 255.0f);
+	float lb = srgbToLinear(b / 255.0f);
+
+	lms[0] = cbrtf(0.4122214708f * lr + 0.5363325363f * lg + 0.0514459929f * lb);
+	lms[1] = cbrtf(0.2119034982f * lr + 0.6806995451f * lg + 0.1073969566f * lb);
+	lms[2] = cbrtf(0.0883024619f * lr + 0.2817188376f * lg + 0.6299787005f * lb);
+}
+
+static const float LmsToLab[3][3] = 
+{
+	{0.2104542553f, 0.7936177850f, -0.0040720468f},
+	{1.9779984951f, -2.4285922050f, 0.4505937099f},
+	{0.0259040371f, 0.7827717662f, -0.8086757660f},
+};
+
+static OkLab lmsToOkLab(const float* lms)
+{
+	return (OkLab)
+	{
+		LmsToLab[0][0] * lms[0] + LmsToLab[0][1] * lms[1] + LmsToLab[0][2] * lms[2],
+		LmsToLab[1][0] * lms[0] + LmsToLab[1][1] * lms[1] + LmsToLab[1][2] * lms[2],
+		LmsToLab[2][0] * lms[0] + LmsToLab[2][1] * lms[1] + LmsToLab[2][2] * lms[2],
+	};
+}
+
+static OkLab rgbToOkLab(const tic_rgb* color)
+{
+	float lms[3];
+	rgbToLms(color->r, color->g, color->b, lms);
+	return lmsToOkLab(lms);
+}
+
+enum
+{
+	LutBits = 5,
+	LutShift = BITS_IN_BYTE - LutBits,
+	LutSize = 1 << (LutBits * 3),
+	CellMax = (1 << LutShift) - 1,
+	// the cell crosses a boundary between palette colors, its colors are searched
+	Ambiguous = 0xff,
+	CacheBits = 10,
+	CacheSize = 1 << CacheBits,
+};
+
+struct tic_quantizer
+{
+	tic_rgb palette[TIC_PALETTE_SIZE];
+	OkLab lab[TIC_PALETTE_SIZE];
+	bool perceptual;
+
+	// nearest palette color for every RGB555 cell that lies inside one color's region
+	u8 cells[LutSize];
+
+	// exact answers for colors from the ambiguous cells, by the whole color
+	u32 keys[CacheSize];
+	u8 colors[CacheSize];
+};
+
+static inline u32 getCellIndex(u8 r, u8 g, u8 b)
+{
+	return (r >> LutShift) << (LutBits * 2) | (g >> LutShift) << LutBits | (b >> LutShift);
+}
+
+static u8 searchPerceptual(const tic_quantizer* quantizer, const tic_rgb* color)
+{
+	OkLab lab = rgbToOkLab(color);
+
+	float minDst = INFINITY;
+	u8 closest = 0;
+
+	for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+	{
+		float l = lab.l - quantizer->lab[i].l;
+		float a = lab.a - quantizer->lab[i].a;
+		float b = lab.b - quantizer->lab[i].b;
+		float dst = l*l + a*a + b*b;
+
+		if(dst < minDst)
+		{
+			minDst = dst;
+			closest = i;
+		}
+	}
+
+	return closest;
+}
+
+// |x-p|^2 - |x-c|^2 is linear in x, so its minimum over the cell is at a corner;
+// c wins the whole cell if that stays positive for every p, or zero for the later ones
+static bool ownsCell(const tic_rgb* palette, u8 c, const u8* lo)
+{
+	const u8* cc = &palette[c].r;
+
+	for(s32 p = 0; p < TIC_PALETTE_SIZE; p++)
+	{
+		if(p == c) continue;
+
+		const u8* pc = &palette[p].r;
+		s32 min = 0;
+
+		for(s32 i = 0; i < 3; i++)
+		{
+			s32 w = 2 * (cc[i] - pc[i]);
+			min += MIN(w * lo[i], w * (lo[i] + CellMax)) + pc[i] * pc[i] - cc[i] * cc[i];
+		}
+
+		if(min < 0 || (min == 0 && p < c))
+			return false;
+	}
+
+	return true;
+}
+
+// the same in OKLab, which is linear in the LMS cube roots; those grow with every channel,
+// so the cell lies inside the box between its darkest and brightest corners
+static bool ownsCellPerceptual(const tic_quantizer* quantizer, u8 c, const u8* lo)
+{
+	// covers float rounding in the search
+	static const float Margin = 1e-5f;
+
+	float lmsLo[3], lmsHi[3];
+	rgbToLms(lo[0], lo[1], lo[2], lmsLo);
+	rgbToLms(lo[0] + CellMax, lo[1] + CellMax, lo[2] + CellMax, lmsHi);
+
+	const OkLab* cl = &quantizer->lab[c];
+
+	for(s32 p = 0; p < TIC_PALETTE_SIZE; p++)
+	{
+		if(p == c) continue;
+
+		const OkLab* pl = &quantizer->lab[p];
+
+		// the search keeps the first of equal colors
+		if(p > c && memcmp(pl, cl, sizeof(OkLab)) == 0) continue;
+
+		float dl = 2 * (cl->l - pl->l), da = 2 * (cl->a - pl->a), db = 2 * (cl->b - pl->b);
+		float min = pl->l*pl->l + pl->a*pl->a + pl->b*pl->b - cl->l*cl->l - cl->a*cl->a - cl->b*cl->b;
+
+		for(s32 i = 0; i < 3; i++)
+		{
+			float w = dl * LmsToLab[0][i] + da * LmsToLab[1][i] + db * LmsToLab[2][i];
+			min += MIN(w * lmsLo[i], w * lmsHi[i]);
+		}
+
+		if(min <= Margin)
+			return false;
+	}
+
+	return true;
+}
+
+tic_quantizer* tic_tool_quantizer_create(const tic_rgb* palette, bool perceptual)
+{
+	tic_quantizer* quantizer = malloc(sizeof(tic_quantizer));
+
+	if(quantizer)
+	{
+		memcpy(quantizer->palette, palette, sizeof quantizer->palette);
+		quantizer->perceptual = perceptual;
+		
+		for(s32 i = 0; i < TIC_PALETTE_SIZE; i++)
+			quantizer->lab[i] = rgbToOkLab(&palette[i]);
+
+		for(u32 i = 0; i < LutSize; i++)
+		{
+			u8 lo[] = 
+			{
+				(i >> (LutBits * 2)) << LutShift, 
+				((i >> LutBits) & ((1 << LutBits) - 1)) << LutShift, 
+				(i & ((1 << LutBits) - 1)) << LutShift,
+			};
+
+			const tic_rgb color = {lo[0], lo[1], lo[2]};
+			u8 c = tic_tool_quantizer_search(quantizer, &color);
+
+			quantizer->cells[i] = (perceptual ? ownsCellPerceptual(quantizer, c, lo) : ownsCell(palette, c, lo)) 
+				? c : Ambiguous;
+		}
+
+		// 0xffffffff never matches a 24 bit color
+		memset(quantizer->keys, 0xff, sizeof quantizer->keys);
+	}
+
+	return quantizer;
+}
+
+void tic_tool_quantizer_free(tic_quantizer* quantizer)
+{
+	free(quantizer);
+}
+
+u8 tic_tool_quantizer_search(const tic_quantizer* quantizer, const tic_rgb* color)
+{
+	return quantizer->perceptual 
+		? searchPerceptual(quantizer, color) 
+		: tic_tool_find_closest_color(quantizer->palette, color);
+}
+
+u8 tic_tool_quantizer_find(tic_quantizer* quantizer, const tic_rgb* color)
+{
+	u8 cell = quantizer->cells[getCellIndex(color->r, color->g, color->b)];
+
+	if(cell != Ambiguous)
+		return cell;
+
+	u32 key = color->r << 16 | color->g << 8 | color->b;
+	u32 slot = (key * 2654435761u) >> (32 - CacheBits);
+
+	if(quantizer->keys[slot] != key)
+	{
+		quantizer->keys[slot] = key;
+		quantizer->colors[slot] = tic_tool_quantizer_search(quantizer, color);
+	}
+
+	return quantizer->colors[slot];
+}
+
+static inline u8 clampColor(s32 value)
+{
+	return value < 0 ? 0 : value > UINT8_MAX ? UINT8_MAX : value;
+}
+
+void tic_tool_quantize(tic_quantizer* quantizer, const tic_rgb* src, u8* dst, s32 width, s32 height, tic_dither dither)
+{
+	switch(dither)
+	{
+	case tic_dither_none:
+		for(s32 i = 0, size = width * height; i < size; i++, src++)
+			dst[i] = tic_tool_quantizer_find(quantizer, src);
+		break;
+
+	case tic_dither_ordered:
+		{
+			static const u8 Bayer[4][4] = 
+			{
+				{ 0,  8,  2, 10},
+				{12,  4, 14,  6},
+				{ 3, 11,  1,  9},
+				{15,  7, 13,  5},
+			};
+
+			enum{Spread = 2};
+
+			for(s32 y = 0; y < height; y++)
+				for(s32 x = 0; x < width; x++, src++, dst++)
+				{
+					s32 offset = (Bayer[y & 3][x & 3] * 2 - 15) * Spread;
+
+					const tic_rgb color = 
+					{
+						clampColor(src->r + offset), 
+						clampColor(src->g + offset), 
+						clampColor(src->b + offset),
+					};
+
+					*dst = tic_tool_quantizer_find(quantizer, &color);
+				}
+		}
+		break;
+
+	case tic_dither_floyd_steinberg:
+		{
+			// error of the current and the next row with a guard pixel on both sides, x 16
+			s32* errors = calloc((width + 2) * 2 * 3, sizeof(s32));
+
+			if(!errors) 
+			{
+				tic_tool_quantize(quantizer, src, dst, width, height, tic_dither_none);
+				break;
+			}
+
+			for(s32 y = 0; y < height; y++)
+			{
+				s32* cur = errors + ((y & 1) ? (width + 2) * 3 : 0) + 3;
+				s32* next = errors + ((y & 1) ? 0 : (width + 2) * 3) + 3;
+
+				memset(next - 3, 0, (width + 2) * 3 * sizeof(s32));
+
+				for(s32 x = 0; x < width; x++, src++, dst++)
+				{
+					s32* err = cur + x * 3;
+
+					const tic_rgb color = 
+					{
+						clampColor(src->r + err[0] / 16),
+						clampColor(src->g + err[1] / 16),
+						clampColor(src->b + err[2] / 16),
+					};
+
+					u8 index = tic_tool_quantizer_find(quantizer, &color);
+					*dst = index;
+
+					const u8* rgb = &color.r;
+					const u8* pal = &quantizer->palette[index].r;
+
+					for(s32 c = 0; c < 3; c++)
+					{
+						s32 e = rgb[c] - pal[c];
+
+						err[c + 3] += e * 7;
+						next[x * 3 + c - 3] += e * 3;
+						next[x * 3 + c] += e * 5;
+						next[x * 3 + c + 3] += e;
+					}
+				}
+			}
+
+			free(errors);
+		}
+		break;
+	}
+}
+
 u32* tic_palette_blit(const tic_palette* srcpal)
 {
 	static u32 pal[TIC_PALETTE_SIZE];
@@ -106,6 +443,24 @@ u32* tic_palette_blit(const tic_palette* srcpal)
 	return pal;
 }
 
+u32 tic_tool_pack_color(tic80_pixel_color_format format, u8 r, u8 g, u8 b)
+{
+	switch(format)
+	{
+	case TIC80_PIXEL_COLOR_XRGB8888:
+		return 0xff000000 | r << 16 | g << 8 | b;
+	case TIC80_PIXEL_COLOR_RGB565:
+		return (r >> 3) << 11 | (g >> 2) << 5 | b >> 3;
+	default:
+		{
+			u32 color;
+			u8* c = (u8*)&color;
+			c[0] = r, c[1] = g, c[2] = b, c[3] = 0xff;
+			return color;
+		}
+	}
+}
+
 bool tic_tool_has_ext(const char* name, const char* ext)
 {
 	return strcmp(name + strlen(name) - strlen(ext), ext) == 0;
@@ -120,4 +475,33 @@ void tic_set_track_row_sfx(tic_track_row* row, s32 sfx)
 {
 	row->sfxhi = (sfx & 0b00100000) >> MUSIC_SFXID_LOW_BITS;
 	row->sfxlow = sfx & 0b00011111;
-}
\ No newline at end of file
+}
+
+#if defined(_WIN32)
+
+u64 tic_tool_get_microseconds()
+{
+	LARGE_INTEGER counter, freq;
+	QueryPerformanceCounter(&counter);
+	QueryPerformanceFrequency(&freq);
+
+	return counter.QuadPart / freq.QuadPart * 1000000 + counter.QuadPart % freq.QuadPart * 1000000 / freq.QuadPart;
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+u64 tic_tool_get_microseconds()
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (u64)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+#else
+
+u64 tic_tool_get_microseconds()
+{
+	return (u64)clock() * 1000000 / CLOCKS_PER_SEC;
+}
+
+#endif
@@ -47,11 +47,32 @@ inline u8 tic_tool_peek4(const void* addr, u32 index)
 	return index & 1 ? val >> 4 : val & 0xf;
 }
 
+typedef enum
+{
+	tic_dither_none,
+	tic_dither_ordered,
+	tic_dither_floyd_steinberg,
+} tic_dither;
+
+// nearest palette colors for one palette, keep it while the palette stays the same
+typedef struct tic_quantizer tic_quantizer;
+
 bool tic_tool_parse_note(const char* noteStr, s32* note, s32* octave);
 s32 tic_tool_get_pattern_id(const tic_track* track, s32 frame, s32 channel);
 void tic_tool_set_pattern_id(tic_track* track, s32 frame, s32 channel, s32 id);
 u32 tic_tool_find_closest_color(const tic_rgb* palette, const tic_rgb* color);
+tic_quantizer* tic_tool_quantizer_create(const tic_rgb* palette, bool perceptual);
+void tic_tool_quantizer_free(tic_quantizer* quantizer);
+// exact search over the palette, by RGB or OKLab distance
+u8 tic_tool_quantizer_search(const tic_quantizer* quantizer, const tic_rgb* color);
+// same answer as the search, from the table where the color's cell has only one
+u8 tic_tool_quantizer_find(tic_quantizer* quantizer, const tic_rgb* color);
+void tic_tool_quantize(tic_quantizer* quantizer, const tic_rgb* src, u8* dst, s32 width, s32 height, tic_dither dither);
 u32* tic_palette_blit(const tic_palette* src);
+u32 tic_tool_pack_color(tic80_pixel_color_format format, u8 r, u8 g, u8 b);
 bool tic_tool_has_ext(const char* name, const char* ext);
 s32 tic_get_track_row_sfx(const tic_track_row* row);
 void tic_set_track_row_sfx(tic_track_row* row, s32 sfx);
+
+// monotonic, for measuring time spent inside a frame
+u64 tic_tool_get_microseconds();
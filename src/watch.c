@@ -0,0 +1,223 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "watch.h"
+#include "tic.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if defined(__TIC_LINUX__)
+
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <limits.h>
+#include <pthread.h>
+
+typedef struct
+{
+	s32 wd;
+	char dir[FILENAME_MAX];
+	char name[FILENAME_MAX];
+} WatchedFile;
+
+struct Watcher
+{
+	s32 fd;
+	s32 quit[2];
+	pthread_t thread;
+	pthread_mutex_t lock;
+
+	WatchedFile files[WATCHER_FILES];
+
+	u32 changes;
+};
+
+// editors save by writing in place or by renaming a temp file over the old one,
+// so the directory is watched and the events are matched by name
+enum {WatchMask = IN_CLOSE_WRITE | IN_MOVED_TO};
+
+static void* watcherThread(void* data)
+{
+	Watcher* watcher = (Watcher*)data;
+
+	char buffer[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)]
+		__attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	struct pollfd fds[] = {{watcher->fd, POLLIN, 0}, {watcher->quit[0], POLLIN, 0}};
+
+	while(poll(fds, COUNT_OF(fds), -1) >= 0 && !fds[1].revents)
+	{
+		ssize_t size = read(watcher->fd, buffer, sizeof buffer);
+
+		if(size <= 0) continue;
+
+		pthread_mutex_lock(&watcher->lock);
+
+		for(const char* ptr = buffer; ptr < buffer + size;)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)ptr;
+
+			for(s32 i = 0; i < WATCHER_FILES; i++)
+			{
+				const WatchedFile* file = &watcher->files[i];
+
+				if(file->wd == event->wd && event->len && strcmp(file->name, event->name) == 0)
+					__atomic_or_fetch(&watcher->changes, 1u << i, __ATOMIC_RELEASE);
+			}
+
+			ptr += sizeof(struct inotify_event) + event->len;
+		}
+
+		pthread_mutex_unlock(&watcher->lock);
+	}
+
+	return NULL;
+}
+
+Watcher* createWatcher()
+{
+	Watcher* watcher = (Watcher*)calloc(1, sizeof(Watcher));
+
+	if(watcher)
+	{
+		for(s32 i = 0; i < WATCHER_FILES; i++)
+			watcher->files[i].wd = -1;
+
+		watcher->fd = inotify_init1(IN_CLOEXEC);
+
+		if(watcher->fd >= 0)
+		{
+			if(pipe(watcher->quit) == 0)
+			{
+				pthread_mutex_init(&watcher->lock, NULL);
+
+				if(pthread_create(&watcher->thread, NULL, watcherThread, watcher) == 0)
+					return watcher;
+
+				pthread_mutex_destroy(&watcher->lock);
+				close(watcher->quit[0]);
+				close(watcher->quit[1]);
+			}
+
+			close(watcher->fd);
+		}
+
+		free(watcher);
+	}
+
+	return NULL;
+}
+
+static void removeWatch(Watcher* watcher, s32 id)
+{
+	WatchedFile* file = &watcher->files[id];
+
+	if(file->wd >= 0)
+	{
+		bool shared = false;
+
+		for(s32 i = 0; i < WATCHER_FILES; i++)
+			if(i != id && watcher->files[i].wd == file->wd)
+				shared = true;
+
+		if(!shared)
+			inotify_rm_watch(watcher->fd, file->wd);
+
+		file->wd = -1;
+	}
+}
+
+void watchFile(Watcher* watcher, s32 id, const char* path)
+{
+	if(!watcher || id < 0 || id >= WATCHER_FILES) return;
+
+	pthread_mutex_lock(&watcher->lock);
+
+	removeWatch(watcher, id);
+
+	WatchedFile* file = &watcher->files[id];
+	const char* slash = strrchr(path, '/');
+
+	if(slash)
+	{
+		snprintf(file->dir, sizeof file->dir, "%.*s", (s32)(slash - path) + 1, path);
+		snprintf(file->name, sizeof file->name, "%s", slash + 1);
+	}
+	else
+	{
+		strcpy(file->dir, ".");
+		snprintf(file->name, sizeof file->name, "%s", path);
+	}
+
+	// inotify returns the same descriptor for a directory watched twice
+	file->wd = inotify_add_watch(watcher->fd, file->dir, WatchMask);
+
+	pthread_mutex_unlock(&watcher->lock);
+}
+
+void unwatchFile(Watcher* watcher, s32 id)
+{
+	if(!watcher || id < 0 || id >= WATCHER_FILES) return;
+
+	pthread_mutex_lock(&watcher->lock);
+	removeWatch(watcher, id);
+	pthread_mutex_unlock(&watcher->lock);
+
+	__atomic_and_fetch(&watcher->changes, ~(1u << id), __ATOMIC_RELEASE);
+}
+
+u32 watcherChanges(Watcher* watcher)
+{
+	return watcher ? __atomic_exchange_n(&watcher->changes, 0, __ATOMIC_ACQUIRE) : 0;
+}
+
+void closeWatcher(Watcher* watcher)
+{
+	if(watcher)
+	{
+		ssize_t done = write(watcher->quit[1], "", 1);
+		(void)done;
+
+		pthread_join(watcher->thread, NULL);
+
+		pthread_mutex_destroy(&watcher->lock);
+
+		close(watcher->quit[0]);
+		close(watcher->quit[1]);
+		close(watcher->fd);
+
+		free(watcher);
+	}
+}
+
+#else
+
+Watcher* createWatcher() {return NULL;}
+void watchFile(Watcher* watcher, s32 id, const char* path) {}
+void unwatchFile(Watcher* watcher, s32 id) {}
+u32 watcherChanges(Watcher* watcher) {return 0;}
+void closeWatcher(Watcher* watcher) {}
+
+#endif
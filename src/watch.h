@@ -0,0 +1,45 @@
+// MIT License
+
+// Copyright (c) 2017 Vadim Grigoruk @nesbox // grigoruk@gmail.com
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <tic80_types.h>
+
+// Tells which files were changed by other programs.
+// Where the system can report it (inotify on Linux) a thread waits for the events,
+// so asking for the changes costs nothing, elsewhere createWatcher returns NULL
+// and the caller keeps checking the files itself.
+
+enum {WATCHER_FILES = 32};
+
+typedef struct Watcher Watcher;
+
+Watcher* createWatcher();
+
+// watches the file under the id, replacing the file watched under it before
+void watchFile(Watcher* watcher, s32 id, const char* path);
+void unwatchFile(Watcher* watcher, s32 id);
+
+// bit mask of the ids changed since the last call
+u32 watcherChanges(Watcher* watcher);
+
+void closeWatcher(Watcher* watcher);
@@ -70,6 +70,16 @@ class TIC {\n\
 	foreign static mset(cell_x, cell_y)\n\
 	foreign static mset(cell_x, cell_y, index)\n\
 	foreign static mget(cell_x, cell_y)\n\
+	foreign static mray(x0, y0, x1, y1)\n\
+	foreign static mray(x0, y0, x1, y1, mask)\n\
+	foreign static msweep(x, y, w, h, dx, dy)\n\
+	foreign static msweep(x, y, w, h, dx, dy, mask)\n\
+	foreign static mfill(cell_x, cell_y)\n\
+	foreign static mfill(cell_x, cell_y, mask)\n\
+	foreign static mfill(cell_x, cell_y, mask, index)\n\
+	foreign static mpath(cell_x0, cell_y0, cell_x1, cell_y1)\n\
+	foreign static mpath(cell_x0, cell_y0, cell_x1, cell_y1, mask)\n\
+	foreign static mpath(cell_x0, cell_y0, cell_x1, cell_y1, mask, cost)\n\
 	foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3)\n\
 	foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map)\n\
 	foreign static textri(x1, y1, x2, y2, x3, y3, u1, v1, u2, v2, u3, v3, use_map, alpha_color)\n\
@@ -108,6 +118,10 @@ class TIC {\n\
 	foreign static sync(mask)\n\
 	foreign static sync(mask, bank)\n\
 	foreign static sync(mask, bank, tocart)\n\
+	foreign static raster()\n\
+	foreign static raster(addr, val)\n\
+	foreign static raster(addr, val, row)\n\
+	foreign static raster(addr, val, row, count)\n\
 	foreign static reset()\n\
 	foreign static exit()\n\
 	foreign static map_width__\n\
@@ -190,31 +204,38 @@ static inline bool isList(WrenVM* vm, s32 index)
 	return wrenGetSlotType(vm, index) == WREN_TYPE_LIST;
 }
 
+// wren doesn't expect allocations to fail,
+// so it goes over the limit and the overflow is reported after the call
+static void* wrenAlloc(void* memory, size_t size, void* userData)
+{
+	tic_machine* machine = userData;
+	return tic_heap_force_realloc(&machine->heap, memory, size);
+}
+
 static void closeWren(tic_mem* tic)
 {
 	tic_machine* machine = (tic_machine*)tic;
 	if(machine->wren)
 	{	
-		// release handles
-		if (loaded)
-		{
-			wrenReleaseHandle(machine->wren, new_handle);
-			wrenReleaseHandle(machine->wren, update_handle);
-			wrenReleaseHandle(machine->wren, scanline_handle);
-			wrenReleaseHandle(machine->wren, overline_handle);
-			if (game_class != NULL) 
-			{
-				wrenReleaseHandle(machine->wren, game_class);
-			}
-		}
-
-		wrenFreeVM(machine->wren);
+		// the VM and its handles live in the machine heap and go away with it
+		tic_heap_release(&machine->heap);
 		machine->wren = NULL;
-
+		game_class = NULL;
 	}
 	loaded = false;
 }
 
+static bool checkWrenHeap(tic_machine* machine)
+{
+	if(machine->heap.overflow)
+	{
+		machine->data->error(machine->data->data, "out of memory");
+		return false;
+	}
+
+	return true;
+}
+
 static tic_machine* getWrenMachine(WrenVM* vm)
 {
 	tic_machine* machine = wrenGetUserData(vm);
@@ -243,7 +264,7 @@ static void wren_mgeti(WrenVM* vm)
 	}
 
 	tic_mem* memory = (tic_mem*)getWrenMachine(vm);
-	wrenSetSlotDouble(vm, 0, *(memory->ram.map.data + index));
+	wrenSetSlotDouble(vm, 0, memory->api.map_get(memory, &memory->ram.map, index % TIC_MAP_WIDTH, index / TIC_MAP_WIDTH));
 }
 
 static void wren_spritesize(WrenVM* vm)
@@ -676,6 +697,116 @@ static void wren_mget(WrenVM* vm)
 	wrenSetSlotDouble(vm, 0, value);
 }
 
+static void wren_mray(WrenVM* vm)
+{
+	tic_mem* memory = (tic_mem*)getWrenMachine(vm);
+
+	s32 top = wrenGetSlotCount(vm);
+
+	float x0 = (float)wrenGetSlotDouble(vm, 1);
+	float y0 = (float)wrenGetSlotDouble(vm, 2);
+	float x1 = (float)wrenGetSlotDouble(vm, 3);
+	float y1 = (float)wrenGetSlotDouble(vm, 4);
+	u8 mask = top > 5 ? getWrenNumber(vm, 5) : 0xff;
+
+	tic_map_hit hit;
+	bool done = memory->api.map_ray(memory, &memory->ram.map, x0, y0, x1, y1, mask, &hit);
+
+	wrenEnsureSlots(vm, 2);
+	wrenSetSlotNewList(vm, 0);
+	wrenSetSlotBool(vm, 1, done);
+	wrenInsertInList(vm, 0, 0, 1);
+	wrenSetSlotDouble(vm, 1, hit.x);
+	wrenInsertInList(vm, 0, 1, 1);
+	wrenSetSlotDouble(vm, 1, hit.y);
+	wrenInsertInList(vm, 0, 2, 1);
+	wrenSetSlotDouble(vm, 1, hit.cellx);
+	wrenInsertInList(vm, 0, 3, 1);
+	wrenSetSlotDouble(vm, 1, hit.celly);
+	wrenInsertInList(vm, 0, 4, 1);
+	wrenSetSlotDouble(vm, 1, hit.normalx);
+	wrenInsertInList(vm, 0, 5, 1);
+	wrenSetSlotDouble(vm, 1, hit.normaly);
+	wrenInsertInList(vm, 0, 6, 1);
+}
+
+static void wren_msweep(WrenVM* vm)
+{
+	tic_mem* memory = (tic_mem*)getWrenMachine(vm);
+
+	s32 top = wrenGetSlotCount(vm);
+
+	float x = (float)wrenGetSlotDouble(vm, 1);
+	float y = (float)wrenGetSlotDouble(vm, 2);
+	float w = (float)wrenGetSlotDouble(vm, 3);
+	float h = (float)wrenGetSlotDouble(vm, 4);
+	float dx = (float)wrenGetSlotDouble(vm, 5);
+	float dy = (float)wrenGetSlotDouble(vm, 6);
+	u8 mask = top > 7 ? getWrenNumber(vm, 7) : 0xff;
+
+	tic_map_hit hit;
+	memory->api.map_sweep(memory, &memory->ram.map, x, y, w, h, dx, dy, mask, &hit);
+
+	wrenEnsureSlots(vm, 2);
+	wrenSetSlotNewList(vm, 0);
+	wrenSetSlotDouble(vm, 1, hit.x);
+	wrenInsertInList(vm, 0, 0, 1);
+	wrenSetSlotDouble(vm, 1, hit.y);
+	wrenInsertInList(vm, 0, 1, 1);
+	wrenSetSlotDouble(vm, 1, hit.normalx);
+	wrenInsertInList(vm, 0, 2, 1);
+	wrenSetSlotDouble(vm, 1, hit.normaly);
+	wrenInsertInList(vm, 0, 3, 1);
+}
+
+static void wren_mfill(WrenVM* vm)
+{
+	tic_mem* memory = (tic_mem*)getWrenMachine(vm);
+
+	s32 top = wrenGetSlotCount(vm);
+
+	s32 x = getWrenNumber(vm, 1);
+	s32 y = getWrenNumber(vm, 2);
+	u8 mask = top > 3 ? getWrenNumber(vm, 3) : 0xff;
+	s32 tile = top > 4 && wrenGetSlotType(vm, 4) != WREN_TYPE_NULL ? (u8)getWrenNumber(vm, 4) : -1;
+
+	wrenSetSlotDouble(vm, 0, memory->api.map_fill(memory, &memory->ram.map, x, y, mask, tile));
+}
+
+static void wren_mpath(WrenVM* vm)
+{
+	tic_mem* memory = (tic_mem*)getWrenMachine(vm);
+
+	s32 top = wrenGetSlotCount(vm);
+
+	s32 x0 = getWrenNumber(vm, 1);
+	s32 y0 = getWrenNumber(vm, 2);
+	s32 x1 = getWrenNumber(vm, 3);
+	s32 y1 = getWrenNumber(vm, 4);
+	u8 mask = top > 5 ? getWrenNumber(vm, 5) : 0xff;
+	u8 cost = top > 6 ? getWrenNumber(vm, 6) : 0;
+
+	const u16* path = NULL;
+	s32 steps = memory->api.map_path(memory, &memory->ram.map, x0, y0, x1, y1, mask, cost, &path);
+
+	if(steps < 0)
+	{
+		wrenSetSlotNull(vm, 0);
+		return;
+	}
+
+	wrenEnsureSlots(vm, 2);
+	wrenSetSlotNewList(vm, 0);
+
+	for(s32 i = 0; i < steps; i++)
+	{
+		wrenSetSlotDouble(vm, 1, path[i] % TIC_MAP_WIDTH);
+		wrenInsertInList(vm, 0, -1, 1);
+		wrenSetSlotDouble(vm, 1, path[i] / TIC_MAP_WIDTH);
+		wrenInsertInList(vm, 0, -1, 1);
+	}
+}
+
 static void wren_textri(WrenVM* vm)
 {
 	int top = wrenGetSlotCount(vm);
@@ -860,6 +991,7 @@ static void wren_peek(WrenVM* vm)
 
 	if(address >= 0 && address < sizeof(tic_ram))
 	{
+		tic_ram_touch(&machine->memory, address, 1);
 		wrenSetSlotDouble(vm, 0, *((u8*)&machine->memory.ram + address));
 	}
 }
@@ -873,6 +1005,7 @@ static void wren_poke(WrenVM* vm)
 
 	if(address >= 0 && address < sizeof(tic_ram))
 	{
+		tic_ram_touch(&machine->memory, address, 1);
 		*((u8*)&machine->memory.ram + address) = value;
 	}
 }
@@ -883,6 +1016,7 @@ static void wren_peek4(WrenVM* vm)
 
 	if(address >= 0 && address < sizeof(tic_ram)*2)
 	{
+		tic_ram_touch(&getWrenMachine(vm)->memory, address / 2, 1);
 		wrenSetSlotDouble(vm, 0, tic_tool_peek4((u8*)&getWrenMachine(vm)->memory.ram, address));
 	}	
 }
@@ -894,6 +1028,7 @@ static void wren_poke4(WrenVM* vm)
 
 	if(address >= 0 && address < sizeof(tic_ram)*2)
 	{
+		tic_ram_touch(&getWrenMachine(vm)->memory, address / 2, 1);
 		tic_tool_poke4((u8*)&getWrenMachine(vm)->memory.ram, address, value);
 	}
 }
@@ -908,6 +1043,8 @@ static void wren_memcpy(WrenVM* vm)
 	if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && src >= 0 && dest <= bound && src <= bound)
 	{
 		u8* base = (u8*)&getWrenMachine(vm)->memory;
+		tic_ram_touch(&getWrenMachine(vm)->memory, dest, size);
+		tic_ram_touch(&getWrenMachine(vm)->memory, src, size);
 		memcpy(base + dest, base + src, size);
 	}
 }
@@ -922,6 +1059,7 @@ static void wren_memset(WrenVM* vm)
 	if(size >= 0 && size <= sizeof(tic_ram) && dest >= 0 && dest <= bound)
 	{
 		u8* base = (u8*)&getWrenMachine(vm)->memory;
+		tic_ram_touch(&getWrenMachine(vm)->memory, dest, size);
 		memset(base + dest, value, size);
 	}
 }
@@ -1097,6 +1235,63 @@ static void wren_sync(WrenVM* vm)
 	else wrenError(vm, "sync() error, invalid bank");
 }
 
+// a null value clears the register, values go from -128 to 255
+static void wren_raster(WrenVM* vm)
+{
+	tic_mem* memory = (tic_mem*)getWrenMachine(vm);
+
+	s32 address = -1;
+	bool clear = true;
+	s32 value = 0;
+	s32 row = 0;
+	s32 count = TIC80_HEIGHT;
+
+	s32 top = wrenGetSlotCount(vm);
+
+	if(top > 2 && isList(vm, 2))
+	{
+		address = getWrenNumber(vm, 1);
+		row = top > 3 ? getWrenNumber(vm, 3) : 0;
+		count = MIN(wrenGetListCount(vm, 2), TIC80_HEIGHT);
+
+		wrenEnsureSlots(vm, top+1);
+
+		for(s32 i = 0; i < count; i++)
+		{
+			wrenGetListElement(vm, 2, i, top);
+			clear = wrenGetSlotType(vm, top) == WREN_TYPE_NULL;
+			value = clear ? 0 : getWrenNumber(vm, top);
+
+			if(!(clear 
+				? memory->api.raster_clear(memory, address, row + i, 1) 
+				: memory->api.raster(memory, address, value, row + i, 1)))
+			{
+				wrenError(vm, "raster() error, invalid address or value");
+				return;
+			}
+		}
+
+		return;
+	}
+	else if(top > 2)
+	{
+		address = getWrenNumber(vm, 1);
+		clear = wrenGetSlotType(vm, 2) == WREN_TYPE_NULL;
+		value = clear ? 0 : getWrenNumber(vm, 2);
+
+		if(top > 3)
+		{
+			row = getWrenNumber(vm, 3);
+			count = top > 4 ? getWrenNumber(vm, 4) : TIC80_HEIGHT - row;
+		}
+	}
+
+	if(!(clear 
+		? memory->api.raster_clear(memory, address, row, count) 
+		: memory->api.raster(memory, address, value, row, count)))
+		wrenError(vm, "raster() error, invalid address or value");
+}
+
 static void wren_reset(WrenVM* vm)
 {
 	tic_machine* machine = getWrenMachine(vm);
@@ -1147,6 +1342,16 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
 	if (strcmp(signature, "static TIC.mset(_,_)"	            ) == 0) return wren_mset;
 	if (strcmp(signature, "static TIC.mset(_,_,_)"	            ) == 0) return wren_mset;
 	if (strcmp(signature, "static TIC.mget(_,_)"	            ) == 0) return wren_mget;
+	if (strcmp(signature, "static TIC.mray(_,_,_,_)"            ) == 0) return wren_mray;
+	if (strcmp(signature, "static TIC.mray(_,_,_,_,_)"          ) == 0) return wren_mray;
+	if (strcmp(signature, "static TIC.msweep(_,_,_,_,_,_)"      ) == 0) return wren_msweep;
+	if (strcmp(signature, "static TIC.msweep(_,_,_,_,_,_,_)"    ) == 0) return wren_msweep;
+	if (strcmp(signature, "static TIC.mfill(_,_)"               ) == 0) return wren_mfill;
+	if (strcmp(signature, "static TIC.mfill(_,_,_)"             ) == 0) return wren_mfill;
+	if (strcmp(signature, "static TIC.mfill(_,_,_,_)"           ) == 0) return wren_mfill;
+	if (strcmp(signature, "static TIC.mpath(_,_,_,_)"           ) == 0) return wren_mpath;
+	if (strcmp(signature, "static TIC.mpath(_,_,_,_,_)"         ) == 0) return wren_mpath;
+	if (strcmp(signature, "static TIC.mpath(_,_,_,_,_,_)"       ) == 0) return wren_mpath;
 
 	if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_)"	     ) == 0) return wren_textri;
 	if (strcmp(signature, "static TIC.textri(_,_,_,_,_,_,_,_,_,_,_,_,_)"	 ) == 0) return wren_textri;
@@ -1191,6 +1396,10 @@ static WrenForeignMethodFn foreignTicMethods(const char* signature)
 	if (strcmp(signature, "static TIC.sync(_)"                  ) == 0) return wren_sync;
 	if (strcmp(signature, "static TIC.sync(_,_)"                ) == 0) return wren_sync;
 	if (strcmp(signature, "static TIC.sync(_,_,_)"              ) == 0) return wren_sync;
+	if (strcmp(signature, "static TIC.raster()"                 ) == 0) return wren_raster;
+	if (strcmp(signature, "static TIC.raster(_,_)"              ) == 0) return wren_raster;
+	if (strcmp(signature, "static TIC.raster(_,_,_)"            ) == 0) return wren_raster;
+	if (strcmp(signature, "static TIC.raster(_,_,_,_)"          ) == 0) return wren_raster;
 	if (strcmp(signature, "static TIC.reset()"    			    ) == 0) return wren_reset;
 	if (strcmp(signature, "static TIC.exit()"    			    ) == 0) return wren_exit;
 
@@ -1273,10 +1482,14 @@ static bool initWren(tic_mem* memory, const char* code)
 	wrenInitConfiguration(&config);
 
 	config.bindForeignMethodFn = bindForeignMethod;
+	config.reallocateFn = wrenAlloc;
 
 	config.errorFn = reportError;
 	config.writeFn = writeFn;
 
+	// wrenAlloc() needs the machine before wrenNewVM() returns
+	config.userData = machine;
+
 	WrenVM* vm = machine->wren = wrenNewVM(&config);
 
 	initAPI(machine);
@@ -1317,7 +1530,7 @@ static bool initWren(tic_mem* memory, const char* code)
 		return false;
 	}
 
-	return true;
+	return checkWrenHeap(machine);
 }
 
 static void callWrenTick(tic_mem* memory)
@@ -1330,6 +1543,8 @@ static void callWrenTick(tic_mem* memory)
 		wrenEnsureSlots(vm, 1);
 		wrenSetSlotHandle(vm, 0, game_class);
 		wrenCall(vm, update_handle);
+
+		checkWrenHeap(machine);
 	}
 }
 
@@ -1442,6 +1657,7 @@ static const tic_script_config WrenSyntaxConfig =
 	.tick 				= callWrenTick,
 	.scanline 			= callWrenScanline,
 	.overline 			= callWrenOverline,
+	.snapshot 			= true,
 
 	.getOutline			= getWrenOutline,
 	.parse 				= parseCode,